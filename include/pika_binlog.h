@@ -7,6 +7,9 @@
 #define PIKA_BINLOG_H_
 
 #include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <vector>
 
 #include "pstd/include/env.h"
 #include "pstd/include/pstd_mutex.h"
@@ -47,13 +50,25 @@ class Version final : public pstd::noncopyable {
 
 class Binlog : public pstd::noncopyable {
  public:
-  Binlog(std::string  Binlog_path, int file_size = 100 * 1024 * 1024);
+  /*
+   * group_commit: concurrent Put calls are queued and written by one leader
+   *               thread as a single append, instead of one append per item.
+   * group_commit_max_bytes: upper bound of the encoded bytes in one group.
+   * sync_on_commit: sync the binlog file after every (group) append.
+   */
+  Binlog(std::string  Binlog_path, int file_size = 100 * 1024 * 1024, bool group_commit = false,
+         uint64_t group_commit_max_bytes = 1024 * 1024, bool sync_on_commit = false);
   ~Binlog();
 
   void Lock() { mutex_.lock(); }
   void Unlock() { mutex_.unlock(); }
 
   pstd::Status Put(const std::string& item);
+  /*
+   * Same as Put(item), also returns the producer status right after the item,
+   * which is the end offset of this item in the binlog.
+   */
+  pstd::Status Put(const std::string& item, uint32_t* filenum, uint64_t* offset);
 
   pstd::Status GetProducerStatus(uint32_t* filenum, uint64_t* pro_offset, uint32_t* term = nullptr, uint64_t* logic_id = nullptr);
   /*
@@ -83,18 +98,44 @@ class Binlog : public pstd::noncopyable {
 
   void Close();
 
+  /*
+   * Group commit statistics
+   */
+  uint64_t group_commit_batches() { return group_commit_batches_.load(std::memory_order_relaxed); }
+  uint64_t group_commit_items() { return group_commit_items_.load(std::memory_order_relaxed); }
+  uint64_t group_commit_max_batch() { return group_commit_max_batch_.load(std::memory_order_relaxed); }
+  uint64_t group_commit_wait_us() { return group_commit_wait_us_.load(std::memory_order_relaxed); }
+
  private:
-  pstd::Status Put(const char* item, int len);
+  /*
+   * A Put call waiting in writers_, filled by the leader of its group
+   */
+  struct Writer {
+    explicit Writer(const std::string* i) : item(i) {}
+    const std::string* item;
+    pstd::Status status;
+    bool done = false;
+    uint32_t filenum = 0;
+    uint64_t offset = 0;
+    pstd::CondVar cv;
+  };
+
+  // Need to hold mutex_
+  pstd::Status WriteGroup(const std::vector<Writer*>& group);
+  // Need to hold mutex_, append batch_buf_ to the current binlog file
+  pstd::Status FlushBatchBuffer(uint64_t pro_offset, uint64_t logic_id, uint32_t items);
+  // Need to hold mutex_
+  pstd::Status RollFile();
   static pstd::Status AppendPadding(pstd::WritableFile* file, uint64_t* len);
   // pstd::WritableFile *queue() { return queue_; }
 
   void InitLogFile();
-  pstd::Status EmitPhysicalRecord(RecordType t, const char* ptr, size_t n, int* temp_pro_offset);
+  void EmitPhysicalRecord(RecordType t, const char* ptr, size_t n, uint64_t* temp_pro_offset);
 
   /*
-   * Produce
+   * Produce, encode item as physical records at the tail of batch_buf_
    */
-  pstd::Status Produce(const pstd::Slice& item, int* pro_offset);
+  void Produce(const pstd::Slice& item, uint64_t* temp_pro_offset);
 
   std::atomic<bool> opened_;
 
@@ -118,6 +159,20 @@ class Binlog : public pstd::noncopyable {
   std::string filename_;
 
   std::atomic<bool> binlog_io_error_;
+
+  const bool group_commit_;
+  const uint64_t group_commit_max_bytes_;
+  const bool sync_on_commit_;
+  // Pending Put calls, the front one is the leader of the next group
+  pstd::Mutex writers_mu_;
+  std::deque<Writer*> writers_;
+  // Encoded records of the group being written, protected by mutex_
+  std::string batch_buf_;
+
+  std::atomic<uint64_t> group_commit_batches_ = 0;
+  std::atomic<uint64_t> group_commit_items_ = 0;
+  std::atomic<uint64_t> group_commit_max_batch_ = 0;
+  std::atomic<uint64_t> group_commit_wait_us_ = 0;
   // Not use
   // int32_t retry_;
 };
@@ -0,0 +1,99 @@
+// Copyright (c) 2023-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef PIKA_BINLOG_CHUNK_READER_H_
+#define PIKA_BINLOG_CHUNK_READER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+
+#include "pstd/include/noncopyable.h"
+#include "pstd/include/pstd_slice.h"
+#include "pstd/include/pstd_status.h"
+
+#include "include/pika_define.h"
+
+/*
+ * Reads a binlog file a chunk of whole blocks at a time with pread, instead
+ * of a read call for every header and every record. A physical record never
+ * crosses a block, so it is handed out as a slice of its chunk without being
+ * copied.
+ *
+ * The chunks of a file the producer is done with do not change anymore, they
+ * are shared by the readers of every slave through a cache, so slaves
+ * catching up from about the same offset read them from the disk once. The
+ * file being written is read up to the limit the producer status gives.
+ */
+
+// A multiple of kBlockSize
+inline constexpr size_t kBinlogChunkSize = 16 * kBlockSize;
+// The chunks shared by the readers, 64MB
+inline constexpr size_t kBinlogChunkCacheSize = 64;
+
+struct BinlogChunk {
+  uint64_t start = 0;
+  // Bytes read into data, less than kBinlogChunkSize at the end of the file
+  // or of what the producer wrote
+  size_t size = 0;
+  std::unique_ptr<char[]> data;
+};
+
+struct BinlogChunkStats {
+  // pread calls, and the chunks taken from the cache instead
+  std::atomic<uint64_t> reads = 0;
+  std::atomic<uint64_t> read_bytes = 0;
+  std::atomic<uint64_t> cache_hits = 0;
+};
+
+class BinlogChunkReader : public pstd::noncopyable {
+ public:
+  static constexpr uint64_t kNoLimit = std::numeric_limits<uint64_t>::max();
+
+  BinlogChunkReader() = default;
+  ~BinlogChunkReader();
+
+  // sealed tells that the producer rolled over to a later file already, so
+  // the chunks of this one may be shared
+  pstd::Status Open(const std::string& filename, bool sealed);
+  /*
+   * Reads n bytes at the current offset, at most up to the end of its block.
+   * result points into the chunk, and is valid until the next call. Fewer
+   * bytes than n are returned with an EndFile status, and the offset is not
+   * moved then.
+   */
+  pstd::Status Read(size_t n, pstd::Slice* result);
+  void Skip(uint64_t n) { offset_ += n; }
+  // Nothing at or beyond limit is read
+  void SetLimit(uint64_t limit) { limit_ = limit; }
+  uint64_t offset() const { return offset_; }
+
+  static BinlogChunkStats& Stats();
+
+ private:
+  pstd::Status LoadChunk(uint64_t start);
+  pstd::Status ReadMore(BinlogChunk* chunk, uint64_t end);
+  void Close();
+
+  std::string filename_;
+  int fd_ = -1;
+  bool sealed_ = false;
+  // Tell apart the files of the same name, which a purge and a full sync
+  // may bring about
+  uint64_t file_dev_ = 0;
+  uint64_t file_ino_ = 0;
+  int64_t file_mtime_ = 0;
+  uint64_t file_size_ = 0;
+
+  uint64_t offset_ = 0;
+  uint64_t limit_ = kNoLimit;
+  // Shared with the cache if the file is sealed, otherwise only with this
+  // reader and read on as the producer writes
+  std::shared_ptr<BinlogChunk> chunk_;
+};
+
+#endif  // PIKA_BINLOG_CHUNK_READER_H_
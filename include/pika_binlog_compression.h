@@ -0,0 +1,46 @@
+// Copyright (c) 2023-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef PIKA_BINLOG_COMPRESSION_H_
+#define PIKA_BINLOG_COMPRESSION_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "pika_inner_message.pb.h"
+
+/*
+ * A slave asks for the compression of its binlog chips in its TrySync
+ * request. The master then compresses every binlog sync response to it as a
+ * whole, wrapped into the compressed_resp of an outer response, so a batch of
+ * chips shares the dictionary of the compressor.
+ */
+
+// Responses smaller than that are sent as they are
+inline constexpr size_t kBinlogCompressMinSize = 1024;
+
+// name is one of none, lz4 and zstd
+bool BinlogCompressionFromName(const std::string& name, InnerMessage::CompressionType* type);
+std::string BinlogCompressionName(InnerMessage::CompressionType type);
+
+bool CompressBinlogChips(InnerMessage::CompressionType type, const std::string& raw, std::string* compressed);
+bool UncompressBinlogChips(InnerMessage::CompressionType type, const std::string& compressed, size_t raw_size,
+                           std::string* raw);
+
+struct BinlogCompressionStats {
+  // Binlog sync responses, and those of them that went compressed
+  std::atomic<uint64_t> batches = 0;
+  std::atomic<uint64_t> compressed_batches = 0;
+  // The size of the serialized responses, and what went over the wire
+  std::atomic<uint64_t> raw_bytes = 0;
+  std::atomic<uint64_t> bytes = 0;
+  // Spent compressing or uncompressing
+  std::atomic<uint64_t> codec_us = 0;
+
+  double Ratio() const { return bytes != 0 ? static_cast<double>(raw_bytes) / static_cast<double>(bytes) : 0; }
+};
+
+#endif  // PIKA_BINLOG_COMPRESSION_H_
@@ -15,6 +15,7 @@
 #include "pstd/include/pstd_status.h"
 
 #include "include/pika_binlog.h"
+#include "include/pika_binlog_chunk_reader.h"
 
 // using pstd::Slice;
 // using pstd::Status;
@@ -32,6 +33,9 @@ class PikaBinlogReader {
 
  private:
   bool GetNext(uint64_t* size);
+  // Opens a file of logger_, whose end is the producer offset while it is
+  // being written
+  pstd::Status OpenFile(uint32_t filenum);
   unsigned int ReadPhysicalRecord(pstd::Slice* result, uint32_t* filenum, uint64_t* offset);
   // Returns scratch binflog and corresponding offset
   pstd::Status Consume(std::string* scratch, uint32_t* filenum, uint64_t* offset);
@@ -42,9 +46,9 @@ class PikaBinlogReader {
   uint64_t last_record_offset_ = 0;
 
   std::shared_ptr<Binlog> logger_;
-  std::unique_ptr<pstd::SequentialFile> queue_;
+  std::unique_ptr<BinlogChunkReader> queue_;
 
-  std::unique_ptr<char[]> const backing_store_;
+  // Points into the chunk of queue_
   pstd::Slice buffer_;
 };
 
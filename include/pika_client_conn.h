@@ -83,10 +83,11 @@ class PikaClientConn : public net::RedisConn {
                  const net::HandleType& handle_type, int max_conn_rbuf_size);
   ~PikaClientConn() = default;
 
-  void ProcessRedisCmds(const std::vector<net::RedisCmdArgsType>& argvs, bool async,
+  void ProcessRedisCmds(std::vector<net::RedisCmdArgsType>& argvs, bool async,
                                 std::string* response) override;
 
-  void BatchExecRedisCmd(const std::vector<net::RedisCmdArgsType>& argvs);
+  // Consumes argvs, the arguments of each command are moved into it
+  void BatchExecRedisCmd(std::vector<net::RedisCmdArgsType>& argvs);
   int DealMessage(const net::RedisCmdArgsType& argv, std::string* response) override { return 0; }
   static void DoBackgroundTask(void* arg);
   static void DoExecTask(void* arg);
@@ -135,13 +136,13 @@ class PikaClientConn : public net::RedisConn {
   std::unordered_set<std::string> watched_db_keys_;
   std::mutex txn_state_mu_;
 
-  std::shared_ptr<Cmd> DoCmd(const PikaCmdArgsType& argv, const std::string& opt,
+  std::shared_ptr<Cmd> DoCmd(PikaCmdArgsType& argv, const std::string& opt,
                              const std::shared_ptr<std::string>& resp_ptr);
 
   void ProcessSlowlog(const PikaCmdArgsType& argv, uint64_t do_duration);
   void ProcessMonitor(const PikaCmdArgsType& argv);
 
-  void ExecRedisCmd(const PikaCmdArgsType& argv, std::shared_ptr<std::string>& resp_ptr);
+  void ExecRedisCmd(PikaCmdArgsType& argv, std::shared_ptr<std::string>& resp_ptr);
   void TryWriteResp();
 
   AuthStat auth_stat_;
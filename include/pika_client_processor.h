@@ -11,10 +11,12 @@
 #include <memory>
 #include "net/include/bg_thread.h"
 #include "net/include/thread_pool.h"
+#include "net/include/work_stealing_thread_pool.h"
 
 class PikaClientProcessor {
  public:
-  PikaClientProcessor(size_t worker_num, size_t max_queue_size, const std::string& name_prefix = "CliProcessor");
+  PikaClientProcessor(size_t worker_num, size_t max_queue_size, bool work_stealing = false,
+                      const std::string& name_prefix = "CliProcessor");
   ~PikaClientProcessor();
   int Start();
   void Stop();
@@ -6,8 +6,12 @@
 #ifndef PIKA_CMD_TABLE_MANAGER_H_
 #define PIKA_CMD_TABLE_MANAGER_H_
 
+#include <atomic>
+#include <mutex>
 #include <shared_mutex>
 #include <thread>
+#include <unordered_set>
+#include <vector>
 
 #include "include/pika_command.h"
 #include "include/pika_data_distribution.h"
@@ -26,18 +30,67 @@ class PikaCmdTableManager {
  public:
   PikaCmdTableManager();
   virtual ~PikaCmdTableManager() = default;
+  /*
+   * Instances of the common commands are taken from a pool of the calling
+   * thread. Such an instance goes back to the pool only when its last
+   * shared_ptr is dropped, whichever thread or task held it last, so it is
+   * never handed out again while a MULTI queue or a binlog task holds it.
+   */
   std::shared_ptr<Cmd> GetCmd(const std::string& opt);
   uint32_t DistributeKey(const std::string& key, uint32_t slot_num);
   bool CmdExist(const std::string& cmd) const;
   CmdTable* GetCmdTable();
 
+  /*
+   * Slow commands are run on a thread pool of their own, so they do not hold
+   * up the workers of the cheap ones. A command is slow if it is flagged so
+   * in the table, or if its executions were slow often enough lately.
+   */
+  bool IsSlowCmd(const std::string& opt) const;
+  // Called with the duration of every execution while the slowlog is on
+  void UpdateCmdDuration(const std::string& opt, uint64_t duration, uint64_t slower_than);
+  // Commands not flagged slow which are run on the slow lane for now
+  std::vector<std::string> AdaptiveSlowCmds() const;
+
  private:
+  // A slow execution outweighs this many fast ones, so a command moves to the
+  // slow lane once more than about one in nine of its executions are slow
+  static constexpr int32_t kSlowCmdScoreStep = 8;
+  static constexpr int32_t kSlowCmdScoreThreshold = 32;
+  static constexpr int32_t kSlowCmdScoreMax = 64;
+
+  struct CmdLane {
+    bool flagged_slow = false;
+    std::atomic<int32_t> slow_score = 0;
+  };
+
+  // Idle Cmd instances of one thread, keyed by command name. Instances are
+  // put back by the thread dropping their last reference, and deleted once
+  // the thread of the pool has exited
+  class CmdPool {
+   public:
+    ~CmdPool();
+    Cmd* Take(const std::string& opt);
+    void Put(Cmd* cmd);
+    void Close();
+
+   private:
+    std::mutex mu_;
+    bool closed_ = false;
+    std::unordered_map<std::string, Cmd*> idle_;
+  };
+
   std::shared_ptr<Cmd> NewCommand(const std::string& opt);
+  static std::shared_ptr<CmdPool> GetCurrentThreadCmdPool();
 
   void InsertCurrentThreadDistributionMap();
   bool CheckCurrentThreadDistributionMapExist(const std::thread::id& tid);
 
   std::unique_ptr<CmdTable> cmds_;
+  // Commands whose Clear() and DoInitial() reset all the state of a request
+  std::unordered_set<std::string> reusable_cmds_;
+  // Filled in by the constructor, only the scores change afterwards
+  std::unordered_map<std::string, CmdLane> cmd_lanes_;
 
   std::shared_mutex map_protector_;
   std::unordered_map<std::thread::id, std::unique_ptr<PikaDataDistribution>> thread_distribution_map_;
@@ -242,6 +242,7 @@ enum CmdFlagsMask {
   kCmdFlagsMaskCacheDo = 1024,
   kCmdFlagsMaskPostDo = 2048,
   kCmdFlagsMaskSlot = 1536,
+  kCmdFlagsMaskSlow = 4096,
 };
 
 enum CmdFlags {
@@ -269,6 +270,8 @@ enum CmdFlags {
   kCmdFlagsSingleSlot = 512,
   kCmdFlagsMultiSlot = 1024,
   kCmdFlagsPreDo = 2048,
+  kCmdFlagsNoSlow = 0,  // default fast
+  kCmdFlagsSlow = 4096,
 };
 
 void inline RedisAppendContent(std::string& str, const std::string& value);
@@ -478,14 +481,23 @@ class Cmd : public std::enable_shared_from_this<Cmd> {
   // used for execute multikey command into different slots
   virtual void Split(std::shared_ptr<Slot> slot, const HintKeys& hint_keys) = 0;
   virtual void Merge() = 0;
+  // A replica writes the consecutive commands of a slot that only put plain
+  // string values with a single Storage::MSet. Such a command appends its
+  // values to kvs and returns true, and DoMergedWrite is called in place of
+  // Do with the status of the write
+  virtual bool AppendStringWrites(std::vector<storage::KeyValue>* kvs) const { return false; }
+  virtual void DoMergedWrite(const std::shared_ptr<Slot>& slot, const storage::Status& s) {}
 
   void Initial(const PikaCmdArgsType& argv, const std::string& db_name);
+  void Initial(PikaCmdArgsType&& argv, const std::string& db_name);
 
   bool is_read() const;
   bool is_write() const;
 
   bool is_local() const;
   bool is_suspend() const;
+  // Run on the slow lane, see PikaCmdTableManager::IsSlowCmd
+  bool is_slow() const;
   bool is_admin_require() const;
   bool is_single_slot() const;
   bool is_multi_slot() const;
@@ -539,6 +551,8 @@ class Cmd : public std::enable_shared_from_this<Cmd> {
  private:
   virtual void DoInitial() = 0;
   virtual void Clear(){};
+  // Resets the state left by the previous request, instances are reused
+  void InternalInitial(const std::string& db_name);
 
   Cmd& operator=(const Cmd&);
 };
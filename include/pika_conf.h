@@ -21,6 +21,7 @@
 
 #define kBinlogReadWinDefaultSize 9000
 #define kBinlogReadWinMaxSize 90000
+#define kBinlogReadWinDefaultBytes (1LL << 30)
 const uint32_t configRunIDSize = 40;
 const uint32_t configReplicationIDSize = 50;
 
@@ -55,10 +56,42 @@ class PikaConf : public pstd::BaseConf {
     std::shared_lock l(rwlock_);
     return thread_pool_size_;
   }
+  bool thread_pool_work_stealing() {
+    std::shared_lock l(rwlock_);
+    return thread_pool_work_stealing_;
+  }
+  int slow_cmd_thread_pool_size() {
+    std::shared_lock l(rwlock_);
+    return slow_cmd_thread_pool_size_;
+  }
+  int slow_cmd_max_queue_size() {
+    std::shared_lock l(rwlock_);
+    return slow_cmd_max_queue_size_;
+  }
+  int64_t reply_zerocopy_threshold() {
+    std::shared_lock l(rwlock_);
+    return reply_zerocopy_threshold_;
+  }
+  int pubsub_thread_num() {
+    std::shared_lock l(rwlock_);
+    return pubsub_thread_num_;
+  }
+  int64_t pubsub_output_buffer_limit() {
+    std::shared_lock l(rwlock_);
+    return pubsub_output_buffer_limit_;
+  }
   int sync_thread_num() {
     std::shared_lock l(rwlock_);
     return sync_thread_num_;
   }
+  int db_open_threads() {
+    std::shared_lock l(rwlock_);
+    return db_open_threads_;
+  }
+  int replica_apply_batch_size() {
+    std::shared_lock l(rwlock_);
+    return replica_apply_batch_size_;
+  }
   std::string log_path() {
     std::shared_lock l(rwlock_);
     return log_path_;
@@ -220,6 +253,35 @@ class PikaConf : public pstd::BaseConf {
     std::shared_lock l(rwlock_);
     return small_compaction_threshold_;
   }
+  bool zset_rank_index() {
+    std::shared_lock l(rwlock_);
+    return zset_rank_index_;
+  }
+  bool exact_key_statistics() {
+    std::shared_lock l(rwlock_);
+    return exact_key_statistics_;
+  }
+  std::string list_chunk_size() {
+    std::shared_lock l(rwlock_);
+    return list_chunk_size_;
+  }
+  int active_expire_cycle_ms() {
+    std::shared_lock l(rwlock_);
+    return active_expire_cycle_ms_;
+  }
+  int active_expire_batch_size() {
+    std::shared_lock l(rwlock_);
+    return active_expire_batch_size_;
+  }
+  int64_t value_cache_size() {
+    std::shared_lock l(rwlock_);
+    return value_cache_size_;
+  }
+  int list_chunk_size(const std::string& db_name) {
+    std::shared_lock l(rwlock_);
+    auto iter = list_chunk_sizes_.find(db_name);
+    return iter != list_chunk_sizes_.end() ? iter->second : default_list_chunk_size_;
+  }
   int max_background_flushes() {
     std::shared_lock l(rwlock_);
     return max_background_flushes_;
@@ -307,6 +369,11 @@ class PikaConf : public pstd::BaseConf {
     return network_interface_;
   }
   int sync_window_size() { return sync_window_size_.load(); }
+  int64_t sync_window_bytes() { return sync_window_bytes_.load(); }
+  std::string replication_compression() {
+    std::shared_lock l(rwlock_);
+    return replication_compression_;
+  }
   int max_conn_rbuf_size() { return max_conn_rbuf_size_.load(); }
   int consensus_level() { return consensus_level_.load(); }
   int replication_num() { return replication_num_.load(); }
@@ -350,6 +417,9 @@ class PikaConf : public pstd::BaseConf {
   bool daemonize() { return daemonize_; }
   std::string pidfile() { return pidfile_; }
   int binlog_file_size() { return binlog_file_size_; }
+  bool binlog_group_commit() { return binlog_group_commit_; }
+  int64_t binlog_group_commit_max_bytes() { return binlog_group_commit_max_bytes_; }
+  bool binlog_sync_on_commit() { return binlog_sync_on_commit_; }
   PikaMeta* local_meta() { return local_meta_.get(); }
   std::vector<rocksdb::CompressionType> compression_per_level();
   std::string compression_all_levels() const { return compression_per_level_; };
@@ -531,6 +601,10 @@ class PikaConf : public pstd::BaseConf {
     TryPushDiffCommands("sync-window-size", std::to_string(value));
     sync_window_size_.store(value);
   }
+  void SetSyncWindowBytes(const int64_t& value) {
+    TryPushDiffCommands("sync-window-bytes", std::to_string(value));
+    sync_window_bytes_.store(value);
+  }
   void SetMaxConnRbufSize(const int& value) {
     TryPushDiffCommands("max-conn-rbuf-size", std::to_string(value));
     max_conn_rbuf_size_.store(value);
@@ -606,7 +680,15 @@ class PikaConf : public pstd::BaseConf {
   int slave_priority_ = 0;
   int thread_num_ = 0;
   int thread_pool_size_ = 0;
+  bool thread_pool_work_stealing_ = false;
+  int slow_cmd_thread_pool_size_ = 1;
+  int slow_cmd_max_queue_size_ = 100000;
+  int64_t reply_zerocopy_threshold_ = 0;
+  int pubsub_thread_num_ = 1;
+  int64_t pubsub_output_buffer_limit_ = 32 * 1024 * 1024;
   int sync_thread_num_ = 0;
+  int replica_apply_batch_size_ = 128;
+  int db_open_threads_ = 4;
   std::string log_path_;
   std::string log_level_;
   std::string db_path_;
@@ -660,6 +742,14 @@ class PikaConf : public pstd::BaseConf {
 
   int max_cache_statistic_keys_ = 0;
   int small_compaction_threshold_ = 0;
+  bool zset_rank_index_ = false;
+  bool exact_key_statistics_ = false;
+  std::string list_chunk_size_;
+  int default_list_chunk_size_ = 0;
+  std::map<std::string, int> list_chunk_sizes_;
+  int active_expire_cycle_ms_ = 100;
+  int active_expire_batch_size_ = 256;
+  int64_t value_cache_size_ = 0;
   int max_background_flushes_ = 0;
   int max_background_compactions_ = 0;
   int max_background_jobs_ = 0;
@@ -679,6 +769,8 @@ class PikaConf : public pstd::BaseConf {
   bool rate_limiter_auto_tuned_ = true;
 
   std::atomic<int> sync_window_size_;
+  std::atomic<int64_t> sync_window_bytes_;
+  std::string replication_compression_ = "none";
   std::atomic<int> max_conn_rbuf_size_;
   std::atomic<int> consensus_level_;
   std::atomic<int> replication_num_;
@@ -695,6 +787,9 @@ class PikaConf : public pstd::BaseConf {
   bool write_binlog_ = false;
   int target_file_size_base_ = 0;
   int binlog_file_size_ = 0;
+  bool binlog_group_commit_ = false;
+  int64_t binlog_group_commit_max_bytes_ = 1024 * 1024;  // 1M
+  bool binlog_sync_on_commit_ = false;
 
   // rocksdb blob
   bool enable_blob_files_ = false;
@@ -60,6 +60,12 @@ class DB : public std::enable_shared_from_this<DB>, public pstd::noncopyable {
   void StopKeyScan();
   void ScanDatabase(const storage::DataType& type);
   KeyScanInfo GetKeyScanInfo();
+  // Sums the keyspace statistics the slots keep up to date, returns false if
+  // any of them is an estimate
+  bool GetKeyStatistics(std::vector<storage::KeyInfo>* key_infos);
+  uint64_t GetActiveExpiredKeys();
+  // Adds the value cache statistics of every slot to info
+  void AddValueCacheInfo(storage::ValueCacheInfo* info);
   pstd::Status GetSlotsKeyScanInfo(std::map<uint32_t, KeyScanInfo>* infos);
 
   // Compact use;
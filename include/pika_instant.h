@@ -14,6 +14,9 @@ inline const std::string STATS_METRIC_NET_INPUT = "stats_metric_net_input";
 inline const std::string STATS_METRIC_NET_OUTPUT = "stats_metric_net_output";
 inline const std::string STATS_METRIC_NET_INPUT_REPLICATION = "stats_metric_net_input_replication";
 inline const std::string STATS_METRIC_NET_OUTPUT_REPLICATION = "stats_metric_net_output_replication";
+inline const std::string STATS_METRIC_REPL_APPLY = "stats_metric_repl_apply";
+inline const std::string STATS_METRIC_REPL_BINLOG_SENT = "stats_metric_repl_binlog_sent";
+inline const std::string STATS_METRIC_REPL_BINLOG_RECV = "stats_metric_repl_binlog_recv";
 
 /* The following two are used to track instantaneous metrics, like
 * number of operations per second, network traffic. */
@@ -26,10 +26,14 @@ class SetCmd : public Cmd {
   void Do(std::shared_ptr<Slot> slot = nullptr) override;
   void Split(std::shared_ptr<Slot> slot, const HintKeys& hint_keys) override {};
   void Merge() override {};
+  bool AppendStringWrites(std::vector<storage::KeyValue>* kvs) const override;
+  void DoMergedWrite(const std::shared_ptr<Slot>& slot, const storage::Status& s) override;
   Cmd* Clone() override { return new SetCmd(*this); }
  private:
+  // The value is read from argv_, big values are not copied
+  const std::string& value() const { return argv_[2]; }
+
   std::string key_;
-  std::string value_;
   std::string target_;
   int32_t success_ = 0;
   int64_t sec_ = 0;
@@ -75,6 +79,7 @@ class DelCmd : public Cmd {
   std::vector<std::string> keys_;
   int64_t split_res_ = 0;
   void DoInitial() override;
+  void Clear() override { split_res_ = 0; }
 };
 
 class IncrCmd : public Cmd {
@@ -342,12 +347,15 @@ class MsetCmd : public Cmd {
   }
   void Split(std::shared_ptr<Slot> slot, const HintKeys& hint_keys) override;
   void Merge() override;
+  bool AppendStringWrites(std::vector<storage::KeyValue>* kvs) const override;
+  void DoMergedWrite(const std::shared_ptr<Slot>& slot, const storage::Status& s) override;
   Cmd* Clone() override { return new MsetCmd(*this); }
   void DoBinlog(const std::shared_ptr<SyncMasterSlot>& slot) override;
 
  private:
   std::vector<storage::KeyValue> kvs_;
   void DoInitial() override;
+  void Clear() override { kvs_.clear(); }
   // used for write binlog
   std::shared_ptr<SetCmd> set_cmd_;
 };
@@ -453,6 +461,7 @@ class ExistsCmd : public Cmd {
   std::vector<std::string> keys_;
   int64_t split_res_ = 0;
   void DoInitial() override;
+  void Clear() override { split_res_ = 0; }
 };
 
 class ExpireCmd : public Cmd {
@@ -132,6 +132,7 @@ class LPopCmd : public Cmd {
   std::string key_;
   std::int64_t count_ = 1;
   void DoInitial() override;
+  void Clear() override { count_ = 1; }
 };
 
 
@@ -290,6 +291,7 @@ class RPopCmd : public Cmd {
   std::string key_;
   std::int64_t count_ = 1;
   void DoInitial() override;
+  void Clear() override { count_ = 1; }
 };
 
 class RPopLPushCmd : public BlockingBaseCmd {
@@ -6,8 +6,12 @@
 #ifndef PIKA_REPL_BGWROKER_H_
 #define PIKA_REPL_BGWROKER_H_
 
+#include <atomic>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "net/include/bg_thread.h"
 #include "net/include/pb_conn.h"
@@ -18,15 +22,46 @@
 #include "include/pika_binlog_transverter.h"
 #include "include/pika_command.h"
 
+struct ReplClientWriteDBTaskArg;
+
 class PikaReplBgWorker {
  public:
   explicit PikaReplBgWorker(int queue_size);
+  ~PikaReplBgWorker();
   int StartThread();
   int StopThread();
   void Schedule(net::TaskFunc func, void* arg);
   void QueueClear();
   static void HandleBGWorkerWriteBinlog(void* arg);
+
+  /*
+   * Commands to apply are queued up on the worker, which drains them in
+   * batches of up to replica-apply-batch-size, taking the lock of a slot once
+   * for all the consecutive commands of that slot instead of once for every
+   * command, and writing the consecutive plain string writes among them with
+   * one WriteBatch. A command is only handed to a worker once the commands
+   * before it sharing a key with it are applied, see PikaReplClient, and the
+   * worker finishes it on the scheduler of its task_arg after applying it.
+   *
+   * The drain runs ahead of the binlog tasks of the worker, so applying the
+   * commands parsed already takes precedence over parsing more of them.
+   */
+  void ScheduleWriteDB(ReplClientWriteDBTaskArg* task_arg);
   static void HandleBGWorkerWriteDB(void* arg);
+  // Applies a batch of the queued up commands on the calling thread, returns
+  // false if there were none. The commands queued up at the same time never
+  // share a key, so they may be applied by several threads at once
+  bool ApplyWriteDB();
+
+  // The commands queued up and not applied yet, without taking the lock
+  size_t write_db_pending() const { return write_db_pending_; }
+  uint64_t applied_cmds() const { return applied_cmds_; }
+  uint64_t applied_batches() const { return applied_batches_; }
+  // The commands written together with others by one WriteBatch
+  uint64_t merged_cmds() const { return merged_cmds_; }
+  // The commands queued up and not applied yet, and since when the oldest of
+  // them waits
+  void WriteDBQueueStatus(size_t* pending, uint64_t* oldest_enqueue_us);
 
   BinlogItem binlog_item_;
   net::RedisParser redis_parser_;
@@ -35,6 +70,24 @@ class PikaReplBgWorker {
   uint32_t slot_id_ = 0;
 
  private:
+  struct PendingWriteDB {
+    std::unique_ptr<ReplClientWriteDBTaskArg> task_arg;
+    uint64_t enqueue_us;
+  };
+
+  void ApplyWriteDBBatch(std::vector<std::unique_ptr<ReplClientWriteDBTaskArg>>* batch);
+  void ScheduleWriteDBDrain();
+
+  // Declared before bg_thread_, which has to stop before they are gone
+  std::mutex write_db_mu_;
+  std::deque<PendingWriteDB> write_db_queue_;
+  // Whether a HandleBGWorkerWriteDB is scheduled on bg_thread_ already
+  bool write_db_scheduled_ = false;
+  std::atomic<size_t> write_db_pending_ = 0;
+  std::atomic<uint64_t> applied_cmds_ = 0;
+  std::atomic<uint64_t> applied_batches_ = 0;
+  std::atomic<uint64_t> merged_cmds_ = 0;
+
   net::BGThread bg_thread_;
   static int HandleWriteBinlog(net::RedisParser* parser, const net::RedisCmdArgsType& argv);
   static void ParseBinlogOffset(const InnerMessage::BinlogOffset& pb_offset, LogOffset* offset);
@@ -6,6 +6,7 @@
 #ifndef PIKA_REPL_CLIENT_H_
 #define PIKA_REPL_CLIENT_H_
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <utility>
@@ -13,8 +14,10 @@
 #include "net/include/client_thread.h"
 #include "net/include/net_conn.h"
 #include "net/include/thread_pool.h"
+#include "pstd/include/key_dependency_scheduler.h"
 #include "pstd/include/pstd_status.h"
 
+#include "include/pika_binlog_compression.h"
 #include "include/pika_binlog_reader.h"
 #include "include/pika_define.h"
 #include "include/pika_repl_bgworker.h"
@@ -48,6 +51,10 @@ struct ReplClientWriteDBTaskArg {
   LogOffset offset;
   std::string db_name;
   uint32_t slot_id;
+  // Set once the command is ready to apply, the worker finishes dep_task on
+  // the scheduler after applying it
+  pstd::KeyDependencyScheduler* scheduler = nullptr;
+  pstd::KeyDependencyScheduler::Task* dep_task = nullptr;
   ReplClientWriteDBTaskArg(std::shared_ptr<Cmd> _cmd_ptr, const LogOffset& _offset, std::string _db_name,
                            uint32_t _slot_id)
       : cmd_ptr(std::move(_cmd_ptr)),
@@ -71,8 +78,28 @@ class PikaReplClient {
   void Schedule(net::TaskFunc func, void* arg);
   void ScheduleWriteBinlogTask(const std::string& db_slot, const std::shared_ptr<InnerMessage::InnerResponse>& res, 
                                const std::shared_ptr<net::PbConn>& conn, void* res_private_data);
+  /*
+   * The commands of every slot are applied by all the workers in parallel.
+   * A command waits for the commands before it that share a key with it, as
+   * told by current_key, and one whose keys are unknown, or a suspend one,
+   * waits for every command before it and holds back every command after it.
+   *
+   * At most PIKA_SYNC_BUFFER_SIZE commands a worker are parsed ahead of the
+   * ones applied. Past that the caller applies queued up commands itself, or
+   * waits for the workers, before it submits another one.
+   */
   void ScheduleWriteDBTask(const std::shared_ptr<Cmd>& cmd_ptr, const LogOffset& offset, const std::string& db_name,
                            uint32_t slot_id);
+  // Summed up over the workers applying the commands, lag_us is how long the
+  // oldest command not applied yet waits
+  void GetWriteDBStatus(uint64_t* applied_cmds, uint64_t* applied_batches, size_t* pending, uint64_t* lag_us);
+  // The commands that had to wait for another one, and those that waited for
+  // every one before them
+  void GetWriteDBDependencyStatus(uint64_t* waited, uint64_t* barriers);
+  // The commands written together with others by one WriteBatch, and the
+  // commands whose submission had to wait for the ones in flight
+  void GetWriteDBMergeStatus(uint64_t* merged, uint64_t* throttled);
+  BinlogCompressionStats& recv_stats() { return recv_stats_; }
 
   pstd::Status SendMetaSync();
   pstd::Status SendSlotDBSync(const std::string& ip, uint32_t port, const std::string& db_name, uint32_t slot_id,
@@ -87,12 +114,19 @@ class PikaReplClient {
 
  private:
   size_t GetHashIndex(const std::string& key, bool upper_half);
+  void DispatchWriteDBTask(pstd::KeyDependencyScheduler::Task* task, void* arg);
+  void ThrottleWriteDB();
   void UpdateNextAvail() { next_avail_ = (next_avail_ + 1) % static_cast<int32_t>(bg_workers_.size()); }
 
   std::unique_ptr<PikaReplClientThread> client_thread_;
   int next_avail_ = 0;
   std::hash<std::string> str_hash;
+  // Outlives bg_workers_, which finish its tasks until they stop
+  std::unique_ptr<pstd::KeyDependencyScheduler> write_db_scheduler_;
+  std::atomic<size_t> next_write_db_worker_ = 0;
+  std::atomic<uint64_t> write_db_throttled_ = 0;
   std::vector<std::unique_ptr<PikaReplBgWorker>> bg_workers_;
+  BinlogCompressionStats recv_stats_;
 };
 
 #endif
@@ -38,6 +38,8 @@ class PikaReplClientConn : public net::PbConn {
  private:
   // dispatch binlog by its table_name + slot
   void DispatchBinlogRes(const std::shared_ptr<InnerMessage::InnerResponse>& response);
+  // Replaces a compressed binlog sync response with the one wrapped in it
+  static bool UncompressBinlogSyncResp(InnerMessage::InnerResponse* response);
 
   struct ReplRespArg {
     std::shared_ptr<InnerMessage::InnerResponse> resp;
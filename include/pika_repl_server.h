@@ -12,6 +12,7 @@
 #include <utility>
 #include <vector>
 
+#include "include/pika_binlog_compression.h"
 #include "include/pika_command.h"
 #include "include/pika_repl_bgworker.h"
 #include "include/pika_repl_server_thread.h"
@@ -38,15 +39,26 @@ class PikaReplServer {
 
   void Schedule(net::TaskFunc func, void* arg);
   void UpdateClientConnMap(const std::string& ip_port, int fd);
+  // The compression the slave at ip_port asked for in its last TrySync
+  void UpdateClientCompression(const std::string& ip_port, InnerMessage::CompressionType compression);
   void RemoveClientConn(int fd);
   void KillAllConns();
 
+  BinlogCompressionStats& sent_stats() { return sent_stats_; }
+
  private:
+  InnerMessage::CompressionType ClientCompression(const std::string& ip, int port);
+  pstd::Status WriteBinlogChips(const std::string& ip, int port, InnerMessage::CompressionType compression,
+                                const std::string& binlog_chip_pb);
+
   std::unique_ptr<net::ThreadPool> server_tp_ = nullptr;
   std::unique_ptr<PikaReplServerThread> pika_repl_server_thread_ = nullptr;
 
   std::shared_mutex client_conn_rwlock_;
   std::map<std::string, int> client_conn_map_;
+  std::map<std::string, InnerMessage::CompressionType> client_compression_map_;
+
+  BinlogCompressionStats sent_stats_;
 };
 
 #endif
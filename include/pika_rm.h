@@ -246,9 +246,15 @@ class PikaReplicaManager {
                                const std::shared_ptr<net::PbConn>& conn, void* res_private_data);
   void ScheduleWriteDBTask(const std::shared_ptr<Cmd>& cmd_ptr, const LogOffset& offset, const std::string& db_name,
                            uint32_t slot_id);
+  void GetWriteDBStatus(uint64_t* applied_cmds, uint64_t* applied_batches, size_t* pending, uint64_t* lag_us);
+  void GetWriteDBDependencyStatus(uint64_t* waited, uint64_t* barriers);
+  void GetWriteDBMergeStatus(uint64_t* merged, uint64_t* throttled);
 
   void ReplServerRemoveClientConn(int fd);
   void ReplServerUpdateClientConnMap(const std::string& ip_port, int fd);
+  void ReplServerUpdateClientCompression(const std::string& ip_port, InnerMessage::CompressionType compression);
+  BinlogCompressionStats& BinlogSentStats();
+  BinlogCompressionStats& BinlogRecvStats();
 
   std::shared_mutex& GetSlotLock() { return slots_rw_; }
   void SlotLock() {
@@ -151,6 +151,7 @@ class PikaServer : public pstd::noncopyable {
   std::string host();
   int port();
   time_t start_time_s();
+  uint64_t db_open_time_ms();
   std::string master_ip();
   std::string master_run_id();
   void set_master_run_id(const std::string& master_run_id);
@@ -252,11 +253,16 @@ class PikaServer : public pstd::noncopyable {
   /*
    * PikaClientProcessor Process Task
    */
-  void ScheduleClientPool(net::TaskFunc func, void* arg);
+  // Slow commands go to a thread pool of their own if there is one
+  void ScheduleClientPool(net::TaskFunc func, void* arg, bool is_slow_cmd = false);
   void ScheduleClientBgThreads(net::TaskFunc func, void* arg, const std::string& hash_str);
   // for info debug
   size_t ClientProcessorThreadPoolCurQueueSize();
   size_t ClientProcessorThreadPoolMaxQueueSize();
+  size_t SlowCmdThreadPoolCurQueueSize();
+  size_t SlowCmdThreadPoolMaxQueueSize();
+  uint64_t ClientPoolTasks() { return client_pool_tasks_.load(); }
+  uint64_t SlowCmdPoolTasks() { return slow_cmd_pool_tasks_.load(); }
 
   /*
    * BGSave used
@@ -337,6 +343,10 @@ class PikaServer : public pstd::noncopyable {
   float InstantaneousOutputKbps();
   float InstantaneousInputReplKbps();
   float InstantaneousOutputReplKbps();
+  double InstantaneousReplApplyOps();
+  // Of the binlog before compression
+  float InstantaneousBinlogSentKbps();
+  float InstantaneousBinlogRecvKbps();
 
   /*
    * Slave to Master communication used
@@ -535,11 +545,14 @@ class PikaServer : public pstd::noncopyable {
   void AutoDeleteExpiredDump();
   void AutoKeepAliveRSync();
   void AutoUpdateNetworkMetric();
+  void AutoUpdateReplicationMetric();
   void PrintThreadPoolQueueStatus();
   
   std::string host_;
   int port_ = 0;
   time_t start_time_s_ = 0;
+  // How long opening every db took on startup
+  uint64_t db_open_time_ms_ = 0;
 
   std::shared_mutex storage_options_rw_;
   storage::StorageOptions storage_options_;
@@ -571,6 +584,10 @@ class PikaServer : public pstd::noncopyable {
    */
   int worker_num_ = 0;
   std::unique_ptr<PikaClientProcessor> pika_client_processor_;
+  // nullptr if slow-cmd-thread-pool-size is 0
+  std::unique_ptr<net::ThreadPool> pika_slow_cmd_thread_pool_;
+  std::atomic<uint64_t> client_pool_tasks_ = 0;
+  std::atomic<uint64_t> slow_cmd_pool_tasks_ = 0;
   std::unique_ptr<PikaDispatchThread> pika_dispatch_thread_ = nullptr;
 
   /*
@@ -32,6 +32,7 @@ class ZAddCmd : public Cmd {
   std::string key_;
   std::vector<storage::ScoreMember> score_members;
   void DoInitial() override;
+  void Clear() override { score_members.clear(); }
 };
 
 class ZCardCmd : public Cmd {
@@ -0,0 +1,131 @@
+// Copyright (c) 2015-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "net/include/net_pubsub.h"
+#include "net/include/net_stats.h"
+#include "net/include/redis_conn.h"
+
+extern std::unique_ptr<net::NetworkStatistic> g_network_statistic;
+
+using net::PubSubThread;
+using net::RedisConn;
+
+static uint64_t NowMicros() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  return static_cast<uint64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+class SubscriberConn : public RedisConn {
+ public:
+  SubscriberConn(int fd, const std::string& ip_port) : RedisConn(fd, ip_port, nullptr) {}
+  int DealMessage(const net::RedisCmdArgsType& argv, std::string* response) override { return 0; }
+  const std::string& GetCurrentTable() override { return table_; }
+
+ private:
+  std::string table_;
+};
+
+// Publishers publish to one channel with subscriber_num subscribers spread
+// over thread_num pubsub threads
+static void Benchmark(int thread_num, int publisher_num, int subscriber_num, int msgs, size_t msg_len) {
+  PubSubThread pubsub(thread_num);
+  pubsub.StartThread();
+
+  const std::string channel = "bench";
+  const std::string msg(msg_len, 'm');
+  const size_t resp_len =
+      std::string("*3\r\n$7\r\nmessage\r\n$" + std::to_string(channel.size()) + "\r\n" + channel + "\r\n$" +
+                  std::to_string(msg.size()) + "\r\n" + msg + "\r\n")
+          .size();
+
+  std::vector<int> client_fds;
+  std::vector<std::shared_ptr<SubscriberConn>> conns;
+  for (int i = 0; i < subscriber_num; i++) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+      std::cout << "socketpair failed" << std::endl;
+      exit(-1);
+    }
+    auto conn = std::make_shared<SubscriberConn>(fds[0], "subscriber:" + std::to_string(i));
+    conn->SetNonblock();
+    conn->set_is_writable(true);
+    std::vector<std::pair<std::string, int>> result;
+    pubsub.Subscribe(conn, {channel}, false, &result);
+    pubsub.UpdateConnReadyState(fds[0], PubSubThread::ReadyState::kReady);
+    conns.push_back(conn);
+    client_fds.push_back(fds[1]);
+  }
+
+  uint64_t start = NowMicros();
+  std::vector<std::thread> readers;
+  for (int fd : client_fds) {
+    readers.emplace_back([fd, expect = resp_len * msgs * publisher_num]() {
+      char buf[64 * 1024];
+      size_t received = 0;
+      while (received < expect) {
+        ssize_t nread = read(fd, buf, sizeof(buf));
+        if (nread <= 0) {
+          break;
+        }
+        received += nread;
+      }
+    });
+  }
+  std::atomic<uint64_t> receivers{0};
+  std::vector<std::thread> publishers;
+  for (int i = 0; i < publisher_num; i++) {
+    publishers.emplace_back([&]() {
+      for (int j = 0; j < msgs; j++) {
+        receivers += pubsub.Publish(channel, msg);
+      }
+    });
+  }
+  for (auto& publisher : publishers) {
+    publisher.join();
+  }
+  uint64_t publish_cost = NowMicros() - start;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  uint64_t cost = NowMicros() - start;
+
+  uint64_t published = static_cast<uint64_t>(msgs) * publisher_num;
+  std::cout << "threads " << thread_num << ", publishers " << publisher_num << ", subscribers " << subscriber_num
+            << ", msg " << msg_len << " bytes: publish " << (publish_cost != 0 ? published * 1000000 / publish_cost : 0)
+            << " msgs/s, deliver " << (cost != 0 ? receivers.load() * 1000000 / cost : 0) << " msgs/s" << std::endl;
+
+  pubsub.StopThread();
+  for (int fd : client_fds) {
+    close(fd);
+  }
+}
+
+int main(int argc, char* argv[]) {
+  g_network_statistic = std::make_unique<net::NetworkStatistic>();
+  int msgs = argc > 1 ? atoi(argv[1]) : 100000;
+  int max_threads = argc > 2 ? atoi(argv[2]) : 4;
+
+  for (int thread_num = 1; thread_num <= max_threads; thread_num *= 2) {
+    for (int publisher_num : {1, 8}) {
+      for (int subscriber_num : {1, 16}) {
+        Benchmark(thread_num, publisher_num, subscriber_num, msgs / publisher_num, 64);
+      }
+    }
+  }
+  return 0;
+}
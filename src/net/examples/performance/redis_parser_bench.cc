@@ -0,0 +1,92 @@
+// Copyright (c) 2015-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#include <sys/time.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "net/include/redis_parser.h"
+
+using net::RedisCmdArgsType;
+using net::RedisParser;
+
+static uint64_t NowMicros() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  return static_cast<uint64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+static uint64_t parsed_cmds = 0;
+
+static int Complete(RedisParser* parser, std::vector<RedisCmdArgsType>& argvs) {
+  parsed_cmds += argvs.size();
+  return 0;
+}
+
+static std::string MultibulkSet(int i, size_t value_len) {
+  std::string key = "key:" + std::to_string(i);
+  std::string value(value_len, 'v');
+  return "*3\r\n$3\r\nSET\r\n$" + std::to_string(key.size()) + "\r\n" + key + "\r\n$" + std::to_string(value.size()) +
+         "\r\n" + value + "\r\n";
+}
+
+static std::string InlineSet(int i, size_t value_len) {
+  return "SET key:" + std::to_string(i) + " " + std::string(value_len, 'v') + "\r\n";
+}
+
+// Feeds the pipeline in reads of read_len bytes like RedisConn does, returns commands per second
+static uint64_t Benchmark(const std::string& pipeline, size_t read_len, int rounds) {
+  net::RedisParserSettings settings;
+  settings.Complete = Complete;
+  RedisParser parser;
+  parser.RedisParserInit(REDIS_PARSER_REQUEST, settings);
+
+  parsed_cmds = 0;
+  uint64_t start = NowMicros();
+  for (int r = 0; r < rounds; r++) {
+    size_t pos = 0;
+    while (pos < pipeline.size()) {
+      int len = static_cast<int>(std::min(read_len, pipeline.size() - pos));
+      int parsed_len = 0;
+      if (parser.ProcessInputBuffer(pipeline.data() + pos, len, &parsed_len) != net::kRedisParserDone &&
+          parser.get_error_code() != net::kRedisParserOk) {
+        std::cout << "parse error " << parser.get_error_code() << std::endl;
+        return 0;
+      }
+      pos += len;
+    }
+  }
+  uint64_t cost = NowMicros() - start;
+  return cost != 0 ? parsed_cmds * 1000000 / cost : 0;
+}
+
+int main(int argc, char* argv[]) {
+  int cmds = argc > 1 ? atoi(argv[1]) : 10000;
+  int rounds = argc > 2 ? atoi(argv[2]) : 100;
+
+  for (size_t value_len : {8, 64, 512, 4096, 262144}) {
+    std::string multibulk;
+    std::string inline_cmds;
+    // Keep each pipeline within 64MB
+    int value_cmds = std::min(cmds, static_cast<int>((64 << 20) / value_len));
+    for (int i = 0; i < value_cmds; i++) {
+      multibulk.append(MultibulkSet(i, value_len));
+      // Inline commands are limited to REDIS_INLINE_MAXLEN
+      if (value_len < REDIS_INLINE_MAXLEN / 2) {
+        inline_cmds.append(InlineSet(i, value_len));
+      }
+    }
+    for (size_t read_len : {1024, 16 * 1024}) {
+      uint64_t multibulk_qps = Benchmark(multibulk, read_len, rounds);
+      uint64_t inline_qps = inline_cmds.empty() ? 0 : Benchmark(inline_cmds, read_len, rounds);
+      std::cout << "value " << value_len << " bytes, read " << read_len << " bytes, multibulk " << multibulk_qps
+                << " cmds/s, inline " << inline_qps << " cmds/s" << std::endl;
+    }
+  }
+  return 0;
+}
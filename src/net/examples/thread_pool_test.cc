@@ -7,10 +7,16 @@
 
 #include <pthread.h>
 #include <sys/time.h>
+#include <atomic>
+#include <cstring>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "net/include/thread_pool.h"
+#include "net/include/work_stealing_thread_pool.h"
 #include "pstd/include/pstd_mutex.h"
 
 using namespace std;
@@ -33,7 +39,55 @@ void task(void* arg) {
   sleep(1);
 }
 
-int main() {
+static std::atomic<uint64_t> bench_done(0);
+
+void bench_task(void* arg) { bench_done.fetch_add(1, std::memory_order_relaxed); }
+
+// producers threads schedule tasks_per_producer empty tasks each, returns tasks per second
+uint64_t Benchmark(net::ThreadPool* pool, int producers, int tasks_per_producer) {
+  bench_done.store(0);
+  pool->start_thread_pool();
+  uint64_t start = NowMicros();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < producers; i++) {
+    threads.emplace_back([pool, tasks_per_producer]() {
+      for (int j = 0; j < tasks_per_producer; j++) {
+        pool->Schedule(bench_task, nullptr);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  uint64_t total = static_cast<uint64_t>(producers) * tasks_per_producer;
+  while (bench_done.load() < total) {
+    std::this_thread::yield();
+  }
+  uint64_t cost = NowMicros() - start;
+  pool->stop_thread_pool();
+  return cost != 0 ? total * 1000000 / cost : 0;
+}
+
+void RunBenchmark() {
+  const int kWorkers = 12;
+  const int kTasks = 200000;
+  std::cout << "Benchmark " << kWorkers << " workers, " << kTasks << " tasks per producer" << std::endl;
+  for (int producers : {1, 4, 16, 48}) {
+    net::ThreadPool pool(kWorkers, 100000);
+    net::WorkStealingThreadPool ws_pool(kWorkers, 100000);
+    uint64_t qps = Benchmark(&pool, producers, kTasks);
+    uint64_t ws_qps = Benchmark(&ws_pool, producers, kTasks);
+    std::cout << " producers: " << producers << ", ThreadPool: " << qps
+              << " tasks/s, WorkStealingThreadPool: " << ws_qps << " tasks/s" << std::endl;
+  }
+}
+
+int main(int argc, char* argv[]) {
+  if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+    RunBenchmark();
+    return 0;
+  }
+
   // 10 threads
   net::ThreadPool t(10, 1000), t2(10, 5);
   t.start_thread_pool();
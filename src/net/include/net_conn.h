@@ -46,8 +46,12 @@ class NetConn : public std::enable_shared_from_this<NetConn>, public pstd::nonco
   virtual ReadStatus GetRequest() = 0;
   virtual WriteStatus SendReply() = 0;
   virtual int WriteResp(const std::string& resp) { return 0; }
+  // Bytes of the replies written but not sent yet
+  virtual size_t PendingReplySize() const { return 0; }
 
   virtual void TryResizeBuffer() {}
+  // Called on an error event, true if the connection consumed it and stays open
+  virtual bool HandleErrorEvent() { return false; }
 
   int flags() const { return flags_; }
 
@@ -10,12 +10,14 @@
 #include <atomic>
 #include <functional>
 #include <map>
+#include <memory>
 #include <queue>
 #include <set>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "pstd/include/noncopyable.h"
 #include "pstd/include/pstd_mutex.h"
 #include "pstd/include/pstd_string.h"
 #include "pstd/include/xdebug.h"
@@ -29,14 +31,27 @@ namespace net {
 class NetFiredEvent;
 class NetConn;
 
-class PubSubThread : public Thread {
+/*
+ * Subscribers are spread over several event loop threads by fd, every
+ * thread keeps the channel and pattern registries of its own connections.
+ * Publish collects the receivers from the registries, pushes the message to
+ * the threads owning them through lock free queues and returns at once, the
+ * threads write the messages out and batch the sends of every connection.
+ */
+class PubSubThread : public pstd::noncopyable {
  public:
-  PubSubThread();
+  // A subscriber whose unsent messages would exceed max_pending_bytes is
+  // disconnected, 0 means no limit
+  explicit PubSubThread(int thread_num = 1, size_t max_pending_bytes = 0);
 
-  ~PubSubThread() override;
+  ~PubSubThread();
+
+  int StartThread();
+  int StopThread();
 
   // PubSub
 
+  // Returns the number of subscribers the message is queued for
   int Publish(const std::string& channel, const std::string& msg);
 
   void Subscribe(const std::shared_ptr<NetConn>& conn, const std::vector<std::string>& channels, bool pattern,
@@ -51,11 +66,6 @@ class PubSubThread : public Thread {
 
   int PubSubNumPat();
 
-  // Move out from pubsub thread
-  void MoveConnOut(const std::shared_ptr<NetConn>& conn);
-  // Move into pubsub thread
-  void MoveConnIn(const std::shared_ptr<NetConn>& conn, const NotifyType& notify_type);
-
   enum ReadyState {
     kNotReady,
     kReady,
@@ -74,47 +84,11 @@ class PubSubThread : public Thread {
   bool IsReady(int fd);
 
  private:
-  void RemoveConn(const std::shared_ptr<NetConn>& conn);
-
-  int ClientChannelSize(const std::shared_ptr<NetConn>& conn);
-
-  int msg_pfd_[2];
-  bool should_exit_;
-
-  mutable pstd::RWMutex rwlock_; /* For external statistics */
-  std::map<int, std::shared_ptr<ConnHandle>> conns_;
-
-  pstd::Mutex pub_mutex_;
-  pstd::CondVar receiver_rsignal_;
-  pstd::Mutex receiver_mutex_;
-
-  /*
-   * receive fd from worker thread
-   */
-  pstd::Mutex mutex_;
-  std::queue<NetItem> queue_;
-
-  std::string channel_;
-  std::string message_;
-  int receivers_{-1};
-
-  /*
-   * The epoll handler
-   */
-  std::unique_ptr<NetMultiplexer> net_multiplexer_;
-
-  void* ThreadMain() override;
-
-  // clean conns
-  void Cleanup();
-
-  // PubSub
-  pstd::Mutex channel_mutex_;
-  pstd::Mutex pattern_mutex_;
+  class Shard;
 
-  std::map<std::string, std::vector<std::shared_ptr<NetConn>>> pubsub_channel_;  // channel <---> conns
-  std::map<std::string, std::vector<std::shared_ptr<NetConn>>> pubsub_pattern_;  // channel <---> conns
+  Shard* ShardOf(int fd) { return shards_[fd % shards_.size()].get(); }
 
+  std::vector<std::unique_ptr<Shard>> shards_;
 };  // class PubSubThread
 
 }  // namespace net
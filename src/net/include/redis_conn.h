@@ -6,8 +6,10 @@
 #ifndef NET_INCLUDE_REDIS_CONN_H_
 #define NET_INCLUDE_REDIS_CONN_H_
 
+#include <deque>
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "net/include/net_conn.h"
@@ -30,12 +32,18 @@ class RedisConn : public NetConn {
   ReadStatus GetRequest() override;
   WriteStatus SendReply() override;
   int WriteResp(const std::string& resp) override;
+  // Big replies are queued as they are and sent without being copied
+  int WriteResp(std::string&& resp);
+  size_t PendingReplySize() const override;
 
   void TryResizeBuffer() override;
+  bool HandleErrorEvent() override;
+  // Replies from this size on are sent with MSG_ZEROCOPY, 0 disables it
+  void SetZeroCopyThreshold(size_t threshold);
   void SetHandleType(const HandleType& handle_type);
   HandleType GetHandleType();
 
-  virtual void ProcessRedisCmds(const std::vector<RedisCmdArgsType>& argvs, bool async, std::string* response);
+  virtual void ProcessRedisCmds(std::vector<RedisCmdArgsType>& argvs, bool async, std::string* response);
   void NotifyEpoll(bool success);
 
   virtual int DealMessage(const RedisCmdArgsType& argv, std::string* response) = 0;
@@ -43,8 +51,12 @@ class RedisConn : public NetConn {
 
  private:
   static int ParserDealMessageCb(RedisParser* parser, const RedisCmdArgsType& argv);
-  static int ParserCompleteCb(RedisParser* parser, const std::vector<RedisCmdArgsType>& argvs);
+  static int ParserCompleteCb(RedisParser* parser, std::vector<RedisCmdArgsType>& argvs);
   ReadStatus ParseRedisParserStatus(RedisParserStatus status);
+  // Moves the replies appended to response_ into replies_
+  void FlushResponse();
+  void PopReply();
+  void CompleteZeroCopy(uint32_t lo, uint32_t hi);
 
   HandleType handle_type_ = kSynchronous;
 
@@ -54,9 +66,23 @@ class RedisConn : public NetConn {
   int msg_peak_ = 0;
   int command_len_ = 0;
 
-  uint32_t wbuf_pos_ = 0;
+  // The reply queue is replies_ followed by response_, which collects the
+  // small replies, wbuf_pos_ is the sent part of the first of them
+  size_t wbuf_pos_ = 0;
+  std::deque<std::string> replies_;
   std::string response_;
 
+  size_t zerocopy_threshold_ = 0;
+  // Notification id of the last zerocopy send of replies_.front(), -1 if none
+  int64_t front_zerocopy_id_ = -1;
+  uint32_t zerocopy_next_id_ = 0;
+  // All the sends before this id are completed
+  uint32_t zerocopy_done_id_ = 0;
+  // Completed ranges that arrived out of order
+  std::map<uint32_t, uint32_t> zerocopy_completed_;
+  // Sent replies the kernel may still read, with their last notification id
+  std::deque<std::pair<uint32_t, std::string>> zerocopy_pending_;
+
   // For Redis Protocol parser
   int last_read_pos_ = -1;
   RedisParser redis_parser_;
@@ -19,7 +19,8 @@ class RedisParser;
 
 using RedisCmdArgsType = std::vector<std::string>;
 using RedisParserDataCb = int (*)(RedisParser *, const RedisCmdArgsType &);
-using RedisParserMultiDataCb = int (*)(RedisParser *, const std::vector<RedisCmdArgsType> &);
+// The callee may move the arguments out of the parsed commands
+using RedisParserMultiDataCb = int (*)(RedisParser *, std::vector<RedisCmdArgsType> &);
 using RedisParserCb = int (*)(RedisParser *);
 using RedisParserType = int;
 
@@ -64,6 +65,9 @@ class RedisParser {
   void CacheHalfArgv();
   int FindNextSeparators();
   int GetNextNum(int pos, long* value);
+  // Parses a multibulk command that is complete in the buffer without
+  // touching the parser state, false leaves it to ProcessMultibulkBuffer
+  bool ProcessMultibulkFast();
   RedisParserStatus ProcessInlineBuffer();
   RedisParserStatus ProcessMultibulkBuffer();
   RedisParserStatus ProcessRequestBuffer();
@@ -86,6 +90,8 @@ class RedisParser {
 
   RedisCmdArgsType argv_;
   std::vector<RedisCmdArgsType> argvs_;
+  // The received part of a big bulk argument
+  std::string big_arg_;
 
   int cur_pos_ = 0;
   const char* input_buf_{nullptr};
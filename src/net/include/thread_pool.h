@@ -52,19 +52,23 @@ class ThreadPool : public pstd::noncopyable {
   explicit ThreadPool(size_t worker_num, size_t max_queue_size, std::string  thread_pool_name = "ThreadPool");
   virtual ~ThreadPool();
 
-  int start_thread_pool();
-  int stop_thread_pool();
+  virtual int start_thread_pool();
+  virtual int stop_thread_pool();
   bool should_stop();
   void set_should_stop();
 
-  void Schedule(TaskFunc func, void* arg);
-  void DelaySchedule(uint64_t timeout, TaskFunc func, void* arg);
+  virtual void Schedule(TaskFunc func, void* arg);
+  virtual void DelaySchedule(uint64_t timeout, TaskFunc func, void* arg);
   size_t max_queue_size();
   size_t worker_size();
-  void cur_queue_size(size_t* qsize);
-  void cur_time_queue_size(size_t* qsize);
+  virtual void cur_queue_size(size_t* qsize);
+  virtual void cur_time_queue_size(size_t* qsize);
   std::string thread_pool_name();
 
+ protected:
+  std::atomic<bool> running_;
+  std::atomic<bool> should_stop_;
+
  private:
   void runInThread();
 
@@ -74,8 +78,6 @@ class ThreadPool : public pstd::noncopyable {
   std::queue<Task> queue_;
   std::priority_queue<TimeTask> time_queue_;
   std::vector<Worker*> workers_;
-  std::atomic<bool> running_;
-  std::atomic<bool> should_stop_;
 
   pstd::Mutex mu_;
   pstd::CondVar rsignal_;
@@ -0,0 +1,108 @@
+// Copyright (c) 2018-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef NET_INCLUDE_WORK_STEALING_THREAD_POOL_H_
+#define NET_INCLUDE_WORK_STEALING_THREAD_POOL_H_
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "net/include/thread_pool.h"
+
+namespace net {
+
+/*
+ * A ThreadPool where every worker owns a bounded lock free queue. Schedule
+ * spreads tasks over the queues round robin and idle workers steal from the
+ * others, so producers and workers only share a mutex when somebody has to
+ * sleep. Delayed tasks wait in a timer wheel with a 1ms tick and are moved
+ * to the queues once due.
+ *
+ * Each queue holds max_queue_size / worker_num tasks rounded up to a power
+ * of two, Schedule blocks while all of them are full.
+ */
+class WorkStealingThreadPool : public ThreadPool {
+ public:
+  explicit WorkStealingThreadPool(size_t worker_num, size_t max_queue_size,
+                                  std::string thread_pool_name = "WSThreadPool");
+  ~WorkStealingThreadPool() override;
+
+  int start_thread_pool() override;
+  int stop_thread_pool() override;
+
+  void Schedule(TaskFunc func, void* arg) override;
+  void DelaySchedule(uint64_t timeout, TaskFunc func, void* arg) override;
+  void cur_queue_size(size_t* qsize) override;
+  void cur_time_queue_size(size_t* qsize) override;
+
+ private:
+  // Bounded MPMC queue, every cell carries a sequence number telling
+  // producers and consumers whose turn it is
+  class TaskQueue {
+   public:
+    explicit TaskQueue(size_t capacity);
+
+    bool Push(TaskFunc func, void* arg);
+    bool Pop(Task* task);
+    size_t size() const;
+
+   private:
+    struct Cell {
+      std::atomic<size_t> sequence;
+      TaskFunc func = nullptr;
+      void* arg = nullptr;
+    };
+
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};
+    alignas(64) std::atomic<size_t> dequeue_pos_{0};
+  };
+
+  struct TimerTask {
+    uint64_t tick;
+    TaskFunc func;
+    void* arg;
+  };
+
+  static const size_t kWheelSlots = 512;
+
+  bool TryPush(TaskFunc func, void* arg);
+  bool TryPop(size_t index, Task* task);
+  void WakeWorker();
+  void RunWorker(size_t index);
+  void RunTimer();
+
+  size_t worker_num_;
+  std::vector<std::unique_ptr<TaskQueue>> queues_;
+  std::vector<std::thread> workers_;
+  std::thread timer_;
+  std::atomic<size_t> next_queue_{0};
+
+  // Workers sleeping on park_cv_, wakeups_ are handed out to them one by one
+  std::atomic<size_t> idle_{0};
+  size_t wakeups_ = 0;
+  pstd::Mutex park_mu_;
+  pstd::CondVar park_cv_;
+
+  // Producers waiting in Schedule for a free slot
+  std::atomic<size_t> blocked_{0};
+  pstd::Mutex full_mu_;
+  pstd::CondVar full_cv_;
+
+  uint64_t current_tick_ = 0;
+  uint64_t last_tick_time_ = 0;
+  std::atomic<size_t> timer_tasks_{0};
+  std::vector<std::vector<TimerTask>> wheel_;
+  pstd::Mutex timer_mu_;
+  pstd::CondVar timer_cv_;
+};
+
+}  // namespace net
+
+#endif  // NET_INCLUDE_WORK_STEALING_THREAD_POOL_H_
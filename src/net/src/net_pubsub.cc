@@ -3,42 +3,43 @@
 // LICENSE file in the root directory of this source tree. An additional grant
 // of patent rights can be found in the PATENTS file in the same directory.
 
+#include <unistd.h>
 #include <algorithm>
-#include <sstream>
+#include <shared_mutex>
+#include <unordered_set>
 #include <vector>
 
+#include <glog/logging.h>
+
 #include "net/src/worker_thread.h"
 
 #include "net/include/net_conn.h"
 #include "net/include/net_pubsub.h"
+#include "pstd/include/pstd_glob.h"
 
 namespace net {
 
+static void AppendBulkString(std::string* resp, const std::string& str) {
+  resp->append("$");
+  resp->append(std::to_string(str.size()));
+  resp->append("\r\n");
+  resp->append(str);
+  resp->append("\r\n");
+}
+
 static std::string ConstructPublishResp(const std::string& subscribe_channel, const std::string& publish_channel,
                                         const std::string& msg, const bool pattern) {
-  std::stringstream resp;
-  std::string common_msg = "message";
-  std::string pattern_msg = "pmessage";
+  std::string resp;
+  resp.reserve(subscribe_channel.size() + publish_channel.size() + msg.size() + 64);
   if (pattern) {
-    resp << "*4\r\n"
-         << "$" << pattern_msg.length() << "\r\n"
-         << pattern_msg << "\r\n"
-         << "$" << subscribe_channel.length() << "\r\n"
-         << subscribe_channel << "\r\n"
-         << "$" << publish_channel.length() << "\r\n"
-         << publish_channel << "\r\n"
-         << "$" << msg.length() << "\r\n"
-         << msg << "\r\n";
+    resp.append("*4\r\n$8\r\npmessage\r\n");
+    AppendBulkString(&resp, subscribe_channel);
   } else {
-    resp << "*3\r\n"
-         << "$" << common_msg.length() << "\r\n"
-         << common_msg << "\r\n"
-         << "$" << publish_channel.length() << "\r\n"
-         << publish_channel << "\r\n"
-         << "$" << msg.length() << "\r\n"
-         << msg << "\r\n";
+    resp.append("*3\r\n$7\r\nmessage\r\n");
   }
-  return resp.str();
+  AppendBulkString(&resp, publish_channel);
+  AppendBulkString(&resp, msg);
+  return resp;
 }
 
 void CloseFd(const std::shared_ptr<NetConn>& conn) { close(conn->fd()); }
@@ -47,8 +48,141 @@ void PubSubThread::ConnHandle::UpdateReadyState(const ReadyState& state) { ready
 
 bool PubSubThread::ConnHandle::IsReady() { return ready_state == PubSubThread::ReadyState::kReady; }
 
-PubSubThread::PubSubThread()  {
-  set_thread_name("PubSubThread");
+/*
+ * One event loop of the PubSubThread with the connections it owns
+ */
+class PubSubThread::Shard : public Thread {
+ public:
+  Shard(int index, size_t max_pending_bytes);
+  ~Shard() override;
+
+  // Queues message for the ready subscribers of this shard, returns their number
+  int Publish(const std::shared_ptr<const std::pair<std::string, std::string>>& message);
+
+  void Subscribe(const std::shared_ptr<NetConn>& conn, const std::vector<std::string>& channels, bool pattern,
+                 std::vector<std::pair<std::string, int>>* result);
+  int UnSubscribe(const std::shared_ptr<NetConn>& conn, const std::vector<std::string>& channels, bool pattern,
+                  std::vector<std::pair<std::string, int>>* result);
+
+  void PubSubChannels(const std::string& pattern, std::set<std::string>* result);
+  int PubSubNumSub(const std::string& channel);
+  int PubSubNumPat();
+
+  void UpdateConnReadyState(int fd, const ReadyState& state);
+  bool IsReady(int fd);
+
+ private:
+  // A published message and the subscribers of this shard it goes to,
+  // the pattern is empty for the subscribers of the channel itself
+  struct Delivery {
+    std::shared_ptr<const std::pair<std::string, std::string>> message;
+    std::vector<std::pair<std::shared_ptr<NetConn>, std::string>> receivers;
+    std::atomic<Delivery*> next{nullptr};
+  };
+
+  // Intrusive MPSC queue, producers only swap the head, the shard thread
+  // is the single consumer
+  class DeliveryQueue {
+   public:
+    DeliveryQueue() : head_(&stub_), tail_(&stub_) {}
+    ~DeliveryQueue();
+
+    void Push(Delivery* delivery);
+    // Null if empty or a producer is halfway through Push, that producer
+    // wakes the shard up again once it is done
+    Delivery* Pop();
+
+   private:
+    Delivery stub_;
+    std::atomic<Delivery*> head_;
+    Delivery* tail_;
+  };
+
+  // Move out from pubsub thread
+  void MoveConnOut(const std::shared_ptr<NetConn>& conn);
+  // Move into pubsub thread
+  void MoveConnIn(const std::shared_ptr<NetConn>& conn, const NotifyType& notify_type);
+  void RemoveConn(const std::shared_ptr<NetConn>& conn);
+  void CloseConn(const std::shared_ptr<NetConn>& conn);
+  // False once conn unsubscribed from everything or was closed
+  bool IsOwnConn(const std::shared_ptr<NetConn>& conn);
+
+  int ClientChannelSize(const std::shared_ptr<NetConn>& conn);
+
+  void WakeUp();
+  void DeliverMessages();
+
+  void* ThreadMain() override;
+
+  // clean conns
+  void Cleanup();
+
+  const size_t max_pending_bytes_;
+
+  int msg_pfd_[2];
+  std::atomic<bool> notified_{false};
+  DeliveryQueue queue_;
+
+  mutable pstd::RWMutex rwlock_; /* For external statistics */
+  std::map<int, std::shared_ptr<ConnHandle>> conns_;
+
+  /*
+   * The epoll handler
+   */
+  std::unique_ptr<NetMultiplexer> net_multiplexer_;
+
+  // PubSub, publishers only take the read locks
+  pstd::RWMutex channel_mutex_;
+  pstd::RWMutex pattern_mutex_;
+
+  std::map<std::string, std::vector<std::shared_ptr<NetConn>>> pubsub_channel_;  // channel <---> conns
+  std::map<std::string, std::vector<std::shared_ptr<NetConn>>> pubsub_pattern_;  // channel <---> conns
+  // Every key of pubsub_pattern_ compiled once, guarded by pattern_mutex_
+  std::map<std::string, pstd::GlobMatcher> pattern_matchers_;
+};
+
+PubSubThread::Shard::DeliveryQueue::~DeliveryQueue() {
+  while (Delivery* delivery = Pop()) {
+    delete delivery;
+  }
+}
+
+void PubSubThread::Shard::DeliveryQueue::Push(Delivery* delivery) {
+  delivery->next.store(nullptr, std::memory_order_relaxed);
+  Delivery* prev = head_.exchange(delivery, std::memory_order_acq_rel);
+  prev->next.store(delivery, std::memory_order_release);
+}
+
+PubSubThread::Shard::Delivery* PubSubThread::Shard::DeliveryQueue::Pop() {
+  Delivery* tail = tail_;
+  Delivery* next = tail->next.load(std::memory_order_acquire);
+  if (tail == &stub_) {
+    if (next == nullptr) {
+      return nullptr;
+    }
+    tail_ = next;
+    tail = next;
+    next = next->next.load(std::memory_order_acquire);
+  }
+  if (next != nullptr) {
+    tail_ = next;
+    return tail;
+  }
+  if (tail != head_.load(std::memory_order_acquire)) {
+    return nullptr;
+  }
+  // tail is the last one, put the stub behind it so it can be taken out
+  Push(&stub_);
+  next = tail->next.load(std::memory_order_acquire);
+  if (next != nullptr) {
+    tail_ = next;
+    return tail;
+  }
+  return nullptr;
+}
+
+PubSubThread::Shard::Shard(int index, size_t max_pending_bytes) : max_pending_bytes_(max_pending_bytes) {
+  set_thread_name("PubSubThread" + std::to_string(index));
   net_multiplexer_.reset(CreateNetMultiplexer());
   net_multiplexer_->Initialize();
   if (pipe(msg_pfd_)) {
@@ -60,9 +194,13 @@ PubSubThread::PubSubThread()  {
   net_multiplexer_->NetAddEvent(msg_pfd_[0], kReadable);
 }
 
-PubSubThread::~PubSubThread() { StopThread(); }
+PubSubThread::Shard::~Shard() {
+  StopThread();
+  close(msg_pfd_[0]);
+  close(msg_pfd_[1]);
+}
 
-void PubSubThread::MoveConnOut(const std::shared_ptr<NetConn>& conn) {
+void PubSubThread::Shard::MoveConnOut(const std::shared_ptr<NetConn>& conn) {
   RemoveConn(conn);
 
   net_multiplexer_->NetDelEvent(conn->fd(), 0);
@@ -72,7 +210,7 @@ void PubSubThread::MoveConnOut(const std::shared_ptr<NetConn>& conn) {
   }
 }
 
-void PubSubThread::MoveConnIn(const std::shared_ptr<NetConn>& conn, const NotifyType& notify_type) {
+void PubSubThread::Shard::MoveConnIn(const std::shared_ptr<NetConn>& conn, const NotifyType& notify_type) {
   NetItem it(conn->fd(), conn->ip_port(), notify_type);
   net_multiplexer_->Register(it, true);
   {
@@ -82,7 +220,18 @@ void PubSubThread::MoveConnIn(const std::shared_ptr<NetConn>& conn, const Notify
   conn->set_net_multiplexer(net_multiplexer_.get());
 }
 
-void PubSubThread::UpdateConnReadyState(int fd, const ReadyState& state) {
+void PubSubThread::Shard::CloseConn(const std::shared_ptr<NetConn>& conn) {
+  MoveConnOut(conn);
+  CloseFd(conn);
+}
+
+bool PubSubThread::Shard::IsOwnConn(const std::shared_ptr<NetConn>& conn) {
+  std::shared_lock l(rwlock_);
+  auto it = conns_.find(conn->fd());
+  return it != conns_.end() && it->second->conn == conn;
+}
+
+void PubSubThread::Shard::UpdateConnReadyState(int fd, const ReadyState& state) {
   std::lock_guard l(rwlock_);
   const auto& it = conns_.find(fd);
   if (it == conns_.end()) {
@@ -91,7 +240,7 @@ void PubSubThread::UpdateConnReadyState(int fd, const ReadyState& state) {
   it->second->UpdateReadyState(state);
 }
 
-bool PubSubThread::IsReady(int fd) {
+bool PubSubThread::Shard::IsReady(int fd) {
   std::shared_lock l(rwlock_);
   const auto& it = conns_.find(fd);
   if (it != conns_.end()) {
@@ -100,10 +249,10 @@ bool PubSubThread::IsReady(int fd) {
   return false;
 }
 
-void PubSubThread::RemoveConn(const std::shared_ptr<NetConn>& conn) {
+void PubSubThread::Shard::RemoveConn(const std::shared_ptr<NetConn>& conn) {
   {
     std::lock_guard lock(pattern_mutex_);
-    for (auto & it : pubsub_pattern_) {
+    for (auto& it : pubsub_pattern_) {
       for (auto conn_ptr = it.second.begin(); conn_ptr != it.second.end(); conn_ptr++) {
         if ((*conn_ptr) == conn) {
           conn_ptr = it.second.erase(conn_ptr);
@@ -115,7 +264,7 @@ void PubSubThread::RemoveConn(const std::shared_ptr<NetConn>& conn) {
 
   {
     std::lock_guard lock(channel_mutex_);
-    for (auto & it : pubsub_channel_) {
+    for (auto& it : pubsub_channel_) {
       for (auto conn_ptr = it.second.begin(); conn_ptr != it.second.end(); conn_ptr++) {
         if ((*conn_ptr) == conn) {
           conn_ptr = it.second.erase(conn_ptr);
@@ -126,26 +275,108 @@ void PubSubThread::RemoveConn(const std::shared_ptr<NetConn>& conn) {
   }
 }
 
-int PubSubThread::Publish(const std::string& channel, const std::string& msg) {
-  // TODO(LIBA-S): change the Publish Mode to Asynchronous
-  std::lock_guard lk(pub_mutex_);
-  channel_ = channel;
-  message_ = msg;
-  // Send signal to ThreadMain()
-  write(msg_pfd_[1], "", 1);
-  std::unique_lock lock(receiver_mutex_);
-  receiver_rsignal_.wait(lock, [this]() { return receivers_ != -1; });
-
-  int receivers = receivers_;
-  receivers_ = -1;
-
+int PubSubThread::Shard::Publish(const std::shared_ptr<const std::pair<std::string, std::string>>& message) {
+  const std::string& channel = message->first;
+  auto delivery = std::make_unique<Delivery>();
+  {
+    std::shared_lock lock(channel_mutex_);
+    auto it = pubsub_channel_.find(channel);
+    if (it != pubsub_channel_.end()) {
+      for (const auto& conn : it->second) {
+        if (IsReady(conn->fd())) {
+          delivery->receivers.emplace_back(conn, std::string());
+        }
+      }
+    }
+  }
+  {
+    std::shared_lock lock(pattern_mutex_);
+    for (const auto& [pattern, matcher] : pattern_matchers_) {
+      if (!matcher.Match(channel)) {
+        continue;
+      }
+      for (const auto& conn : pubsub_pattern_.at(pattern)) {
+        if (IsReady(conn->fd())) {
+          delivery->receivers.emplace_back(conn, pattern);
+        }
+      }
+    }
+  }
+  if (delivery->receivers.empty()) {
+    return 0;
+  }
+  auto receivers = static_cast<int>(delivery->receivers.size());
+  delivery->message = message;
+  queue_.Push(delivery.release());
+  WakeUp();
   return receivers;
 }
 
+void PubSubThread::Shard::WakeUp() {
+  // Only the first producer after the shard drained the queue writes the pipe
+  if (!notified_.exchange(true)) {
+    write(msg_pfd_[1], "", 1);
+  }
+}
+
+void PubSubThread::Shard::DeliverMessages() {
+  // Reset before draining, a push after the last Pop writes the pipe again
+  notified_.store(false);
+
+  std::vector<std::shared_ptr<NetConn>> written;
+  std::unordered_set<NetConn*> written_set;
+  while (Delivery* item = queue_.Pop()) {
+    std::unique_ptr<Delivery> delivery(item);
+    const std::string& channel = delivery->message->first;
+    const std::string& msg = delivery->message->second;
+    std::string channel_resp;
+    for (const auto& [conn, pattern] : delivery->receivers) {
+      // It may have unsubscribed or been closed after the message was published
+      if (!IsOwnConn(conn)) {
+        continue;
+      }
+      // The subscribers of the channel itself all get the same reply
+      const std::string* resp = &channel_resp;
+      std::string pattern_resp;
+      if (pattern.empty()) {
+        if (channel_resp.empty()) {
+          channel_resp = ConstructPublishResp(channel, channel, msg, false);
+        }
+      } else {
+        pattern_resp = ConstructPublishResp(pattern, channel, msg, true);
+        resp = &pattern_resp;
+      }
+      if (max_pending_bytes_ != 0 && conn->PendingReplySize() + resp->size() > max_pending_bytes_) {
+        LOG(WARNING) << "close pubsub conn " << conn->ip_port() << ", unsent messages exceed " << max_pending_bytes_
+                     << " bytes";
+        CloseConn(conn);
+        continue;
+      }
+      conn->WriteResp(*resp);
+      if (written_set.insert(conn.get()).second) {
+        written.push_back(conn);
+      }
+    }
+  }
+
+  // Every connection sends all the messages of this round at once
+  for (const auto& conn : written) {
+    if (!IsOwnConn(conn)) {
+      continue;
+    }
+    WriteStatus write_status = conn->SendReply();
+    if (write_status == kWriteHalf) {
+      net_multiplexer_->NetModEvent(conn->fd(), kReadable, kWritable);
+    } else if (write_status == kWriteError) {
+      CloseConn(conn);
+    }
+  }
+}
+
 /*
  * return the number of channels that the specific connection currently subscribed
  */
-int PubSubThread::ClientChannelSize(const std::shared_ptr<NetConn>& conn) {
+int PubSubThread::Shard::ClientChannelSize(const std::shared_ptr<NetConn>& conn) {
   int subscribed = 0;
 
   channel_mutex_.lock();
@@ -169,15 +400,15 @@ int PubSubThread::ClientChannelSize(const std::shared_ptr<NetConn>& conn) {
   return subscribed;
 }
 
-void PubSubThread::Subscribe(const std::shared_ptr<NetConn>& conn, const std::vector<std::string>& channels,
-                             const bool pattern, std::vector<std::pair<std::string, int>>* result) {
+void PubSubThread::Shard::Subscribe(const std::shared_ptr<NetConn>& conn, const std::vector<std::string>& channels,
+                                    const bool pattern, std::vector<std::pair<std::string, int>>* result) {
   int subscribed = ClientChannelSize(conn);
 
   if (subscribed == 0) {
     MoveConnIn(conn, net::NotifyType::kNotiWait);
   }
 
-  for (const auto & channel : channels) {
+  for (const auto& channel : channels) {
     if (pattern) {  // if pattern mode, register channel to map
       std::lock_guard channel_lock(pattern_mutex_);
       if (pubsub_pattern_.find(channel) != pubsub_pattern_.end()) {
@@ -189,6 +420,7 @@ void PubSubThread::Subscribe(const std::shared_ptr<NetConn>& conn, const std::ve
       } else {  // the channel first subscribed
         std::vector<std::shared_ptr<NetConn>> conns = {conn};
         pubsub_pattern_[channel] = conns;
+        pattern_matchers_.emplace(channel, pstd::GlobMatcher(channel));
         ++subscribed;
       }
       result->push_back(std::make_pair(channel, subscribed));
@@ -214,8 +446,8 @@ void PubSubThread::Subscribe(const std::shared_ptr<NetConn>& conn, const std::ve
  * Unsubscribes the client from the given channels, or from all of them if none
  * is given.
  */
-int PubSubThread::UnSubscribe(const std::shared_ptr<NetConn>& conn, const std::vector<std::string>& channels,
-                              const bool pattern, std::vector<std::pair<std::string, int>>* result) {
+int PubSubThread::Shard::UnSubscribe(const std::shared_ptr<NetConn>& conn, const std::vector<std::string>& channels,
+                                     const bool pattern, std::vector<std::pair<std::string, int>>* result) {
   int subscribed = ClientChannelSize(conn);
   bool exist = true;
   if (subscribed == 0) {
@@ -245,7 +477,7 @@ int PubSubThread::UnSubscribe(const std::shared_ptr<NetConn>& conn, const std::v
     return 0;
   }
 
-  for (const auto & channel : channels) {
+  for (const auto& channel : channels) {
     if (pattern) {  // if pattern mode, unsubscribe the channels of specified
       std::lock_guard l(pattern_mutex_);
       auto channel_ptr = pubsub_pattern_.find(channel);
@@ -287,52 +519,35 @@ int PubSubThread::UnSubscribe(const std::shared_ptr<NetConn>& conn, const std::v
   return subscribed;
 }
 
-void PubSubThread::PubSubChannels(const std::string& pattern, std::vector<std::string>* result) {
-  if (pattern.empty()) {
-    std::lock_guard l(channel_mutex_);
-    for (auto& channel : pubsub_channel_) {
-      if (!channel.second.empty()) {
-        result->push_back(channel.first);
-      }
+void PubSubThread::Shard::PubSubChannels(const std::string& pattern, std::set<std::string>* result) {
+  pstd::GlobMatcher matcher(pattern);
+  std::shared_lock l(channel_mutex_);
+  for (auto& channel : pubsub_channel_) {
+    if (channel.second.empty()) {
+      continue;
     }
-  } else {
-    std::lock_guard l(channel_mutex_);
-    for (auto& channel : pubsub_channel_) {
-      if (pstd::stringmatchlen(channel.first.c_str(), static_cast<int32_t>(channel.first.size()), 
-							   pattern.c_str(), static_cast<int32_t>(pattern.size()), 0)) {
-        if (!channel.second.empty()) {
-          result->push_back(channel.first);
-        }
-      }
+    if (pattern.empty() || matcher.Match(channel.first)) {
+      result->insert(channel.first);
     }
   }
 }
 
-void PubSubThread::PubSubNumSub(const std::vector<std::string>& channels,
-                                std::vector<std::pair<std::string, int>>* result) {
-  int subscribed;
-  std::lock_guard l(channel_mutex_);
-  for (const auto & i : channels) {
-    subscribed = 0;
-    for (auto& channel : pubsub_channel_) {
-      if (channel.first == i) {
-        subscribed = static_cast<int32_t>(channel.second.size());
-      }
-    }
-    result->push_back(std::make_pair(i, subscribed));
-  }
+int PubSubThread::Shard::PubSubNumSub(const std::string& channel) {
+  std::shared_lock l(channel_mutex_);
+  auto it = pubsub_channel_.find(channel);
+  return it != pubsub_channel_.end() ? static_cast<int32_t>(it->second.size()) : 0;
 }
 
-int PubSubThread::PubSubNumPat() {
+int PubSubThread::Shard::PubSubNumPat() {
   int subscribed = 0;
-  std::lock_guard l(pattern_mutex_);
+  std::shared_lock l(pattern_mutex_);
   for (auto& channel : pubsub_pattern_) {
     subscribed += static_cast<int32_t>(channel.second.size());
   }
   return subscribed;
 }
 
-void* PubSubThread::ThreadMain() {
+void* PubSubThread::Shard::ThreadMain() {
   int nfds;
   NetFiredEvent* pfe;
   pstd::Status s;
@@ -366,74 +581,7 @@ void* PubSubThread::ThreadMain() {
       if (pfe->fd == msg_pfd_[0]) {  // Publish message
         if (pfe->mask & kReadable) {
           read(msg_pfd_[0], triger, 1);
-          std::string channel;
-          std::string msg;
-          int32_t receivers = 0;
-          channel = channel_;
-          msg = message_;
-          channel_.clear();
-          message_.clear();
-
-          // Send message to a channel's clients
-          channel_mutex_.lock();
-          auto it = pubsub_channel_.find(channel);
-          if (it != pubsub_channel_.end()) {
-            for (size_t i = 0; i < it->second.size(); i++) {
-              if (!IsReady(it->second[i]->fd())) {
-                continue;
-              }
-              std::string resp = ConstructPublishResp(it->first, channel, msg, false);
-              it->second[i]->WriteResp(resp);
-              WriteStatus write_status = it->second[i]->SendReply();
-              if (write_status == kWriteHalf) {
-                net_multiplexer_->NetModEvent(it->second[i]->fd(), kReadable, kWritable);
-              } else if (write_status == kWriteError) {
-                channel_mutex_.unlock();
-
-                MoveConnOut(it->second[i]);
-
-                channel_mutex_.lock();
-                CloseFd(it->second[i]);
-              } else if (write_status == kWriteAll) {
-                receivers++;
-              }
-            }
-          }
-          channel_mutex_.unlock();
-
-          // Send message to a channel pattern's clients
-          pattern_mutex_.lock();
-          for (auto& it : pubsub_pattern_) {
-            if (pstd::stringmatchlen(it.first.c_str(), static_cast<int32_t>(it.first.size()), 
-									 channel.c_str(), static_cast<int32_t>(channel.size()), 0)) {
-              for (size_t i = 0; i < it.second.size(); i++) {
-                if (!IsReady(it.second[i]->fd())) {
-                  continue;
-                }
-                std::string resp = ConstructPublishResp(it.first, channel, msg, true);
-                it.second[i]->WriteResp(resp);
-                WriteStatus write_status = it.second[i]->SendReply();
-                if (write_status == kWriteHalf) {
-                  net_multiplexer_->NetModEvent(it.second[i]->fd(), kReadable, kWritable);
-                } else if (write_status == kWriteError) {
-                  pattern_mutex_.unlock();
-
-                  MoveConnOut(it.second[i]);
-
-                  pattern_mutex_.lock();
-                  CloseFd(it.second[i]);
-                } else if (write_status == kWriteAll) {
-                  receivers++;
-                }
-              }
-            }
-          }
-          pattern_mutex_.unlock();
-
-          receiver_mutex_.lock();
-          receivers_ = receivers;
-          receiver_rsignal_.notify_one();
-          receiver_mutex_.unlock();
+          DeliverMessages();
         } else {
           continue;
         }
@@ -488,8 +636,7 @@ void* PubSubThread::ThreadMain() {
         }
         // Error
         if ((pfe->mask & kErrorEvent) || should_close) {
-          MoveConnOut(in_conn);
-          CloseFd(in_conn);
+          CloseConn(in_conn);
           in_conn = nullptr;
         }
       }
@@ -499,7 +646,7 @@ void* PubSubThread::ThreadMain() {
   return nullptr;
 }
 
-void PubSubThread::Cleanup() {
+void PubSubThread::Shard::Cleanup() {
   std::lock_guard l(rwlock_);
   for (auto& iter : conns_) {
     CloseFd(iter.second->conn);
@@ -507,4 +654,86 @@ void PubSubThread::Cleanup() {
   conns_.clear();
 }
 
+PubSubThread::PubSubThread(int thread_num, size_t max_pending_bytes) {
+  for (int i = 0; i < std::max(thread_num, 1); i++) {
+    shards_.push_back(std::make_unique<Shard>(i, max_pending_bytes));
+  }
+}
+
+PubSubThread::~PubSubThread() { StopThread(); }
+
+int PubSubThread::StartThread() {
+  for (auto& shard : shards_) {
+    int ret = shard->StartThread();
+    if (ret != 0) {
+      return ret;
+    }
+  }
+  return 0;
+}
+
+int PubSubThread::StopThread() {
+  int ret = 0;
+  for (auto& shard : shards_) {
+    int shard_ret = shard->StopThread();
+    if (shard_ret != 0) {
+      ret = shard_ret;
+    }
+  }
+  return ret;
+}
+
+int PubSubThread::Publish(const std::string& channel, const std::string& msg) {
+  // The shards share the message, each of them only takes its receivers
+  auto message = std::make_shared<const std::pair<std::string, std::string>>(channel, msg);
+  int receivers = 0;
+  for (auto& shard : shards_) {
+    receivers += shard->Publish(message);
+  }
+  return receivers;
+}
+
+void PubSubThread::Subscribe(const std::shared_ptr<NetConn>& conn, const std::vector<std::string>& channels,
+                             const bool pattern, std::vector<std::pair<std::string, int>>* result) {
+  ShardOf(conn->fd())->Subscribe(conn, channels, pattern, result);
+}
+
+int PubSubThread::UnSubscribe(const std::shared_ptr<NetConn>& conn, const std::vector<std::string>& channels,
+                              const bool pattern, std::vector<std::pair<std::string, int>>* result) {
+  return ShardOf(conn->fd())->UnSubscribe(conn, channels, pattern, result);
+}
+
+void PubSubThread::PubSubChannels(const std::string& pattern, std::vector<std::string>* result) {
+  std::set<std::string> channels;
+  for (auto& shard : shards_) {
+    shard->PubSubChannels(pattern, &channels);
+  }
+  result->insert(result->end(), channels.begin(), channels.end());
+}
+
+void PubSubThread::PubSubNumSub(const std::vector<std::string>& channels,
+                                std::vector<std::pair<std::string, int>>* result) {
+  for (const auto& channel : channels) {
+    int subscribed = 0;
+    for (auto& shard : shards_) {
+      subscribed += shard->PubSubNumSub(channel);
+    }
+    result->push_back(std::make_pair(channel, subscribed));
+  }
+}
+
+int PubSubThread::PubSubNumPat() {
+  int subscribed = 0;
+  for (auto& shard : shards_) {
+    subscribed += shard->PubSubNumPat();
+  }
+  return subscribed;
+}
+
+void PubSubThread::UpdateConnReadyState(int fd, const ReadyState& state) {
+  ShardOf(fd)->UpdateConnReadyState(fd, state);
+}
+
+bool PubSubThread::IsReady(int fd) { return ShardOf(fd)->IsReady(fd); }
+
 };  // namespace net
@@ -5,9 +5,18 @@
 
 #include "net/include/redis_conn.h"
 
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <cerrno>
 #include <cstdlib>
 #include <sstream>
 
+#if defined(__linux__)
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#endif
+
 #include <glog/logging.h>
 
 #include "net/include/net_stats.h"
@@ -16,8 +25,16 @@
 
 extern std::unique_ptr<net::NetworkStatistic> g_network_statistic;
 
+#if defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY) && defined(SO_EE_ORIGIN_ZEROCOPY)
+#define NET_HAS_ZEROCOPY 1
+#endif
+
 namespace net {
 
+// Replies smaller than this are copied into response_ and sent together
+static const size_t kReplyCopyLimit = 4096;
+static const int kMaxReplyIov = 64;
+
 RedisConn::RedisConn(const int fd, const std::string& ip_port, Thread* thread, NetMultiplexer* net_mpx,
                      const HandleType& handle_type, const int rbuf_max_len)
     : NetConn(fd, ip_port, thread, net_mpx),
@@ -127,25 +144,62 @@ ReadStatus RedisConn::GetRequest() {
 
 WriteStatus RedisConn::SendReply() {
   ssize_t nwritten = 0;
-  size_t wbuf_len = response_.size();
-  while (wbuf_len > 0) {
-    nwritten = write(fd(), response_.data() + wbuf_pos_, wbuf_len - wbuf_pos_);
-    g_network_statistic->IncrRedisOutputBytes(nwritten);
+  while (!replies_.empty() || !response_.empty()) {
+    if (!replies_.empty() && zerocopy_threshold_ != 0 && replies_.front().size() - wbuf_pos_ >= zerocopy_threshold_) {
+#ifdef NET_HAS_ZEROCOPY
+      struct iovec iov;
+      iov.iov_base = replies_.front().data() + wbuf_pos_;
+      iov.iov_len = replies_.front().size() - wbuf_pos_;
+      struct msghdr msg = {};
+      msg.msg_iov = &iov;
+      msg.msg_iovlen = 1;
+      nwritten = sendmsg(fd(), &msg, MSG_ZEROCOPY);
+      if (nwritten > 0) {
+        front_zerocopy_id_ = zerocopy_next_id_++;
+      } else if (nwritten == -1 && errno == ENOBUFS) {
+        // Out of option memory for the notifications, send it the usual way
+        nwritten = write(fd(), iov.iov_base, iov.iov_len);
+      }
+#endif
+    } else {
+      // Gather the queued replies into one writev, a reply that goes out
+      // with MSG_ZEROCOPY starts the next round
+      struct iovec iov[kMaxReplyIov];
+      int iovcnt = 0;
+      size_t pos = wbuf_pos_;
+      size_t gathered = 0;
+      for (auto& reply : replies_) {
+        if (iovcnt == kMaxReplyIov || (iovcnt > 0 && zerocopy_threshold_ != 0 && reply.size() >= zerocopy_threshold_)) {
+          break;
+        }
+        iov[iovcnt].iov_base = reply.data() + pos;
+        iov[iovcnt].iov_len = reply.size() - pos;
+        iovcnt++;
+        gathered++;
+        pos = 0;
+      }
+      if (gathered == replies_.size() && iovcnt < kMaxReplyIov && !response_.empty()) {
+        iov[iovcnt].iov_base = response_.data() + pos;
+        iov[iovcnt].iov_len = response_.size() - pos;
+        iovcnt++;
+      }
+      nwritten = writev(fd(), iov, iovcnt);
+    }
     if (nwritten <= 0) {
       break;
     }
-    wbuf_pos_ += nwritten;
-    if (wbuf_pos_ == wbuf_len) {
-      // Have sended all response data
-      if (wbuf_len > DEFAULT_WBUF_SIZE) {
-        std::string buf;
-        buf.reserve(DEFAULT_WBUF_SIZE);
-        response_.swap(buf);
-      }
-      response_.clear();
+    g_network_statistic->IncrRedisOutputBytes(nwritten);
 
-      wbuf_len = 0;
+    auto left = static_cast<size_t>(nwritten);
+    while (left > 0) {
+      size_t remain = (replies_.empty() ? response_.size() : replies_.front().size()) - wbuf_pos_;
+      if (left < remain) {
+        wbuf_pos_ += left;
+        break;
+      }
+      left -= remain;
       wbuf_pos_ = 0;
+      PopReply();
     }
   }
   if (nwritten == -1) {
@@ -156,7 +210,7 @@ WriteStatus RedisConn::SendReply() {
       return kWriteError;
     }
   }
-  if (wbuf_len == 0) {
+  if (replies_.empty() && response_.empty()) {
     return kWriteAll;
   } else {
     return kWriteHalf;
@@ -169,6 +223,107 @@ int RedisConn::WriteResp(const std::string& resp) {
   return 0;
 }
 
+int RedisConn::WriteResp(std::string&& resp) {
+  if (resp.size() < kReplyCopyLimit) {
+    return WriteResp(static_cast<const std::string&>(resp));
+  }
+  FlushResponse();
+  replies_.push_back(std::move(resp));
+  set_is_reply(true);
+  return 0;
+}
+
+size_t RedisConn::PendingReplySize() const {
+  size_t size = response_.size();
+  for (const auto& reply : replies_) {
+    size += reply.size();
+  }
+  return size - wbuf_pos_;
+}
+
+void RedisConn::FlushResponse() {
+  if (!response_.empty()) {
+    replies_.push_back(std::move(response_));
+    response_.clear();
+  }
+}
+
+void RedisConn::PopReply() {
+  if (!replies_.empty()) {
+    if (front_zerocopy_id_ >= 0) {
+      // The kernel may still read it, keep it until the send completes
+      zerocopy_pending_.emplace_back(static_cast<uint32_t>(front_zerocopy_id_), std::move(replies_.front()));
+      front_zerocopy_id_ = -1;
+    }
+    replies_.pop_front();
+    return;
+  }
+  // Have sended all response data
+  if (response_.size() > DEFAULT_WBUF_SIZE) {
+    std::string buf;
+    buf.reserve(DEFAULT_WBUF_SIZE);
+    response_.swap(buf);
+  }
+  response_.clear();
+}
+
+void RedisConn::SetZeroCopyThreshold(size_t threshold) {
+#ifdef NET_HAS_ZEROCOPY
+  int one = 1;
+  if (threshold != 0 && setsockopt(fd(), SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0) {
+    zerocopy_threshold_ = threshold;
+  }
+#endif
+}
+
+bool RedisConn::HandleErrorEvent() {
+#ifdef NET_HAS_ZEROCOPY
+  if (zerocopy_threshold_ == 0) {
+    return false;
+  }
+  // Completions of MSG_ZEROCOPY sends are reported on the error queue
+  bool completed = false;
+  while (true) {
+    char control[128];
+    struct msghdr msg = {};
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    if (recvmsg(fd(), &msg, MSG_ERRQUEUE) == -1) {
+      break;
+    }
+    for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm)) {
+      if ((cm->cmsg_level != SOL_IP || cm->cmsg_type != IP_RECVERR) &&
+          (cm->cmsg_level != SOL_IPV6 || cm->cmsg_type != IPV6_RECVERR)) {
+        continue;
+      }
+      auto err = reinterpret_cast<struct sock_extended_err*>(CMSG_DATA(cm));
+      if (err->ee_errno != 0 || err->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+        return false;
+      }
+      CompleteZeroCopy(err->ee_info, err->ee_data);
+      completed = true;
+    }
+  }
+  int error = 0;
+  socklen_t len = sizeof(error);
+  return completed && getsockopt(fd(), SOL_SOCKET, SO_ERROR, &error, &len) == 0 && error == 0;
+#else
+  return false;
+#endif
+}
+
+void RedisConn::CompleteZeroCopy(uint32_t lo, uint32_t hi) {
+  zerocopy_completed_[lo] = hi;
+  for (auto iter = zerocopy_completed_.find(zerocopy_done_id_); iter != zerocopy_completed_.end();
+       iter = zerocopy_completed_.find(zerocopy_done_id_)) {
+    zerocopy_done_id_ = iter->second + 1;
+    zerocopy_completed_.erase(iter);
+  }
+  while (!zerocopy_pending_.empty() && static_cast<int32_t>(zerocopy_done_id_ - zerocopy_pending_.front().first) > 0) {
+    zerocopy_pending_.pop_front();
+  }
+}
+
 void RedisConn::TryResizeBuffer() {
   struct timeval now;
   gettimeofday(&now, nullptr);
@@ -188,7 +343,7 @@ void RedisConn::SetHandleType(const HandleType& handle_type) { handle_type_ = ha
 
 HandleType RedisConn::GetHandleType() { return handle_type_; }
 
-void RedisConn::ProcessRedisCmds(const std::vector<RedisCmdArgsType>& argvs, bool async, std::string* response) {}
+void RedisConn::ProcessRedisCmds(std::vector<RedisCmdArgsType>& argvs, bool async, std::string* response) {}
 
 void RedisConn::NotifyEpoll(bool success) {
   NetItem ti(fd(), ip_port(), success ? kNotiEpolloutAndEpollin : kNotiClose);
@@ -204,7 +359,7 @@ int RedisConn::ParserDealMessageCb(RedisParser* parser, const RedisCmdArgsType&
   }
 }
 
-int RedisConn::ParserCompleteCb(RedisParser* parser, const std::vector<RedisCmdArgsType>& argvs) {
+int RedisConn::ParserCompleteCb(RedisParser* parser, std::vector<RedisCmdArgsType>& argvs) {
   auto conn = reinterpret_cast<RedisConn*>(parser->data);
   bool async = conn->GetHandleType() == HandleType::kAsynchronous;
   conn->ProcessRedisCmds(argvs, async, &(conn->response_));
@@ -5,7 +5,13 @@
 
 #include "net/include/redis_parser.h"
 
+#include <algorithm>
 #include <cassert> /* assert */
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 #include <glog/logging.h>
 
@@ -143,18 +149,79 @@ static int split2args(const std::string& req_buf, RedisCmdArgsType& argv) {
   }
 }
 
+static const char* FindNewlineScalar(const char* begin, const char* end) {
+  return static_cast<const char*>(memchr(begin, '\n', end - begin));
+}
+
+#if defined(__SSE2__)
+static const char* FindNewlineSSE(const char* begin, const char* end) {
+  const __m128i newline = _mm_set1_epi8('\n');
+  const char* p = begin;
+  for (; p + 16 <= end; p += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+  }
+  return FindNewlineScalar(p, end);
+}
+
+__attribute__((target("avx2"))) static const char* FindNewlineAVX2(const char* begin, const char* end) {
+  const __m256i newline = _mm256_set1_epi8('\n');
+  const char* p = begin;
+  for (; p + 32 <= end; p += 32) {
+    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline)));
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+  }
+  return FindNewlineSSE(p, end);
+}
+#endif
+
+using FindNewlineFunc = const char* (*)(const char*, const char*);
+
+// Picks the widest separator search the cpu supports
+static FindNewlineFunc SelectFindNewline() {
+#if defined(__SSE2__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return FindNewlineAVX2;
+  }
+  return FindNewlineSSE;
+#else
+  return FindNewlineScalar;
+#endif
+}
+
+static const FindNewlineFunc FindNewline = SelectFindNewline();
+
+// Parses the decimal digits in [begin, end), false if there is anything
+// else, a leading zero or too many digits to be a sane length
+static bool ParseLength(const char* begin, const char* end, long* value) {
+  if (end <= begin || end - begin > 18 || (*begin == '0' && end - begin > 1)) {
+    return false;
+  }
+  long num = 0;
+  for (const char* p = begin; p < end; p++) {
+    auto digit = static_cast<unsigned char>(*p - '0');
+    if (digit > 9) {
+      return false;
+    }
+    num = num * 10 + digit;
+  }
+  *value = num;
+  return true;
+}
+
 int RedisParser::FindNextSeparators() {
   if (cur_pos_ > length_ - 1) {
     return -1;
   }
-  int pos = cur_pos_;
-  while (pos <= length_ - 1) {
-    if (input_buf_[pos] == '\n') {
-      return pos;
-    }
-    pos++;
-  }
-  return -1;
+  const char* pos = FindNewline(input_buf_ + cur_pos_, input_buf_ + length_);
+  return pos != nullptr ? static_cast<int>(pos - input_buf_) : -1;
 }
 
 int RedisParser::GetNextNum(int pos, long* value) {
@@ -164,12 +231,51 @@ int RedisParser::GetNextNum(int pos, long* value) {
   //      |    |
   //      *3\r\n
   // [cur_pos_ + 1, pos - cur_pos_ - 2]
-  if (pstd::string2int(input_buf_ + cur_pos_ + 1, pos - cur_pos_ - 2, value) != 0) {
+  if (ParseLength(input_buf_ + cur_pos_ + 1, input_buf_ + pos - 1, value) ||
+      pstd::string2int(input_buf_ + cur_pos_ + 1, pos - cur_pos_ - 2, value) != 0) {
     return 0;  // Success
   }
   return -1;  // Failed
 }
 
+bool RedisParser::ProcessMultibulkFast() {
+  const char* p = input_buf_ + cur_pos_ + 1;
+  const char* end = input_buf_ + length_;
+  const char* num_end = p;
+  long multibulk_len = 0;
+  while (num_end < end && *num_end != '\r') {
+    num_end++;
+  }
+  if (num_end + 1 >= end || num_end[1] != '\n' || !ParseLength(p, num_end, &multibulk_len) || multibulk_len == 0) {
+    return false;
+  }
+  p = num_end + 2;
+
+  argv_.clear();
+  argv_.reserve(std::min(multibulk_len, 1024L));
+  for (long i = 0; i < multibulk_len; i++) {
+    if (p >= end || *p != '$') {
+      argv_.clear();
+      return false;
+    }
+    num_end = ++p;
+    while (num_end < end && *num_end != '\r') {
+      num_end++;
+    }
+    long bulk_len = 0;
+    if (num_end + 1 >= end || num_end[1] != '\n' || !ParseLength(p, num_end, &bulk_len) ||
+        end - (num_end + 2) < bulk_len + 2) {
+      argv_.clear();
+      return false;
+    }
+    p = num_end + 2;
+    argv_.emplace_back(p, bulk_len);
+    p += bulk_len + 2;
+  }
+  cur_pos_ = static_cast<int>(p - input_buf_);
+  return true;
+}
+
 RedisParser::RedisParser()
     : redis_type_(0), bulk_len_(-1), redis_parser_type_(REDIS_PARSER_REQUEST) {}
 
@@ -274,7 +380,25 @@ RedisParserStatus RedisParser::ProcessMultibulkBuffer() {
         return status_code_;
       }
     }
-    if ((length_ - 1) - cur_pos_ + 1 < bulk_len_ + 2) {
+    long available = length_ - cur_pos_;
+    if (bulk_len_ >= REDIS_MBULK_BIG_ARG && (!big_arg_.empty() || available < bulk_len_ + 2)) {
+      // A big argument is gathered into its final string as it arrives,
+      // so the received part is not copied through half_argv_ on every read
+      if (big_arg_.empty()) {
+        big_arg_.reserve(bulk_len_ + 2);
+      }
+      long n = std::min(available, bulk_len_ + 2 - static_cast<long>(big_arg_.size()));
+      big_arg_.append(input_buf_ + cur_pos_, n);
+      cur_pos_ = static_cast<int32_t>(cur_pos_ + n);
+      if (static_cast<long>(big_arg_.size()) < bulk_len_ + 2) {
+        break;
+      }
+      big_arg_.resize(bulk_len_);
+      argv_.push_back(std::move(big_arg_));
+      big_arg_.clear();
+      bulk_len_ = -1;
+      multibulk_len_--;
+    } else if (available < bulk_len_ + 2) {
       // Data not enough
       break;
     } else {
@@ -304,7 +428,7 @@ void RedisParser::PrintCurrentStatus() {
   LOG(INFO) << "cur_pos : " << cur_pos_;
   LOG(INFO) << "input_buf_ is clean ? " << (input_buf_ == nullptr);
   if (input_buf_) {
-    LOG(INFO) << " input_buf " << input_buf_;
+    LOG(INFO) << " input_buf " << std::string(input_buf_, length_);
   }
   LOG(INFO) << "half_argv_ : " << half_argv_;
   LOG(INFO) << "input_buf len " << length_;
@@ -312,11 +436,16 @@ void RedisParser::PrintCurrentStatus() {
 
 RedisParserStatus RedisParser::ProcessInputBuffer(const char* input_buf, int length, int* parsed_len) {
   if (status_code_ == kRedisParserInitDone || status_code_ == kRedisParserHalf || status_code_ == kRedisParserDone) {
-    // TODO(): AZ: avoid copy
-    std::string tmp_str(input_buf, length);
-    input_str_ = half_argv_ + tmp_str;
-    input_buf_ = input_str_.c_str();
-    length_ = static_cast<int32_t>(length + half_argv_.size());
+    if (half_argv_.empty()) {
+      // Parse the caller's buffer in place, only a half command is copied
+      input_buf_ = input_buf;
+      length_ = length;
+    } else {
+      input_str_ = half_argv_;
+      input_str_.append(input_buf, length);
+      input_buf_ = input_str_.data();
+      length_ = static_cast<int32_t>(input_str_.size());
+    }
     if (redis_parser_type_ == REDIS_PARSER_REQUEST) {
       ProcessRequestBuffer();
     } else if (redis_parser_type_ == REDIS_PARSER_RESPONSE) {
@@ -344,36 +473,40 @@ RedisParserStatus RedisParser::ProcessResponseBuffer() {
 RedisParserStatus RedisParser::ProcessRequestBuffer() {
   RedisParserStatus ret;
   while (cur_pos_ <= length_ - 1) {
-    if (redis_type_ == 0) {
-      if (input_buf_[cur_pos_] == '*') {
-        redis_type_ = REDIS_REQ_MULTIBULK;
-      } else {
-        redis_type_ = REDIS_REQ_INLINE;
+    if (redis_type_ == 0 && input_buf_[cur_pos_] == '*' && ProcessMultibulkFast()) {
+      // The whole command was in the buffer
+    } else {
+      if (redis_type_ == 0) {
+        if (input_buf_[cur_pos_] == '*') {
+          redis_type_ = REDIS_REQ_MULTIBULK;
+        } else {
+          redis_type_ = REDIS_REQ_INLINE;
+        }
       }
-    }
 
-    if (redis_type_ == REDIS_REQ_INLINE) {
-      ret = ProcessInlineBuffer();
-      if (ret != kRedisParserDone) {
-        return ret;
-      }
-    } else if (redis_type_ == REDIS_REQ_MULTIBULK) {
-      ret = ProcessMultibulkBuffer();
-      if (ret != kRedisParserDone) {  // FULL_ERROR || HALF || PARSE_ERROR
-        return ret;
+      if (redis_type_ == REDIS_REQ_INLINE) {
+        ret = ProcessInlineBuffer();
+        if (ret != kRedisParserDone) {
+          return ret;
+        }
+      } else if (redis_type_ == REDIS_REQ_MULTIBULK) {
+        ret = ProcessMultibulkBuffer();
+        if (ret != kRedisParserDone) {  // FULL_ERROR || HALF || PARSE_ERROR
+          return ret;
+        }
+      } else {
+        // Unknown requeset type;
+        return kRedisParserError;
       }
-    } else {
-      // Unknown requeset type;
-      return kRedisParserError;
     }
     if (!argv_.empty()) {
-      argvs_.push_back(argv_);
       if (parser_settings_.DealMessage) {
         if (parser_settings_.DealMessage(this, argv_) != 0) {
           SetParserStatus(kRedisParserError, kRedisParserDealError);
           return status_code_;
         }
       }
+      argvs_.push_back(std::move(argv_));
     }
     argv_.clear();
     // Reset
@@ -395,6 +528,7 @@ void RedisParser::ResetCommandStatus() {
   multibulk_len_ = 0;
   bulk_len_ = -1;
   half_argv_.clear();
+  big_arg_.clear();
 }
 
 void RedisParser::ResetRedisParser() {
@@ -42,11 +42,11 @@ int ThreadPool::Worker::stop() {
 }
 
 ThreadPool::ThreadPool(size_t worker_num, size_t max_queue_size, std::string  thread_pool_name)
-    : worker_num_(worker_num),
+    : running_(false),
+      should_stop_(false),
+      worker_num_(worker_num),
       max_queue_size_(max_queue_size),
-      thread_pool_name_(std::move(thread_pool_name)),
-      running_(false),
-      should_stop_(false) {}
+      thread_pool_name_(std::move(thread_pool_name)) {}
 
 ThreadPool::~ThreadPool() { stop_thread_pool(); }
 
@@ -0,0 +1,288 @@
+// Copyright (c) 2018-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#include "net/include/work_stealing_thread_pool.h"
+#include "net/src/net_thread_name.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <system_error>
+#include <utility>
+
+namespace net {
+
+static uint64_t NowMillis() {
+  auto now = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+}
+
+WorkStealingThreadPool::TaskQueue::TaskQueue(size_t capacity)
+    : mask_(capacity - 1), cells_(new Cell[capacity]) {
+  for (size_t i = 0; i < capacity; ++i) {
+    cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+bool WorkStealingThreadPool::TaskQueue::Push(TaskFunc func, void* arg) {
+  Cell* cell;
+  size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+  while (true) {
+    cell = &cells_[pos & mask_];
+    size_t seq = cell->sequence.load(std::memory_order_acquire);
+    auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+    if (diff == 0) {
+      if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      return false;
+    } else {
+      pos = enqueue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+  cell->func = func;
+  cell->arg = arg;
+  cell->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+bool WorkStealingThreadPool::TaskQueue::Pop(Task* task) {
+  Cell* cell;
+  size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+  while (true) {
+    cell = &cells_[pos & mask_];
+    size_t seq = cell->sequence.load(std::memory_order_acquire);
+    auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+    if (diff == 0) {
+      if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      return false;
+    } else {
+      pos = dequeue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+  task->func = cell->func;
+  task->arg = cell->arg;
+  cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+  return true;
+}
+
+size_t WorkStealingThreadPool::TaskQueue::size() const {
+  size_t dequeue_pos = dequeue_pos_.load(std::memory_order_relaxed);
+  size_t enqueue_pos = enqueue_pos_.load(std::memory_order_relaxed);
+  return enqueue_pos > dequeue_pos ? enqueue_pos - dequeue_pos : 0;
+}
+
+WorkStealingThreadPool::WorkStealingThreadPool(size_t worker_num, size_t max_queue_size, std::string thread_pool_name)
+    : ThreadPool(worker_num, max_queue_size, std::move(thread_pool_name)),
+      worker_num_(std::max<size_t>(worker_num, 1)),
+      wheel_(kWheelSlots) {
+  size_t capacity = 2;
+  while (capacity * worker_num_ < max_queue_size) {
+    capacity <<= 1;
+  }
+  for (size_t i = 0; i < worker_num_; ++i) {
+    queues_.push_back(std::make_unique<TaskQueue>(capacity));
+  }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() { stop_thread_pool(); }
+
+int WorkStealingThreadPool::start_thread_pool() {
+  if (!running_.load()) {
+    should_stop_.store(false);
+    running_.store(true);
+    try {
+      for (size_t i = 0; i < worker_num_; ++i) {
+        workers_.emplace_back(&WorkStealingThreadPool::RunWorker, this, i);
+        SetThreadName(workers_.back().native_handle(), thread_pool_name() + "Worker");
+      }
+      timer_ = std::thread(&WorkStealingThreadPool::RunTimer, this);
+      SetThreadName(timer_.native_handle(), thread_pool_name() + "Timer");
+    } catch (const std::system_error&) {
+      stop_thread_pool();
+      return kCreateThreadError;
+    }
+  }
+  return kSuccess;
+}
+
+int WorkStealingThreadPool::stop_thread_pool() {
+  if (running_.load()) {
+    should_stop_.store(true);
+    {
+      std::lock_guard lock(park_mu_);
+      park_cv_.notify_all();
+    }
+    {
+      std::lock_guard lock(full_mu_);
+      full_cv_.notify_all();
+    }
+    {
+      std::lock_guard lock(timer_mu_);
+      timer_cv_.notify_all();
+    }
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+    workers_.clear();
+    if (timer_.joinable()) {
+      timer_.join();
+    }
+    running_.store(false);
+  }
+  return 0;
+}
+
+void WorkStealingThreadPool::Schedule(TaskFunc func, void* arg) {
+  while (!should_stop()) {
+    if (TryPush(func, arg)) {
+      WakeWorker();
+      return;
+    }
+    // Every queue is full, wait until a worker takes a task
+    bool pushed = false;
+    {
+      std::unique_lock lock(full_mu_);
+      blocked_.fetch_add(1);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      pushed = TryPush(func, arg);
+      if (!pushed && !should_stop()) {
+        full_cv_.wait(lock);
+      }
+      blocked_.fetch_sub(1);
+    }
+    if (pushed) {
+      WakeWorker();
+      return;
+    }
+  }
+}
+
+/*
+ * timeout is in millisecond
+ */
+void WorkStealingThreadPool::DelaySchedule(uint64_t timeout, TaskFunc func, void* arg) {
+  std::lock_guard lock(timer_mu_);
+  if (should_stop()) {
+    return;
+  }
+  uint64_t now = NowMillis();
+  if (timer_tasks_.load() == 0) {
+    // The timer does not tick while the wheel is empty
+    last_tick_time_ = now;
+  }
+  uint64_t tick = current_tick_ + (now - last_tick_time_) + timeout;
+  tick = std::max(tick, current_tick_ + 1);
+  wheel_[tick % kWheelSlots].push_back({tick, func, arg});
+  timer_tasks_.fetch_add(1);
+  timer_cv_.notify_one();
+}
+
+void WorkStealingThreadPool::cur_queue_size(size_t* qsize) {
+  *qsize = 0;
+  for (const auto& queue : queues_) {
+    *qsize += queue->size();
+  }
+}
+
+void WorkStealingThreadPool::cur_time_queue_size(size_t* qsize) { *qsize = timer_tasks_.load(); }
+
+bool WorkStealingThreadPool::TryPush(TaskFunc func, void* arg) {
+  size_t start = next_queue_.fetch_add(1, std::memory_order_relaxed);
+  for (size_t i = 0; i < worker_num_; ++i) {
+    if (queues_[(start + i) % worker_num_]->Push(func, arg)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool WorkStealingThreadPool::TryPop(size_t index, Task* task) {
+  for (size_t i = 0; i < worker_num_; ++i) {
+    if (queues_[(index + i) % worker_num_]->Pop(task)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void WorkStealingThreadPool::WakeWorker() {
+  // Pairs with the fence in RunWorker, either the worker sees the task
+  // or we see the worker going to sleep
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (idle_.load() == 0) {
+    return;
+  }
+  std::lock_guard lock(park_mu_);
+  if (wakeups_ < idle_.load()) {
+    ++wakeups_;
+    park_cv_.notify_one();
+  }
+}
+
+void WorkStealingThreadPool::RunWorker(size_t index) {
+  Task task(nullptr, nullptr);
+  while (!should_stop()) {
+    bool got = TryPop(index, &task);
+    if (!got) {
+      std::unique_lock lock(park_mu_);
+      idle_.fetch_add(1);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      got = TryPop(index, &task);
+      if (!got) {
+        park_cv_.wait(lock, [this]() { return wakeups_ > 0 || should_stop(); });
+        if (wakeups_ > 0) {
+          --wakeups_;
+        }
+      }
+      idle_.fetch_sub(1);
+    }
+    if (got) {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (blocked_.load() > 0) {
+        std::lock_guard lock(full_mu_);
+        full_cv_.notify_one();
+      }
+      (*task.func)(task.arg);
+    }
+  }
+}
+
+void WorkStealingThreadPool::RunTimer() {
+  std::vector<TimerTask> due;
+  while (!should_stop()) {
+    {
+      std::unique_lock lock(timer_mu_);
+      if (timer_tasks_.load() == 0) {
+        timer_cv_.wait(lock, [this]() { return timer_tasks_.load() > 0 || should_stop(); });
+        continue;
+      }
+      uint64_t now = NowMillis();
+      while (last_tick_time_ < now) {
+        ++current_tick_;
+        ++last_tick_time_;
+        auto& slot = wheel_[current_tick_ % kWheelSlots];
+        auto iter = std::partition(slot.begin(), slot.end(),
+                                   [this](const TimerTask& task) { return task.tick > current_tick_; });
+        due.insert(due.end(), iter, slot.end());
+        slot.erase(iter, slot.end());
+      }
+      timer_tasks_.fetch_sub(due.size());
+    }
+    for (const auto& task : due) {
+      Schedule(task.func, task.arg);
+    }
+    due.clear();
+
+    std::unique_lock lock(timer_mu_);
+    timer_cv_.wait_for(lock, std::chrono::milliseconds(1), [this]() { return should_stop(); });
+  }
+}
+
+}  // namespace net
@@ -199,7 +199,7 @@ void* WorkerThread::ThreadMain() {
           }
         }
 
-        if (((pfe->mask & kErrorEvent) != 0) || (should_close != 0)) {
+        if (((pfe->mask & kErrorEvent) != 0 && !in_conn->HandleErrorEvent()) || (should_close != 0)) {
           //check if this conn disconnected from being blocked by blpop/brpop
           dynamic_cast<net::DispatchThread*>(server_thread_)->ClosingConnCheckForBlrPop(std::dynamic_pointer_cast<net::RedisConn>(in_conn));
           net_multiplexer_->NetDelEvent(pfe->fd, 0);
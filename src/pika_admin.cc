@@ -26,6 +26,7 @@ using pstd::Status;
 
 extern PikaServer* g_pika_server;
 extern std::unique_ptr<PikaReplicaManager> g_pika_rm;
+extern std::unique_ptr<PikaCmdTableManager> g_pika_cmd_table_manager;
 
 static std::string ConstructPinginPubSubResp(const PikaCmdArgsType& argv) {
   if (argv.size() > 2) {
@@ -921,6 +922,7 @@ void InfoCmd::InfoServer(std::string& info) {
   tmp_stream << "tcp_port:" << g_pika_conf->port() << "\r\n";
   tmp_stream << "thread_num:" << g_pika_conf->thread_num() << "\r\n";
   tmp_stream << "sync_thread_num:" << g_pika_conf->sync_thread_num() << "\r\n";
+  tmp_stream << "db_open_time_ms:" << g_pika_server->db_open_time_ms() << "\r\n";
   tmp_stream << "uptime_in_seconds:" << (current_time_s - g_pika_server->start_time_s()) << "\r\n";
   tmp_stream << "uptime_in_days:" << (current_time_s / (24 * 3600) - g_pika_server->start_time_s() / (24 * 3600) + 1)
              << "\r\n";
@@ -958,11 +960,43 @@ void InfoCmd::InfoStats(std::string& info) {
   tmp_stream << "instantaneous_input_repl_kbps:" << g_pika_server->InstantaneousInputReplKbps() << "\r\n";
   tmp_stream << "instantaneous_output_repl_kbps:" << g_pika_server->InstantaneousOutputReplKbps() << "\r\n";
 
+  // The thread pool of the commands, and the one of the slow commands
+  tmp_stream << "thread_pool_queue_size:" << g_pika_server->ClientProcessorThreadPoolCurQueueSize() << "\r\n";
+  tmp_stream << "thread_pool_max_queue_size:" << g_pika_server->ClientProcessorThreadPoolMaxQueueSize() << "\r\n";
+  tmp_stream << "thread_pool_tasks:" << g_pika_server->ClientPoolTasks() << "\r\n";
+  tmp_stream << "slow_cmd_thread_pool_queue_size:" << g_pika_server->SlowCmdThreadPoolCurQueueSize() << "\r\n";
+  tmp_stream << "slow_cmd_thread_pool_max_queue_size:" << g_pika_server->SlowCmdThreadPoolMaxQueueSize() << "\r\n";
+  tmp_stream << "slow_cmd_thread_pool_tasks:" << g_pika_server->SlowCmdPoolTasks() << "\r\n";
+  std::string adaptive_slow_cmds;
+  for (const auto& cmd : g_pika_cmd_table_manager->AdaptiveSlowCmds()) {
+    adaptive_slow_cmds += (adaptive_slow_cmds.empty() ? "" : ",") + cmd;
+  }
+  tmp_stream << "adaptive_slow_cmds:" << adaptive_slow_cmds << "\r\n";
+
   tmp_stream << "is_bgsaving:" << (g_pika_server->IsBgSaving() ? "Yes" : "No") << "\r\n";
   tmp_stream << "is_scaning_keyspace:" << (g_pika_server->IsKeyScaning() ? "Yes" : "No") << "\r\n";
   tmp_stream << "is_compact:" << (g_pika_server->IsCompacting() ? "Yes" : "No") << "\r\n";
   tmp_stream << "compact_cron:" << g_pika_conf->compact_cron() << "\r\n";
   tmp_stream << "compact_interval:" << g_pika_conf->compact_interval() << "\r\n";
+  uint64_t expired_keys = 0;
+  {
+    std::shared_lock rwl(g_pika_server->dbs_rw_);
+    for (const auto& db_item : g_pika_server->dbs_) {
+      expired_keys += db_item.second->GetActiveExpiredKeys();
+    }
+  }
+  tmp_stream << "expired_keys:" << expired_keys << "\r\n";
+  storage::ValueCacheInfo value_cache_info;
+  {
+    std::shared_lock rwl(g_pika_server->dbs_rw_);
+    for (const auto& db_item : g_pika_server->dbs_) {
+      db_item.second->AddValueCacheInfo(&value_cache_info);
+    }
+  }
+  tmp_stream << "value_cache_hits:" << value_cache_info.hits << "\r\n";
+  tmp_stream << "value_cache_misses:" << value_cache_info.misses << "\r\n";
+  tmp_stream << "value_cache_used_memory:" << value_cache_info.usage << "\r\n";
+  tmp_stream << "value_cache_keys:" << value_cache_info.entries << "\r\n";
   time_t current_time_s = time(nullptr);
   PikaServer::BGSlotsReload bgslotsreload_info = g_pika_server->bgslots_reload();
   bool is_reloading = g_pika_server->GetSlotsreloading();
@@ -1171,6 +1205,10 @@ void InfoCmd::InfoReplication(std::string& info) {
   uint64_t offset = 0;
   std::string safety_purge;
   std::shared_ptr<SyncMasterSlot> master_slot = nullptr;
+  uint64_t group_commit_batches = 0;
+  uint64_t group_commit_items = 0;
+  uint64_t group_commit_max_batch = 0;
+  uint64_t group_commit_wait_us = 0;
   for (const auto& t_item : g_pika_server->dbs_) {
     std::shared_lock slot_rwl(t_item.second->slots_rw_);
     for (const auto& p_item : t_item.second->slots_) {
@@ -1185,8 +1223,67 @@ void InfoCmd::InfoReplication(std::string& info) {
       tmp_stream << db_name << " binlog_offset=" << filenum << " " << offset;
       s = master_slot->GetSafetyPurgeBinlog(&safety_purge);
       tmp_stream << ",safety_purge=" << (s.ok() ? safety_purge : "error") << "\r\n";
+      std::shared_ptr<Binlog> logger = master_slot->Logger();
+      if (!logger) {
+        continue;
+      }
+      group_commit_batches += logger->group_commit_batches();
+      group_commit_items += logger->group_commit_items();
+      group_commit_max_batch = std::max(group_commit_max_batch, logger->group_commit_max_batch());
+      group_commit_wait_us += logger->group_commit_wait_us();
     }
   }
+  tmp_stream << "binlog_group_commit:" << (g_pika_conf->binlog_group_commit() ? "yes" : "no") << "\r\n";
+  tmp_stream << "binlog_group_commit_batches:" << group_commit_batches << "\r\n";
+  tmp_stream << "binlog_group_commit_items:" << group_commit_items << "\r\n";
+  tmp_stream << "binlog_group_commit_avg_batch_size:" << std::setiosflags(std::ios::fixed) << std::setprecision(2)
+             << (group_commit_batches != 0 ? static_cast<double>(group_commit_items) / group_commit_batches : 0)
+             << "\r\n";
+  tmp_stream << "binlog_group_commit_max_batch_size:" << group_commit_max_batch << "\r\n";
+  tmp_stream << "binlog_group_commit_avg_wait_us:"
+             << (group_commit_items != 0 ? group_commit_wait_us / group_commit_items : 0) << "\r\n";
+
+  uint64_t repl_applied_cmds = 0;
+  uint64_t repl_applied_batches = 0;
+  size_t repl_apply_pending = 0;
+  uint64_t repl_apply_lag_us = 0;
+  g_pika_rm->GetWriteDBStatus(&repl_applied_cmds, &repl_applied_batches, &repl_apply_pending, &repl_apply_lag_us);
+  tmp_stream << "repl_applied_cmds:" << repl_applied_cmds << "\r\n";
+  tmp_stream << "repl_applied_batches:" << repl_applied_batches << "\r\n";
+  tmp_stream << "repl_apply_avg_batch_size:"
+             << (repl_applied_batches != 0 ? static_cast<double>(repl_applied_cmds) / repl_applied_batches : 0)
+             << "\r\n";
+  tmp_stream << "instantaneous_repl_apply_ops_per_sec:" << g_pika_server->InstantaneousReplApplyOps() << "\r\n";
+  tmp_stream << "repl_apply_pending_cmds:" << repl_apply_pending << "\r\n";
+  tmp_stream << "repl_apply_lag_ms:" << repl_apply_lag_us / 1000 << "\r\n";
+  uint64_t repl_apply_waited = 0;
+  uint64_t repl_apply_barriers = 0;
+  g_pika_rm->GetWriteDBDependencyStatus(&repl_apply_waited, &repl_apply_barriers);
+  tmp_stream << "repl_apply_waited_cmds:" << repl_apply_waited << "\r\n";
+  tmp_stream << "repl_apply_barrier_cmds:" << repl_apply_barriers << "\r\n";
+  uint64_t repl_apply_merged = 0;
+  uint64_t repl_apply_throttled = 0;
+  g_pika_rm->GetWriteDBMergeStatus(&repl_apply_merged, &repl_apply_throttled);
+  tmp_stream << "repl_apply_merged_cmds:" << repl_apply_merged << "\r\n";
+  tmp_stream << "repl_apply_throttled_cmds:" << repl_apply_throttled << "\r\n";
+
+  BinlogCompressionStats& sent_stats = g_pika_rm->BinlogSentStats();
+  BinlogCompressionStats& recv_stats = g_pika_rm->BinlogRecvStats();
+  tmp_stream << "replication_compression:" << g_pika_conf->replication_compression() << "\r\n";
+  tmp_stream << "binlog_sent_batches:" << sent_stats.batches << "\r\n";
+  tmp_stream << "binlog_sent_compressed_batches:" << sent_stats.compressed_batches << "\r\n";
+  tmp_stream << "binlog_sent_raw_bytes:" << sent_stats.raw_bytes << "\r\n";
+  tmp_stream << "binlog_sent_bytes:" << sent_stats.bytes << "\r\n";
+  tmp_stream << "binlog_sent_compression_ratio:" << sent_stats.Ratio() << "\r\n";
+  tmp_stream << "binlog_compress_us:" << sent_stats.codec_us << "\r\n";
+  tmp_stream << "instantaneous_binlog_sent_kbps:" << g_pika_server->InstantaneousBinlogSentKbps() << "\r\n";
+  tmp_stream << "binlog_recv_batches:" << recv_stats.batches << "\r\n";
+  tmp_stream << "binlog_recv_compressed_batches:" << recv_stats.compressed_batches << "\r\n";
+  tmp_stream << "binlog_recv_raw_bytes:" << recv_stats.raw_bytes << "\r\n";
+  tmp_stream << "binlog_recv_bytes:" << recv_stats.bytes << "\r\n";
+  tmp_stream << "binlog_recv_compression_ratio:" << recv_stats.Ratio() << "\r\n";
+  tmp_stream << "binlog_uncompress_us:" << recv_stats.codec_us << "\r\n";
+  tmp_stream << "instantaneous_binlog_recv_kbps:" << g_pika_server->InstantaneousBinlogRecvKbps() << "\r\n";
 
   info.append(tmp_stream.str());
 }
@@ -1201,6 +1298,7 @@ void InfoCmd::InfoKeyspace(std::string& info) {
   std::string db_name;
   KeyScanInfo key_scan_info;
   int32_t duration;
+  bool exact;
   std::vector<storage::KeyInfo> key_infos;
   std::stringstream tmp_stream;
   tmp_stream << "# Keyspace"
@@ -1219,12 +1317,16 @@ void InfoCmd::InfoKeyspace(std::string& info) {
     if (keyspace_scan_dbs_.empty() || keyspace_scan_dbs_.find(db_item.first) != keyspace_scan_dbs_.end()) {
       db_name = db_item.second->GetDBName();
       key_scan_info = db_item.second->GetKeyScanInfo();
-      key_infos = key_scan_info.key_infos;
+      exact = db_item.second->GetKeyStatistics(&key_infos);
       duration = key_scan_info.duration;
       if (key_infos.size() != 5) {
         info.append("info keyspace error\r\n");
         return;
       }
+      // The keys are counted as they are written, the last async statistics
+      // recounts them when they are estimated after an unclean shutdown. The
+      // string keys are always estimated unless exact-key-statistics is on
+      tmp_stream << "# Statistics: " << (exact ? "exact" : "estimated") << "\r\n";
       tmp_stream << "# Time:" << key_scan_info.s_start_time << "\r\n";
       if (duration == -2) {
         tmp_stream << "# Duration: "
@@ -1474,12 +1576,60 @@ void ConfigCmd::ConfigGet(std::string& ret) {
     EncodeNumber(&config_body, g_pika_conf->thread_pool_size());
   }
 
+  if (pstd::stringmatch(pattern.data(), "thread-pool-work-stealing", 1) != 0) {
+    elements += 2;
+    EncodeString(&config_body, "thread-pool-work-stealing");
+    EncodeString(&config_body, g_pika_conf->thread_pool_work_stealing() ? "yes" : "no");
+  }
+
+  if (pstd::stringmatch(pattern.data(), "slow-cmd-thread-pool-size", 1) != 0) {
+    elements += 2;
+    EncodeString(&config_body, "slow-cmd-thread-pool-size");
+    EncodeNumber(&config_body, g_pika_conf->slow_cmd_thread_pool_size());
+  }
+
+  if (pstd::stringmatch(pattern.data(), "slow-cmd-max-queue-size", 1) != 0) {
+    elements += 2;
+    EncodeString(&config_body, "slow-cmd-max-queue-size");
+    EncodeNumber(&config_body, g_pika_conf->slow_cmd_max_queue_size());
+  }
+
+  if (pstd::stringmatch(pattern.data(), "reply-zerocopy-threshold", 1) != 0) {
+    elements += 2;
+    EncodeString(&config_body, "reply-zerocopy-threshold");
+    EncodeNumber(&config_body, g_pika_conf->reply_zerocopy_threshold());
+  }
+
+  if (pstd::stringmatch(pattern.data(), "pubsub-thread-num", 1) != 0) {
+    elements += 2;
+    EncodeString(&config_body, "pubsub-thread-num");
+    EncodeNumber(&config_body, g_pika_conf->pubsub_thread_num());
+  }
+
+  if (pstd::stringmatch(pattern.data(), "pubsub-output-buffer-limit", 1) != 0) {
+    elements += 2;
+    EncodeString(&config_body, "pubsub-output-buffer-limit");
+    EncodeNumber(&config_body, g_pika_conf->pubsub_output_buffer_limit());
+  }
+
   if (pstd::stringmatch(pattern.data(), "sync-thread-num", 1) != 0) {
     elements += 2;
     EncodeString(&config_body, "sync-thread-num");
     EncodeNumber(&config_body, g_pika_conf->sync_thread_num());
   }
 
+  if (pstd::stringmatch(pattern.data(), "replica-apply-batch-size", 1) != 0) {
+    elements += 2;
+    EncodeString(&config_body, "replica-apply-batch-size");
+    EncodeNumber(&config_body, g_pika_conf->replica_apply_batch_size());
+  }
+
+  if (pstd::stringmatch(pattern.data(), "db-open-threads", 1) != 0) {
+    elements += 2;
+    EncodeString(&config_body, "db-open-threads");
+    EncodeNumber(&config_body, g_pika_conf->db_open_threads());
+  }
+
   if (pstd::stringmatch(pattern.data(), "log-path", 1) != 0) {
     elements += 2;
     EncodeString(&config_body, "log-path");
@@ -1618,6 +1768,42 @@ void ConfigCmd::ConfigGet(std::string& ret) {
     EncodeNumber(&config_body, g_pika_conf->small_compaction_threshold());
   }
 
+  if (pstd::stringmatch(pattern.data(), "zset-rank-index", 1) != 0) {
+    elements += 2;
+    EncodeString(&config_body, "zset-rank-index");
+    EncodeString(&config_body, g_pika_conf->zset_rank_index() ? "yes" : "no");
+  }
+
+  if (pstd::stringmatch(pattern.data(), "exact-key-statistics", 1) != 0) {
+    elements += 2;
+    EncodeString(&config_body, "exact-key-statistics");
+    EncodeString(&config_body, g_pika_conf->exact_key_statistics() ? "yes" : "no");
+  }
+
+  if (pstd::stringmatch(pattern.data(), "list-chunk-size", 1) != 0) {
+    elements += 2;
+    EncodeString(&config_body, "list-chunk-size");
+    EncodeString(&config_body, g_pika_conf->list_chunk_size());
+  }
+
+  if (pstd::stringmatch(pattern.data(), "active-expire-cycle-ms", 1) != 0) {
+    elements += 2;
+    EncodeString(&config_body, "active-expire-cycle-ms");
+    EncodeNumber(&config_body, g_pika_conf->active_expire_cycle_ms());
+  }
+
+  if (pstd::stringmatch(pattern.data(), "active-expire-batch-size", 1) != 0) {
+    elements += 2;
+    EncodeString(&config_body, "active-expire-batch-size");
+    EncodeNumber(&config_body, g_pika_conf->active_expire_batch_size());
+  }
+
+  if (pstd::stringmatch(pattern.data(), "value-cache-size", 1) != 0) {
+    elements += 2;
+    EncodeString(&config_body, "value-cache-size");
+    EncodeNumber(&config_body, g_pika_conf->value_cache_size());
+  }
+
   if (pstd::stringmatch(pattern.data(), "max-background-flushes", 1) != 0) {
     elements += 2;
     EncodeString(&config_body, "max-background-flushes");
@@ -1811,6 +1997,18 @@ void ConfigCmd::ConfigGet(std::string& ret) {
     EncodeNumber(&config_body, g_pika_conf->sync_window_size());
   }
 
+  if (pstd::stringmatch(pattern.data(), "sync-window-bytes", 1) != 0) {
+    elements += 2;
+    EncodeString(&config_body, "sync-window-bytes");
+    EncodeNumber(&config_body, g_pika_conf->sync_window_bytes());
+  }
+
+  if (pstd::stringmatch(pattern.data(), "replication-compression", 1) != 0) {
+    elements += 2;
+    EncodeString(&config_body, "replication-compression");
+    EncodeString(&config_body, g_pika_conf->replication_compression());
+  }
+
   if (pstd::stringmatch(pattern.data(), "max-conn-rbuf-size", 1) != 0) {
     elements += 2;
     EncodeString(&config_body, "max-conn-rbuf-size");
@@ -2000,6 +2198,7 @@ void ConfigCmd::ConfigSet(std::string& ret) {
     EncodeString(&ret, "compact-interval");
     EncodeString(&ret, "slave-priority");
     EncodeString(&ret, "sync-window-size");
+    EncodeString(&ret, "sync-window-bytes");
     // Options for storage engine
     // MutableDBOptions
     EncodeString(&ret, "max-cache-files");
@@ -2228,6 +2427,13 @@ void ConfigCmd::ConfigSet(std::string& ret) {
     }
     g_pika_conf->SetSyncWindowSize(static_cast<int>(ival));
     ret = "+OK\r\n";
+  } else if (set_item == "sync-window-bytes") {
+    if (pstd::string2int(value.data(), value.size(), &ival) == 0 || ival <= 0) {
+      ret = "-ERR Invalid argument \'" + value + "\' for CONFIG SET 'sync-window-bytes'\r\n";
+      return;
+    }
+    g_pika_conf->SetSyncWindowBytes(ival);
+    ret = "+OK\r\n";
   } else if (set_item == "max-cache-files") {
     if (pstd::string2int(value.data(), value.size(), &ival) == 0) {
       ret = "-ERR Invalid argument \'" + value + "\' for CONFIG SET 'max-cache-files'\r\n";
@@ -2383,8 +2589,8 @@ void DbsizeCmd::Do(std::shared_ptr<Slot> slot) {
   if (!db) {
     res_.SetRes(CmdRes::kInvalidDB);
   } else {
-    KeyScanInfo key_scan_info = db->GetKeyScanInfo();
-    std::vector<storage::KeyInfo> key_infos = key_scan_info.key_infos;
+    std::vector<storage::KeyInfo> key_infos;
+    db->GetKeyStatistics(&key_infos);
     if (key_infos.size() != 5) {
       res_.SetRes(CmdRes::kErrOther, "keyspace error");
       return;
@@ -2963,8 +3169,6 @@ void CommandCmd::DoInitial() {
   cmds_end_ = argv_.cend();
 }
 
-extern std::unique_ptr<PikaCmdTableManager> g_pika_cmd_table_manager;
-
 void CommandCmd::Do(std::shared_ptr<Slot> slots) {
   std::unordered_map<std::string, CommandCmd::EncodablePtr> cmds;
   std::unordered_map<std::string, CommandCmd::EncodablePtr> specializations;
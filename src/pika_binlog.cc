@@ -60,11 +60,15 @@ Status Version::Init() {
 /*
  * Binlog
  */
-Binlog::Binlog(std::string  binlog_path, const int file_size)
+Binlog::Binlog(std::string  binlog_path, const int file_size, bool group_commit, uint64_t group_commit_max_bytes,
+               bool sync_on_commit)
     : opened_(false),
       binlog_path_(std::move(binlog_path)),
       file_size_(file_size),
-      binlog_io_error_(false) {
+      binlog_io_error_(false),
+      group_commit_(group_commit),
+      group_commit_max_bytes_(group_commit_max_bytes),
+      sync_on_commit_(sync_on_commit) {
   // To intergrate with old version, we don't set mmap file size to 100M;
   // pstd::SetMmapBoundSize(file_size);
   // pstd::kMmapBoundSize = 1024 * 1024 * 100;
@@ -164,77 +168,176 @@ Status Binlog::GetProducerStatus(uint32_t* filenum, uint64_t* pro_offset, uint32
   return Status::OK();
 }
 
-// Note: mutex lock should be held
 Status Binlog::Put(const std::string& item) {
+  uint32_t filenum = 0;
+  uint64_t offset = 0;
+  return Put(item, &filenum, &offset);
+}
+
+/*
+ * Every Put enqueues itself into writers_, the writer at the front becomes
+ * the leader, it encodes itself and the writers queued behind it into one
+ * buffer, appends the buffer under mutex_ and then wakes up the followers.
+ */
+Status Binlog::Put(const std::string& item, uint32_t* filenum, uint64_t* offset) {
   if (!opened_.load()) {
     return Status::Busy("Binlog is not open yet");
   }
+  uint64_t start_us = pstd::NowMicros();
+
+  Writer w(&item);
+  std::unique_lock wl(writers_mu_);
+  writers_.push_back(&w);
+  while (!w.done && &w != writers_.front()) {
+    w.cv.wait(wl);
+  }
+
+  if (!w.done) {
+    std::vector<Writer*> group;
+    uint64_t group_bytes = 0;
+    for (Writer* writer : writers_) {
+      if (!group.empty() && (!group_commit_ || group_bytes + writer->item->size() > group_commit_max_bytes_)) {
+        break;
+      }
+      group.push_back(writer);
+      group_bytes += writer->item->size();
+    }
+    wl.unlock();
+
+    {
+      std::lock_guard l(mutex_);
+      WriteGroup(group);
+    }
+
+    wl.lock();
+    for (Writer* writer : group) {
+      assert(writer == writers_.front());
+      writers_.pop_front();
+      if (writer != &w) {
+        writer->done = true;
+        writer->cv.notify_one();
+      }
+    }
+    if (!writers_.empty()) {
+      writers_.front()->cv.notify_one();
+    }
+  }
+  wl.unlock();
+
+  group_commit_wait_us_.fetch_add(pstd::NowMicros() - start_us, std::memory_order_relaxed);
+  *filenum = w.filenum;
+  *offset = w.offset;
+  return w.status;
+}
+
+// Note: mutex lock should be held
+Status Binlog::WriteGroup(const std::vector<Writer*>& group) {
   uint32_t filenum = 0;
   uint32_t term = 0;
   uint64_t offset = 0;
   uint64_t logic_id = 0;
 
-  Lock();
-  DEFER {
-    Unlock();
-  };
-
   Status s = GetProducerStatus(&filenum, &offset, &term, &logic_id);
-  if (!s.ok()) {
-    return s;
+  if (s.ok()) {
+    uint32_t pending = 0;
+    for (Writer* writer : group) {
+      /* Check to roll log file */
+      if (queue_->Filesize() + batch_buf_.size() > file_size_) {
+        s = FlushBatchBuffer(offset, logic_id, pending);
+        if (s.ok()) {
+          s = RollFile();
+        }
+        if (!s.ok()) {
+          break;
+        }
+        pending = 0;
+        filenum = pro_num_;
+        offset = 0;
+      }
+
+      logic_id++;
+      std::string data = PikaBinlogTransverter::BinlogEncode(BinlogType::TypeFirst,
+          time(nullptr), term, logic_id, filenum, offset, *writer->item, {});
+      Produce(pstd::Slice(data.data(), data.size()), &offset);
+      pending++;
+      writer->filenum = filenum;
+      writer->offset = offset;
+    }
+    if (s.ok()) {
+      s = FlushBatchBuffer(offset, logic_id, pending);
+    }
   }
-  logic_id++;
-  std::string data = PikaBinlogTransverter::BinlogEncode(BinlogType::TypeFirst,
-      time(nullptr), term, logic_id, filenum, offset, item, {});
+  batch_buf_.clear();
 
-  s = Put(data.c_str(), static_cast<int>(data.size()));
   if (!s.ok()) {
     binlog_io_error_.store(true);
   }
+  for (Writer* writer : group) {
+    writer->status = s;
+  }
+
+  uint64_t group_size = group.size();
+  group_commit_batches_.fetch_add(1, std::memory_order_relaxed);
+  group_commit_items_.fetch_add(group_size, std::memory_order_relaxed);
+  if (group_size > group_commit_max_batch_.load(std::memory_order_relaxed)) {
+    group_commit_max_batch_.store(group_size, std::memory_order_relaxed);
+  }
   return s;
 }
 
 // Note: mutex lock should be held
-Status Binlog::Put(const char* item, int len) {
-  Status s;
-
-  /* Check to roll log file */
-  uint64_t filesize = queue_->Filesize();
-  if (filesize > file_size_) {
-    std::unique_ptr<pstd::WritableFile> queue;
-    std::string profile = NewFileName(filename_, pro_num_ + 1);
-    s = pstd::NewWritableFile(profile, queue);
-    if (!s.ok()) {
-      LOG(ERROR) << "Binlog: new " << filename_ << " " << s.ToString();
-      return s;
-    }
-    queue_.reset();
-    queue_ = std::move(queue);
-    pro_num_++;
+Status Binlog::FlushBatchBuffer(uint64_t pro_offset, uint64_t logic_id, uint32_t items) {
+  if (items == 0) {
+    return Status::OK();
+  }
 
-    {
-      std::lock_guard l(version_->rwlock_);
-      version_->pro_offset_ = 0;
-      version_->pro_num_ = pro_num_;
-      version_->StableSave();
-    }
-    InitLogFile();
+  Status s = queue_->Append(pstd::Slice(batch_buf_.data(), batch_buf_.size()));
+  if (s.ok()) {
+    s = queue_->Flush();
+  }
+  if (s.ok() && sync_on_commit_) {
+    s = queue_->Sync();
+  }
+  // Do not keep the memory of an oversized item around
+  if (batch_buf_.capacity() > 2 * group_commit_max_bytes_) {
+    std::string().swap(batch_buf_);
+  } else {
+    batch_buf_.clear();
   }
 
-  int pro_offset;
-  s = Produce(pstd::Slice(item, len), &pro_offset);
   if (s.ok()) {
     std::lock_guard l(version_->rwlock_);
     version_->pro_offset_ = pro_offset;
-    version_->logic_id_++;
+    version_->logic_id_ = logic_id;
     version_->StableSave();
   }
-
   return s;
 }
 
-Status Binlog::EmitPhysicalRecord(RecordType t, const char* ptr, size_t n, int* temp_pro_offset) {
-  Status s;
+// Note: mutex lock should be held
+Status Binlog::RollFile() {
+  std::unique_ptr<pstd::WritableFile> queue;
+  std::string profile = NewFileName(filename_, pro_num_ + 1);
+  Status s = pstd::NewWritableFile(profile, queue);
+  if (!s.ok()) {
+    LOG(ERROR) << "Binlog: new " << filename_ << " " << s.ToString();
+    return s;
+  }
+  queue_.reset();
+  queue_ = std::move(queue);
+  pro_num_++;
+
+  {
+    std::lock_guard l(version_->rwlock_);
+    version_->pro_offset_ = 0;
+    version_->pro_num_ = pro_num_;
+    version_->StableSave();
+  }
+  InitLogFile();
+  return Status::OK();
+}
+
+void Binlog::EmitPhysicalRecord(RecordType t, const char* ptr, size_t n, uint64_t* temp_pro_offset) {
   assert(n <= 0xffffff);
   assert(block_offset_ + kHeaderSize + n <= kBlockSize);
 
@@ -253,35 +356,24 @@ Status Binlog::EmitPhysicalRecord(RecordType t, const char* ptr, size_t n, int*
   buf[6] = static_cast<char>((now & 0xff000000) >> 24);
   buf[7] = static_cast<char>(t);
 
-  s = queue_->Append(pstd::Slice(buf, kHeaderSize));
-  if (s.ok()) {
-    s = queue_->Append(pstd::Slice(ptr, n));
-    if (s.ok()) {
-      s = queue_->Flush();
-    }
-  }
+  batch_buf_.append(buf, kHeaderSize);
+  batch_buf_.append(ptr, n);
   block_offset_ += static_cast<int32_t>(kHeaderSize + n);
 
-  *temp_pro_offset += static_cast<int32_t>(kHeaderSize + n);
-  return s;
+  *temp_pro_offset += kHeaderSize + n;
 }
 
-Status Binlog::Produce(const pstd::Slice& item, int* temp_pro_offset) {
-  Status s;
+void Binlog::Produce(const pstd::Slice& item, uint64_t* temp_pro_offset) {
   const char* ptr = item.data();
   size_t left = item.size();
   bool begin = true;
 
-  *temp_pro_offset = static_cast<int>(version_->pro_offset_);
   do {
     const int leftover = static_cast<int>(kBlockSize) - block_offset_;
     assert(leftover >= 0);
     if (static_cast<size_t>(leftover) < kHeaderSize) {
       if (leftover > 0) {
-        s = queue_->Append(pstd::Slice("\x00\x00\x00\x00\x00\x00\x00", leftover));
-        if (!s.ok()) {
-          return s;
-        }
+        batch_buf_.append("\x00\x00\x00\x00\x00\x00\x00", leftover);
         *temp_pro_offset += leftover;
       }
       block_offset_ = 0;
@@ -301,13 +393,11 @@ Status Binlog::Produce(const pstd::Slice& item, int* temp_pro_offset) {
       type = kMiddleType;
     }
 
-    s = EmitPhysicalRecord(type, ptr, fragment_length, temp_pro_offset);
+    EmitPhysicalRecord(type, ptr, fragment_length, temp_pro_offset);
     ptr += fragment_length;
     left -= fragment_length;
     begin = false;
-  } while (s.ok() && left > 0);
-
-  return s;
+  } while (left > 0);
 }
 
 Status Binlog::AppendPadding(pstd::WritableFile* file, uint64_t* len) {
@@ -0,0 +1,211 @@
+// Copyright (c) 2023-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#include "include/pika_binlog_chunk_reader.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+using pstd::Status;
+
+namespace {
+
+struct ChunkKey {
+  uint64_t dev;
+  uint64_t ino;
+  int64_t mtime;
+  uint64_t size;
+  uint64_t start;
+
+  bool operator==(const ChunkKey& other) const {
+    return dev == other.dev && ino == other.ino && mtime == other.mtime && size == other.size &&
+           start == other.start;
+  }
+};
+
+struct ChunkKeyHash {
+  size_t operator()(const ChunkKey& key) const {
+    return std::hash<uint64_t>()(key.ino) ^ (std::hash<uint64_t>()(key.start) << 1) ^ key.dev;
+  }
+};
+
+// The chunks of sealed files recently read by any reader
+class BinlogChunkCache {
+ public:
+  std::shared_ptr<BinlogChunk> Lookup(const ChunkKey& key) {
+    std::lock_guard l(mu_);
+    auto iter = index_.find(key);
+    if (iter == index_.end()) {
+      return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, iter->second);
+    return iter->second->second;
+  }
+
+  void Insert(const ChunkKey& key, const std::shared_ptr<BinlogChunk>& chunk) {
+    std::lock_guard l(mu_);
+    auto iter = index_.find(key);
+    if (iter != index_.end()) {
+      // Read by another reader meanwhile
+      lru_.splice(lru_.begin(), lru_, iter->second);
+      return;
+    }
+    lru_.emplace_front(key, chunk);
+    index_[key] = lru_.begin();
+    while (lru_.size() > kBinlogChunkCacheSize) {
+      index_.erase(lru_.back().first);
+      lru_.pop_back();
+    }
+  }
+
+ private:
+  std::mutex mu_;
+  // The most recently used first
+  std::list<std::pair<ChunkKey, std::shared_ptr<BinlogChunk>>> lru_;
+  std::unordered_map<ChunkKey, decltype(lru_)::iterator, ChunkKeyHash> index_;
+};
+
+BinlogChunkCache& ChunkCache() {
+  static BinlogChunkCache cache;
+  return cache;
+}
+
+}  // namespace
+
+BinlogChunkReader::~BinlogChunkReader() { Close(); }
+
+BinlogChunkStats& BinlogChunkReader::Stats() {
+  static BinlogChunkStats stats;
+  return stats;
+}
+
+void BinlogChunkReader::Close() {
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+  chunk_.reset();
+}
+
+Status BinlogChunkReader::Open(const std::string& filename, bool sealed) {
+  Close();
+  int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return Status::IOError(filename, strerror(errno));
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    int err = errno;
+    close(fd);
+    return Status::IOError(filename, strerror(err));
+  }
+#if !defined(__APPLE__)
+  // A slave reads a file from its offset to the end
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+  filename_ = filename;
+  fd_ = fd;
+  sealed_ = sealed;
+  file_dev_ = st.st_dev;
+  file_ino_ = st.st_ino;
+  file_mtime_ = st.st_mtime;
+  file_size_ = st.st_size;
+  offset_ = 0;
+  limit_ = kNoLimit;
+  return Status::OK();
+}
+
+Status BinlogChunkReader::Read(size_t n, pstd::Slice* result) {
+  *result = pstd::Slice();
+  if (fd_ < 0) {
+    return Status::Corruption("Not open");
+  }
+  uint64_t start = offset_ / kBinlogChunkSize * kBinlogChunkSize;
+  if (!chunk_ || chunk_->start != start) {
+    Status s = LoadChunk(start);
+    if (!s.ok()) {
+      return s;
+    }
+  }
+  uint64_t end = std::min({offset_ + n, start + kBinlogChunkSize, limit_});
+  if (!sealed_ && end > start + chunk_->size) {
+    Status s = ReadMore(chunk_.get(), end);
+    if (!s.ok()) {
+      return s;
+    }
+  }
+  uint64_t available_end = std::min(end, start + chunk_->size);
+  size_t available = available_end > offset_ ? available_end - offset_ : 0;
+  *result = pstd::Slice(chunk_->data.get() + (offset_ - start), available);
+  if (available < n) {
+    return Status::EndFile(filename_, "end file");
+  }
+  offset_ += n;
+  return Status::OK();
+}
+
+Status BinlogChunkReader::LoadChunk(uint64_t start) {
+  ChunkKey key{file_dev_, file_ino_, file_mtime_, file_size_, start};
+  if (sealed_) {
+    std::shared_ptr<BinlogChunk> chunk = ChunkCache().Lookup(key);
+    if (chunk) {
+      Stats().cache_hits++;
+      chunk_ = std::move(chunk);
+      return Status::OK();
+    }
+  }
+
+  auto chunk = std::make_shared<BinlogChunk>();
+  chunk->start = start;
+  // Not zeroed, it is read over right away
+  chunk->data.reset(new char[kBinlogChunkSize]);
+  // What the producer did not write yet is read on demand by Read
+  uint64_t end = start + kBinlogChunkSize;
+  if (!sealed_) {
+    end = std::max(start, std::min(end, limit_));
+  }
+  Status s = ReadMore(chunk.get(), end);
+  if (!s.ok()) {
+    return s;
+  }
+#if !defined(__APPLE__)
+  // Have the kernel read the next chunk meanwhile
+  posix_fadvise(fd_, static_cast<off_t>(start + kBinlogChunkSize), kBinlogChunkSize, POSIX_FADV_WILLNEED);
+#endif
+  if (sealed_) {
+    ChunkCache().Insert(key, chunk);
+  }
+  chunk_ = std::move(chunk);
+  return Status::OK();
+}
+
+Status BinlogChunkReader::ReadMore(BinlogChunk* chunk, uint64_t end) {
+  while (chunk->start + chunk->size < end) {
+    ssize_t r = pread(fd_, chunk->data.get() + chunk->size, end - chunk->start - chunk->size,
+                      static_cast<off_t>(chunk->start + chunk->size));
+    Stats().reads++;
+    if (r < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return Status::IOError(filename_, strerror(errno));
+    }
+    if (r == 0) {
+      break;
+    }
+    chunk->size += r;
+    Stats().read_bytes += r;
+  }
+  return Status::OK();
+}
@@ -0,0 +1,102 @@
+// Copyright (c) 2023-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#include "include/pika_binlog_compression.h"
+
+#include <memory>
+
+#include <lz4.h>
+#include <zstd.h>
+
+// Fast enough to keep up with a burst of writes, the dictionary of a whole
+// batch does most of the work
+static const int kZstdLevel = 1;
+
+namespace {
+
+struct ZstdCCtxDeleter {
+  void operator()(ZSTD_CCtx* cctx) const { ZSTD_freeCCtx(cctx); }
+};
+
+struct ZstdDCtxDeleter {
+  void operator()(ZSTD_DCtx* dctx) const { ZSTD_freeDCtx(dctx); }
+};
+
+}  // namespace
+
+bool BinlogCompressionFromName(const std::string& name, InnerMessage::CompressionType* type) {
+  if (name == "none") {
+    *type = InnerMessage::kCompressionNone;
+  } else if (name == "lz4") {
+    *type = InnerMessage::kCompressionLz4;
+  } else if (name == "zstd") {
+    *type = InnerMessage::kCompressionZstd;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+std::string BinlogCompressionName(InnerMessage::CompressionType type) {
+  switch (type) {
+    case InnerMessage::kCompressionLz4:
+      return "lz4";
+    case InnerMessage::kCompressionZstd:
+      return "zstd";
+    default:
+      return "none";
+  }
+}
+
+bool CompressBinlogChips(InnerMessage::CompressionType type, const std::string& raw, std::string* compressed) {
+  switch (type) {
+    case InnerMessage::kCompressionLz4: {
+      int bound = LZ4_compressBound(static_cast<int>(raw.size()));
+      if (bound <= 0) {
+        return false;
+      }
+      compressed->resize(bound);
+      int size = LZ4_compress_default(raw.data(), compressed->data(), static_cast<int>(raw.size()), bound);
+      if (size <= 0) {
+        return false;
+      }
+      compressed->resize(size);
+      return true;
+    }
+    case InnerMessage::kCompressionZstd: {
+      // A context for every sender thread, so it is set up only once
+      thread_local std::unique_ptr<ZSTD_CCtx, ZstdCCtxDeleter> cctx(ZSTD_createCCtx());
+      compressed->resize(ZSTD_compressBound(raw.size()));
+      size_t size =
+          ZSTD_compressCCtx(cctx.get(), compressed->data(), compressed->size(), raw.data(), raw.size(), kZstdLevel);
+      if (ZSTD_isError(size) != 0U) {
+        return false;
+      }
+      compressed->resize(size);
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+bool UncompressBinlogChips(InnerMessage::CompressionType type, const std::string& compressed, size_t raw_size,
+                           std::string* raw) {
+  raw->resize(raw_size);
+  switch (type) {
+    case InnerMessage::kCompressionLz4: {
+      int size = LZ4_decompress_safe(compressed.data(), raw->data(), static_cast<int>(compressed.size()),
+                                     static_cast<int>(raw_size));
+      return size >= 0 && static_cast<size_t>(size) == raw_size;
+    }
+    case InnerMessage::kCompressionZstd: {
+      thread_local std::unique_ptr<ZSTD_DCtx, ZstdDCtxDeleter> dctx(ZSTD_createDCtx());
+      size_t size = ZSTD_decompressDCtx(dctx.get(), raw->data(), raw_size, compressed.data(), compressed.size());
+      return ZSTD_isError(size) == 0U && size == raw_size;
+    }
+    default:
+      return false;
+  }
+}
@@ -10,16 +10,11 @@
 using pstd::Status;
 
 PikaBinlogReader::PikaBinlogReader(uint32_t cur_filenum, uint64_t cur_offset)
-    : cur_filenum_(cur_filenum),
-      cur_offset_(cur_offset),
-      backing_store_(std::make_unique<char[]>(kBlockSize)),
-      buffer_() {
+    : cur_filenum_(cur_filenum), cur_offset_(cur_offset), buffer_() {
   last_record_offset_ = cur_offset % kBlockSize;
 }
 
-PikaBinlogReader::PikaBinlogReader() : backing_store_(std::make_unique<char[]>(kBlockSize)), buffer_() {
-  last_record_offset_ = 0 % kBlockSize;
-}
+PikaBinlogReader::PikaBinlogReader() : buffer_() { last_record_offset_ = 0 % kBlockSize; }
 
 void PikaBinlogReader::GetReaderStatus(uint32_t* cur_filenum, uint64_t* cur_offset) {
   std::shared_lock l(rwlock_);
@@ -35,31 +30,43 @@ bool PikaBinlogReader::ReadToTheEnd() {
   return (pro_num == cur_filenum_ && pro_offset == cur_offset_);
 }
 
+Status PikaBinlogReader::OpenFile(uint32_t filenum) {
+  std::string confile = NewFileName(logger_->filename(), filenum);
+  uint32_t pro_num = 0;
+  uint64_t pro_offset = 0;
+  logger_->GetProducerStatus(&pro_num, &pro_offset);
+  auto readfile = std::make_unique<BinlogChunkReader>();
+  // The producer rolled over already, so the file does not change anymore
+  Status s = readfile->Open(confile, filenum < pro_num);
+  if (!s.ok()) {
+    return s;
+  }
+  // Beyond the producer offset a file being written holds the zeros it is
+  // preallocated with
+  readfile->SetLimit(filenum == pro_num ? pro_offset : BinlogChunkReader::kNoLimit);
+  queue_ = std::move(readfile);
+  return Status::OK();
+}
+
 int PikaBinlogReader::Seek(const std::shared_ptr<Binlog>& logger, uint32_t filenum, uint64_t offset) {
   std::string confile = NewFileName(logger->filename(), filenum);
   if (!pstd::FileExists(confile)) {
     LOG(WARNING) << confile << " not exits";
     return -1;
   }
-  std::unique_ptr<pstd::SequentialFile> readfile;
-  if (!pstd::NewSequentialFile(confile, readfile).ok()) {
-    LOG(WARNING) << "New swquential " << confile << " failed";
+  logger_ = logger;
+  if (!OpenFile(filenum).ok()) {
+    LOG(WARNING) << "Open " << confile << " failed";
     return -1;
   }
-  if (queue_) {
-    queue_.reset();
-  }
-  queue_ = std::move(readfile);
-  logger_ = logger;
 
   std::lock_guard l(rwlock_);
   cur_filenum_ = filenum;
   cur_offset_ = offset;
   last_record_offset_ = cur_filenum_ % kBlockSize;
 
-  pstd::Status s;
   uint64_t start_block = (cur_offset_ / kBlockSize) * kBlockSize;
-  s = queue_->Skip((cur_offset_ / kBlockSize) * kBlockSize);
+  queue_->Skip((cur_offset_ / kBlockSize) * kBlockSize);
   uint64_t block_offset = cur_offset_ % kBlockSize;
   uint64_t ret = 0;
   uint64_t res = 0;
@@ -88,7 +95,7 @@ bool PikaBinlogReader::GetNext(uint64_t* size) {
 
   while (true) {
     buffer_.clear();
-    s = queue_->Read(kHeaderSize, &buffer_, backing_store_.get());
+    s = queue_->Read(kHeaderSize, &buffer_);
     if (!s.ok()) {
       is_error = true;
       return is_error;
@@ -106,21 +113,21 @@ bool PikaBinlogReader::GetNext(uint64_t* size) {
     }
 
     if (type == kFullType) {
-      s = queue_->Read(length, &buffer_, backing_store_.get());
+      s = queue_->Read(length, &buffer_);
       offset += kHeaderSize + length;
       break;
     } else if (type == kFirstType) {
-      s = queue_->Read(length, &buffer_, backing_store_.get());
+      s = queue_->Read(length, &buffer_);
       offset += kHeaderSize + length;
     } else if (type == kMiddleType) {
-      s = queue_->Read(length, &buffer_, backing_store_.get());
+      s = queue_->Read(length, &buffer_);
       offset += kHeaderSize + length;
     } else if (type == kLastType) {
-      s = queue_->Read(length, &buffer_, backing_store_.get());
+      s = queue_->Read(length, &buffer_);
       offset += kHeaderSize + length;
       break;
     } else if (type == kBadRecord) {
-      s = queue_->Read(length, &buffer_, backing_store_.get());
+      s = queue_->Read(length, &buffer_);
       offset += kHeaderSize + length;
       break;
     } else {
@@ -141,7 +148,7 @@ unsigned int PikaBinlogReader::ReadPhysicalRecord(pstd::Slice* result, uint32_t*
     last_record_offset_ = 0;
   }
   buffer_.clear();
-  s = queue_->Read(kHeaderSize, &buffer_, backing_store_.get());
+  s = queue_->Read(kHeaderSize, &buffer_);
   if (s.IsEndFile()) {
     return kEof;
   } else if (!s.ok()) {
@@ -165,7 +172,7 @@ unsigned int PikaBinlogReader::ReadPhysicalRecord(pstd::Slice* result, uint32_t*
   }
 
   buffer_.clear();
-  s = queue_->Read(length, &buffer_, backing_store_.get());
+  s = queue_->Read(length, &buffer_);
   *result = pstd::Slice(buffer_.data(), buffer_.size());
   last_record_offset_ += kHeaderSize + length;
   if (s.ok()) {
@@ -231,9 +238,17 @@ Status PikaBinlogReader::Get(std::string* scratch, uint32_t* filenum, uint64_t*
   Status s = Status::OK();
 
   do {
-    if (ReadToTheEnd()) {
-      return Status::EndFile("End of cur log file");
+    uint32_t pro_num = 0;
+    uint64_t pro_offset = 0;
+    logger_->GetProducerStatus(&pro_num, &pro_offset);
+    {
+      std::shared_lock l(rwlock_);
+      if (pro_num == cur_filenum_ && pro_offset == cur_offset_) {
+        return Status::EndFile("End of cur log file");
+      }
     }
+    // What the producer wrote since the last time is read on
+    queue_->SetLimit(pro_num == cur_filenum_ ? pro_offset : BinlogChunkReader::kNoLimit);
     s = Consume(scratch, filenum, offset);
     if (s.IsEndFile()) {
       std::string confile = NewFileName(logger_->filename(), cur_filenum_ + 1);
@@ -244,10 +259,10 @@ Status PikaBinlogReader::Get(std::string* scratch, uint32_t* filenum, uint64_t*
       // Roll to next file need retry;
       if (pstd::FileExists(confile)) {
         DLOG(INFO) << "BinlogSender roll to new binlog" << confile;
-        queue_.reset();
-        queue_ = nullptr;
-
-        pstd::NewSequentialFile(confile, queue_);
+        Status open_s = OpenFile(cur_filenum_ + 1);
+        if (!open_s.ok()) {
+          return open_s;
+        }
         {
           std::lock_guard l(rwlock_);
           cur_filenum_++;
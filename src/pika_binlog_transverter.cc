@@ -62,6 +62,7 @@ std::string PikaBinlogTransverter::BinlogEncode(BinlogType type, uint32_t exec_t
                                                 uint64_t logic_id, uint32_t filenum, uint64_t offset,
                                                 const std::string& content, const std::vector<std::string>& extends) {
   std::string binlog;
+  binlog.reserve(BINLOG_ITEM_HEADER_SIZE + content.size());
   pstd::PutFixed16(&binlog, type);
   pstd::PutFixed32(&binlog, exec_time);
   pstd::PutFixed32(&binlog, term_id);
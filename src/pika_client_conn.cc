@@ -24,7 +24,18 @@ extern PikaServer* g_pika_server;
 extern std::unique_ptr<PikaReplicaManager> g_pika_rm;
 extern std::unique_ptr<PikaCmdTableManager> g_pika_cmd_table_manager;
 
-
+// The name of the command in the table
+static std::string CmdOpt(const PikaCmdArgsType& argv) {
+  std::string opt = argv[0];
+  pstd::StringToLower(opt);
+  if (opt == kClusterPrefix) {
+    if (argv.size() >= 2) {
+      opt += argv[1];
+      pstd::StringToLower(opt);
+    }
+  }
+  return opt;
+}
 
 PikaClientConn::PikaClientConn(int fd, const std::string& ip_port, net::Thread* thread, net::NetMultiplexer* mpx,
                                const net::HandleType& handle_type, int max_conn_rbuf_size)
@@ -33,9 +44,10 @@ PikaClientConn::PikaClientConn(int fd, const std::string& ip_port, net::Thread*
       current_db_(g_pika_conf->default_db()) {
   auth_stat_.Init();
   time_stat_.reset(new TimeStat());
+  SetZeroCopyThreshold(g_pika_conf->reply_zerocopy_threshold());
 }
 
-std::shared_ptr<Cmd> PikaClientConn::DoCmd(const PikaCmdArgsType& argv, const std::string& opt,
+std::shared_ptr<Cmd> PikaClientConn::DoCmd(PikaCmdArgsType& argv, const std::string& opt,
                                            const std::shared_ptr<std::string>& resp_ptr) {
   // Get command info
   std::shared_ptr<Cmd> c_ptr = g_pika_cmd_table_manager->GetCmd(opt);
@@ -62,8 +74,8 @@ std::shared_ptr<Cmd> PikaClientConn::DoCmd(const PikaCmdArgsType& argv, const st
     ProcessMonitor(argv);
   }
 
-  // Initial
-  c_ptr->Initial(argv, current_db_);
+  // Initial, the arguments are moved into the command
+  c_ptr->Initial(std::move(argv), current_db_);
   if (!c_ptr->res().ok()) {
     if (IsInTxn()) {
       SetTxnInitFailState(true);
@@ -99,12 +111,13 @@ std::shared_ptr<Cmd> PikaClientConn::DoCmd(const PikaCmdArgsType& argv, const st
     return c_ptr;
   }
 
+  std::vector<std::string> cur_key;
   if (c_ptr->is_write()) {
     if (g_pika_server->IsDBBinlogIoError(current_db_)) {
       c_ptr->res().SetRes(CmdRes::kErrOther, "Writing binlog failed, maybe no space left on device");
       return c_ptr;
     }
-    std::vector<std::string> cur_key = c_ptr->current_key();
+    cur_key = c_ptr->current_key();
     if (cur_key.empty() && opt != kCmdNameExec) {
       c_ptr->res().SetRes(CmdRes::kErrOther, "Internal ERROR");
       return c_ptr;
@@ -129,16 +142,18 @@ std::shared_ptr<Cmd> PikaClientConn::DoCmd(const PikaCmdArgsType& argv, const st
     } else if (c_ptr->name() == kCmdNameFlushall) {
       SetAllTxnFailed();
     } else {
-      auto table_keys = c_ptr->current_key();
-      for (auto& key : table_keys) {
-        key = c_ptr->db_name().append(key);
+      for (auto& key : cur_key) {
+        key.insert(0, c_ptr->db_name());
       }
-      SetTxnFailedFromKeys(table_keys);
+      SetTxnFailedFromKeys(cur_key);
     }
   }
 
   if (g_pika_conf->slowlog_slower_than() >= 0) {
-    ProcessSlowlog(argv, c_ptr->GetDoDuration());
+    // The time in the queue does not tell whether the command is slow
+    g_pika_cmd_table_manager->UpdateCmdDuration(opt, c_ptr->GetDoDuration(),
+                                                static_cast<uint64_t>(g_pika_conf->slowlog_slower_than()));
+    ProcessSlowlog(c_ptr->argv(), c_ptr->GetDoDuration());
   }
 
   return c_ptr;
@@ -183,15 +198,23 @@ void PikaClientConn::ProcessMonitor(const PikaCmdArgsType& argv) {
   g_pika_server->AddMonitorMessage(monitor_message);
 }
 
-void PikaClientConn::ProcessRedisCmds(const std::vector<net::RedisCmdArgsType>& argvs, bool async,
+void PikaClientConn::ProcessRedisCmds(std::vector<net::RedisCmdArgsType>& argvs, bool async,
                                       std::string* response) {
   time_stat_->Reset();
   if (async) {
     auto arg = new BgTaskArg();
-    arg->redis_cmds = argvs;
+    arg->redis_cmds = std::move(argvs);
     time_stat_->enqueue_ts_ = pstd::NowMicros();
     arg->conn_ptr = std::dynamic_pointer_cast<PikaClientConn>(shared_from_this());
-    g_pika_server->ScheduleClientPool(&DoBackgroundTask, arg);
+    // A pipeline is a single task, a slow command takes all of it to the slow lane
+    bool is_slow_cmd = false;
+    for (const auto& argv : arg->redis_cmds) {
+      if (!argv.empty() && g_pika_cmd_table_manager->IsSlowCmd(CmdOpt(argv))) {
+        is_slow_cmd = true;
+        break;
+      }
+    }
+    g_pika_server->ScheduleClientPool(&DoBackgroundTask, arg, is_slow_cmd);
     return;
   }
   BatchExecRedisCmd(argvs);
@@ -249,9 +272,9 @@ void PikaClientConn::DoExecTask(void* arg) {
   conn_ptr->TryWriteResp();
 }
 
-void PikaClientConn::BatchExecRedisCmd(const std::vector<net::RedisCmdArgsType>& argvs) {
+void PikaClientConn::BatchExecRedisCmd(std::vector<net::RedisCmdArgsType>& argvs) {
   resp_num.store(static_cast<int32_t>(argvs.size()));
-  for (const auto& argv : argvs) {
+  for (auto& argv : argvs) {
     std::shared_ptr<std::string> resp_ptr = std::make_shared<std::string>();
     resp_array.push_back(resp_ptr);
     ExecRedisCmd(argv, resp_ptr);
@@ -264,7 +287,7 @@ void PikaClientConn::TryWriteResp() {
   int expected = 0;
   if (resp_num.compare_exchange_strong(expected, -1)) {
     for (auto& resp : resp_array) {
-      WriteResp(*resp);
+      WriteResp(std::move(*resp));
     }
     if (write_completed_cb_) {
       write_completed_cb_();
@@ -389,16 +412,9 @@ void PikaClientConn::ExitTxn() {
   }
 }
 
-void PikaClientConn::ExecRedisCmd(const PikaCmdArgsType& argv, std::shared_ptr<std::string>& resp_ptr) {
+void PikaClientConn::ExecRedisCmd(PikaCmdArgsType& argv, std::shared_ptr<std::string>& resp_ptr) {
   // get opt
-  std::string opt = argv[0];
-  pstd::StringToLower(opt);
-  if (opt == kClusterPrefix) {
-    if (argv.size() >= 2) {
-      opt += argv[1];
-      pstd::StringToLower(opt);
-    }
-  }
+  std::string opt = CmdOpt(argv);
 
   std::shared_ptr<Cmd> cmd_ptr = DoCmd(argv, opt, resp_ptr);
   *resp_ptr = std::move(cmd_ptr->res().message());
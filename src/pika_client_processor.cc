@@ -7,8 +7,13 @@
 
 #include <glog/logging.h>
 
-PikaClientProcessor::PikaClientProcessor(size_t worker_num, size_t max_queue_size, const std::string& name_prefix) {
-  pool_ = std::make_unique<net::ThreadPool>(worker_num, max_queue_size, name_prefix + "Pool");
+PikaClientProcessor::PikaClientProcessor(size_t worker_num, size_t max_queue_size, bool work_stealing,
+                                         const std::string& name_prefix) {
+  if (work_stealing) {
+    pool_ = std::make_unique<net::WorkStealingThreadPool>(worker_num, max_queue_size, name_prefix + "Pool");
+  } else {
+    pool_ = std::make_unique<net::ThreadPool>(worker_num, max_queue_size, name_prefix + "Pool");
+  }
   for (size_t i = 0; i < worker_num; ++i) {
     bg_threads_.push_back(std::make_unique<net::BGThread>(max_queue_size));
     bg_threads_.back()->set_thread_name(name_prefix + "BgThread");
@@ -8,6 +8,8 @@
 #include <sys/syscall.h>
 #include <unistd.h>
 
+#include <algorithm>
+
 #include "include/pika_conf.h"
 #include "pstd/include/pstd_mutex.h"
 
@@ -17,11 +19,36 @@ PikaCmdTableManager::PikaCmdTableManager() {
   cmds_ = std::make_unique<CmdTable>();
   cmds_->reserve(300);
   InitCmdTable(cmds_.get());
+
+  reusable_cmds_ = {kCmdNamePing,     kCmdNameGet,      kCmdNameSet,     kCmdNameIncr,     kCmdNameIncrby,
+                    kCmdNameDecr,     kCmdNameDel,      kCmdNameExists,  kCmdNameMget,     kCmdNameMset,
+                    kCmdNameExpire,   kCmdNameTtl,      kCmdNameHGet,    kCmdNameHSet,     kCmdNameHMget,
+                    kCmdNameHGetall,  kCmdNameHDel,     kCmdNameHIncrby, kCmdNameHLen,     kCmdNameLPush,
+                    kCmdNameRPush,    kCmdNameLPop,     kCmdNameRPop,    kCmdNameLRange,   kCmdNameLLen,
+                    kCmdNameSAdd,     kCmdNameSRem,     kCmdNameSCard,   kCmdNameSIsmember, kCmdNameSMembers,
+                    kCmdNameZAdd,     kCmdNameZRem,     kCmdNameZCard,   kCmdNameZScore,   kCmdNameZRange};
+
+  for (const auto& item : *cmds_) {
+    cmd_lanes_[item.first].flagged_slow = item.second->is_slow();
+  }
 }
 
 std::shared_ptr<Cmd> PikaCmdTableManager::GetCmd(const std::string& opt) {
-  const std::string& internal_opt = opt;
-  return NewCommand(internal_opt);
+  if (reusable_cmds_.find(opt) == reusable_cmds_.end()) {
+    return NewCommand(opt);
+  }
+  std::shared_ptr<CmdPool> pool = GetCurrentThreadCmdPool();
+  Cmd* cmd = pool->Take(opt);
+  if (!cmd) {
+    Cmd* proto = GetCmdFromDB(opt, *cmds_);
+    if (!proto) {
+      return nullptr;
+    }
+    cmd = proto->Clone();
+  }
+  // Dropping the last reference orders every use of the instance by the
+  // other owners before it is put back
+  return std::shared_ptr<Cmd>(cmd, [pool](Cmd* released) { pool->Put(released); });
 }
 
 std::shared_ptr<Cmd> PikaCmdTableManager::NewCommand(const std::string& opt) {
@@ -32,6 +59,58 @@ std::shared_ptr<Cmd> PikaCmdTableManager::NewCommand(const std::string& opt) {
   return nullptr;
 }
 
+std::shared_ptr<PikaCmdTableManager::CmdPool> PikaCmdTableManager::GetCurrentThreadCmdPool() {
+  // Closes the pool when the thread exits, the instances still in use are
+  // deleted instead of put back
+  struct ThreadCmdPool {
+    std::shared_ptr<CmdPool> pool = std::make_shared<CmdPool>();
+    ~ThreadCmdPool() { pool->Close(); }
+  };
+  thread_local ThreadCmdPool thread_pool;
+  return thread_pool.pool;
+}
+
+PikaCmdTableManager::CmdPool::~CmdPool() { Close(); }
+
+Cmd* PikaCmdTableManager::CmdPool::Take(const std::string& opt) {
+  std::lock_guard l(mu_);
+  auto iter = idle_.find(opt);
+  if (iter == idle_.end()) {
+    return nullptr;
+  }
+  // The entry stays, so taking and putting back allocate nothing
+  Cmd* cmd = iter->second;
+  iter->second = nullptr;
+  return cmd;
+}
+
+void PikaCmdTableManager::CmdPool::Put(Cmd* cmd) {
+  {
+    std::lock_guard l(mu_);
+    // One idle instance of every command is kept
+    if (!closed_) {
+      Cmd*& idle = idle_[cmd->name()];
+      if (!idle) {
+        idle = cmd;
+        return;
+      }
+    }
+  }
+  delete cmd;
+}
+
+void PikaCmdTableManager::CmdPool::Close() {
+  std::unordered_map<std::string, Cmd*> idle;
+  {
+    std::lock_guard l(mu_);
+    closed_ = true;
+    idle.swap(idle_);
+  }
+  for (auto& item : idle) {
+    delete item.second;
+  }
+}
+
 CmdTable* PikaCmdTableManager::GetCmdTable() {
   return cmds_.get();
 }
@@ -59,4 +138,46 @@ uint32_t PikaCmdTableManager::DistributeKey(const std::string& key, uint32_t slo
   return thread_distribution_map_[tid]->Distribute(key, slot_num);
 }
 
+bool PikaCmdTableManager::IsSlowCmd(const std::string& opt) const {
+  auto iter = cmd_lanes_.find(opt);
+  if (iter == cmd_lanes_.end()) {
+    return false;
+  }
+  return iter->second.flagged_slow || iter->second.slow_score.load(std::memory_order_relaxed) >= kSlowCmdScoreThreshold;
+}
+
+void PikaCmdTableManager::UpdateCmdDuration(const std::string& opt, uint64_t duration, uint64_t slower_than) {
+  auto iter = cmd_lanes_.find(opt);
+  if (iter == cmd_lanes_.end() || iter->second.flagged_slow) {
+    return;
+  }
+  std::atomic<int32_t>& score = iter->second.slow_score;
+  int32_t cur = score.load(std::memory_order_relaxed);
+  bool slow = duration > slower_than;
+  // The cheap commands of a busy server are never slow, leave their score
+  // alone instead of writing it from every worker
+  if (!slow && cur == 0) {
+    return;
+  }
+  int32_t next;
+  do {
+    next = slow ? std::min(cur + kSlowCmdScoreStep, kSlowCmdScoreMax) : cur - 1;
+    if (next < 0) {
+      return;
+    }
+  } while (!score.compare_exchange_weak(cur, next, std::memory_order_relaxed));
+}
+
+std::vector<std::string> PikaCmdTableManager::AdaptiveSlowCmds() const {
+  std::vector<std::string> cmds;
+  for (const auto& item : cmd_lanes_) {
+    if (!item.second.flagged_slow &&
+        item.second.slow_score.load(std::memory_order_relaxed) >= kSlowCmdScoreThreshold) {
+      cmds.push_back(item.first);
+    }
+  }
+  std::sort(cmds.begin(), cmds.end());
+  return cmds;
+}
+
 bool PikaCmdTableManager::CmdExist(const std::string& cmd) const { return cmds_->find(cmd) != cmds_->end(); }
@@ -13,6 +13,7 @@
 #include "pstd/include/env.h"
 #include "pstd/include/pstd_string.h"
 
+#include "include/pika_binlog_compression.h"
 #include "include/pika_define.h"
 
 using pstd::Status;
@@ -261,6 +262,30 @@ int PikaConf::Load() {
   if (thread_pool_size_ > 100) {
     thread_pool_size_ = 100;
   }
+  GetConfBool("thread-pool-work-stealing", &thread_pool_work_stealing_);
+  GetConfInt("slow-cmd-thread-pool-size", &slow_cmd_thread_pool_size_);
+  if (slow_cmd_thread_pool_size_ < 0) {
+    slow_cmd_thread_pool_size_ = 0;
+  }
+  if (slow_cmd_thread_pool_size_ > 50) {
+    slow_cmd_thread_pool_size_ = 50;
+  }
+  GetConfInt("slow-cmd-max-queue-size", &slow_cmd_max_queue_size_);
+  if (slow_cmd_max_queue_size_ <= 0) {
+    slow_cmd_max_queue_size_ = 100000;
+  }
+  GetConfInt64("reply-zerocopy-threshold", &reply_zerocopy_threshold_);
+  if (reply_zerocopy_threshold_ < 0) {
+    reply_zerocopy_threshold_ = 0;
+  }
+  GetConfInt("pubsub-thread-num", &pubsub_thread_num_);
+  if (pubsub_thread_num_ <= 0) {
+    pubsub_thread_num_ = 1;
+  }
+  GetConfInt64Human("pubsub-output-buffer-limit", &pubsub_output_buffer_limit_);
+  if (pubsub_output_buffer_limit_ < 0) {
+    pubsub_output_buffer_limit_ = 0;
+  }
   GetConfInt("sync-thread-num", &sync_thread_num_);
   if (sync_thread_num_ <= 0) {
     sync_thread_num_ = 3;
@@ -268,6 +293,14 @@ int PikaConf::Load() {
   if (sync_thread_num_ > 24) {
     sync_thread_num_ = 24;
   }
+  GetConfInt("replica-apply-batch-size", &replica_apply_batch_size_);
+  if (replica_apply_batch_size_ <= 0) {
+    replica_apply_batch_size_ = 1;
+  }
+  GetConfInt("db-open-threads", &db_open_threads_);
+  if (db_open_threads_ <= 0) {
+    db_open_threads_ = 1;
+  }
 
   std::string instance_mode;
   GetConfStr("instance-mode", &instance_mode);
@@ -454,6 +487,49 @@ int PikaConf::Load() {
     small_compaction_threshold_ = 5000;
   }
 
+  std::string zri;
+  GetConfStr("zset-rank-index", &zri);
+  zset_rank_index_ = zri == "yes";
+
+  std::string eks;
+  GetConfStr("exact-key-statistics", &eks);
+  exact_key_statistics_ = eks == "yes";
+
+  active_expire_cycle_ms_ = 100;
+  GetConfInt("active-expire-cycle-ms", &active_expire_cycle_ms_);
+  if (active_expire_cycle_ms_ < 0) {
+    active_expire_cycle_ms_ = 0;
+  }
+  active_expire_batch_size_ = 256;
+  GetConfInt("active-expire-batch-size", &active_expire_batch_size_);
+  if (active_expire_batch_size_ <= 0) {
+    active_expire_batch_size_ = 256;
+  }
+
+  value_cache_size_ = 0;
+  GetConfInt64Human("value-cache-size", &value_cache_size_);
+  if (value_cache_size_ < 0) {
+    value_cache_size_ = 0;
+  }
+
+  // Either a size for all the dbs or a list of db:size items
+  list_chunk_size_ = "0";
+  GetConfStr("list-chunk-size", &list_chunk_size_);
+  default_list_chunk_size_ = 0;
+  list_chunk_sizes_.clear();
+  std::vector<std::string> list_chunk_items;
+  pstd::StringSplit(list_chunk_size_, COMMA, list_chunk_items);
+  for (const auto& item : list_chunk_items) {
+    std::string::size_type colon = item.find(':');
+    int size = atoi(item.substr(colon == std::string::npos ? 0 : colon + 1).c_str());
+    size = size < 0 ? 0 : (size > 65536 ? 65536 : size);
+    if (colon == std::string::npos) {
+      default_list_chunk_size_ = size;
+    } else {
+      list_chunk_sizes_[item.substr(0, colon)] = size;
+    }
+  }
+
   max_background_flushes_ = 1;
   GetConfInt("max-background-flushes", &max_background_flushes_);
   if (max_background_flushes_ <= 0) {
@@ -540,6 +616,16 @@ int PikaConf::Load() {
   if (binlog_file_size_ < 1024 || static_cast<int64_t>(binlog_file_size_) > (1024LL * 1024 * 1024)) {
     binlog_file_size_ = 100 * 1024 * 1024;  // 100M
   }
+  std::string bgc;
+  GetConfStr("binlog-group-commit", &bgc);
+  binlog_group_commit_ = bgc == "yes";
+  GetConfInt64Human("binlog-group-commit-max-bytes", &binlog_group_commit_max_bytes_);
+  if (binlog_group_commit_max_bytes_ <= 0) {
+    binlog_group_commit_max_bytes_ = 1024 * 1024;  // 1M
+  }
+  std::string bsoc;
+  GetConfStr("binlog-sync-on-commit", &bsoc);
+  binlog_sync_on_commit_ = bsoc == "yes";
   GetConfStr("pidfile", &pidfile_);
 
   // db sync
@@ -577,6 +663,16 @@ int PikaConf::Load() {
   } else {
     sync_window_size_.store(tmp_sync_window_size);
   }
+  int64_t tmp_sync_window_bytes = kBinlogReadWinDefaultBytes;
+  GetConfInt64Human("sync-window-bytes", &tmp_sync_window_bytes);
+  sync_window_bytes_.store(tmp_sync_window_bytes > 0 ? tmp_sync_window_bytes : kBinlogReadWinDefaultBytes);
+
+  GetConfStr("replication-compression", &replication_compression_);
+  InnerMessage::CompressionType compression;
+  if (!BinlogCompressionFromName(replication_compression_, &compression)) {
+    LOG(WARNING) << "replication-compression " << replication_compression_ << " is invalid, use none instead";
+    replication_compression_ = "none";
+  }
 
   // max conn rbuf size
   int tmp_max_conn_rbuf_size = PIKA_MAX_CONN_RBUF;
@@ -666,6 +762,7 @@ int PikaConf::ConfigRewrite() {
   SetConfInt("throttle-bytes-per-second", throttle_bytes_per_second_);
   SetConfInt("max-rsync-parallel-num", max_rsync_parallel_num_);
   SetConfInt("sync-window-size", sync_window_size_.load());
+  SetConfInt64("sync-window-bytes", sync_window_bytes_.load());
   SetConfInt("consensus-level", consensus_level_.load());
   SetConfInt("replication-num", replication_num_.load());
   // options for storage engine
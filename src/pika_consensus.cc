@@ -410,7 +410,9 @@ Status ConsensusCoordinator::UpdateSlave(const std::string& ip, int port, const
 Status ConsensusCoordinator::InternalAppendBinlog(const BinlogItem& item, const std::shared_ptr<Cmd>& cmd_ptr,
                                                   LogOffset* log_offset) {
   std::string content = cmd_ptr->ToRedisProtocol();
-  Status s = stable_logger_->Logger()->Put(content);
+  uint32_t filenum = 0;
+  uint64_t offset = 0;
+  Status s = stable_logger_->Logger()->Put(content, &filenum, &offset);
   if (!s.ok()) {
     std::string db_name = cmd_ptr->db_name().empty() ? g_pika_conf->default_db() : cmd_ptr->db_name();
     std::shared_ptr<DB> db = g_pika_server->GetDB(db_name);
@@ -419,9 +421,6 @@ Status ConsensusCoordinator::InternalAppendBinlog(const BinlogItem& item, const
     }
     return s;
   }
-  uint32_t filenum;
-  uint64_t offset;
-  stable_logger_->Logger()->GetProducerStatus(&filenum, &offset);
   *log_offset = LogOffset(BinlogOffset(filenum, offset), LogicOffset(item.term_id(), item.logic_id()));
   return Status::OK();
 }
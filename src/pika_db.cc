@@ -10,9 +10,11 @@
 #include "include/pika_cmd_table_manager.h"
 #include "include/pika_rm.h"
 #include "include/pika_server.h"
+#include "pstd/include/pstd_parallel.h"
 
 using pstd::Status;
 extern PikaServer* g_pika_server;
+extern std::unique_ptr<PikaConf> g_pika_conf;
 extern std::unique_ptr<PikaReplicaManager> g_pika_rm;
 extern std::unique_ptr<PikaCmdTableManager> g_pika_cmd_table_manager;
 
@@ -95,8 +97,13 @@ Status DB::AddSlots(const std::set<uint32_t>& slot_ids) {
     }
   }
 
-  for (const uint32_t& id : slot_ids) {
-    slots_.emplace(id, std::make_shared<Slot>(db_name_, id, db_path_));
+  // Each slot opens its own rocksdb instances, open them in parallel
+  std::vector<uint32_t> ids(slot_ids.begin(), slot_ids.end());
+  std::vector<std::shared_ptr<Slot>> slots(ids.size());
+  pstd::ParallelFor(g_pika_conf->db_open_threads(), ids.size(),
+                    [&](size_t i) { slots[i] = std::make_shared<Slot>(db_name_, ids[i], db_path_); });
+  for (size_t i = 0; i < ids.size(); i++) {
+    slots_.emplace(ids[i], slots[i]);
   }
   return Status::OK();
 }
@@ -205,6 +212,44 @@ KeyScanInfo DB::GetKeyScanInfo() {
   return key_scan_info_;
 }
 
+bool DB::GetKeyStatistics(std::vector<storage::KeyInfo>* key_infos) {
+  bool exact = true;
+  key_infos->assign(5, storage::KeyInfo());
+  std::shared_lock l(slots_rw_);
+  for (const auto& item : slots_) {
+    std::vector<storage::KeyInfo> tmp_key_infos;
+    exact = item.second->db()->GetKeyStatistics(&tmp_key_infos) && exact;
+    for (size_t idx = 0; idx < tmp_key_infos.size(); ++idx) {
+      (*key_infos)[idx].keys += tmp_key_infos[idx].keys;
+      (*key_infos)[idx].expires += tmp_key_infos[idx].expires;
+      (*key_infos)[idx].avg_ttl += tmp_key_infos[idx].avg_ttl;
+      (*key_infos)[idx].invaild_keys += tmp_key_infos[idx].invaild_keys;
+    }
+  }
+  return exact;
+}
+
+uint64_t DB::GetActiveExpiredKeys() {
+  uint64_t keys = 0;
+  std::shared_lock l(slots_rw_);
+  for (const auto& item : slots_) {
+    keys += item.second->db()->GetActiveExpiredKeys();
+  }
+  return keys;
+}
+
+void DB::AddValueCacheInfo(storage::ValueCacheInfo* info) {
+  std::shared_lock l(slots_rw_);
+  for (const auto& item : slots_) {
+    storage::ValueCacheInfo slot_info;
+    item.second->db()->GetValueCacheInfo(&slot_info);
+    info->hits += slot_info.hits;
+    info->misses += slot_info.misses;
+    info->usage += slot_info.usage;
+    info->entries += slot_info.entries;
+  }
+}
+
 void DB::Compact(const storage::DataType& type) {
   std::lock_guard rwl(slots_rw_);
   for (const auto& item : slots_) {
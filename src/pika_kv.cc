@@ -23,7 +23,6 @@ void SetCmd::DoInitial() {
     return;
   }
   key_ = argv_[1];
-  value_ = argv_[2];
   condition_ = SetCmd::kNONE;
   sec_ = 0;
   size_t index = 3;
@@ -70,19 +69,19 @@ void SetCmd::Do(std::shared_ptr<Slot> slot) {
   int32_t res = 1;
   switch (condition_) {
     case SetCmd::kXX:
-      s = slot->db()->Setxx(key_, value_, &res, static_cast<int32_t>(sec_));
+      s = slot->db()->Setxx(key_, value(), &res, static_cast<int32_t>(sec_));
       break;
     case SetCmd::kNX:
-      s = slot->db()->Setnx(key_, value_, &res, static_cast<int32_t>(sec_));
+      s = slot->db()->Setnx(key_, value(), &res, static_cast<int32_t>(sec_));
       break;
     case SetCmd::kVX:
-      s = slot->db()->Setvx(key_, target_, value_, &success_, static_cast<int32_t>(sec_));
+      s = slot->db()->Setvx(key_, target_, value(), &success_, static_cast<int32_t>(sec_));
       break;
     case SetCmd::kEXORPX:
-      s = slot->db()->Setex(key_, value_, static_cast<int32_t>(sec_));
+      s = slot->db()->Setex(key_, value(), static_cast<int32_t>(sec_));
       break;
     default:
-      s = slot->db()->Set(key_, value_);
+      s = slot->db()->Set(key_, value());
       break;
   }
 
@@ -102,10 +101,27 @@ void SetCmd::Do(std::shared_ptr<Slot> slot) {
   }
 }
 
+bool SetCmd::AppendStringWrites(std::vector<storage::KeyValue>* kvs) const {
+  if (condition_ != SetCmd::kNONE) {
+    return false;
+  }
+  kvs->push_back({key_, value()});
+  return true;
+}
+
+void SetCmd::DoMergedWrite(const std::shared_ptr<Slot>& slot, const storage::Status& s) {
+  if (s.ok()) {
+    res_.SetRes(CmdRes::kOk);
+    AddSlotKey("k", key_, slot);
+  } else {
+    res_.SetRes(CmdRes::kErrOther, s.ToString());
+  }
+}
+
 std::string SetCmd::ToRedisProtocol() {
   if (condition_ == SetCmd::kEXORPX) {
     std::string content;
-    content.reserve(RAW_ARGS_LEN);
+    content.reserve(256 + key_.size() + value().size());
     RedisAppendLen(content, 4, "*");
 
     // to pksetexat cmd
@@ -123,8 +139,8 @@ std::string SetCmd::ToRedisProtocol() {
     RedisAppendLenUint64(content, at.size(), "$");
     RedisAppendContent(content, at);
     // value
-    RedisAppendLenUint64(content, value_.size(), "$");
-    RedisAppendContent(content, value_);
+    RedisAppendLenUint64(content, value().size(), "$");
+    RedisAppendContent(content, value());
     return content;
   } else {
     return Cmd::ToRedisProtocol();
@@ -652,6 +668,22 @@ void MsetCmd::Do(std::shared_ptr<Slot> slot) {
   }
 }
 
+bool MsetCmd::AppendStringWrites(std::vector<storage::KeyValue>* kvs) const {
+  kvs->insert(kvs->end(), kvs_.begin(), kvs_.end());
+  return true;
+}
+
+void MsetCmd::DoMergedWrite(const std::shared_ptr<Slot>& slot, const storage::Status& s) {
+  if (s.ok()) {
+    res_.SetRes(CmdRes::kOk);
+    for (const auto& kv : kvs_) {
+      AddSlotKey("k", kv.key, slot);
+    }
+  } else {
+    res_.SetRes(CmdRes::kErrOther, s.ToString());
+  }
+}
+
 void MsetCmd::Split(std::shared_ptr<Slot> slot, const HintKeys& hint_keys) {
   std::vector<storage::KeyValue> kvs;
   const std::vector<std::string>& keys = hint_keys.keys;
@@ -27,13 +27,55 @@ PikaReplBgWorker::PikaReplBgWorker(int queue_size) : bg_thread_(queue_size) {
   slot_id_ = 0;
 }
 
+PikaReplBgWorker::~PikaReplBgWorker() = default;
+
 int PikaReplBgWorker::StartThread() { return bg_thread_.StartThread(); }
 
 int PikaReplBgWorker::StopThread() { return bg_thread_.StopThread(); }
 
 void PikaReplBgWorker::Schedule(net::TaskFunc func, void* arg) { bg_thread_.Schedule(func, arg); }
 
-void PikaReplBgWorker::QueueClear() { bg_thread_.QueueClear(); }
+void PikaReplBgWorker::QueueClear() {
+  bg_thread_.QueueClear();
+  std::deque<PendingWriteDB> dropped;
+  {
+    std::lock_guard l(write_db_mu_);
+    dropped.swap(write_db_queue_);
+    write_db_pending_ = 0;
+    write_db_scheduled_ = false;
+  }
+  // Outside of the lock, finishing them may hand their successors to this
+  // worker again
+  for (auto& pending : dropped) {
+    pending.task_arg->scheduler->Finish(pending.task_arg->dep_task);
+  }
+}
+
+void PikaReplBgWorker::ScheduleWriteDB(ReplClientWriteDBTaskArg* task_arg) {
+  {
+    std::lock_guard l(write_db_mu_);
+    write_db_queue_.push_back({std::unique_ptr<ReplClientWriteDBTaskArg>(task_arg), pstd::NowMicros()});
+    write_db_pending_++;
+    if (write_db_scheduled_) {
+      return;
+    }
+    write_db_scheduled_ = true;
+  }
+  ScheduleWriteDBDrain();
+}
+
+void PikaReplBgWorker::ScheduleWriteDBDrain() {
+  // The timer queue of the thread never blocks and is served before its
+  // other tasks. A worker applying the commands of another one must not wait
+  // for the room in its own queue, which that one may be waiting for in turn
+  bg_thread_.DelaySchedule(0, &PikaReplBgWorker::HandleBGWorkerWriteDB, static_cast<void*>(this));
+}
+
+void PikaReplBgWorker::WriteDBQueueStatus(size_t* pending, uint64_t* oldest_enqueue_us) {
+  std::lock_guard l(write_db_mu_);
+  *pending = write_db_queue_.size();
+  *oldest_enqueue_us = write_db_queue_.empty() ? 0 : write_db_queue_.front().enqueue_us;
+}
 
 void PikaReplBgWorker::ParseBinlogOffset(const InnerMessage::BinlogOffset& pb_offset, LogOffset* offset) {
   offset->b_offset.filenum = pb_offset.filenum();
@@ -242,37 +284,108 @@ int PikaReplBgWorker::HandleWriteBinlog(net::RedisParser* parser, const net::Red
 }
 
 void PikaReplBgWorker::HandleBGWorkerWriteDB(void* arg) {
-  std::unique_ptr<ReplClientWriteDBTaskArg> task_arg(static_cast<ReplClientWriteDBTaskArg*>(arg));
-  const std::shared_ptr<Cmd> c_ptr = task_arg->cmd_ptr;
-  const PikaCmdArgsType& argv = c_ptr->argv();
-  LogOffset offset = task_arg->offset;
-  std::string db_name = task_arg->db_name;
-  uint32_t slot_id = task_arg->slot_id;
-
-  uint64_t start_us = 0;
-  if (g_pika_conf->slowlog_slower_than() >= 0) {
-    start_us = pstd::NowMicros();
-  }
-  std::shared_ptr<Slot> slot = g_pika_server->GetDBSlotById(db_name, slot_id);
-  // Add read lock for no suspend command
-  if (!c_ptr->is_suspend()) {
-    slot->DbRWLockReader();
+  auto worker = static_cast<PikaReplBgWorker*>(arg);
+  worker->ApplyWriteDB();
+
+  {
+    std::lock_guard l(worker->write_db_mu_);
+    if (worker->write_db_queue_.empty()) {
+      worker->write_db_scheduled_ = false;
+      return;
+    }
   }
+  worker->ScheduleWriteDBDrain();
+}
 
-  c_ptr->Do(slot);
+bool PikaReplBgWorker::ApplyWriteDB() {
+  std::vector<std::unique_ptr<ReplClientWriteDBTaskArg>> batch;
+  {
+    std::lock_guard l(write_db_mu_);
+    auto batch_size = static_cast<size_t>(g_pika_conf->replica_apply_batch_size());
+    while (!write_db_queue_.empty() && batch.size() < batch_size) {
+      batch.push_back(std::move(write_db_queue_.front().task_arg));
+      write_db_queue_.pop_front();
+      write_db_pending_--;
+    }
+  }
+  if (batch.empty()) {
+    return false;
+  }
+  ApplyWriteDBBatch(&batch);
+  return true;
+}
 
-  if (!c_ptr->is_suspend()) {
-    slot->DbRWUnLock();
+static void SlowlogWriteDB(const PikaCmdArgsType& argv, uint64_t start_us) {
+  if (g_pika_conf->slowlog_slower_than() < 0) {
+    return;
   }
+  auto start_time = static_cast<int32_t>(start_us / 1000000);
+  auto duration = static_cast<int64_t>(pstd::NowMicros() - start_us);
+  if (duration > g_pika_conf->slowlog_slower_than()) {
+    g_pika_server->SlowlogPushEntry(argv, start_time, duration);
+    if (g_pika_conf->slowlog_write_errorlog()) {
+      LOG(ERROR) << "command: " << argv[0] << ", start_time(s): " << start_time << ", duration(us): " << duration;
+    }
+  }
+}
 
-  if (g_pika_conf->slowlog_slower_than() >= 0) {
-    auto start_time = static_cast<int32_t>(start_us / 1000000);
-    auto duration = static_cast<int64_t>(pstd::NowMicros() - start_us);
-    if (duration > g_pika_conf->slowlog_slower_than()) {
-      g_pika_server->SlowlogPushEntry(argv, start_time, duration);
-      if (g_pika_conf->slowlog_write_errorlog()) {
-        LOG(ERROR) << "command: " << argv[0] << ", start_time(s): " << start_time << ", duration(us): " << duration;
+void PikaReplBgWorker::ApplyWriteDBBatch(std::vector<std::unique_ptr<ReplClientWriteDBTaskArg>>* batch) {
+  size_t begin = 0;
+  while (begin < batch->size()) {
+    const std::string& db_name = (*batch)[begin]->db_name;
+    uint32_t slot_id = (*batch)[begin]->slot_id;
+    // A suspend command takes the lock of its slot itself, so it is applied
+    // on its own
+    bool is_suspend = (*batch)[begin]->cmd_ptr->is_suspend();
+    size_t end = begin + 1;
+    while (!is_suspend && end < batch->size() && (*batch)[end]->slot_id == slot_id &&
+           (*batch)[end]->db_name == db_name && !(*batch)[end]->cmd_ptr->is_suspend()) {
+      end++;
+    }
+
+    std::shared_ptr<Slot> slot = g_pika_server->GetDBSlotById(db_name, slot_id);
+    // Add read lock for no suspend command
+    if (!is_suspend) {
+      slot->DbRWLockReader();
+    }
+
+    size_t i = begin;
+    while (i < end) {
+      // The plain string writes following each other go into one WriteBatch,
+      // the commands of a batch never share a key
+      std::vector<storage::KeyValue> kvs;
+      size_t merged = i;
+      while (!is_suspend && merged < end && (*batch)[merged]->cmd_ptr->AppendStringWrites(&kvs)) {
+        merged++;
+      }
+      uint64_t start_us = g_pika_conf->slowlog_slower_than() >= 0 ? pstd::NowMicros() : 0;
+      if (merged - i >= 2) {
+        storage::Status s = slot->db()->MSet(kvs);
+        for (size_t j = i; j < merged; j++) {
+          (*batch)[j]->cmd_ptr->DoMergedWrite(slot, s);
+          (*batch)[j]->scheduler->Finish((*batch)[j]->dep_task);
+        }
+        // Logged once, as its first command
+        SlowlogWriteDB((*batch)[i]->cmd_ptr->argv(), start_us);
+        merged_cmds_ += merged - i;
+        i = merged;
+        continue;
       }
+
+      const std::shared_ptr<Cmd> c_ptr = (*batch)[i]->cmd_ptr;
+      c_ptr->Do(slot);
+      // Hands the commands waiting for this one to the workers
+      (*batch)[i]->scheduler->Finish((*batch)[i]->dep_task);
+      SlowlogWriteDB(c_ptr->argv(), start_us);
+      i++;
+    }
+
+    if (!is_suspend) {
+      slot->DbRWUnLock();
     }
+
+    applied_cmds_ += end - begin;
+    applied_batches_++;
+    begin = end;
   }
 }
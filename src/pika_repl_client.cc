@@ -9,11 +9,13 @@
 #include <netinet/in.h>
 #include <sys/socket.h>
 
+#include <algorithm>
 #include <utility>
 
 #include "net/include/net_cli.h"
 #include "net/include/redis_cli.h"
 #include "pstd/include/env.h"
+#include "pstd/include/lock_mgr.h"
 #include "pstd/include/pstd_coding.h"
 #include "pstd/include/pstd_string.h"
 
@@ -27,6 +29,8 @@ extern std::unique_ptr<PikaReplicaManager> g_pika_rm;
 PikaReplClient::PikaReplClient(int cron_interval, int keepalive_timeout)  {
   client_thread_ = std::make_unique<PikaReplClientThread>(cron_interval, keepalive_timeout);
   client_thread_->set_thread_name("PikaReplClient");
+  write_db_scheduler_ = std::make_unique<pstd::KeyDependencyScheduler>(
+      [this](pstd::KeyDependencyScheduler::Task* task, void* arg) { DispatchWriteDBTask(task, arg); });
   for (int i = 0; i < 2 * g_pika_conf->sync_thread_num(); ++i) {
     bg_workers_.push_back(std::make_unique<PikaReplBgWorker>(PIKA_SYNC_BUFFER_SIZE));
   }
@@ -76,11 +80,93 @@ void PikaReplClient::ScheduleWriteBinlogTask(const std::string& db_slot,
 
 void PikaReplClient::ScheduleWriteDBTask(const std::shared_ptr<Cmd>& cmd_ptr, const LogOffset& offset,
                                          const std::string& db_name, uint32_t slot_id) {
-  const PikaCmdArgsType& argv = cmd_ptr->argv();
-  std::string dispatch_key = argv.size() >= 2 ? argv[1] : argv[0];
-  size_t index = GetHashIndex(dispatch_key, false);
+  std::vector<std::string> keys = cmd_ptr->current_key();
+  bool barrier = cmd_ptr->is_suspend() || keys.empty();
+  for (const auto& key : keys) {
+    // The default of a command without keys of its own
+    if (key.empty()) {
+      barrier = true;
+      break;
+    }
+  }
+  std::vector<uint64_t> key_hashes;
+  if (!barrier) {
+    key_hashes = pstd::lock::LockMgr::SortedHashes(keys);
+  }
+  ThrottleWriteDB();
   auto task_arg = new ReplClientWriteDBTaskArg(cmd_ptr, offset, db_name, slot_id);
-  bg_workers_[index]->Schedule(&PikaReplBgWorker::HandleBGWorkerWriteDB, static_cast<void*>(task_arg));
+  task_arg->scheduler = write_db_scheduler_.get();
+  write_db_scheduler_->Submit(key_hashes, barrier, static_cast<void*>(task_arg));
+}
+
+void PikaReplClient::ThrottleWriteDB() {
+  size_t max_in_flight = PIKA_SYNC_BUFFER_SIZE * bg_workers_.size();
+  if (write_db_scheduler_->InFlight() < max_in_flight) {
+    return;
+  }
+  write_db_throttled_++;
+  while (write_db_scheduler_->InFlight() >= max_in_flight) {
+    // The caller is a worker parsing a binlog, and the commands it waits for
+    // may be queued up on itself, so it applies those of the busiest worker
+    // instead of only waiting for them
+    PikaReplBgWorker* busiest = bg_workers_.front().get();
+    for (const auto& bg_worker : bg_workers_) {
+      if (bg_worker->write_db_pending() > busiest->write_db_pending()) {
+        busiest = bg_worker.get();
+      }
+    }
+    if (!busiest->ApplyWriteDB()) {
+      // The rest is being applied or waits for the commands being applied
+      write_db_scheduler_->WaitInFlightBelow(max_in_flight, std::chrono::milliseconds(10));
+    }
+  }
+}
+
+void PikaReplClient::DispatchWriteDBTask(pstd::KeyDependencyScheduler::Task* task, void* arg) {
+  auto task_arg = static_cast<ReplClientWriteDBTaskArg*>(arg);
+  task_arg->dep_task = task;
+  // The less busy of the worker of the first key and the next one in turn,
+  // a hot key does not pile up on a single worker that way
+  const PikaCmdArgsType& argv = task_arg->cmd_ptr->argv();
+  size_t index = str_hash(argv.size() >= 2 ? argv[1] : argv[0]) % bg_workers_.size();
+  size_t other = next_write_db_worker_++ % bg_workers_.size();
+  if (bg_workers_[other]->write_db_pending() < bg_workers_[index]->write_db_pending()) {
+    index = other;
+  }
+  bg_workers_[index]->ScheduleWriteDB(task_arg);
+}
+
+void PikaReplClient::GetWriteDBStatus(uint64_t* applied_cmds, uint64_t* applied_batches, size_t* pending,
+                                      uint64_t* lag_us) {
+  *applied_cmds = 0;
+  *applied_batches = 0;
+  *pending = 0;
+  *lag_us = 0;
+  uint64_t now = pstd::NowMicros();
+  for (size_t i = 0; i < bg_workers_.size(); i++) {
+    size_t worker_pending = 0;
+    uint64_t oldest_enqueue_us = 0;
+    bg_workers_[i]->WriteDBQueueStatus(&worker_pending, &oldest_enqueue_us);
+    *applied_cmds += bg_workers_[i]->applied_cmds();
+    *applied_batches += bg_workers_[i]->applied_batches();
+    *pending += worker_pending;
+    if (worker_pending != 0 && now > oldest_enqueue_us) {
+      *lag_us = std::max(*lag_us, now - oldest_enqueue_us);
+    }
+  }
+}
+
+void PikaReplClient::GetWriteDBDependencyStatus(uint64_t* waited, uint64_t* barriers) {
+  *waited = write_db_scheduler_->waited();
+  *barriers = write_db_scheduler_->barriers();
+}
+
+void PikaReplClient::GetWriteDBMergeStatus(uint64_t* merged, uint64_t* throttled) {
+  *merged = 0;
+  for (const auto& bg_worker : bg_workers_) {
+    *merged += bg_worker->merged_cmds();
+  }
+  *throttled = write_db_throttled_;
 }
 
 size_t PikaReplClient::GetHashIndex(const std::string& key, bool upper_half) {
@@ -181,6 +267,12 @@ Status PikaReplClient::SendSlotTrySync(const std::string& ip, uint32_t port, con
   binlog_offset->set_filenum(boffset.filenum);
   binlog_offset->set_offset(boffset.offset);
 
+  InnerMessage::CompressionType compression = InnerMessage::kCompressionNone;
+  BinlogCompressionFromName(g_pika_conf->replication_compression(), &compression);
+  if (compression != InnerMessage::kCompressionNone) {
+    try_sync->set_compression(compression);
+  }
+
   std::string to_send;
   if (!request.SerializeToString(&to_send)) {
     LOG(WARNING) << "Serialize Slot TrySync Request Failed, to Master (" << ip << ":" << port << ")";
@@ -48,6 +48,21 @@ int PikaReplClientConn::DealMessage() {
     g_pika_server->SyncError();
     return -1;
   }
+  if (response->type() == InnerMessage::kBinlogSync) {
+    BinlogCompressionStats& recv_stats = g_pika_rm->BinlogRecvStats();
+    recv_stats.batches++;
+    recv_stats.bytes += header_len_;
+    if (response->has_compressed_resp()) {
+      if (!UncompressBinlogSyncResp(response.get())) {
+        LOG(WARNING) << "Uncompress binlog sync response FAILED! "
+                     << " msg_len: " << header_len_;
+        g_pika_server->SyncError();
+        return -1;
+      }
+    } else {
+      recv_stats.raw_bytes += header_len_;
+    }
+  }
   switch (response->type()) {
     case InnerMessage::kMetaSync: {
       auto task_arg =
@@ -84,6 +99,34 @@ int PikaReplClientConn::DealMessage() {
   return 0;
 }
 
+bool PikaReplClientConn::UncompressBinlogSyncResp(InnerMessage::InnerResponse* response) {
+  if (response->raw_size() > static_cast<uint32_t>(g_pika_conf->max_conn_rbuf_size())) {
+    return false;
+  }
+  BinlogCompressionStats& recv_stats = g_pika_rm->BinlogRecvStats();
+  uint64_t start_us = pstd::NowMicros();
+  std::string raw;
+  bool uncompressed =
+      UncompressBinlogChips(response->compression(), response->compressed_resp(), response->raw_size(), &raw);
+  recv_stats.codec_us += pstd::NowMicros() - start_us;
+  if (!uncompressed) {
+    return false;
+  }
+
+  InnerMessage::InnerResponse inner;
+  ::google::protobuf::io::ArrayInputStream input(raw.data(), static_cast<int32_t>(raw.size()));
+  ::google::protobuf::io::CodedInputStream decoder(&input);
+  decoder.SetTotalBytesLimit(g_pika_conf->max_conn_rbuf_size());
+  if (!inner.ParseFromCodedStream(&decoder) || !decoder.ConsumedEntireMessage() ||
+      inner.type() != InnerMessage::kBinlogSync) {
+    return false;
+  }
+  response->Swap(&inner);
+  recv_stats.compressed_batches++;
+  recv_stats.raw_bytes += raw.size();
+  return true;
+}
+
 void PikaReplClientConn::HandleMetaSyncResponse(void* arg) {
   std::unique_ptr<ReplClientTaskArg> task_arg(static_cast<ReplClientTaskArg*>(arg));
   std::shared_ptr<net::PbConn> conn = task_arg->conn;
@@ -250,7 +293,9 @@ void PikaReplClientConn::HandleTrySyncResponse(void* arg) {
     // after connected, update receive time first to avoid connection timeout
     slave_slot->SetLastRecvTime(pstd::NowMicros());
 
-    LOG(INFO) << "Slot: " << slot_name << " TrySync Ok";
+    LOG(INFO) << "Slot: " << slot_name << " TrySync Ok, compression: "
+              << BinlogCompressionName(try_sync_response.has_compression() ? try_sync_response.compression()
+                                                                          : InnerMessage::kCompressionNone);
   } else if (try_sync_response.reply_code() == InnerMessage::InnerResponse::TrySync::kSyncPointBePurged) {
     slave_slot->SetReplState(ReplState::kTryDBSync);
     LOG(INFO) << "Slot: " << slot_name << " Need To Try DBSync";
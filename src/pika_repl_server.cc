@@ -52,6 +52,7 @@ int PikaReplServer::Stop() {
 
 pstd::Status PikaReplServer::SendSlaveBinlogChips(const std::string& ip, int port,
                                                   const std::vector<WriteTask>& tasks) {
+  InnerMessage::CompressionType compression = ClientCompression(ip, port);
   InnerMessage::InnerResponse response;
   BuildBinlogSyncResp(tasks, &response);
 
@@ -69,14 +70,55 @@ pstd::Status PikaReplServer::SendSlaveBinlogChips(const std::string& ip, int por
       if (!response.SerializeToString(&binlog_chip_pb)) {
         return Status::Corruption("Serialized Failed");
       }
-      pstd::Status s = Write(ip, port, binlog_chip_pb);
+      pstd::Status s = WriteBinlogChips(ip, port, compression, binlog_chip_pb);
       if (!s.ok()) {
         return s;
       }
     }
     return pstd::Status::OK();
   }
-  return Write(ip, port, binlog_chip_pb);
+  return WriteBinlogChips(ip, port, compression, binlog_chip_pb);
+}
+
+InnerMessage::CompressionType PikaReplServer::ClientCompression(const std::string& ip, int port) {
+  std::shared_lock l(client_conn_rwlock_);
+  auto iter = client_compression_map_.find(pstd::IpPortString(ip, port));
+  return iter != client_compression_map_.end() ? iter->second : InnerMessage::kCompressionNone;
+}
+
+pstd::Status PikaReplServer::WriteBinlogChips(const std::string& ip, int port,
+                                              InnerMessage::CompressionType compression,
+                                              const std::string& binlog_chip_pb) {
+  sent_stats_.batches++;
+  sent_stats_.raw_bytes += binlog_chip_pb.size();
+  if (compression == InnerMessage::kCompressionNone || binlog_chip_pb.size() < kBinlogCompressMinSize) {
+    sent_stats_.bytes += binlog_chip_pb.size();
+    return Write(ip, port, binlog_chip_pb);
+  }
+
+  uint64_t start_us = pstd::NowMicros();
+  std::string compressed;
+  bool compressed_ok = CompressBinlogChips(compression, binlog_chip_pb, &compressed);
+  sent_stats_.codec_us += pstd::NowMicros() - start_us;
+  // Incompressible chips are not worth the work of the slave
+  if (!compressed_ok || compressed.size() >= binlog_chip_pb.size()) {
+    sent_stats_.bytes += binlog_chip_pb.size();
+    return Write(ip, port, binlog_chip_pb);
+  }
+
+  InnerMessage::InnerResponse response;
+  response.set_code(InnerMessage::kOk);
+  response.set_type(InnerMessage::Type::kBinlogSync);
+  response.set_compression(compression);
+  response.set_raw_size(static_cast<uint32_t>(binlog_chip_pb.size()));
+  response.set_compressed_resp(std::move(compressed));
+  std::string compressed_pb;
+  if (!response.SerializeToString(&compressed_pb)) {
+    return Status::Corruption("Serialized Failed");
+  }
+  sent_stats_.compressed_batches++;
+  sent_stats_.bytes += compressed_pb.size();
+  return Write(ip, port, compressed_pb);
 }
 
 void PikaReplServer::BuildBinlogOffset(const LogOffset& offset, InnerMessage::BinlogOffset* boffset) {
@@ -128,11 +170,17 @@ void PikaReplServer::UpdateClientConnMap(const std::string& ip_port, int fd) {
   client_conn_map_[ip_port] = fd;
 }
 
+void PikaReplServer::UpdateClientCompression(const std::string& ip_port, InnerMessage::CompressionType compression) {
+  std::lock_guard l(client_conn_rwlock_);
+  client_compression_map_[ip_port] = compression;
+}
+
 void PikaReplServer::RemoveClientConn(int fd) {
   std::lock_guard l(client_conn_rwlock_);
   auto iter = client_conn_map_.begin();
   while (iter != client_conn_map_.end()) {
     if (iter->second == fd) {
+      client_compression_map_.erase(iter->first);
       iter = client_conn_map_.erase(iter);
       break;
     }
@@ -151,6 +151,10 @@ bool PikaReplServerConn::TrySyncUpdateSlaveNode(const std::shared_ptr<SyncMaster
                                                 InnerMessage::InnerResponse::TrySync* try_sync_response) {
   const InnerMessage::Node& node = try_sync_request.node();
   std::string slot_name = slot->SlotName();
+  // Slaves that do not know about compression leave it out
+  InnerMessage::CompressionType compression =
+      try_sync_request.has_compression() ? try_sync_request.compression() : InnerMessage::kCompressionNone;
+  try_sync_response->set_compression(compression);
 
   if (!slot->CheckSlaveNodeExist(node.ip(), node.port())) {
     int32_t session_id = slot->GenSessionId();
@@ -169,6 +173,7 @@ bool PikaReplServerConn::TrySyncUpdateSlaveNode(const std::shared_ptr<SyncMaster
     }
     const std::string ip_port = pstd::IpPortString(node.ip(), node.port());
     g_pika_rm->ReplServerUpdateClientConnMap(ip_port, conn->fd());
+    g_pika_rm->ReplServerUpdateClientCompression(ip_port, compression);
     try_sync_response->set_reply_code(InnerMessage::InnerResponse::TrySync::kOk);
     LOG(INFO) << "Slot: " << slot_name << " TrySync Success, Session: " << session_id;
   } else {
@@ -179,6 +184,7 @@ bool PikaReplServerConn::TrySyncUpdateSlaveNode(const std::shared_ptr<SyncMaster
       LOG(WARNING) << "Slot: " << slot_name << ", Get Session id Failed" << s.ToString();
       return false;
     }
+    g_pika_rm->ReplServerUpdateClientCompression(pstd::IpPortString(node.ip(), node.port()), compression);
     try_sync_response->set_reply_code(InnerMessage::InnerResponse::TrySync::kOk);
     try_sync_response->set_session_id(session_id);
     LOG(INFO) << "Slot: " << slot_name << " TrySync Success, Session: " << session_id;
@@ -146,12 +146,14 @@ Status SyncMasterSlot::ReadBinlogFileToWq(const std::shared_ptr<SlaveNode>& slav
   if (!reader) {
     return Status::OK();
   }
+  // Bounds the bytes in flight, not only the number of binlog items
+  auto window_bytes = static_cast<size_t>(g_pika_conf->sync_window_bytes());
   std::vector<WriteTask> tasks;
   for (int i = 0; i < cnt; ++i) {
     std::string msg;
     uint32_t filenum;
     uint64_t offset;
-    if (slave_ptr->sync_win.GetTotalBinlogSize() > PIKA_MAX_CONN_RBUF_HB * 2) {
+    if (slave_ptr->sync_win.GetTotalBinlogSize() > window_bytes) {
       LOG(INFO) << slave_ptr->ToString()
                 << " total binlog size in sync window is :" << slave_ptr->sync_win.GetTotalBinlogSize();
       break;
@@ -812,12 +814,34 @@ void PikaReplicaManager::ScheduleWriteDBTask(const std::shared_ptr<Cmd>& cmd_ptr
   pika_repl_client_->ScheduleWriteDBTask(cmd_ptr, offset, db_name, slot_id);
 }
 
+void PikaReplicaManager::GetWriteDBStatus(uint64_t* applied_cmds, uint64_t* applied_batches, size_t* pending,
+                                          uint64_t* lag_us) {
+  pika_repl_client_->GetWriteDBStatus(applied_cmds, applied_batches, pending, lag_us);
+}
+
+void PikaReplicaManager::GetWriteDBDependencyStatus(uint64_t* waited, uint64_t* barriers) {
+  pika_repl_client_->GetWriteDBDependencyStatus(waited, barriers);
+}
+
+void PikaReplicaManager::GetWriteDBMergeStatus(uint64_t* merged, uint64_t* throttled) {
+  pika_repl_client_->GetWriteDBMergeStatus(merged, throttled);
+}
+
 void PikaReplicaManager::ReplServerRemoveClientConn(int fd) { pika_repl_server_->RemoveClientConn(fd); }
 
 void PikaReplicaManager::ReplServerUpdateClientConnMap(const std::string& ip_port, int fd) {
   pika_repl_server_->UpdateClientConnMap(ip_port, fd);
 }
 
+void PikaReplicaManager::ReplServerUpdateClientCompression(const std::string& ip_port,
+                                                           InnerMessage::CompressionType compression) {
+  pika_repl_server_->UpdateClientCompression(ip_port, compression);
+}
+
+BinlogCompressionStats& PikaReplicaManager::BinlogSentStats() { return pika_repl_server_->sent_stats(); }
+
+BinlogCompressionStats& PikaReplicaManager::BinlogRecvStats() { return pika_repl_client_->recv_stats(); }
+
 Status PikaReplicaManager::UpdateSyncBinlogStatus(const RmNode& slave, const LogOffset& offset_start,
                                                   const LogOffset& offset_end) {
   std::shared_lock l(slots_rw_);
@@ -9,6 +9,7 @@
 #include <sys/resource.h>
 #include <sys/statvfs.h>
 #include <algorithm>
+#include <chrono>
 #include <ctime>
 #include <fstream>
 #include <memory>
@@ -20,6 +21,7 @@
 #include "net/include/redis_cli.h"
 #include "net/include/net_stats.h"
 #include "pstd/include/env.h"
+#include "pstd/include/pstd_parallel.h"
 #include "pstd/include/rsync.h"
 
 #include "include/pika_cmd_table_manager.h"
@@ -83,12 +85,18 @@ PikaServer::PikaServer()
   pika_rsync_service_ = std::make_unique<PikaRsyncService>(g_pika_conf->db_sync_path(), g_pika_conf->port() + kPortShiftRSync);
   //TODO: remove pika_rsync_service_，reuse pika_rsync_service_ port
   rsync_server_ = std::make_unique<rsync::RsyncServer>(ips, port_ + kPortShiftRsync2);
-  pika_pubsub_thread_ = std::make_unique<net::PubSubThread>();
+  pika_pubsub_thread_ = std::make_unique<net::PubSubThread>(g_pika_conf->pubsub_thread_num(),
+                                                            g_pika_conf->pubsub_output_buffer_limit());
   pika_auxiliary_thread_ = std::make_unique<PikaAuxiliaryThread>();
   pika_migrate_ = std::make_unique<PikaMigrate>();
   pika_migrate_thread_ = std::make_unique<PikaMigrateThread>();
 
-  pika_client_processor_ = std::make_unique<PikaClientProcessor>(g_pika_conf->thread_pool_size(), 100000);
+  pika_client_processor_ = std::make_unique<PikaClientProcessor>(g_pika_conf->thread_pool_size(), 100000,
+                                                               g_pika_conf->thread_pool_work_stealing());
+  if (g_pika_conf->slow_cmd_thread_pool_size() > 0) {
+    pika_slow_cmd_thread_pool_ = std::make_unique<net::ThreadPool>(
+        g_pika_conf->slow_cmd_thread_pool_size(), g_pika_conf->slow_cmd_max_queue_size(), "SlowCmdPool");
+  }
   instant_ = std::make_unique<Instant>();
   exit_mutex_.lock();
 }
@@ -98,6 +106,9 @@ PikaServer::~PikaServer() {
   // DispatchThread will use queue of worker thread,
   // so we need to delete dispatch before worker.
   pika_client_processor_->Stop();
+  if (pika_slow_cmd_thread_pool_) {
+    pika_slow_cmd_thread_pool_->stop_thread_pool();
+  }
 
   {
     std::lock_guard l(slave_mutex_);
@@ -160,6 +171,14 @@ void PikaServer::Start() {
     LOG(FATAL) << "Start PikaClientProcessor Error: " << ret
                << (ret == net::kCreateThreadError ? ": create thread error " : ": other error");
   }
+  if (pika_slow_cmd_thread_pool_) {
+    ret = pika_slow_cmd_thread_pool_->start_thread_pool();
+    if (ret != net::kSuccess) {
+      dbs_.clear();
+      LOG(FATAL) << "Start SlowCmdThreadPool Error: " << ret
+                 << (ret == net::kCreateThreadError ? ": create thread error " : ": other error");
+    }
+  }
   ret = pika_dispatch_thread_->StartThread();
   if (ret != net::kSuccess) {
     dbs_.clear();
@@ -224,6 +243,8 @@ int PikaServer::port() { return port_; }
 
 time_t PikaServer::start_time_s() { return start_time_s_; }
 
+uint64_t PikaServer::db_open_time_ms() { return db_open_time_ms_; }
+
 std::string PikaServer::master_ip() {
   std::shared_lock l(state_protector_);
   return master_ip_;
@@ -327,13 +348,22 @@ void PikaServer::InitDBStruct() {
   std::string log_path = g_pika_conf->log_path();
   std::vector<DBStruct> db_structs = g_pika_conf->db_structs();
   std::lock_guard rwl(dbs_rw_);
+  std::vector<std::shared_ptr<DB>> db_ptrs;
   for (const auto& db : db_structs) {
     std::string name = db.db_name;
     uint32_t num = db.slot_num;
     std::shared_ptr<DB> db_ptr = std::make_shared<DB>(name, num, db_path, log_path);
-    db_ptr->AddSlots(db.slot_ids);
+    db_ptrs.push_back(db_ptr);
     dbs_.emplace(name, db_ptr);
   }
+
+  // Restarts are bound by replaying the rocksdb instances, open them in parallel
+  auto start = std::chrono::steady_clock::now();
+  pstd::ParallelFor(g_pika_conf->db_open_threads(), db_ptrs.size(),
+                    [&](size_t i) { db_ptrs[i]->AddSlots(db_structs[i].slot_ids); });
+  db_open_time_ms_ =
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+  LOG(INFO) << "open " << db_ptrs.size() << " dbs in " << db_open_time_ms_ << "ms";
 }
 
 Status PikaServer::AddDBStruct(const std::string &db_name, uint32_t num) {
@@ -843,7 +873,15 @@ void PikaServer::SetFirstMetaSync(bool v) {
   first_meta_sync_ = v;
 }
 
-void PikaServer::ScheduleClientPool(net::TaskFunc func, void* arg) { pika_client_processor_->SchedulePool(func, arg); }
+void PikaServer::ScheduleClientPool(net::TaskFunc func, void* arg, bool is_slow_cmd) {
+  if (is_slow_cmd && pika_slow_cmd_thread_pool_) {
+    slow_cmd_pool_tasks_++;
+    pika_slow_cmd_thread_pool_->Schedule(func, arg);
+    return;
+  }
+  client_pool_tasks_++;
+  pika_client_processor_->SchedulePool(func, arg);
+}
 
 void PikaServer::ScheduleClientBgThreads(net::TaskFunc func, void* arg, const std::string& hash_str) {
   pika_client_processor_->ScheduleBgThreads(func, arg, hash_str);
@@ -863,6 +901,21 @@ size_t PikaServer::ClientProcessorThreadPoolMaxQueueSize() {
   return pika_client_processor_->ThreadPoolMaxQueueSize();
 }
 
+size_t PikaServer::SlowCmdThreadPoolCurQueueSize() {
+  size_t cur_size = 0;
+  if (pika_slow_cmd_thread_pool_) {
+    pika_slow_cmd_thread_pool_->cur_queue_size(&cur_size);
+  }
+  return cur_size;
+}
+
+size_t PikaServer::SlowCmdThreadPoolMaxQueueSize() {
+  if (!pika_slow_cmd_thread_pool_) {
+    return 0;
+  }
+  return pika_slow_cmd_thread_pool_->max_queue_size();
+}
+
 void PikaServer::BGSaveTaskSchedule(net::TaskFunc func, void* arg) {
   bgsave_thread_.StartThread();
   bgsave_thread_.Schedule(func, arg);
@@ -1242,6 +1295,18 @@ float PikaServer::InstantaneousOutputReplKbps() {
   return static_cast<float>(g_pika_server->instant_->getInstantaneousMetric(STATS_METRIC_NET_OUTPUT_REPLICATION)) / 1024.0f;
 }
 
+double PikaServer::InstantaneousReplApplyOps() {
+  return g_pika_server->instant_->getInstantaneousMetric(STATS_METRIC_REPL_APPLY);
+}
+
+float PikaServer::InstantaneousBinlogSentKbps() {
+  return static_cast<float>(g_pika_server->instant_->getInstantaneousMetric(STATS_METRIC_REPL_BINLOG_SENT)) / 1024.0f;
+}
+
+float PikaServer::InstantaneousBinlogRecvKbps() {
+  return static_cast<float>(g_pika_server->instant_->getInstantaneousMetric(STATS_METRIC_REPL_BINLOG_RECV)) / 1024.0f;
+}
+
 std::unordered_map<std::string, uint64_t> PikaServer::ServerExecCountDB() {
   std::unordered_map<std::string, uint64_t> res;
   for (auto& cmd : statistic_.server_stat.exec_count_db) {
@@ -1307,6 +1372,7 @@ void PikaServer::DoTimingTask() {
   ResetLastSecQuerynum();
   // Auto update network instantaneous metric
   AutoUpdateNetworkMetric();
+  AutoUpdateReplicationMetric();
   // Print the queue status periodically
   PrintThreadPoolQueueStatus();
 }
@@ -1502,6 +1568,21 @@ void PikaServer::AutoUpdateNetworkMetric() {
                                      current_time, factor);
 }
 
+void PikaServer::AutoUpdateReplicationMetric() {
+  monotime current_time = getMonotonicUs();
+  size_t factor = 1000000;  // us, 1s
+  uint64_t applied_cmds = 0;
+  uint64_t applied_batches = 0;
+  size_t pending = 0;
+  uint64_t lag_us = 0;
+  g_pika_rm->GetWriteDBStatus(&applied_cmds, &applied_batches, &pending, &lag_us);
+  instant_->trackInstantaneousMetric(STATS_METRIC_REPL_APPLY, applied_cmds, current_time, factor);
+  instant_->trackInstantaneousMetric(STATS_METRIC_REPL_BINLOG_SENT, g_pika_rm->BinlogSentStats().raw_bytes,
+                                     current_time, factor);
+  instant_->trackInstantaneousMetric(STATS_METRIC_REPL_BINLOG_RECV, g_pika_rm->BinlogRecvStats().raw_bytes,
+                                     current_time, factor);
+}
+
 void PikaServer::PrintThreadPoolQueueStatus() {
     // Print the current queue size if it exceeds QUEUE_SIZE_THRESHOLD_PERCENTAGE/100 of the maximum queue size.
     size_t cur_size = ClientProcessorThreadPoolCurQueueSize();
@@ -1510,6 +1591,12 @@ void PikaServer::PrintThreadPoolQueueStatus() {
     if (cur_size > thread_hold) {
       LOG(INFO) << "The current queue size of the Pika Server's client thread processor thread pool: " << cur_size;
     }
+    cur_size = SlowCmdThreadPoolCurQueueSize();
+    max_size = SlowCmdThreadPoolMaxQueueSize();
+    thread_hold = (max_size / 100) * QUEUE_SIZE_THRESHOLD_PERCENTAGE;
+    if (cur_size > thread_hold) {
+      LOG(INFO) << "The current queue size of the Pika Server's slow cmd thread pool: " << cur_size;
+    }
 }
 
 void PikaServer::InitStorageOptions() {
@@ -1576,6 +1663,19 @@ void PikaServer::InitStorageOptions() {
   storage_options_.statistics_max_size = g_pika_conf->max_cache_statistic_keys();
   storage_options_.small_compaction_threshold = g_pika_conf->small_compaction_threshold();
 
+  // For ZRANK/ZREVRANK/ZRANGE by rank
+  storage_options_.zset_rank_index = g_pika_conf->zset_rank_index();
+
+  // For the keyspace statistics of the strings
+  storage_options_.exact_key_statistics = g_pika_conf->exact_key_statistics();
+
+  // For the active expiration of the keys with a ttl
+  storage_options_.active_expire_cycle_ms = g_pika_conf->active_expire_cycle_ms();
+  storage_options_.active_expire_batch_size = g_pika_conf->active_expire_batch_size();
+
+  // For the cache of hot strings and small hashes
+  storage_options_.value_cache_size = g_pika_conf->value_cache_size();
+
   // rocksdb blob
   if (g_pika_conf->enable_blob_files()) {
     storage_options_.options.enable_blob_files = g_pika_conf->enable_blob_files();
@@ -1624,6 +1724,7 @@ void PikaServer::ServerStatus(std::string* info) {
   std::stringstream tmp_stream;
   size_t q_size = ClientProcessorThreadPoolCurQueueSize();
   tmp_stream << "Client Processor thread-pool queue size: " << q_size << "\r\n";
+  tmp_stream << "Slow Cmd thread-pool queue size: " << SlowCmdThreadPoolCurQueueSize() << "\r\n";
   info->append(tmp_stream.str());
 }
 
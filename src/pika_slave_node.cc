@@ -53,8 +53,9 @@ bool SyncWindow::Update(const SyncWinItem& start_item, const SyncWinItem& end_it
 }
 
 int SyncWindow::Remaining() {
-  std::size_t remaining_size = g_pika_conf->sync_window_size() - win_.size();
-  return static_cast<int>(remaining_size > 0 ? remaining_size : 0);
+  // The window may be shrunk by config set below what is in flight
+  auto window_size = static_cast<std::size_t>(g_pika_conf->sync_window_size());
+  return window_size > win_.size() ? static_cast<int>(window_size - win_.size()) : 0;
 }
 
 /* SlaveNode */
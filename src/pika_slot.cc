@@ -3,6 +3,7 @@
 // LICENSE file in the root directory of this source tree. An additional grant
 // of patent rights can be found in the PATENTS file in the same directory.
 
+#include <chrono>
 #include <fstream>
 #include <memory>
 
@@ -11,7 +12,6 @@
 #include "include/pika_server.h"
 #include "include/pika_slot.h"
 
-#include "pstd/include/mutex_impl.h"
 #include "pstd/include/pstd_hash.h"
 
 using pstd::Status;
@@ -45,6 +45,13 @@ std::string DbSyncPath(const std::string& sync_path, const std::string& db_name,
   return sync_path + buf;
 }
 
+// The storage options of the server with the settings chosen per db
+storage::StorageOptions SlotStorageOptions(const std::string& db_name) {
+  storage::StorageOptions storage_options = g_pika_server->storage_options();
+  storage_options.lists_chunk_size = g_pika_conf->list_chunk_size(db_name);
+  return storage_options;
+}
+
 Slot::Slot(const std::string& db_name, uint32_t slot_id, const std::string& table_db_path)
     : db_name_(db_name), slot_id_(slot_id), bgsave_engine_(nullptr) {
   db_path_ = table_db_path;
@@ -52,15 +59,17 @@ Slot::Slot(const std::string& db_name, uint32_t slot_id, const std::string& tabl
   dbsync_path_ = DbSyncPath(g_pika_conf->db_sync_path(), db_name, slot_id_);
   slot_name_ = db_name;
 
+  auto start = std::chrono::steady_clock::now();
   db_ = std::make_shared<storage::Storage>();
-  rocksdb::Status s = db_->Open(g_pika_server->storage_options(), db_path_);
+  rocksdb::Status s = db_->Open(SlotStorageOptions(db_name_), db_path_);
+  auto cost = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
 
-  lock_mgr_ = std::make_shared<pstd::lock::LockMgr>(1000, 0, std::make_shared<pstd::lock::MutexFactoryImpl>());
+  lock_mgr_ = std::make_shared<pstd::lock::LockMgr>(1000, 0);
 
   opened_ = s.ok();
   assert(db_);
   assert(s.ok());
-  LOG(INFO) << slot_name_ << " DB Success";
+  LOG(INFO) << slot_name_ << " DB Success, open in " << cost.count() << "ms";
 }
 
 Slot::~Slot() {
@@ -255,7 +264,7 @@ bool Slot::ChangeDb(const std::string& new_path) {
   }
 
   db_ = std::make_shared<storage::Storage>();
-  rocksdb::Status s = db_->Open(g_pika_server->storage_options(), db_path_);
+  rocksdb::Status s = db_->Open(SlotStorageOptions(db_name_), db_path_);
   assert(db_);
   assert(s.ok());
   pstd::DeleteDirIfExist(tmp_path);
@@ -472,7 +481,7 @@ bool Slot::FlushDBWithoutLock() {
   pstd::RenameFile(db_path_, dbpath);
 
   db_ = std::make_shared<storage::Storage>();
-  rocksdb::Status s = db_->Open(g_pika_server->storage_options(), db_path_);
+  rocksdb::Status s = db_->Open(SlotStorageOptions(db_name_), db_path_);
   assert(db_);
   assert(s.ok());
   LOG(INFO) << slot_name_ << " Open new db success";
@@ -504,7 +513,7 @@ bool Slot::FlushSubDBWithoutLock(const std::string& db_name) {
   pstd::RenameFile(sub_dbpath, del_dbpath);
 
   db_ = std::make_shared<storage::Storage>();
-  rocksdb::Status s = db_->Open(g_pika_server->storage_options(), db_path_);
+  rocksdb::Status s = db_->Open(SlotStorageOptions(db_name_), db_path_);
   assert(db_);
   assert(s.ok());
   LOG(INFO) << slot_name_ << " open new " + db_name + " db success";
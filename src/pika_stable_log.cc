@@ -23,7 +23,10 @@ extern std::unique_ptr<PikaReplicaManager> g_pika_rm;
 
 StableLog::StableLog(std::string db_name, uint32_t slot_id, std::string log_path)
     : purging_(false), db_name_(std::move(db_name)), slot_id_(slot_id), log_path_(std::move(log_path)) {
-  stable_logger_ = std::make_shared<Binlog>(log_path_, g_pika_conf->binlog_file_size());
+  stable_logger_ = std::make_shared<Binlog>(log_path_, g_pika_conf->binlog_file_size(),
+                                            g_pika_conf->binlog_group_commit(),
+                                            g_pika_conf->binlog_group_commit_max_bytes(),
+                                            g_pika_conf->binlog_sync_on_commit());
   std::map<uint32_t, std::string> binlogs;
   if (!GetBinlogFiles(&binlogs)) {
     LOG(FATAL) << log_path_ << " Could not get binlog files!";
@@ -0,0 +1,80 @@
+// Copyright (c) 2015-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef __PSTD_KEY_DEPENDENCY_SCHEDULER_H__
+#define __PSTD_KEY_DEPENDENCY_SCHEDULER_H__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "pstd/include/noncopyable.h"
+
+namespace pstd {
+
+/*
+ * Orders tasks by the keys they touch. A task is handed to dispatch once
+ * every task submitted before it that shares a key with it is finished, so
+ * tasks of disjoint keys run in parallel and those of a common key in the
+ * order of their submission.
+ *
+ * A barrier, a task whose keys are unknown, waits for every task submitted
+ * before it and holds back every task submitted after it.
+ *
+ * Keys are identified by their 64 bit hash, tasks of keys with the same hash
+ * are ordered as well, which is only a false dependency.
+ */
+class KeyDependencyScheduler : public pstd::noncopyable {
+ public:
+  struct Task;
+  // Runs a task that became ready, or hands it to a worker, which calls
+  // Finish with it once done. Never called with the mutex of the scheduler
+  // held, so it may submit or finish tasks itself
+  using Dispatch = std::function<void(Task* task, void* arg)>;
+
+  explicit KeyDependencyScheduler(Dispatch dispatch);
+  ~KeyDependencyScheduler();
+
+  void Submit(const std::vector<uint64_t>& key_hashes, bool barrier, void* arg);
+  void Finish(Task* task);
+
+  // The tasks submitted and not finished yet
+  size_t InFlight();
+  // Waits at most timeout for fewer than limit tasks to be in flight, returns
+  // whether they are. Submit does not wait itself, the submitter may have to
+  // run tasks to get there
+  bool WaitInFlightBelow(size_t limit, std::chrono::milliseconds timeout);
+  uint64_t submitted() const { return submitted_; }
+  // The tasks that had to wait for another one
+  uint64_t waited() const { return waited_; }
+  uint64_t barriers() const { return barriers_; }
+
+ private:
+  void DependOn(Task* pred, Task* task);
+
+  const Dispatch dispatch_;
+
+  std::mutex mu_;
+  std::condition_variable finished_cv_;
+  // The last task submitted for every key that is not finished yet
+  std::unordered_map<uint64_t, Task*> last_tasks_;
+  // Every task not finished yet, what a barrier waits for
+  std::unordered_set<Task*> in_flight_;
+  Task* last_barrier_ = nullptr;
+
+  std::atomic<uint64_t> submitted_ = 0;
+  std::atomic<uint64_t> waited_ = 0;
+  std::atomic<uint64_t> barriers_ = 0;
+};
+
+}  // namespace pstd
+
+#endif  // __PSTD_KEY_DEPENDENCY_SCHEDULER_H__
@@ -6,8 +6,11 @@
 #ifndef __SRC_LOCK_MGR_H__
 #define __SRC_LOCK_MGR_H__
 
+#include <atomic>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "pstd/include/mutex.h"
 #include "pstd/include/noncopyable.h"
@@ -15,41 +18,55 @@
 namespace pstd {
 
 namespace lock {
-struct LockMap;
-struct LockMapStripe;
 
+/*
+ * Record locks of keys, identified by their hash only, so locking a key
+ * allocates nothing. Keys with the same 64 bit hash share one lock.
+ *
+ * A locked hash takes a slot of a small open-addressed table of the shard it
+ * maps to, a slot has its own condition variable, so an unlock wakes up a
+ * single thread waiting for that very key instead of every waiter of the
+ * shard.
+ */
 class LockMgr : public pstd::noncopyable {
  public:
-  LockMgr(size_t default_num_stripes, int64_t max_num_locks, const std::shared_ptr<MutexFactory>& factory);
+  // num_shards is rounded up to a power of two, max_num_locks limits the
+  // keys locked at the same time if it is positive
+  LockMgr(size_t num_shards, int64_t max_num_locks);
 
   ~LockMgr();
 
+  // Never 0, which marks a free slot
+  static uint64_t Hash(std::string_view key);
+  // The hashes of keys sorted and without duplicates, the order in which
+  // every caller locking several keys has to lock them
+  static std::vector<uint64_t> SortedHashes(const std::vector<std::string>& keys);
+
   // Attempt to lock key.  If OK status is returned, the caller is responsible
   // for calling UnLock() on this key.
-  Status TryLock(const std::string& key);
+  Status TryLock(const std::string& key) { return TryLock(Hash(key)); }
+  // Same as above with the hash of the key computed by the caller
+  Status TryLock(uint64_t hash);
 
   // Unlock a key locked by TryLock().
-  void UnLock(const std::string& key);
+  void UnLock(const std::string& key) { UnLock(Hash(key)); }
+  void UnLock(uint64_t hash);
 
  private:
-  // Default number of lock map stripes
-  const size_t default_num_stripes_[[maybe_unused]];
-
-  // Limit on number of keys locked per column family
-  const int64_t max_num_locks_;
+  struct Slot;
+  struct Shard;
 
-  // Used to allocate mutexes/condvars to use when locking keys
-  std::shared_ptr<MutexFactory> mutex_factory_;
+  Shard& GetShard(uint64_t hash);
 
-  // Map to locked key info
-  std::shared_ptr<LockMap> lock_map_;
-
-  Status Acquire(const std::shared_ptr<LockMapStripe>& stripe, const std::string& key);
-
-  Status AcquireLocked(const std::shared_ptr<LockMapStripe>& stripe, const std::string& key);
+  // Limit on number of keys locked at the same time
+  const int64_t max_num_locks_;
 
-  void UnLockKey(const std::string& key, const std::shared_ptr<LockMapStripe>& stripe);
+  // Count of keys that are currently locked.
+  // (Only maintained if max_num_locks_ is positive.)
+  std::atomic<int64_t> lock_cnt_{0};
 
+  uint64_t shard_mask_ = 0;
+  std::unique_ptr<Shard[]> shards_;
 };
 
 }  //  namespace lock
@@ -0,0 +1,91 @@
+// Copyright (c) 2015-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef __PSTD_GLOB_H__
+#define __PSTD_GLOB_H__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pstd {
+
+/*
+ * A glob pattern compiled once and matched against many strings, with the
+ * same semantics as stringmatchlen.
+ *
+ * The pattern is split at its stars into fixed length segments. The first
+ * segment is matched at the start of the string, the last one at the end and
+ * the ones in between are searched from left to right, looking for their
+ * first literal with memchr. Character classes become 256 bit tables, so a
+ * match never backtracks and costs O(string length) for most patterns.
+ */
+class GlobMatcher {
+ public:
+  GlobMatcher(const char* pattern, size_t pattern_len, bool nocase);
+  explicit GlobMatcher(const std::string& pattern, bool nocase = false)
+      : GlobMatcher(pattern.data(), pattern.size(), nocase) {}
+
+  bool Match(const char* str, size_t len) const;
+  bool Match(const std::string& str) const { return Match(str.data(), str.size()); }
+
+  // The literal every matching string starts with, empty if the
+  // pattern does not start with a literal or ignores case
+  const std::string& literal_prefix() const { return literal_prefix_; }
+  // True if the pattern only matches literal_prefix() itself
+  bool is_literal() const { return !has_star_ && segments_.size() == 1 && segments_[0].len == literal_prefix_.size(); }
+  // True if the pattern matches every string
+  bool match_all() const { return has_star_ && segments_.size() == 2 && segments_[0].len == 0 && segments_[1].len == 0; }
+
+ private:
+  // Matches exactly len bytes
+  struct Piece {
+    enum Kind : uint8_t { kLiteral, kAnyChar, kCharClass };
+    Kind kind;
+    // Offset in literals_ of kLiteral, index in classes_ of kCharClass
+    uint32_t index;
+    uint32_t len;
+  };
+
+  // The pieces between two stars
+  struct Segment {
+    size_t begin;
+    size_t end;
+    size_t len;
+    // Offset and index of the first literal piece, end if there is none
+    size_t literal_offset;
+    size_t literal_piece;
+  };
+
+  using CharClass = std::array<uint64_t, 4>;
+
+  void AddLiteral(char c);
+  void AddClass(const CharClass& char_class);
+  void AddAnyChar();
+  void CloseSegment();
+
+  bool MatchSegment(const Segment& segment, const char* str) const;
+  // The first position in [from, to) the segment matches at, or npos
+  size_t FindSegment(const Segment& segment, const char* str, size_t from, size_t to) const;
+
+  static bool InClass(const CharClass& char_class, unsigned char c) {
+    return ((char_class[c >> 6] >> (c & 63)) & 1) != 0;
+  }
+
+  bool nocase_;
+  bool has_star_ = false;
+  std::string literals_;
+  std::vector<CharClass> classes_;
+  std::vector<Piece> pieces_;
+  std::vector<Segment> segments_;
+  std::string literal_prefix_;
+  size_t segment_begin_ = 0;
+};
+
+}  // namespace pstd
+
+#endif  // __PSTD_GLOB_H__
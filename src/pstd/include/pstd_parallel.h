@@ -0,0 +1,40 @@
+// Copyright (c) 2015-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef __PSTD_PARALLEL_H__
+#define __PSTD_PARALLEL_H__
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace pstd {
+
+// Runs task(0) ... task(n - 1) on at most max_threads threads, the calling
+// thread included, and returns once every task is done
+inline void ParallelFor(size_t max_threads, size_t n, const std::function<void(size_t)>& task) {
+  std::atomic<size_t> next{0};
+  auto worker = [&]() {
+    for (size_t i = next.fetch_add(1); i < n; i = next.fetch_add(1)) {
+      task(i);
+    }
+  };
+  size_t threads = std::min(std::max<size_t>(max_threads, 1), n);
+  std::vector<std::thread> helpers;
+  for (size_t i = 1; i < threads; i++) {
+    helpers.emplace_back(worker);
+  }
+  worker();
+  for (auto& helper : helpers) {
+    helper.join();
+  }
+}
+
+}  // namespace pstd
+
+#endif  // __PSTD_PARALLEL_H__
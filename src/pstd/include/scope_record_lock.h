@@ -21,14 +21,15 @@ using Slice = rocksdb::Slice;
 
 class ScopeRecordLock final : public pstd::noncopyable {
  public:
-  ScopeRecordLock(const std::shared_ptr<LockMgr>& lock_mgr, const Slice& key) : lock_mgr_(lock_mgr), key_(key) {
-    lock_mgr_->TryLock(key_.ToString());
+  ScopeRecordLock(const std::shared_ptr<LockMgr>& lock_mgr, const Slice& key)
+      : lock_mgr_(lock_mgr), hash_(LockMgr::Hash(std::string_view(key.data(), key.size()))) {
+    lock_mgr_->TryLock(hash_);
   }
-  ~ScopeRecordLock() { lock_mgr_->UnLock(key_.ToString()); }
+  ~ScopeRecordLock() { lock_mgr_->UnLock(hash_); }
 
  private:
   std::shared_ptr<LockMgr> const lock_mgr_;
-  Slice key_;
+  const uint64_t hash_;
 };
 
 class MultiScopeRecordLock final : public pstd::noncopyable {
@@ -38,7 +39,7 @@ class MultiScopeRecordLock final : public pstd::noncopyable {
 
  private:
   std::shared_ptr<LockMgr> const lock_mgr_;
-  std::vector<std::string> keys_;
+  std::vector<uint64_t> hashes_;
 };
 
 class MultiRecordLock : public noncopyable {
@@ -46,8 +47,12 @@ class MultiRecordLock : public noncopyable {
   explicit MultiRecordLock(const std::shared_ptr<LockMgr>& lock_mgr) : lock_mgr_(lock_mgr) {}
   ~MultiRecordLock() = default;
 
-  void Lock(const std::vector<std::string>& keys);
-  void Unlock(const std::vector<std::string>& keys);
+  void Lock(const std::vector<std::string>& keys) { Lock(LockMgr::SortedHashes(keys)); }
+  void Unlock(const std::vector<std::string>& keys) { Unlock(LockMgr::SortedHashes(keys)); }
+  // Same as above with the hashes computed once by LockMgr::SortedHashes for
+  // the lock and the unlock
+  void Lock(const std::vector<uint64_t>& sorted_hashes);
+  void Unlock(const std::vector<uint64_t>& sorted_hashes);
 
  private:
   std::shared_ptr<LockMgr> const lock_mgr_;
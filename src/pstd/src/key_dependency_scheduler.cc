@@ -0,0 +1,111 @@
+// Copyright (c) 2015-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#include "pstd/include/key_dependency_scheduler.h"
+
+#include <utility>
+
+namespace pstd {
+
+struct KeyDependencyScheduler::Task {
+  std::vector<uint64_t> key_hashes;
+  void* arg = nullptr;
+  // The tasks not finished yet this one waits for
+  size_t pending = 0;
+  std::vector<Task*> successors;
+};
+
+KeyDependencyScheduler::KeyDependencyScheduler(Dispatch dispatch) : dispatch_(std::move(dispatch)) {}
+
+KeyDependencyScheduler::~KeyDependencyScheduler() {
+  for (Task* task : in_flight_) {
+    delete task;
+  }
+}
+
+void KeyDependencyScheduler::DependOn(Task* pred, Task* task) {
+  // A task sharing several keys with pred waits for it only once
+  if (!pred->successors.empty() && pred->successors.back() == task) {
+    return;
+  }
+  pred->successors.push_back(task);
+  task->pending++;
+}
+
+void KeyDependencyScheduler::Submit(const std::vector<uint64_t>& key_hashes, bool barrier, void* arg) {
+  auto task = new Task();
+  task->arg = arg;
+  {
+    std::lock_guard l(mu_);
+    if (barrier) {
+      for (Task* pred : in_flight_) {
+        DependOn(pred, task);
+      }
+      // Every later task waits for the barrier, so it does not need to know
+      // about the tasks before
+      last_tasks_.clear();
+      last_barrier_ = task;
+      barriers_++;
+    } else {
+      task->key_hashes = key_hashes;
+      if (last_barrier_ != nullptr) {
+        DependOn(last_barrier_, task);
+      }
+      for (uint64_t hash : key_hashes) {
+        Task*& last = last_tasks_[hash];
+        if (last != nullptr && last != task) {
+          DependOn(last, task);
+        }
+        last = task;
+      }
+    }
+    in_flight_.insert(task);
+    submitted_++;
+    if (task->pending != 0) {
+      waited_++;
+      return;
+    }
+  }
+  dispatch_(task, arg);
+}
+
+void KeyDependencyScheduler::Finish(Task* task) {
+  std::vector<Task*> ready;
+  {
+    std::lock_guard l(mu_);
+    in_flight_.erase(task);
+    for (uint64_t hash : task->key_hashes) {
+      auto iter = last_tasks_.find(hash);
+      if (iter != last_tasks_.end() && iter->second == task) {
+        last_tasks_.erase(iter);
+      }
+    }
+    if (last_barrier_ == task) {
+      last_barrier_ = nullptr;
+    }
+    for (Task* successor : task->successors) {
+      if (--successor->pending == 0) {
+        ready.push_back(successor);
+      }
+    }
+  }
+  delete task;
+  finished_cv_.notify_all();
+  for (Task* successor : ready) {
+    dispatch_(successor, successor->arg);
+  }
+}
+
+size_t KeyDependencyScheduler::InFlight() {
+  std::lock_guard l(mu_);
+  return in_flight_.size();
+}
+
+bool KeyDependencyScheduler::WaitInFlightBelow(size_t limit, std::chrono::milliseconds timeout) {
+  std::unique_lock l(mu_);
+  return finished_cv_.wait_for(l, timeout, [&]() { return in_flight_.size() < limit; });
+}
+
+}  // namespace pstd
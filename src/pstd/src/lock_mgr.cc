@@ -9,169 +9,161 @@
 
 #include "pstd/include/lock_mgr.h"
 
-#include <atomic>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
 #include <functional>
-#include <memory>
-#include <unordered_set>
-#include <vector>
-
-#include "pstd/include/mutex.h"
+#include <list>
+#include <mutex>
+#include <thread>
 
 namespace pstd::lock {
 
-struct LockMapStripe {
-  explicit LockMapStripe(const std::shared_ptr<MutexFactory>& factory) {
-    stripe_mutex = factory->AllocateMutex();
-    stripe_cv = factory->AllocateCondVar();
-    assert(stripe_mutex);
-    assert(stripe_cv);
-  }
-
-  // Mutex must be held before modifying keys map
-  std::shared_ptr<Mutex> stripe_mutex;
+// The slots of the open-addressed table of a shard, keys locked beyond that
+// in the same shard spill into its overflow list
+static const size_t kSlotsPerShard = 4;
+
+struct LockMgr::Slot {
+  // 0 if the slot is free
+  uint64_t hash = 0;
+  bool locked = false;
+  // The threads waiting for the key of the slot, which keeps the slot until
+  // the last of them has locked and unlocked it
+  uint32_t waiters = 0;
+  std::condition_variable cv;
+};
 
-  // Condition Variable per stripe for waiting on a lock
-  std::shared_ptr<CondVar> stripe_cv;
+struct alignas(64) LockMgr::Shard {
+  // Must be held to read or modify the slots
+  std::mutex mu;
+  Slot slots[kSlotsPerShard];
+  std::list<Slot> overflow;
 
-  // Locked keys
-  std::unordered_set<std::string> keys;
+  // The slot of hash, otherwise nullptr and *free_slot is a free slot of the
+  // table, nullptr if it is full
+  Slot* Find(uint64_t hash, Slot** free_slot);
+  void Release(Slot* slot);
 };
 
-// Map of #num_stripes LockMapStripes
-struct LockMap {
-  explicit LockMap(size_t num_stripes, const std::shared_ptr<MutexFactory>& factory) : num_stripes_(num_stripes) {
-    lock_map_stripes_.reserve(num_stripes);
-    for (size_t i = 0; i < num_stripes; i++) {
-      auto stripe = std::make_shared<LockMapStripe>(factory);
-      lock_map_stripes_.push_back(stripe);
+LockMgr::Slot* LockMgr::Shard::Find(uint64_t hash, Slot** free_slot) {
+  *free_slot = nullptr;
+  size_t start = (hash >> 32) % kSlotsPerShard;
+  for (size_t i = 0; i < kSlotsPerShard; i++) {
+    Slot* slot = &slots[(start + i) % kSlotsPerShard];
+    if (slot->hash == hash) {
+      return slot;
+    }
+    if (slot->hash == 0 && *free_slot == nullptr) {
+      *free_slot = slot;
     }
   }
+  for (auto& slot : overflow) {
+    if (slot.hash == hash) {
+      return &slot;
+    }
+  }
+  return nullptr;
+}
 
-  ~LockMap() = default;
-
-  // Number of sepearate LockMapStripes to create, each with their own Mutex
-  const size_t num_stripes_;
-
-  // Count of keys that are currently locked.
-  // (Only maintained if LockMgr::max_num_locks_ is positive.)
-  std::atomic<int64_t> lock_cnt{0};
-
-  std::vector<std::shared_ptr<LockMapStripe>> lock_map_stripes_;
-
-  size_t GetStripe(const std::string& key) const;
-};
-
-size_t LockMap::GetStripe(const std::string& key) const {
-  assert(num_stripes_ > 0);
-  size_t stripe = std::hash<std::string>{}(key) % num_stripes_;
-  return stripe;
+void LockMgr::Shard::Release(Slot* slot) {
+  if (slot < slots || slot >= slots + kSlotsPerShard) {
+    overflow.remove_if([slot](const Slot& overflow_slot) { return &overflow_slot == slot; });
+    return;
+  }
+  slot->hash = 0;
 }
 
-LockMgr::LockMgr(size_t default_num_stripes, int64_t max_num_locks, const std::shared_ptr<MutexFactory>& mutex_factory)
-    : default_num_stripes_(default_num_stripes),
-      max_num_locks_(max_num_locks),
-      mutex_factory_(mutex_factory),
-      lock_map_(std::make_shared<LockMap>(default_num_stripes, mutex_factory)) {}
+LockMgr::LockMgr(size_t num_shards, int64_t max_num_locks) : max_num_locks_(max_num_locks) {
+  size_t shards = 1;
+  while (shards < num_shards) {
+    shards <<= 1;
+  }
+  shard_mask_ = shards - 1;
+  shards_ = std::make_unique<Shard[]>(shards);
+}
 
 LockMgr::~LockMgr() = default;
 
-Status LockMgr::TryLock(const std::string& key) {
-#ifdef LOCKLESS
-  return Status::OK();
-#else
-  size_t stripe_num = lock_map_->GetStripe(key);
-  assert(lock_map_->lock_map_stripes_.size() > stripe_num);
-  auto stripe = lock_map_->lock_map_stripes_.at(stripe_num);
+LockMgr::Shard& LockMgr::GetShard(uint64_t hash) { return shards_[hash & shard_mask_]; }
 
-  return Acquire(stripe, key);
-#endif
+uint64_t LockMgr::Hash(std::string_view key) {
+  uint64_t hash = std::hash<std::string_view>{}(key);
+  return hash != 0 ? hash : 1;
 }
 
-// Helper function for TryLock().
-Status LockMgr::Acquire(const std::shared_ptr<LockMapStripe>& stripe, const std::string& key) {
-  Status result;
-
-  // we wait indefinitely to acquire the lock
-  result = stripe->stripe_mutex->Lock();
-
-  if (!result.ok()) {
-    // failed to acquire mutex
-    return result;
-  }
-
-  // Acquire lock if we are able to
-  result = AcquireLocked(stripe, key);
-
-  if (!result.ok()) {
-    // If we weren't able to acquire the lock, we will keep retrying
-    do {
-      result = stripe->stripe_cv->Wait(stripe->stripe_mutex);
-      if (result.ok()) {
-        result = AcquireLocked(stripe, key);
-      }
-    } while (!result.ok());
+std::vector<uint64_t> LockMgr::SortedHashes(const std::vector<std::string>& keys) {
+  std::vector<uint64_t> hashes;
+  hashes.reserve(keys.size());
+  for (const auto& key : keys) {
+    hashes.push_back(Hash(key));
   }
-
-  stripe->stripe_mutex->UnLock();
-
-  return result;
+  std::sort(hashes.begin(), hashes.end());
+  hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+  return hashes;
 }
 
-// Try to lock this key after we have acquired the mutex.
-// REQUIRED:  Stripe mutex must be held.
-Status LockMgr::AcquireLocked(const std::shared_ptr<LockMapStripe>& stripe, const std::string& key) {
-  Status result;
-  // Check if this key is already locked
-  if (stripe->keys.find(key) != stripe->keys.end()) {
-    // Lock already held
-    result = Status::Busy("LockTimeout");
-  } else {  // Lock not held.
-    // Check lock limit
-    if (max_num_locks_ > 0 && lock_map_->lock_cnt.load(std::memory_order_acquire) >= max_num_locks_) {
-      result = Status::Busy("LockLimit");
-    } else {
-      // acquire lock
-      stripe->keys.insert(key);
-
-      // Maintain lock count if there is a limit on the number of locks
-      if (max_num_locks_ != 0) {
-        lock_map_->lock_cnt++;
+Status LockMgr::TryLock(uint64_t hash) {
+#ifdef LOCKLESS
+  return Status::OK();
+#else
+  Shard& shard = GetShard(hash);
+  std::unique_lock l(shard.mu);
+  while (true) {
+    Slot* free_slot = nullptr;
+    Slot* slot = shard.Find(hash, &free_slot);
+    if (slot != nullptr) {
+      // Wait until the holder hands the key over
+      slot->waiters++;
+      slot->cv.wait(l, [slot] { return !slot->locked; });
+      slot->waiters--;
+      slot->locked = true;
+      break;
+    }
+    if (max_num_locks_ <= 0 || lock_cnt_.load(std::memory_order_acquire) < max_num_locks_) {
+      if (free_slot == nullptr) {
+        free_slot = &shard.overflow.emplace_back();
       }
+      free_slot->hash = hash;
+      free_slot->locked = true;
+      break;
     }
+    // The unlocks of the other shards are not signaled here, so the lock
+    // limit is polled
+    l.unlock();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    l.lock();
   }
-
-  return result;
+  if (max_num_locks_ > 0) {
+    lock_cnt_++;
+  }
+  return Status::OK();
+#endif
 }
 
-void LockMgr::UnLockKey(const std::string& key, const std::shared_ptr<LockMapStripe>& stripe) {
+void LockMgr::UnLock(uint64_t hash) {
 #ifdef LOCKLESS
 #else
-  auto stripe_iter = stripe->keys.find(key);
-  if (stripe_iter != stripe->keys.end()) {
-    // Found the key locked.  unlock it.
-    stripe->keys.erase(stripe_iter);
-    if (max_num_locks_ > 0) {
-      // Maintain lock count if there is a limit on the number of locks.
-      assert(lock_map_->lock_cnt.load(std::memory_order_relaxed) > 0);
-      lock_map_->lock_cnt--;
-    }
-  } else {
-    // This key is either not locked or locked by someone else.
+  Shard& shard = GetShard(hash);
+  std::lock_guard l(shard.mu);
+  Slot* free_slot = nullptr;
+  Slot* slot = shard.Find(hash, &free_slot);
+  if (slot == nullptr || !slot->locked) {
+    // This key is not locked.
+    return;
+  }
+  slot->locked = false;
+  if (max_num_locks_ > 0) {
+    assert(lock_cnt_.load(std::memory_order_relaxed) > 0);
+    lock_cnt_--;
   }
+  if (slot->waiters == 0) {
+    shard.Release(slot);
+    return;
+  }
+  // Only wake up a thread waiting for this key, under the mutex, since the
+  // slot is gone once the waiters are done with it
+  slot->cv.notify_one();
 #endif
 }
-
-void LockMgr::UnLock(const std::string& key) {
-  // Lock the mutex for the stripe that this key hashes to
-  size_t stripe_num = lock_map_->GetStripe(key);
-  assert(lock_map_->lock_map_stripes_.size() > stripe_num);
-  auto stripe = lock_map_->lock_map_stripes_.at(stripe_num);
-
-  stripe->stripe_mutex->Lock();
-  UnLockKey(key, stripe);
-  stripe->stripe_mutex->UnLock();
-
-  // Signal waiting threads to retry locking
-  stripe->stripe_cv->NotifyAll();
-}
 }  // namespace pstd::lock
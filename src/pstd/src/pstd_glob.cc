@@ -0,0 +1,225 @@
+// Copyright (c) 2015-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#include "pstd/include/pstd_glob.h"
+
+#include <cctype>
+#include <cstring>
+#include <utility>
+
+namespace pstd {
+
+static const size_t npos = static_cast<size_t>(-1);
+
+// stringmatchlen compares chars as signed ints, and lowers them with tolower
+static int CharValue(int byte, bool nocase) {
+  int c = static_cast<signed char>(byte);
+  return nocase ? tolower(c) : c;
+}
+
+GlobMatcher::GlobMatcher(const char* pattern, size_t pattern_len, bool nocase) : nocase_(nocase) {
+  size_t i = 0;
+  while (i < pattern_len) {
+    char c = pattern[i];
+    if (c == '*') {
+      while (i < pattern_len && pattern[i] == '*') {
+        i++;
+      }
+      CloseSegment();
+      has_star_ = true;
+      continue;
+    }
+    if (c == '?') {
+      AddAnyChar();
+      i++;
+      continue;
+    }
+    if (c == '[') {
+      i++;
+      bool negate = i < pattern_len && pattern[i] == '^';
+      if (negate) {
+        i++;
+      }
+      // An unterminated class runs to the end of the pattern
+      CharClass char_class = {};
+      while (i < pattern_len) {
+        if (pattern[i] == '\\') {
+          // Escaped chars are compared as they are, even without case
+          if (++i == pattern_len) {
+            break;
+          }
+          auto byte = static_cast<unsigned char>(pattern[i]);
+          char_class[byte >> 6] |= uint64_t{1} << (byte & 63);
+          i++;
+        } else if (pattern[i] == ']') {
+          i++;
+          break;
+        } else if (pattern_len - i >= 3 && pattern[i + 1] == '-') {
+          int start = CharValue(static_cast<unsigned char>(pattern[i]), false);
+          int end = CharValue(static_cast<unsigned char>(pattern[i + 2]), false);
+          if (start > end) {
+            std::swap(start, end);
+          }
+          if (nocase_) {
+            start = tolower(start);
+            end = tolower(end);
+          }
+          for (int byte = 0; byte < 256; byte++) {
+            int value = CharValue(byte, nocase_);
+            if (value >= start && value <= end) {
+              char_class[byte >> 6] |= uint64_t{1} << (byte & 63);
+            }
+          }
+          i += 3;
+        } else {
+          int expect = CharValue(static_cast<unsigned char>(pattern[i]), nocase_);
+          for (int byte = 0; byte < 256; byte++) {
+            if (CharValue(byte, nocase_) == expect) {
+              char_class[byte >> 6] |= uint64_t{1} << (byte & 63);
+            }
+          }
+          i++;
+        }
+      }
+      if (negate) {
+        for (auto& bits : char_class) {
+          bits = ~bits;
+        }
+      }
+      AddClass(char_class);
+      continue;
+    }
+    if (c == '\\' && pattern_len - i >= 2) {
+      c = pattern[++i];
+    }
+    AddLiteral(c);
+    i++;
+  }
+  CloseSegment();
+
+  const Segment& head = segments_.front();
+  if (head.begin != head.end && pieces_[head.begin].kind == Piece::kLiteral) {
+    literal_prefix_.assign(literals_, pieces_[head.begin].index, pieces_[head.begin].len);
+  }
+}
+
+void GlobMatcher::AddLiteral(char c) {
+  if (nocase_) {
+    CharClass char_class = {};
+    int expect = CharValue(static_cast<unsigned char>(c), true);
+    for (int byte = 0; byte < 256; byte++) {
+      if (CharValue(byte, true) == expect) {
+        char_class[byte >> 6] |= uint64_t{1} << (byte & 63);
+      }
+    }
+    AddClass(char_class);
+    return;
+  }
+  literals_.push_back(c);
+  if (pieces_.size() > segment_begin_ && pieces_.back().kind == Piece::kLiteral) {
+    pieces_.back().len++;
+  } else {
+    pieces_.push_back({Piece::kLiteral, static_cast<uint32_t>(literals_.size() - 1), 1});
+  }
+}
+
+void GlobMatcher::AddClass(const CharClass& char_class) {
+  classes_.push_back(char_class);
+  pieces_.push_back({Piece::kCharClass, static_cast<uint32_t>(classes_.size() - 1), 1});
+}
+
+void GlobMatcher::AddAnyChar() {
+  if (pieces_.size() > segment_begin_ && pieces_.back().kind == Piece::kAnyChar) {
+    pieces_.back().len++;
+  } else {
+    pieces_.push_back({Piece::kAnyChar, 0, 1});
+  }
+}
+
+void GlobMatcher::CloseSegment() {
+  Segment segment = {segment_begin_, pieces_.size(), 0, 0, pieces_.size()};
+  for (size_t i = segment.begin; i < segment.end; i++) {
+    if (pieces_[i].kind == Piece::kLiteral && segment.literal_piece == segment.end) {
+      segment.literal_piece = i;
+      segment.literal_offset = segment.len;
+    }
+    segment.len += pieces_[i].len;
+  }
+  segments_.push_back(segment);
+  segment_begin_ = pieces_.size();
+}
+
+bool GlobMatcher::MatchSegment(const Segment& segment, const char* str) const {
+  for (size_t i = segment.begin; i < segment.end; i++) {
+    const Piece& piece = pieces_[i];
+    if (piece.kind == Piece::kLiteral) {
+      if (memcmp(str, literals_.data() + piece.index, piece.len) != 0) {
+        return false;
+      }
+    } else if (piece.kind == Piece::kCharClass) {
+      if (!InClass(classes_[piece.index], static_cast<unsigned char>(*str))) {
+        return false;
+      }
+    }
+    str += piece.len;
+  }
+  return true;
+}
+
+size_t GlobMatcher::FindSegment(const Segment& segment, const char* str, size_t from, size_t to) const {
+  if (to < from || to - from < segment.len) {
+    return npos;
+  }
+  size_t last = to - segment.len;
+  if (segment.literal_piece == segment.end) {
+    for (size_t pos = from; pos <= last; pos++) {
+      if (MatchSegment(segment, str + pos)) {
+        return pos;
+      }
+    }
+    return npos;
+  }
+
+  // Only the places where the first literal shows up can match
+  const Piece& literal = pieces_[segment.literal_piece];
+  const char first = literals_[literal.index];
+  const char* cursor = str + from + segment.literal_offset;
+  const char* limit = str + last + segment.literal_offset + 1;
+  while (cursor < limit) {
+    const auto* found = static_cast<const char*>(memchr(cursor, first, limit - cursor));
+    if (found == nullptr) {
+      break;
+    }
+    size_t pos = found - str - segment.literal_offset;
+    if (MatchSegment(segment, str + pos)) {
+      return pos;
+    }
+    cursor = found + 1;
+  }
+  return npos;
+}
+
+bool GlobMatcher::Match(const char* str, size_t len) const {
+  const Segment& head = segments_.front();
+  if (!has_star_) {
+    return len == head.len && MatchSegment(head, str);
+  }
+  const Segment& tail = segments_.back();
+  if (len < head.len + tail.len || !MatchSegment(head, str) || !MatchSegment(tail, str + len - tail.len)) {
+    return false;
+  }
+  size_t pos = head.len;
+  size_t limit = len - tail.len;
+  for (size_t i = 1; i + 1 < segments_.size(); i++) {
+    size_t found = FindSegment(segments_[i], str, pos, limit);
+    if (found == npos) {
+      return false;
+    }
+    pos = found + segments_[i].len;
+  }
+  return true;
+}
+
+}  // namespace pstd
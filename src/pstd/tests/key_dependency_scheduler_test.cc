@@ -0,0 +1,197 @@
+// Copyright (c) 2015-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#include <sys/time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "pstd/include/key_dependency_scheduler.h"
+
+namespace pstd {
+
+static uint64_t NowMicros() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  return static_cast<uint64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+struct TestTask {
+  std::vector<uint64_t> keys;
+  bool barrier = false;
+  uint64_t seq = 0;
+};
+
+// Runs the ready tasks of a scheduler on a few threads
+class TestPool {
+ public:
+  TestPool(size_t threads, std::function<void(TestTask*)> run)
+      : run_(std::move(run)), scheduler_([this](KeyDependencyScheduler::Task* task, void* arg) {
+          std::lock_guard l(mu_);
+          ready_.emplace_back(task, static_cast<TestTask*>(arg));
+          cv_.notify_one();
+        }) {
+    for (size_t i = 0; i < threads; i++) {
+      threads_.emplace_back([this] { Work(); });
+    }
+  }
+
+  ~TestPool() {
+    {
+      std::lock_guard l(mu_);
+      stop_ = true;
+      cv_.notify_all();
+    }
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  void Submit(TestTask* task) { scheduler_.Submit(task->keys, task->barrier, task); }
+
+  void WaitIdle() {
+    while (scheduler_.InFlight() != 0) {
+      std::this_thread::yield();
+    }
+  }
+
+  KeyDependencyScheduler& scheduler() { return scheduler_; }
+
+ private:
+  void Work() {
+    while (true) {
+      std::pair<KeyDependencyScheduler::Task*, TestTask*> item;
+      {
+        std::unique_lock l(mu_);
+        cv_.wait(l, [this] { return stop_ || !ready_.empty(); });
+        if (ready_.empty()) {
+          return;
+        }
+        item = ready_.front();
+        ready_.pop_front();
+      }
+      run_(item.second);
+      scheduler_.Finish(item.first);
+    }
+  }
+
+  std::function<void(TestTask*)> run_;
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::deque<std::pair<KeyDependencyScheduler::Task*, TestTask*>> ready_;
+  bool stop_ = false;
+  std::vector<std::thread> threads_;
+  KeyDependencyScheduler scheduler_;
+};
+
+TEST(KeyDependencySchedulerTest, OrderOfKeys) {
+  const int kKeys = 16;
+  const int kTasks = 20000;
+  std::vector<uint64_t> last_seq(kKeys, 0);
+  std::atomic<int> running = 0;
+  std::atomic<int> errors = 0;
+  std::atomic<int> max_running = 0;
+
+  std::vector<TestTask> tasks(kTasks);
+  {
+    TestPool pool(4, [&](TestTask* task) {
+      int now_running = ++running;
+      int max = max_running;
+      while (now_running > max && !max_running.compare_exchange_weak(max, now_running)) {
+      }
+      for (uint64_t key : task->keys) {
+        // Tasks of a key see the ones submitted before them done
+        if (last_seq[key] > task->seq) {
+          errors++;
+        }
+        last_seq[key] = task->seq;
+      }
+      // Long enough for tasks of other keys to overlap
+      uint64_t until = NowMicros() + 5;
+      while (NowMicros() < until) {
+      }
+      running--;
+    });
+    for (int i = 0; i < kTasks; i++) {
+      tasks[i].seq = i + 1;
+      tasks[i].keys.push_back(i % kKeys);
+      // Some of them touch two keys, or the same key twice
+      if (i % 7 == 0) {
+        tasks[i].keys.push_back((i / 7) % kKeys);
+      }
+      pool.Submit(&tasks[i]);
+    }
+    pool.WaitIdle();
+    ASSERT_EQ(pool.scheduler().submitted(), kTasks);
+  }
+  ASSERT_EQ(errors, 0);
+  ASSERT_GT(max_running, 1);
+}
+
+TEST(KeyDependencySchedulerTest, Barrier) {
+  const int kTasks = 10000;
+  std::atomic<uint64_t> finished = 0;
+  std::atomic<int> errors = 0;
+
+  std::vector<TestTask> tasks(kTasks);
+  {
+    TestPool pool(4, [&](TestTask* task) {
+      // A barrier runs alone after every task before it, and no task after
+      // it runs before it is done
+      if (task->barrier && finished != task->seq - 1) {
+        errors++;
+      }
+      if (!task->barrier && finished < (task->seq / 1000) * 1000) {
+        errors++;
+      }
+      finished++;
+    });
+    for (int i = 0; i < kTasks; i++) {
+      tasks[i].seq = i + 1;
+      tasks[i].barrier = tasks[i].seq % 1000 == 0;
+      tasks[i].keys.push_back(i);
+      pool.Submit(&tasks[i]);
+    }
+    pool.WaitIdle();
+    ASSERT_EQ(pool.scheduler().barriers(), kTasks / 1000);
+  }
+  ASSERT_EQ(errors, 0);
+  ASSERT_EQ(finished, kTasks);
+}
+
+TEST(KeyDependencySchedulerTest, InFlightLimit) {
+  const int kTasks = 2000;
+  const size_t kLimit = 8;
+  size_t max_in_flight = 0;
+
+  std::vector<TestTask> tasks(kTasks);
+  {
+    TestPool pool(2, [](TestTask* /*task*/) {
+      uint64_t until = NowMicros() + 5;
+      while (NowMicros() < until) {
+      }
+    });
+    // Nothing is in flight, nothing to wait for
+    ASSERT_TRUE(pool.scheduler().WaitInFlightBelow(1, std::chrono::milliseconds(0)));
+    for (int i = 0; i < kTasks; i++) {
+      tasks[i].seq = i + 1;
+      tasks[i].keys.push_back(i % 4);
+      while (!pool.scheduler().WaitInFlightBelow(kLimit, std::chrono::milliseconds(100))) {
+      }
+      pool.Submit(&tasks[i]);
+      max_in_flight = std::max(max_in_flight, pool.scheduler().InFlight());
+    }
+    pool.WaitIdle();
+  }
+  ASSERT_LE(max_in_flight, kLimit);
+}
+
+}  // namespace pstd
@@ -0,0 +1,75 @@
+// Copyright (c) 2015-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#include <random>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "pstd/include/pstd_glob.h"
+#include "pstd/include/pstd_string.h"
+
+namespace pstd {
+
+class GlobTest : public ::testing::Test {};
+
+static bool StringMatch(const std::string& pattern, const std::string& str, bool nocase) {
+  return stringmatchlen(pattern.data(), static_cast<int>(pattern.size()), str.data(), static_cast<int>(str.size()),
+                        nocase ? 1 : 0) != 0;
+}
+
+TEST_F(GlobTest, Basic) {
+  ASSERT_TRUE(GlobMatcher("").Match(""));
+  ASSERT_FALSE(GlobMatcher("").Match("a"));
+  ASSERT_TRUE(GlobMatcher("*").Match(""));
+  ASSERT_TRUE(GlobMatcher("user:*").Match("user:1000"));
+  ASSERT_FALSE(GlobMatcher("user:*").Match("order:1000"));
+  ASSERT_TRUE(GlobMatcher("*:1000").Match("user:1000"));
+  ASSERT_TRUE(GlobMatcher("a*b*c").Match("aXbYbZc"));
+  ASSERT_FALSE(GlobMatcher("a*b*c").Match("aXcYb"));
+  ASSERT_TRUE(GlobMatcher("h?llo").Match("hello"));
+  ASSERT_TRUE(GlobMatcher("h[ae]llo").Match("hallo"));
+  ASSERT_FALSE(GlobMatcher("h[^e]llo").Match("hello"));
+  ASSERT_TRUE(GlobMatcher("h[a-b]llo").Match("hbllo"));
+  ASSERT_TRUE(GlobMatcher("h[b-a]llo").Match("hallo"));
+  ASSERT_TRUE(GlobMatcher("h\\*llo").Match("h*llo"));
+  ASSERT_FALSE(GlobMatcher("h\\*llo").Match("hello"));
+  ASSERT_TRUE(GlobMatcher(std::string("HeLLo"), true).Match("hello"));
+  ASSERT_FALSE(GlobMatcher("HeLLo").Match("hello"));
+
+  GlobMatcher prefix("user:\\*[0-9]*");
+  ASSERT_EQ(prefix.literal_prefix(), "user:*");
+  ASSERT_FALSE(prefix.is_literal());
+  ASSERT_TRUE(GlobMatcher("user:1000").is_literal());
+  ASSERT_TRUE(GlobMatcher("**").match_all());
+  ASSERT_FALSE(GlobMatcher("*a*").match_all());
+  ASSERT_TRUE(GlobMatcher(std::string("user:*"), true).literal_prefix().empty());
+}
+
+TEST_F(GlobTest, SameAsStringMatch) {
+  // Small alphabets so that patterns and strings often overlap
+  const std::string pattern_chars = "ab*?[]^-\\Aa";
+  const std::string string_chars = "abAB-]\\*";
+  std::mt19937 rnd(301);
+  for (int i = 0; i < 200000; i++) {
+    std::string pattern;
+    std::string str;
+    for (size_t len = rnd() % 10; len > 0; len--) {
+      pattern.push_back(pattern_chars[rnd() % pattern_chars.size()]);
+    }
+    for (size_t len = rnd() % 12 + 1; len > 0; len--) {
+      str.push_back(rnd() % 16 == 0 ? static_cast<char>(rnd() % 256) : string_chars[rnd() % string_chars.size()]);
+    }
+    // stringmatchlen reads past both ends on these
+    if (!pattern.empty() && pattern.back() == '\\') {
+      continue;
+    }
+    for (bool nocase : {false, true}) {
+      ASSERT_EQ(GlobMatcher(pattern, nocase).Match(str), StringMatch(pattern, str, nocase))
+          << "pattern " << pattern << ", string " << str << ", nocase " << nocase;
+    }
+  }
+}
+
+}  // namespace pstd
@@ -3,8 +3,10 @@
 //  LICENSE file in the root directory of this source tree. An additional grant
 //  of patent rights can be found in the PATENTS file in the same directory.
 
+#include <cmath>
 #include <functional>
 #include <iostream>
+#include <random>
 #include <thread>
 #include <vector>
 
@@ -23,10 +25,10 @@ static const std::string value(VALUELENGTH, 'a');
 
 void BenchSet() {
   printf("====== Set ======\n");
-  storage::Options options;
-  options.create_if_missing = true;
+  storage::StorageOptions storage_options;
+  storage_options.options.create_if_missing = true;
   storage::Storage db;
-  storage::Status s = db.Open(options, "./db");
+  storage::Status s = db.Open(storage_options, "./db");
 
   if (!s.ok()) {
     printf("Open db failed, error: %s\n", s.ToString().c_str());
@@ -81,10 +83,10 @@ void BenchSet() {
 
 void BenchHGetall() {
   printf("====== HGetall ======\n");
-  storage::Options options;
-  options.create_if_missing = true;
+  storage::StorageOptions storage_options;
+  storage_options.options.create_if_missing = true;
   storage::Storage db;
-  storage::Status s = db.Open(options, "./db");
+  storage::Status s = db.Open(storage_options, "./db");
 
   if (!s.ok()) {
     printf("Open db failed, error: %s\n", s.ToString().c_str());
@@ -92,10 +94,10 @@ void BenchHGetall() {
   }
 
   int32_t ret = 0;
-  Storage::FieldValue fv;
+  FieldValue fv;
   std::vector<std::string> fields;
-  std::vector<Storage::FieldValue> fvs_in;
-  std::vector<Storage::FieldValue> fvs_out;
+  std::vector<FieldValue> fvs_in;
+  std::vector<FieldValue> fvs_out;
 
   // 1. Create the hash table then insert hash table 10000 field
   // 2. HGetall the hash table 10000 field (statistics cost time)
@@ -127,8 +129,8 @@ void BenchHGetall() {
     fvs_in.push_back(fv);
   }
   db.HMSet("HGETALL_KEY2", fvs_in);
-  std::vector<Slice> del_keys({"HGETALL_KEY2"});
-  std::map<Storage::DataType, Status> type_status;
+  std::vector<std::string> del_keys({"HGETALL_KEY2"});
+  std::map<DataType, Status> type_status;
   db.Del(del_keys, &type_status);
   fvs_in.clear();
   for (size_t i = 0; i < 10000; ++i) {
@@ -173,10 +175,10 @@ void BenchHGetall() {
 
 void BenchScan() {
   printf("====== Scan ======\n");
-  storage::Options options;
-  options.create_if_missing = true;
+  storage::StorageOptions storage_options;
+  storage_options.options.create_if_missing = true;
   storage::Storage db;
-  storage::Status s = db.Open(options, "./db");
+  storage::Status s = db.Open(storage_options, "./db");
 
   if (!s.ok()) {
     printf("Open db failed, error: %s\n", s.ToString().c_str());
@@ -224,12 +226,249 @@ void BenchScan() {
   elapsed_seconds = end - start;
   cost = duration_cast<seconds>(elapsed_seconds).count();
   std::cout << "Test case 3, Scan " << kv_num << " Cost: " << cost << "s" << std::endl;
+
+  // Scan and Keys by a prefix only visit the keys starting with it
+  const std::string pattern = key + "1234*";
+  size_t matched = 0;
+  int64_t cursor = 0;
+  auto prefix_start = system_clock::now();
+  do {
+    keys.clear();
+    cursor = db.Scan(DataType::kStrings, cursor, pattern, 100, &keys);
+    matched += keys.size();
+  } while (cursor != 0);
+  auto prefix_cost = duration_cast<microseconds>(system_clock::now() - prefix_start).count();
+  std::cout << "Test case 4, Scan " << pattern.substr(key.size()) << " matched " << matched
+            << " Cost: " << prefix_cost << "us" << std::endl;
+
+  keys.clear();
+  prefix_start = system_clock::now();
+  db.Keys(DataType::kStrings, pattern, &keys);
+  prefix_cost = duration_cast<microseconds>(system_clock::now() - prefix_start).count();
+  std::cout << "Test case 5, Keys " << pattern.substr(key.size()) << " matched " << keys.size()
+            << " Cost: " << prefix_cost << "us" << std::endl;
+}
+
+// Compare the batched MGet/Exists against looking up the same keys one by one
+void BenchMGet() {
+  printf("====== MGet ======\n");
+  storage::StorageOptions storage_options;
+  storage_options.options.create_if_missing = true;
+  storage::Storage db;
+  storage::Status s = db.Open(storage_options, "./db_mget");
+
+  if (!s.ok()) {
+    printf("Open db failed, error: %s\n", s.ToString().c_str());
+    return;
+  }
+
+  const size_t kv_num = 1000000;
+  const std::string mget_value(100, 'v');
+  std::vector<KeyValue> kvs;
+  for (size_t i = 0; i < kv_num; ++i) {
+    kvs.push_back({"MGET_KEY_" + std::to_string(i), mget_value});
+    if (kvs.size() == 1000) {
+      db.MSet(kvs);
+      kvs.clear();
+    }
+  }
+  db.Compact(DataType::kStrings, true);
+
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<size_t> dist(0, kv_num * 2 - 1);
+  const size_t rounds = 1000;
+  for (size_t batch_size : {100, 500}) {
+    std::vector<std::vector<std::string>> batches(rounds);
+    for (auto& batch : batches) {
+      for (size_t i = 0; i < batch_size; ++i) {
+        // Half of the keys do not exist
+        batch.push_back("MGET_KEY_" + std::to_string(dist(gen)));
+      }
+    }
+
+    std::string value;
+    auto start = system_clock::now();
+    for (const auto& batch : batches) {
+      for (const auto& batch_key : batch) {
+        db.Get(batch_key, &value);
+      }
+    }
+    auto end = system_clock::now();
+    auto loop_cost = duration_cast<milliseconds>(end - start).count();
+
+    std::vector<ValueStatus> vss;
+    start = system_clock::now();
+    for (const auto& batch : batches) {
+      db.MGet(batch, &vss);
+    }
+    end = system_clock::now();
+    auto batch_cost = duration_cast<milliseconds>(end - start).count();
+    std::cout << "Test case " << batch_size << " keys, Get loop Cost: " << loop_cost
+              << "ms, MGet Cost: " << batch_cost << "ms" << std::endl;
+
+    std::map<DataType, Status> type_status;
+    start = system_clock::now();
+    for (const auto& batch : batches) {
+      for (const auto& batch_key : batch) {
+        db.Exists({batch_key}, &type_status);
+      }
+    }
+    end = system_clock::now();
+    loop_cost = duration_cast<milliseconds>(end - start).count();
+
+    start = system_clock::now();
+    for (const auto& batch : batches) {
+      db.Exists(batch, &type_status);
+    }
+    end = system_clock::now();
+    batch_cost = duration_cast<milliseconds>(end - start).count();
+    std::cout << "Test case " << batch_size << " keys, Exists loop Cost: " << loop_cost
+              << "ms, Exists batch Cost: " << batch_cost << "ms" << std::endl;
+  }
+}
+
+// Multi type key commands on keys owned by one type and on missing keys,
+// every type database is probed once and only the owners are locked
+void BenchKeyCommands() {
+  printf("====== Key Commands ======\n");
+  storage::StorageOptions storage_options;
+  storage_options.options.create_if_missing = true;
+  storage::Storage db;
+  storage::Status s = db.Open(storage_options, "./db_keys");
+
+  if (!s.ok()) {
+    printf("Open db failed, error: %s\n", s.ToString().c_str());
+    return;
+  }
+
+  const size_t kv_num = 100000;
+  int32_t ret = 0;
+  for (size_t i = 0; i < kv_num; ++i) {
+    db.Set("KEYS_STRING_" + std::to_string(i), "value");
+    db.HSet("KEYS_HASH_" + std::to_string(i), "field", "value", &ret);
+  }
+
+  using KeyCommand = std::function<void(const std::string&)>;
+  std::map<DataType, Status> type_status;
+  std::vector<std::string> types;
+  const std::vector<std::pair<std::string, KeyCommand>> commands = {
+      {"Exists", [&](const std::string& k) { db.Exists({k}, &type_status); }},
+      {"Type", [&](const std::string& k) { db.GetType(k, true, types); }},
+      {"TTL", [&](const std::string& k) { db.TTL(k, &type_status); }},
+      {"Expire", [&](const std::string& k) { db.Expire(k, 1000, &type_status); }},
+      {"Persist", [&](const std::string& k) { db.Persist(k, &type_status); }}};
+  for (const char* prefix : {"KEYS_STRING_", "KEYS_HASH_", "KEYS_MISSING_"}) {
+    for (const auto& [name, command] : commands) {
+      auto start = system_clock::now();
+      for (size_t i = 0; i < kv_num; ++i) {
+        command(prefix + std::to_string(i));
+      }
+      auto end = system_clock::now();
+      auto cost = duration_cast<microseconds>(end - start).count();
+      std::cout << "Test case " << prefix << "*, " << name << " " << kv_num << " Cost: " << cost / 1000
+                << "ms QPS: " << (cost != 0 ? kv_num * 1000000 / cost : 0) << std::endl;
+    }
+  }
+}
+
+// Get and HGet on keys picked by a zipf distribution, so a few keys take most
+// of the reads, without and with the value cache, one in twenty reads is
+// followed by a write to the same key
+void BenchValueCache() {
+  printf("====== Value Cache ======\n");
+  const size_t kv_num = 1000000;
+  const size_t ops_per_thread = 500000;
+  const size_t thread_num = 4;
+  const std::string cache_value(100, 'v');
+
+  // P(i) ~ 1 / (i + 1)^0.99
+  std::vector<double> weights(kv_num);
+  for (size_t i = 0; i < kv_num; ++i) {
+    weights[i] = 1.0 / std::pow(static_cast<double>(i + 1), 0.99);
+  }
+
+  for (size_t value_cache_size : {0, 256 << 20}) {
+    storage::StorageOptions storage_options;
+    storage_options.options.create_if_missing = true;
+    storage_options.value_cache_size = value_cache_size;
+    storage::Storage db;
+    storage::Status s = db.Open(storage_options, "./db_value_cache");
+    if (!s.ok()) {
+      printf("Open db failed, error: %s\n", s.ToString().c_str());
+      return;
+    }
+
+    std::vector<KeyValue> kvs;
+    for (size_t i = 0; i < kv_num; ++i) {
+      kvs.push_back({"CACHE_STRING_" + std::to_string(i), cache_value});
+      if (kvs.size() == 1000) {
+        db.MSet(kvs);
+        kvs.clear();
+      }
+      if (i % 10 == 0) {
+        std::vector<FieldValue> fvs;
+        for (size_t j = 0; j < 10; ++j) {
+          fvs.push_back({"field_" + std::to_string(j), cache_value});
+        }
+        db.HMSet("CACHE_HASH_" + std::to_string(i), fvs);
+      }
+    }
+
+    for (const std::string command : {"Get", "HGet"}) {
+      bool strings = command == "Get";
+      std::vector<std::thread> jobs;
+      auto start = system_clock::now();
+      for (size_t i = 0; i < thread_num; ++i) {
+        jobs.emplace_back([&, i]() {
+          std::mt19937 gen(i);
+          std::discrete_distribution<size_t> dist(weights.begin(), weights.end());
+          std::string result;
+          int32_t ret = 0;
+          for (size_t j = 0; j < ops_per_thread; ++j) {
+            size_t index = dist(gen);
+            if (strings) {
+              std::string cache_key = "CACHE_STRING_" + std::to_string(index);
+              db.Get(cache_key, &result);
+              if (j % 20 == 0) {
+                db.Set(cache_key, cache_value);
+              }
+            } else {
+              std::string cache_key = "CACHE_HASH_" + std::to_string(index / 10 * 10);
+              db.HGet(cache_key, "field_" + std::to_string(index % 10), &result);
+              if (j % 20 == 0) {
+                db.HSet(cache_key, "field_0", cache_value, &ret);
+              }
+            }
+          }
+        });
+      }
+      for (auto& job : jobs) {
+        job.join();
+      }
+      auto end = system_clock::now();
+      auto cost = duration_cast<microseconds>(end - start).count();
+      ValueCacheInfo value_cache_info;
+      db.GetValueCacheInfo(&value_cache_info);
+      uint64_t lookups = value_cache_info.hits + value_cache_info.misses;
+      std::cout << "Test case " << command << ", value cache " << (value_cache_size >> 20) << "MB, "
+                << thread_num * ops_per_thread << " Cost: " << cost / 1000
+                << "ms QPS: " << (cost != 0 ? thread_num * ops_per_thread * 1000000 / cost : 0)
+                << " hit rate: " << (lookups != 0 ? value_cache_info.hits * 100 / lookups : 0) << "%" << std::endl;
+    }
+  }
 }
 
 int main(int argc, char** argv) {
   // keys
   BenchSet();
 
+  // batched lookups
+  BenchMGet();
+  BenchKeyCommands();
+
+  // hot keys
+  BenchValueCache();
+
   // hashes
   BenchHGetall();
 
@@ -48,6 +48,7 @@ using BlockBasedTableOptions = rocksdb::BlockBasedTableOptions;
 using Status = rocksdb::Status;
 using Slice = rocksdb::Slice;
 
+class Redis;
 class RedisStrings;
 class RedisHashes;
 class RedisSets;
@@ -57,7 +58,8 @@ class HyperLogLog;
 enum class OptionType;
 
 template <typename T1, typename T2>
-class LRUCache;
+class ShardedLRUCache;
+class ValueCache;
 
 struct StorageOptions {
   rocksdb::Options options;
@@ -66,6 +68,21 @@ struct StorageOptions {
   bool share_block_cache = false;
   size_t statistics_max_size = 0;
   size_t small_compaction_threshold = 5000;
+  bool zset_rank_index = false;
+  uint32_t lists_chunk_size = 0;
+  // Whether the string writes that do not read the key look up its previous
+  // state, without it the string statistics are estimated by rocksdb
+  bool exact_key_statistics = false;
+  // The type dbs opened at the same time by Storage::Open
+  size_t open_threads = 5;
+  // How often the bg thread deletes the due keys of the expire indexes, 0
+  // leaves them to the compaction, and how many deletions one round of a
+  // type db may make
+  int64_t active_expire_cycle_ms = 100;
+  size_t active_expire_batch_size = 256;
+  // The bytes of the cache of hot strings and small hashes in front of the
+  // type dbs, 0 disables it
+  size_t value_cache_size = 0;
   Status ResetOptions(const OptionType& option_type, const std::unordered_map<std::string, std::string>& options_map);
 };
 
@@ -83,6 +100,13 @@ struct KeyInfo {
   uint64_t invaild_keys;
 };
 
+struct ValueCacheInfo {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t usage = 0;
+  uint64_t entries = 0;
+};
+
 struct ValueStatus {
   std::string value;
   Status status;
@@ -1008,6 +1032,8 @@ class Storage {
   // Admin Commands
   Status StartBGThread();
   Status RunBGTask();
+  void PersistKeyStatistics();
+  void ActiveExpire();
   Status AddBGTask(const BGTask& bg_task);
 
   Status Compact(const DataType& type, bool sync = false);
@@ -1022,8 +1048,16 @@ class Storage {
   Status GetUsage(const std::string& property, std::map<std::string, uint64_t>* type_result);
   uint64_t GetProperty(const std::string& db_type, const std::string& property);
 
+  // Scans every db for its keys and recounts the keyspace statistics
   Status GetKeyNum(std::vector<KeyInfo>* key_infos);
+  // The keyspace statistics kept up to date by the write paths, in the order
+  // of GetKeyNum, returns false if any of them is an estimate
+  bool GetKeyStatistics(std::vector<KeyInfo>* key_infos);
   Status StopScanKeyNum();
+  // The expired keys deleted by the active expiration since Open
+  uint64_t GetActiveExpiredKeys();
+  // All zero if the value cache is disabled
+  void GetValueCacheInfo(ValueCacheInfo* info);
 
   rocksdb::DB* GetDBByType(const std::string& type);
 
@@ -1032,6 +1066,15 @@ class Storage {
   void GetRocksDBInfo(std::string& info);
 
  private:
+  // All the databases except hyperloglog, which is stored in strings_db_
+  std::vector<std::pair<DataType, Redis*>> TypeDBs();
+  // Probes the meta value of key in every type database, collects the ones
+  // holding a live key into owners and returns false if any probe failed
+  bool ProbeKeyOwners(const Slice& key, std::vector<std::pair<DataType, Redis*>>* owners,
+                      std::map<DataType, Status>* type_status);
+
+  // Shared by strings_db_ and hashes_db_, which outlive it
+  std::unique_ptr<ValueCache> value_cache_;
   std::unique_ptr<RedisStrings> strings_db_;
   std::unique_ptr<RedisHashes> hashes_db_;
   std::unique_ptr<RedisSets> sets_db_;
@@ -1039,7 +1082,7 @@ class Storage {
   std::unique_ptr<RedisLists> lists_db_;
   std::atomic<bool> is_opened_ = false;
 
-  std::unique_ptr<LRUCache<std::string, std::string>> cursors_store_;
+  std::unique_ptr<ShardedLRUCache<std::string, std::string>> cursors_store_;
 
   // Storage start the background thread for compaction task
   pthread_t bg_tasks_thread_id_ = 0;
@@ -1049,6 +1092,8 @@ class Storage {
 
   std::atomic<int> current_task_type_ = kNone;
   std::atomic<bool> bg_tasks_should_exit_ = false;
+  std::atomic<int64_t> active_expire_cycle_ms_ = 0;
+  std::atomic<size_t> active_expire_batch_size_ = 0;
 
   // For scan keys in data base
   std::atomic<bool> scan_keynum_exit_ = false;
@@ -6,20 +6,24 @@
 #ifndef SRC_BASE_FILTER_H_
 #define SRC_BASE_FILTER_H_
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "rocksdb/compaction_filter.h"
+#include "rocksdb/db.h"
+#include "rocksdb/env.h"
 #include "src/base_data_key_format.h"
 #include "src/base_meta_value_format.h"
 #include "src/debug.h"
+#include "src/key_statistics.h"
 
 namespace storage {
 
 class BaseMetaFilter : public rocksdb::CompactionFilter {
  public:
-  BaseMetaFilter() = default;
+  explicit BaseMetaFilter(KeyStatistics* key_statistics = nullptr) : key_statistics_(key_statistics) {}
   bool Filter(int level, const rocksdb::Slice& key, const rocksdb::Slice& value, std::string* new_value,
               bool* value_changed) const override {
     int64_t unix_time;
@@ -34,6 +38,9 @@ class BaseMetaFilter : public rocksdb::CompactionFilter {
     if (parsed_base_meta_value.timestamp() != 0 && parsed_base_meta_value.timestamp() < cur_time &&
         parsed_base_meta_value.version() < cur_time) {
       TRACE("Drop[Stale & version < cur_time]");
+      if (key_statistics_ != nullptr) {
+        key_statistics_->Drop({parsed_base_meta_value.count() != 0, parsed_base_meta_value.timestamp()});
+      }
       return true;
     }
     if (parsed_base_meta_value.count() == 0 && parsed_base_meta_value.version() < cur_time) {
@@ -45,24 +52,139 @@ class BaseMetaFilter : public rocksdb::CompactionFilter {
   }
 
   const char* Name() const override { return "BaseMetaFilter"; }
+
+ private:
+  KeyStatistics* key_statistics_ = nullptr;
 };
 
 class BaseMetaFilterFactory : public rocksdb::CompactionFilterFactory {
  public:
-  BaseMetaFilterFactory() = default;
+  // The expired keys dropped are taken out of key_statistics
+  explicit BaseMetaFilterFactory(KeyStatistics* key_statistics = nullptr) : key_statistics_(key_statistics) {}
   std::unique_ptr<rocksdb::CompactionFilter> CreateCompactionFilter(
       const rocksdb::CompactionFilter::Context& context) override {
-    return std::unique_ptr<rocksdb::CompactionFilter>(new BaseMetaFilter());
+    return std::unique_ptr<rocksdb::CompactionFilter>(new BaseMetaFilter(key_statistics_));
   }
   const char* Name() const override { return "BaseMetaFilterFactory"; }
+
+ private:
+  KeyStatistics* key_statistics_ = nullptr;
+};
+
+// The meta lookups of the data filters of one db, for INFO
+struct DataFilterStatistics {
+  std::atomic<uint64_t> lookups = 0;
+  // Found by stepping the meta iterator forward
+  std::atomic<uint64_t> iterator_hits = 0;
+  std::atomic<uint64_t> seeks = 0;
+  std::atomic<uint64_t> gets = 0;
+};
+
+/*
+ * Looks up the meta values of the keys a compaction hands to a data filter.
+ *
+ * The data keys of a key are contiguous, and keys of the same length come in
+ * the order of the meta column family, so instead of a random Get per key the
+ * lookups step one meta iterator forward and only seek it when the key is not
+ * a few entries ahead.
+ *
+ * The iterator reads the meta values as they were when the compaction
+ * started. A version only grows and an expired key stays expired, so what it
+ * reads is good enough to drop data, except for a key that expires during the
+ * compaction, whose expire time may have been changed since, it is read again
+ * with a Get.
+ */
+template <typename ParsedMetaValue>
+class DataFilterMetaReader {
+ public:
+  DataFilterMetaReader(rocksdb::DB* db, rocksdb::ColumnFamilyHandle* meta_handle, DataFilterStatistics* statistics)
+      : db_(db), meta_handle_(meta_handle), statistics_(statistics) {
+    iterator_options_.fill_cache = false;
+  }
+
+  ~DataFilterMetaReader() {
+    delete iter_;
+    if (statistics_ != nullptr) {
+      statistics_->lookups += lookups_;
+      statistics_->iterator_hits += iterator_hits_;
+      statistics_->seeks += seeks_;
+      statistics_->gets += gets_;
+    }
+  }
+
+  // Returns NotFound if the meta value does not exist
+  rocksdb::Status Lookup(const std::string& key, int32_t* version, int32_t* timestamp) {
+    lookups_++;
+    if (iter_ == nullptr) {
+      rocksdb::Env::Default()->GetCurrentTime(&iter_time_);
+      iter_ = db_->NewIterator(iterator_options_, meta_handle_);
+    }
+
+    // Stepping forward finds the key if the iterator stops at it, after it or
+    // at the end, not standing after it already
+    int32_t steps = 0;
+    while (iter_->Valid() && steps < kMaxForwardSteps && iter_->key().compare(key) < 0) {
+      iter_->Next();
+      steps++;
+    }
+    int cmp = iter_->Valid() ? iter_->key().compare(key) : (iter_->status().ok() ? 1 : -1);
+    if (cmp == 0 || (cmp > 0 && steps > 0)) {
+      iterator_hits_++;
+    } else {
+      seeks_++;
+      iter_->Seek(key);
+    }
+    if (!iter_->status().ok()) {
+      return iter_->status();
+    }
+    if (!iter_->Valid() || iter_->key() != key) {
+      return rocksdb::Status::NotFound();
+    }
+
+    ParsedMetaValue parsed_meta_value(iter_->value());
+    *version = parsed_meta_value.version();
+    *timestamp = parsed_meta_value.timestamp();
+    if (*timestamp == 0 || *timestamp < iter_time_) {
+      return rocksdb::Status::OK();
+    }
+    int64_t unix_time;
+    rocksdb::Env::Default()->GetCurrentTime(&unix_time);
+    if (*timestamp >= unix_time) {
+      return rocksdb::Status::OK();
+    }
+
+    gets_++;
+    std::string meta_value;
+    rocksdb::Status s = db_->Get(rocksdb::ReadOptions(), meta_handle_, key, &meta_value);
+    if (s.ok()) {
+      ParsedMetaValue parsed_latest_meta_value(&meta_value);
+      *version = parsed_latest_meta_value.version();
+      *timestamp = parsed_latest_meta_value.timestamp();
+    }
+    return s;
+  }
+
+ private:
+  // Like rocksdb's max_sequential_skip_in_iterations
+  static const int32_t kMaxForwardSteps = 8;
+
+  rocksdb::DB* db_ = nullptr;
+  rocksdb::ColumnFamilyHandle* meta_handle_ = nullptr;
+  DataFilterStatistics* statistics_ = nullptr;
+  rocksdb::ReadOptions iterator_options_;
+  rocksdb::Iterator* iter_ = nullptr;
+  int64_t iter_time_ = 0;
+  uint64_t lookups_ = 0;
+  uint64_t iterator_hits_ = 0;
+  uint64_t seeks_ = 0;
+  uint64_t gets_ = 0;
 };
 
 class BaseDataFilter : public rocksdb::CompactionFilter {
  public:
-  BaseDataFilter(rocksdb::DB* db, std::vector<rocksdb::ColumnFamilyHandle*>* cf_handles_ptr)
-      : db_(db),
-        cf_handles_ptr_(cf_handles_ptr)
-        {}
+  BaseDataFilter(rocksdb::DB* db, std::vector<rocksdb::ColumnFamilyHandle*>* cf_handles_ptr,
+                 DataFilterStatistics* statistics = nullptr)
+      : db_(db), cf_handles_ptr_(cf_handles_ptr), statistics_(statistics) {}
 
   bool Filter(int level, const Slice& key, const rocksdb::Slice& value, std::string* new_value,
               bool* value_changed) const override {
@@ -71,19 +193,19 @@ class BaseDataFilter : public rocksdb::CompactionFilter {
     TRACE("[DataFilter], key: %s, data = %s, version = %d", parsed_base_data_key.key().ToString().c_str(),
           parsed_base_data_key.data().ToString().c_str(), parsed_base_data_key.version());
 
-    if (parsed_base_data_key.key().ToString() != cur_key_) {
+    if (parsed_base_data_key.key() != Slice(cur_key_)) {
       cur_key_ = parsed_base_data_key.key().ToString();
-      std::string meta_value;
       // destroyed when close the database, Reserve Current key value
       if (cf_handles_ptr_->empty()) {
         return false;
       }
-      Status s = db_->Get(default_read_options_, (*cf_handles_ptr_)[0], cur_key_, &meta_value);
+      if (!meta_reader_) {
+        meta_reader_ =
+            std::make_unique<DataFilterMetaReader<ParsedBaseMetaValue>>(db_, (*cf_handles_ptr_)[0], statistics_);
+      }
+      Status s = meta_reader_->Lookup(cur_key_, &cur_meta_version_, &cur_meta_timestamp_);
       if (s.ok()) {
         meta_not_found_ = false;
-        ParsedBaseMetaValue parsed_base_meta_value(&meta_value);
-        cur_meta_version_ = parsed_base_meta_value.version();
-        cur_meta_timestamp_ = parsed_base_meta_value.timestamp();
       } else if (s.IsNotFound()) {
         meta_not_found_ = true;
       } else {
@@ -119,7 +241,8 @@ class BaseDataFilter : public rocksdb::CompactionFilter {
  private:
   rocksdb::DB* db_ = nullptr;
   std::vector<rocksdb::ColumnFamilyHandle*>* cf_handles_ptr_ = nullptr;
-  rocksdb::ReadOptions default_read_options_;
+  DataFilterStatistics* statistics_ = nullptr;
+  mutable std::unique_ptr<DataFilterMetaReader<ParsedBaseMetaValue>> meta_reader_;
   mutable std::string cur_key_;
   mutable bool meta_not_found_ = false;
   mutable int32_t cur_meta_version_ = 0;
@@ -128,17 +251,19 @@ class BaseDataFilter : public rocksdb::CompactionFilter {
 
 class BaseDataFilterFactory : public rocksdb::CompactionFilterFactory {
  public:
-  BaseDataFilterFactory(rocksdb::DB** db_ptr, std::vector<rocksdb::ColumnFamilyHandle*>* handles_ptr)
-      : db_ptr_(db_ptr), cf_handles_ptr_(handles_ptr) {}
+  BaseDataFilterFactory(rocksdb::DB** db_ptr, std::vector<rocksdb::ColumnFamilyHandle*>* handles_ptr,
+                        DataFilterStatistics* statistics = nullptr)
+      : db_ptr_(db_ptr), cf_handles_ptr_(handles_ptr), statistics_(statistics) {}
   std::unique_ptr<rocksdb::CompactionFilter> CreateCompactionFilter(
       const rocksdb::CompactionFilter::Context& context) override {
-    return std::unique_ptr<rocksdb::CompactionFilter>(new BaseDataFilter(*db_ptr_, cf_handles_ptr_));
+    return std::unique_ptr<rocksdb::CompactionFilter>(new BaseDataFilter(*db_ptr_, cf_handles_ptr_, statistics_));
   }
   const char* Name() const override { return "BaseDataFilterFactory"; }
 
  private:
   rocksdb::DB** db_ptr_ = nullptr;
   std::vector<rocksdb::ColumnFamilyHandle*>* cf_handles_ptr_ = nullptr;
+  DataFilterStatistics* statistics_ = nullptr;
 };
 
 using HashesMetaFilter = BaseMetaFilter;
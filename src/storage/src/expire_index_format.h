@@ -0,0 +1,60 @@
+//  Copyright (c) 2017-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef SRC_EXPIRE_INDEX_FORMAT_H_
+#define SRC_EXPIRE_INDEX_FORMAT_H_
+
+#include <string>
+
+#include "rocksdb/slice.h"
+
+namespace storage {
+
+/*
+ * An entry of the expire index column family, with an empty value:
+ *
+ * | <Timestamp> | <Key> |
+ *     4 Bytes
+ *
+ * The timestamp is big endian, so the entries are ordered by the time their
+ * keys expire and the due ones are a prefix of the column family.
+ */
+class ExpireIndexKey {
+ public:
+  ExpireIndexKey(int32_t timestamp, const rocksdb::Slice& key) {
+    auto value = static_cast<uint32_t>(timestamp);
+    encoded_.reserve(sizeof(uint32_t) + key.size());
+    encoded_.push_back(static_cast<char>(value >> 24));
+    encoded_.push_back(static_cast<char>(value >> 16));
+    encoded_.push_back(static_cast<char>(value >> 8));
+    encoded_.push_back(static_cast<char>(value));
+    encoded_.append(key.data(), key.size());
+  }
+
+  rocksdb::Slice Encode() const { return encoded_; }
+
+ private:
+  std::string encoded_;
+};
+
+class ParsedExpireIndexKey {
+ public:
+  explicit ParsedExpireIndexKey(const rocksdb::Slice& index_key) {
+    const auto* ptr = reinterpret_cast<const unsigned char*>(index_key.data());
+    timestamp_ = static_cast<int32_t>((static_cast<uint32_t>(ptr[0]) << 24) | (static_cast<uint32_t>(ptr[1]) << 16) |
+                                      (static_cast<uint32_t>(ptr[2]) << 8) | static_cast<uint32_t>(ptr[3]));
+    key_ = rocksdb::Slice(index_key.data() + sizeof(uint32_t), index_key.size() - sizeof(uint32_t));
+  }
+
+  int32_t timestamp() const { return timestamp_; }
+  rocksdb::Slice key() const { return key_; }
+
+ private:
+  int32_t timestamp_ = 0;
+  rocksdb::Slice key_;
+};
+
+}  //  namespace storage
+#endif  // SRC_EXPIRE_INDEX_FORMAT_H_
@@ -0,0 +1,302 @@
+//  Copyright (c) 2017-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "src/key_statistics.h"
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+
+#include "rocksdb/env.h"
+
+#include "src/coding.h"
+
+namespace storage {
+
+static const uint32_t kKeyStatisticsFormatVersion = 1;
+
+static int64_t NowBucket(int64_t now) { return now / KeyStatistics::kBucketSeconds; }
+
+void KeyStatistics::Counts::Apply(const KeyState& state, int64_t delta) {
+  if (!state.exists) {
+    return;
+  }
+  keys += delta;
+  if (state.timestamp != 0) {
+    ApplyTimestamp(state.timestamp, delta);
+  }
+}
+
+void KeyStatistics::Counts::ApplyTimestamp(int32_t timestamp, int64_t delta) {
+  int64_t bucket = timestamp / kBucketSeconds;
+  if (bucket < first_bucket) {
+    expired += delta;
+    return;
+  }
+  auto& [count, timestamp_sum] = buckets[bucket];
+  count += delta;
+  timestamp_sum += delta * timestamp;
+  if (count == 0 && timestamp_sum == 0) {
+    buckets.erase(bucket);
+  }
+}
+
+void KeyStatistics::Counts::ExpireBefore(int64_t bucket) {
+  auto iter = buckets.begin();
+  while (iter != buckets.end() && iter->first < bucket) {
+    expired += iter->second.first;
+    iter = buckets.erase(iter);
+  }
+  first_bucket = std::max(first_bucket, bucket);
+}
+
+void KeyStatistics::Counts::Merge(const Counts& other) {
+  ExpireBefore(other.first_bucket);
+  keys += other.keys;
+  expired += other.expired;
+  for (const auto& [bucket, counts] : other.buckets) {
+    if (bucket < first_bucket) {
+      expired += counts.first;
+      continue;
+    }
+    auto& [count, timestamp_sum] = buckets[bucket];
+    count += counts.first;
+    timestamp_sum += counts.second;
+    if (count == 0 && timestamp_sum == 0) {
+      buckets.erase(bucket);
+    }
+  }
+}
+
+KeyStatistics::~KeyStatistics() {
+  for (auto& shard : shards_) {
+    TimestampChange* change = shard.changes.exchange(nullptr);
+    while (change) {
+      TimestampChange* next = change->next;
+      delete change;
+      change = next;
+    }
+  }
+}
+
+void KeyStatistics::Update(const KeyState& before, const KeyState& after) {
+  if (before.exists == after.exists && (!before.exists || before.timestamp == after.timestamp)) {
+    return;
+  }
+  Shard* shard = &shards_[std::hash<std::thread::id>()(std::this_thread::get_id()) % kShards];
+  int64_t keys = (after.exists ? 1 : 0) - (before.exists ? 1 : 0);
+  if (keys != 0) {
+    shard->keys.fetch_add(keys, std::memory_order_relaxed);
+  }
+  if (before.exists && before.timestamp != 0) {
+    PushTimestampChange(shard, before.timestamp, -1);
+  }
+  if (after.exists && after.timestamp != 0) {
+    PushTimestampChange(shard, after.timestamp, 1);
+  }
+}
+
+void KeyStatistics::PushTimestampChange(Shard* shard, int32_t timestamp, int32_t delta) {
+  auto change = new TimestampChange{timestamp, delta, shard->changes.load(std::memory_order_relaxed)};
+  while (!shard->changes.compare_exchange_weak(change->next, change, std::memory_order_release,
+                                               std::memory_order_relaxed)) {
+  }
+  // Keeps the changes from piling up when nobody reads the statistics, a
+  // writer never waits for the lock
+  if (shard->pending.fetch_add(1, std::memory_order_relaxed) + 1 >= kMaxPendingChanges && mu_.try_lock()) {
+    Collect();
+    mu_.unlock();
+  }
+}
+
+void KeyStatistics::Collect() {
+  for (auto& shard : shards_) {
+    int64_t keys = shard.keys.exchange(0, std::memory_order_relaxed);
+    counts_.keys += keys;
+    if (recount_ != 0) {
+      recount_counts_.keys += keys;
+    }
+    TimestampChange* change = shard.changes.exchange(nullptr, std::memory_order_acquire);
+    int64_t collected = 0;
+    while (change) {
+      counts_.ApplyTimestamp(change->timestamp, change->delta);
+      if (recount_ != 0) {
+        recount_counts_.ApplyTimestamp(change->timestamp, change->delta);
+      }
+      TimestampChange* next = change->next;
+      delete change;
+      change = next;
+      collected++;
+    }
+    shard.pending.fetch_sub(collected, std::memory_order_relaxed);
+  }
+}
+
+void KeyStatistics::Drop(const KeyState& state) {
+  if (!state.exists || state.timestamp == 0) {
+    return;
+  }
+  std::lock_guard l(mu_);
+  Collect();
+  if (counts_.keys <= 0) {
+    return;
+  }
+  int64_t bucket = state.timestamp / kBucketSeconds;
+  if (bucket < counts_.first_bucket) {
+    if (counts_.expired <= 0) {
+      return;
+    }
+    counts_.expired--;
+  } else {
+    auto iter = counts_.buckets.find(bucket);
+    if (iter == counts_.buckets.end() || iter->second.first <= 0) {
+      return;
+    }
+    auto& [count, timestamp_sum] = iter->second;
+    count--;
+    timestamp_sum -= state.timestamp;
+    if (count == 0) {
+      counts_.buckets.erase(iter);
+    }
+  }
+  counts_.keys--;
+}
+
+void KeyStatistics::GetKeyInfo(KeyInfo* key_info) {
+  int64_t now;
+  rocksdb::Env::Default()->GetCurrentTime(&now);
+
+  std::lock_guard l(mu_);
+  Collect();
+  counts_.ExpireBefore(NowBucket(now));
+  int64_t expires = 0;
+  int64_t timestamp_sum = 0;
+  for (const auto& [bucket, counts] : counts_.buckets) {
+    expires += counts.first;
+    timestamp_sum += counts.second;
+  }
+  key_info->keys = std::max<int64_t>(counts_.keys - counts_.expired, 0);
+  key_info->expires = std::max<int64_t>(expires, 0);
+  key_info->avg_ttl = expires > 0 ? std::max<int64_t>(timestamp_sum / expires - now, 0) : 0;
+  key_info->invaild_keys = std::max<int64_t>(counts_.expired, 0);
+}
+
+void KeyStatistics::Estimate(uint64_t keys) {
+  std::lock_guard l(mu_);
+  Collect();
+  counts_ = Counts();
+  counts_.keys = static_cast<int64_t>(keys);
+  exact_ = false;
+}
+
+uint64_t KeyStatistics::StartRecount() {
+  std::lock_guard l(mu_);
+  // The writes made so far go to counts_ only
+  Collect();
+  recount_ = ++last_recount_;
+  recount_counts_ = Counts();
+  return recount_;
+}
+
+void KeyStatistics::FinishRecount(uint64_t recount, KeyStatistics* scanned) {
+  Counts scanned_counts;
+  {
+    std::lock_guard l(scanned->mu_);
+    scanned->Collect();
+    scanned_counts = scanned->counts_;
+  }
+  std::lock_guard l(mu_);
+  Collect();
+  if (recount != recount_) {
+    return;
+  }
+  counts_ = std::move(scanned_counts);
+  counts_.Merge(recount_counts_);
+  recount_ = 0;
+  recount_counts_ = Counts();
+  exact_ = true;
+}
+
+static void AppendFixed64(std::string* dst, uint64_t value) {
+  char buf[sizeof(uint64_t)];
+  EncodeFixed64(buf, value);
+  dst->append(buf, sizeof(buf));
+}
+
+rocksdb::Status KeyStatistics::Save(const std::string& path, bool clean, uint64_t sequence) {
+  // version | clean | sequence | keys | expired | first bucket | bucket number | (bucket | count | timestamp sum)...
+  std::string data;
+  {
+    std::lock_guard l(mu_);
+    Collect();
+    data.reserve(sizeof(uint64_t) * (7 + 3 * counts_.buckets.size()));
+    AppendFixed64(&data, kKeyStatisticsFormatVersion);
+    AppendFixed64(&data, clean && exact_ ? 1 : 0);
+    AppendFixed64(&data, sequence);
+    AppendFixed64(&data, counts_.keys);
+    AppendFixed64(&data, counts_.expired);
+    AppendFixed64(&data, counts_.first_bucket);
+    AppendFixed64(&data, counts_.buckets.size());
+    for (const auto& [bucket, counts] : counts_.buckets) {
+      AppendFixed64(&data, bucket);
+      AppendFixed64(&data, counts.first);
+      AppendFixed64(&data, counts.second);
+    }
+  }
+
+  rocksdb::Env* env = rocksdb::Env::Default();
+  std::string tmp_path = path + ".tmp";
+  rocksdb::Status s = rocksdb::WriteStringToFile(env, data, tmp_path, true);
+  if (s.ok()) {
+    s = env->RenameFile(tmp_path, path);
+  }
+  return s;
+}
+
+rocksdb::Status KeyStatistics::Load(const std::string& path, uint64_t sequence) {
+  std::string data;
+  rocksdb::Status s = rocksdb::ReadFileToString(rocksdb::Env::Default(), path, &data);
+  if (!s.ok()) {
+    return s;
+  }
+  const size_t header_size = sizeof(uint64_t) * 7;
+  if (data.size() < header_size) {
+    return rocksdb::Status::Corruption("key statistics too short");
+  }
+  const char* ptr = data.data();
+  auto next = [&ptr]() {
+    uint64_t value = DecodeFixed64(ptr);
+    ptr += sizeof(uint64_t);
+    return value;
+  };
+  if (next() != kKeyStatisticsFormatVersion) {
+    return rocksdb::Status::NotSupported("unknown key statistics version");
+  }
+  bool clean = next() == 1;
+  uint64_t saved_sequence = next();
+  Counts counts;
+  counts.keys = static_cast<int64_t>(next());
+  counts.expired = static_cast<int64_t>(next());
+  counts.first_bucket = static_cast<int64_t>(next());
+  uint64_t bucket_num = next();
+  if (data.size() != header_size + bucket_num * sizeof(uint64_t) * 3) {
+    return rocksdb::Status::Corruption("key statistics size mismatch");
+  }
+  for (uint64_t i = 0; i < bucket_num; i++) {
+    int64_t bucket = static_cast<int64_t>(next());
+    int64_t count = static_cast<int64_t>(next());
+    int64_t timestamp_sum = static_cast<int64_t>(next());
+    counts.buckets.emplace(bucket, std::make_pair(count, timestamp_sum));
+  }
+
+  std::lock_guard l(mu_);
+  // Replaces whatever was counted before
+  Collect();
+  counts_ = std::move(counts);
+  exact_ = clean && saved_sequence == sequence;
+  return rocksdb::Status::OK();
+}
+
+}  // namespace storage
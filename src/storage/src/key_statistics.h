@@ -0,0 +1,130 @@
+//  Copyright (c) 2017-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef SRC_KEY_STATISTICS_H_
+#define SRC_KEY_STATISTICS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "rocksdb/status.h"
+
+#include "pstd/include/noncopyable.h"
+#include "storage/storage.h"
+
+namespace storage {
+
+// What the keyspace statistics know about a key: whether the database holds
+// it, expired or not, and its expire time, 0 if it never expires
+struct KeyState {
+  bool exists = false;
+  int32_t timestamp = 0;
+};
+
+/*
+ * The keys, expiring keys and their average ttl of one database, kept up to
+ * date by the write paths, so INFO KEYSPACE and DBSIZE do not need to scan
+ * the meta column family.
+ *
+ * Expiring keys are counted in buckets of their expire time. Once a bucket
+ * has passed, its keys are counted as expired and left out of the keys,
+ * whether the compaction dropped them since or they are still waiting to be
+ * overwritten.
+ *
+ * Update takes no lock. A write adds to the key count of the shard of its
+ * thread, and pushes the expire times it adds or removes on a lock free
+ * stack of that shard. The shards are folded into the buckets under the
+ * lock by the readers, the recounts and Save, or by a writer that finds the
+ * lock free once a shard has piled up kMaxPendingChanges changes.
+ */
+class KeyStatistics : public pstd::noncopyable {
+ public:
+  // The width of an expire time bucket, expired keys leave the key count at
+  // most this late
+  static const int32_t kBucketSeconds = 60;
+
+  KeyStatistics() = default;
+  ~KeyStatistics();
+
+  // Applies a successful write that took a key from before to after
+  void Update(const KeyState& before, const KeyState& after);
+  // Applies an expired key the compaction dropped. A write or ActiveExpire
+  // may have counted it out already through a newer copy, so the counts are
+  // never lowered below zero
+  void Drop(const KeyState& state);
+
+  // invaild_keys are the keys that expired but are still counted as written
+  void GetKeyInfo(KeyInfo* key_info);
+
+  // False while the statistics are estimated, after an unclean shutdown or
+  // when there were none to load, until a recount replaces them
+  bool exact() const { return exact_; }
+  // Starts from the number of keys the database estimates it holds
+  void Estimate(uint64_t keys);
+
+  // A recount scans the database into a statistics of its own, the writes
+  // made since StartRecount are applied on top of it by FinishRecount,
+  // unless a newer recount started in the meantime
+  uint64_t StartRecount();
+  void FinishRecount(uint64_t recount, KeyStatistics* scanned);
+
+  // sequence is the latest sequence number of the database, clean means no
+  // write can come in anymore, so the statistics loaded back are exact if
+  // the database reopens at the same sequence number
+  rocksdb::Status Save(const std::string& path, bool clean, uint64_t sequence);
+  rocksdb::Status Load(const std::string& path, uint64_t sequence);
+
+ private:
+  static const size_t kShards = 16;
+  static const int64_t kMaxPendingChanges = 4096;
+
+  struct Counts {
+    int64_t keys = 0;
+    // The keys of the buckets before first_bucket
+    int64_t expired = 0;
+    int64_t first_bucket = 0;
+    // bucket -> number of keys and sum of their expire times
+    std::map<int64_t, std::pair<int64_t, int64_t>> buckets;
+
+    void Apply(const KeyState& state, int64_t delta);
+    void ApplyTimestamp(int32_t timestamp, int64_t delta);
+    void ExpireBefore(int64_t bucket);
+    void Merge(const Counts& other);
+  };
+
+  // An expire time a write added or removed, not folded into the buckets yet
+  struct TimestampChange {
+    int32_t timestamp;
+    int32_t delta;
+    TimestampChange* next;
+  };
+
+  struct alignas(64) Shard {
+    std::atomic<int64_t> keys = 0;
+    std::atomic<TimestampChange*> changes = nullptr;
+    std::atomic<int64_t> pending = 0;
+  };
+
+  void PushTimestampChange(Shard* shard, int32_t timestamp, int32_t delta);
+  // Folds the shards into counts_, and into recount_counts_ during a
+  // recount. Called with mu_ held
+  void Collect();
+
+  Shard shards_[kShards];
+  std::mutex mu_;
+  Counts counts_;
+  // The writes made during the current recount, 0 if there is none
+  uint64_t recount_ = 0;
+  uint64_t last_recount_ = 0;
+  Counts recount_counts_;
+  std::atomic<bool> exact_ = true;
+};
+
+}  // namespace storage
+#endif  // SRC_KEY_STATISTICS_H_
@@ -0,0 +1,121 @@
+//  Copyright (c) 2017-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef SRC_LISTS_CHUNK_FORMAT_H_
+#define SRC_LISTS_CHUNK_FORMAT_H_
+
+#include <string>
+#include <vector>
+
+#include "pstd/include/pstd_coding.h"
+#include "rocksdb/slice.h"
+
+#include "src/coding.h"
+
+namespace storage {
+
+/*
+ * A chunked list packs consecutive elements into chunks stored under
+ * ListsDataKey(key, version, chunk id), the user value of its meta value
+ * carries the chunk table in list order:
+ *
+ * | <Count> | <Encoding> | <Next Chunk Id> | <Chunk Num> | <Chunk Id> | <Chunk Size> | ...
+ *   8 Bytes    1 Byte       Varint64         Varint32      Varint64      Varint32
+ *
+ * The user value of a plain list is only the 8 bytes count, so both layouts
+ * are told apart by the encoding byte. Chunk ids are never reused within a
+ * version, the chunk value is a sequence of varint32 length prefixed elements.
+ */
+const char kListsChunkedEncoding = 1;
+
+// A chunk holding more bytes than this is split even if not full
+const size_t kListsChunkMaxBytes = 8192;
+
+/*
+ * The chunk table lives in the meta value, so every write of a list rewrites
+ * all of it, a few bytes for every chunk. Past this many chunks the limits of
+ * a chunk grow by one more multiple of the chunk size and of
+ * kListsChunkMaxBytes for every further kListsChunkTableSoftLimit chunks.
+ * The table and the chunks then both grow with the square root of the length
+ * of the list instead of the table growing linearly with it.
+ */
+const size_t kListsChunkTableSoftLimit = 4096;
+
+struct ListsChunk {
+  uint64_t id = 0;
+  uint32_t size = 0;
+};
+
+inline bool IsChunkedListsUserValue(const rocksdb::Slice& user_value) {
+  return user_value.size() > sizeof(uint64_t) && user_value[sizeof(uint64_t)] == kListsChunkedEncoding;
+}
+
+inline void EncodeListsChunkTable(uint64_t count, uint64_t next_id, const std::vector<ListsChunk>& chunks,
+                                  std::string* user_value) {
+  char buf[8];
+  EncodeFixed64(buf, count);
+  user_value->assign(buf, sizeof(buf));
+  user_value->push_back(kListsChunkedEncoding);
+  pstd::PutVarint64(user_value, next_id);
+  pstd::PutVarint32(user_value, static_cast<uint32_t>(chunks.size()));
+  for (const auto& chunk : chunks) {
+    pstd::PutVarint64(user_value, chunk.id);
+    pstd::PutVarint32(user_value, chunk.size);
+  }
+}
+
+inline bool DecodeListsChunkTable(const rocksdb::Slice& user_value, uint64_t* next_id,
+                                  std::vector<ListsChunk>* chunks) {
+  chunks->clear();
+  if (!IsChunkedListsUserValue(user_value)) {
+    return false;
+  }
+  const char* ptr = user_value.data() + sizeof(uint64_t) + 1;
+  const char* limit = user_value.data() + user_value.size();
+  uint32_t num = 0;
+  if ((ptr = pstd::GetVarint64Ptr(ptr, limit, next_id)) == nullptr ||
+      (ptr = pstd::GetVarint32Ptr(ptr, limit, &num)) == nullptr) {
+    return false;
+  }
+  chunks->resize(num);
+  for (auto& chunk : *chunks) {
+    if ((ptr = pstd::GetVarint64Ptr(ptr, limit, &chunk.id)) == nullptr ||
+        (ptr = pstd::GetVarint32Ptr(ptr, limit, &chunk.size)) == nullptr) {
+      return false;
+    }
+  }
+  return true;
+}
+
+inline void EncodeListsChunk(const std::vector<std::string>& elements, std::string* value) {
+  value->clear();
+  for (const auto& element : elements) {
+    pstd::PutVarint32(value, static_cast<uint32_t>(element.size()));
+    value->append(element);
+  }
+}
+
+inline bool DecodeListsChunk(const rocksdb::Slice& value, std::vector<std::string>* elements) {
+  elements->clear();
+  const char* ptr = value.data();
+  const char* limit = value.data() + value.size();
+  while (ptr < limit) {
+    uint32_t len = 0;
+    if ((ptr = pstd::GetVarint32Ptr(ptr, limit, &len)) == nullptr || len > static_cast<size_t>(limit - ptr)) {
+      return false;
+    }
+    elements->emplace_back(ptr, len);
+    ptr += len;
+  }
+  return true;
+}
+
+// Replaces the user value of a lists meta value, keeping its version, timestamp and indexes
+inline void ReplaceListsUserValue(std::string* meta_value, size_t suffix_length, const std::string& user_value) {
+  meta_value->replace(0, meta_value->size() - suffix_length, user_value);
+}
+
+}  // namespace storage
+#endif  // SRC_LISTS_CHUNK_FORMAT_H_
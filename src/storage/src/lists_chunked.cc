@@ -0,0 +1,481 @@
+//  Copyright (c) 2017-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "src/lists_chunked.h"
+
+#include <algorithm>
+
+#include "src/lists_data_key_format.h"
+
+namespace storage {
+
+// Used for chunked lists met while new lists are created in the plain layout
+const uint32_t kListsDefaultChunkSize = 128;
+
+// Chunks read by one MultiGet while scanning the whole list
+const size_t kListsChunkScanBatch = 16;
+
+ChunkedList::ChunkedList(rocksdb::DB* db, rocksdb::ColumnFamilyHandle* handle,
+                         const rocksdb::ReadOptions& read_options, const rocksdb::Slice& key, int32_t version,
+                         uint32_t chunk_size)
+    : db_(db),
+      handle_(handle),
+      read_options_(read_options),
+      key_(key),
+      version_(version),
+      chunk_size_(chunk_size != 0 ? chunk_size : kListsDefaultChunkSize) {}
+
+Status ChunkedList::Init(const rocksdb::Slice& user_value) {
+  chunks_.clear();
+  removed_.clear();
+  next_id_ = 0;
+  size_ = 0;
+  if (!IsChunkedListsUserValue(user_value)) {
+    return Status::OK();
+  }
+  std::vector<ListsChunk> table;
+  if (!DecodeListsChunkTable(user_value, &next_id_, &table)) {
+    return Status::Corruption("invalid list chunk table");
+  }
+  chunks_.resize(table.size());
+  for (size_t idx = 0; idx < table.size(); ++idx) {
+    chunks_[idx].id = table[idx].id;
+    chunks_[idx].size = table[idx].size;
+    size_ += table[idx].size;
+  }
+  return Status::OK();
+}
+
+Status ChunkedList::Load(size_t first, size_t last) {
+  std::vector<size_t> positions;
+  std::vector<std::string> encoded_keys;
+  for (size_t pos = first; pos <= last && pos < chunks_.size(); ++pos) {
+    if (!chunks_[pos].loaded) {
+      ListsDataKey lists_data_key(key_, version_, chunks_[pos].id);
+      positions.push_back(pos);
+      encoded_keys.push_back(lists_data_key.Encode().ToString());
+    }
+  }
+  if (positions.empty()) {
+    return Status::OK();
+  }
+  std::vector<rocksdb::Slice> keys(encoded_keys.begin(), encoded_keys.end());
+  std::vector<rocksdb::PinnableSlice> values(keys.size());
+  std::vector<Status> statuses(keys.size());
+  db_->MultiGet(read_options_, handle_, keys.size(), keys.data(), values.data(), statuses.data());
+  for (size_t idx = 0; idx < positions.size(); ++idx) {
+    if (!statuses[idx].ok()) {
+      return statuses[idx].IsNotFound() ? Status::Corruption("list chunk missing") : statuses[idx];
+    }
+    Chunk& chunk = chunks_[positions[idx]];
+    if (!DecodeListsChunk(values[idx], &chunk.elements) || chunk.elements.size() != chunk.size) {
+      return Status::Corruption("invalid list chunk");
+    }
+    chunk.bytes = 0;
+    for (const auto& element : chunk.elements) {
+      chunk.bytes += element.size();
+    }
+    chunk.loaded = true;
+  }
+  return Status::OK();
+}
+
+void ChunkedList::Locate(uint64_t index, size_t* pos, uint32_t* offset) const {
+  if (index < size_ / 2) {
+    size_t cur = 0;
+    while (index >= chunks_[cur].size) {
+      index -= chunks_[cur].size;
+      cur++;
+    }
+    *pos = cur;
+    *offset = static_cast<uint32_t>(index);
+  } else {
+    uint64_t from_tail = size_ - 1 - index;
+    size_t cur = chunks_.size() - 1;
+    while (from_tail >= chunks_[cur].size) {
+      from_tail -= chunks_[cur].size;
+      cur--;
+    }
+    *pos = cur;
+    *offset = static_cast<uint32_t>(chunks_[cur].size - 1 - from_tail);
+  }
+}
+
+void ChunkedList::NewChunk(size_t pos) {
+  Chunk chunk;
+  chunk.id = next_id_++;
+  chunk.loaded = true;
+  chunk.dirty = true;
+  chunks_.insert(chunks_.begin() + static_cast<int64_t>(pos), std::move(chunk));
+}
+
+void ChunkedList::EraseChunk(size_t pos) {
+  removed_.push_back(chunks_[pos].id);
+  if (!chunks_[pos].dirty) {
+    modified_++;
+  }
+  chunks_.erase(chunks_.begin() + static_cast<int64_t>(pos));
+}
+
+void ChunkedList::Touch(Chunk* chunk) {
+  if (!chunk->dirty) {
+    chunk->dirty = true;
+    modified_++;
+  }
+}
+
+bool ChunkedList::Full(const Chunk& chunk) const {
+  uint64_t scale = LimitScale();
+  return chunk.size >= chunk_size_ * scale || chunk.bytes >= kListsChunkMaxBytes * scale;
+}
+
+void ChunkedList::SplitIfNeeded(size_t pos) {
+  uint64_t scale = LimitScale();
+  if (chunks_[pos].size <= chunk_size_ * scale &&
+      (chunks_[pos].bytes <= kListsChunkMaxBytes * scale || chunks_[pos].size < 2)) {
+    return;
+  }
+  NewChunk(pos + 1);
+  Chunk& head = chunks_[pos];
+  Chunk& tail = chunks_[pos + 1];
+  auto middle = head.elements.begin() + head.elements.size() / 2;
+  tail.elements.assign(std::make_move_iterator(middle), std::make_move_iterator(head.elements.end()));
+  head.elements.erase(middle, head.elements.end());
+  head.size = static_cast<uint32_t>(head.elements.size());
+  tail.size = static_cast<uint32_t>(tail.elements.size());
+  head.bytes = 0;
+  for (const auto& element : head.elements) {
+    head.bytes += element.size();
+  }
+  tail.bytes = 0;
+  for (const auto& element : tail.elements) {
+    tail.bytes += element.size();
+  }
+  Touch(&head);
+  SplitIfNeeded(pos + 1);
+  SplitIfNeeded(pos);
+}
+
+Status ChunkedList::Index(uint64_t index, std::string* element) {
+  size_t pos;
+  uint32_t offset;
+  Locate(index, &pos, &offset);
+  Status s = Load(pos, pos);
+  if (s.ok()) {
+    *element = chunks_[pos].elements[offset];
+  }
+  return s;
+}
+
+Status ChunkedList::Range(uint64_t start, uint64_t stop, std::vector<std::string>* elements) {
+  size_t first_pos;
+  size_t last_pos;
+  uint32_t first_offset;
+  uint32_t last_offset;
+  Locate(start, &first_pos, &first_offset);
+  Locate(stop, &last_pos, &last_offset);
+  Status s = Load(first_pos, last_pos);
+  if (!s.ok()) {
+    return s;
+  }
+  elements->reserve(elements->size() + stop - start + 1);
+  for (size_t pos = first_pos; pos <= last_pos; ++pos) {
+    const auto& chunk_elements = chunks_[pos].elements;
+    uint32_t begin = pos == first_pos ? first_offset : 0;
+    uint32_t end = pos == last_pos ? last_offset + 1 : chunks_[pos].size;
+    elements->insert(elements->end(), chunk_elements.begin() + begin, chunk_elements.begin() + end);
+  }
+  return Status::OK();
+}
+
+Status ChunkedList::Set(uint64_t index, const rocksdb::Slice& value) {
+  size_t pos;
+  uint32_t offset;
+  Locate(index, &pos, &offset);
+  Status s = Load(pos, pos);
+  if (!s.ok()) {
+    return s;
+  }
+  Chunk& chunk = chunks_[pos];
+  chunk.bytes = chunk.bytes - chunk.elements[offset].size() + value.size();
+  chunk.elements[offset] = value.ToString();
+  Touch(&chunk);
+  SplitIfNeeded(pos);
+  return Status::OK();
+}
+
+Status ChunkedList::Insert(uint64_t index, const rocksdb::Slice& value) {
+  size_t pos;
+  uint32_t offset;
+  if (chunks_.empty()) {
+    NewChunk(0);
+    pos = 0;
+    offset = 0;
+  } else if (index >= size_) {
+    pos = chunks_.size() - 1;
+    offset = chunks_[pos].size;
+  } else {
+    Locate(index, &pos, &offset);
+  }
+  Status s = Load(pos, pos);
+  if (!s.ok()) {
+    return s;
+  }
+  Chunk& chunk = chunks_[pos];
+  chunk.elements.insert(chunk.elements.begin() + offset, value.ToString());
+  chunk.size++;
+  chunk.bytes += value.size();
+  size_++;
+  Touch(&chunk);
+  SplitIfNeeded(pos);
+  return Status::OK();
+}
+
+Status ChunkedList::Find(const rocksdb::Slice& value, uint64_t* index) {
+  uint64_t base = 0;
+  for (size_t pos = 0; pos < chunks_.size(); ++pos) {
+    if (!chunks_[pos].loaded) {
+      Status s = Load(pos, pos + kListsChunkScanBatch - 1);
+      if (!s.ok()) {
+        return s;
+      }
+    }
+    const auto& chunk_elements = chunks_[pos].elements;
+    for (size_t offset = 0; offset < chunk_elements.size(); ++offset) {
+      if (value.compare(chunk_elements[offset]) == 0) {
+        *index = base + offset;
+        return Status::OK();
+      }
+    }
+    base += chunks_[pos].size;
+  }
+  return Status::NotFound();
+}
+
+Status ChunkedList::Remove(int64_t count, const rocksdb::Slice& value, uint64_t* removed) {
+  *removed = 0;
+  uint64_t limit = count == 0 ? size_ : static_cast<uint64_t>(count > 0 ? count : -count);
+  bool reverse = count < 0;
+  size_t num = chunks_.size();
+  for (size_t step = 0; step < num && *removed < limit; ++step) {
+    size_t pos = reverse ? num - 1 - step : step;
+    if (!chunks_[pos].loaded) {
+      Status s = reverse ? Load(pos >= kListsChunkScanBatch ? pos - kListsChunkScanBatch + 1 : 0, pos)
+                         : Load(pos, pos + kListsChunkScanBatch - 1);
+      if (!s.ok()) {
+        return s;
+      }
+    }
+    Chunk& chunk = chunks_[pos];
+    uint64_t chunk_removed = 0;
+    if (!reverse) {
+      auto iter = chunk.elements.begin();
+      while (iter != chunk.elements.end() && *removed < limit) {
+        if (value.compare(*iter) == 0) {
+          chunk.bytes -= iter->size();
+          iter = chunk.elements.erase(iter);
+          (*removed)++;
+          chunk_removed++;
+        } else {
+          ++iter;
+        }
+      }
+    } else {
+      for (size_t offset = chunk.elements.size(); offset > 0 && *removed < limit; --offset) {
+        if (value.compare(chunk.elements[offset - 1]) == 0) {
+          chunk.bytes -= chunk.elements[offset - 1].size();
+          chunk.elements.erase(chunk.elements.begin() + static_cast<int64_t>(offset - 1));
+          (*removed)++;
+          chunk_removed++;
+        }
+      }
+    }
+    if (chunk_removed != 0) {
+      chunk.size -= static_cast<uint32_t>(chunk_removed);
+      size_ -= chunk_removed;
+      Touch(&chunk);
+    }
+  }
+  for (size_t pos = chunks_.size(); pos > 0; --pos) {
+    if (chunks_[pos - 1].size == 0) {
+      EraseChunk(pos - 1);
+    }
+  }
+  return Status::OK();
+}
+
+Status ChunkedList::Trim(uint64_t start, uint64_t stop) {
+  size_t first_pos;
+  size_t last_pos;
+  uint32_t first_offset;
+  uint32_t last_offset;
+  Locate(start, &first_pos, &first_offset);
+  Locate(stop, &last_pos, &last_offset);
+  // Only the two boundary chunks are read, the chunks outside are dropped as a whole
+  if (last_offset + 1 < chunks_[last_pos].size) {
+    Status s = Load(last_pos, last_pos);
+    if (!s.ok()) {
+      return s;
+    }
+    Chunk& chunk = chunks_[last_pos];
+    for (size_t offset = last_offset + 1; offset < chunk.elements.size(); ++offset) {
+      chunk.bytes -= chunk.elements[offset].size();
+    }
+    chunk.elements.resize(last_offset + 1);
+    chunk.size = last_offset + 1;
+    Touch(&chunk);
+  }
+  if (first_offset != 0) {
+    Status s = Load(first_pos, first_pos);
+    if (!s.ok()) {
+      return s;
+    }
+    Chunk& chunk = chunks_[first_pos];
+    for (size_t offset = 0; offset < first_offset; ++offset) {
+      chunk.bytes -= chunk.elements[offset].size();
+    }
+    chunk.elements.erase(chunk.elements.begin(), chunk.elements.begin() + first_offset);
+    chunk.size -= first_offset;
+    Touch(&chunk);
+  }
+  for (size_t pos = chunks_.size() - 1; pos > last_pos; --pos) {
+    EraseChunk(pos);
+  }
+  for (size_t pos = first_pos; pos > 0; --pos) {
+    EraseChunk(pos - 1);
+  }
+  size_ = stop - start + 1;
+  return Status::OK();
+}
+
+Status ChunkedList::PopFront(uint64_t count, std::vector<std::string>* elements) {
+  count = std::min(count, size_);
+  if (count == 0) {
+    return Status::OK();
+  }
+  size_t last_pos = 0;
+  for (uint64_t covered = 0; covered + chunks_[last_pos].size < count; ++last_pos) {
+    covered += chunks_[last_pos].size;
+  }
+  Status s = Load(0, last_pos);
+  if (!s.ok()) {
+    return s;
+  }
+  while (count > 0) {
+    Chunk& chunk = chunks_.front();
+    uint32_t take = static_cast<uint32_t>(std::min<uint64_t>(count, chunk.size));
+    for (uint32_t idx = 0; idx < take; ++idx) {
+      chunk.bytes -= chunk.elements[idx].size();
+      elements->push_back(std::move(chunk.elements[idx]));
+    }
+    count -= take;
+    size_ -= take;
+    if (take == chunk.size) {
+      EraseChunk(0);
+    } else {
+      chunk.elements.erase(chunk.elements.begin(), chunk.elements.begin() + take);
+      chunk.size -= take;
+      Touch(&chunk);
+    }
+  }
+  return Status::OK();
+}
+
+Status ChunkedList::PopBack(uint64_t count, std::vector<std::string>* elements) {
+  count = std::min(count, size_);
+  if (count == 0) {
+    return Status::OK();
+  }
+  size_t first_pos = chunks_.size() - 1;
+  for (uint64_t covered = 0; covered + chunks_[first_pos].size < count; --first_pos) {
+    covered += chunks_[first_pos].size;
+  }
+  Status s = Load(first_pos, chunks_.size() - 1);
+  if (!s.ok()) {
+    return s;
+  }
+  while (count > 0) {
+    Chunk& chunk = chunks_.back();
+    uint32_t take = static_cast<uint32_t>(std::min<uint64_t>(count, chunk.size));
+    for (uint32_t idx = 0; idx < take; ++idx) {
+      auto& element = chunk.elements[chunk.size - 1 - idx];
+      chunk.bytes -= element.size();
+      elements->push_back(std::move(element));
+    }
+    count -= take;
+    size_ -= take;
+    if (take == chunk.size) {
+      EraseChunk(chunks_.size() - 1);
+    } else {
+      chunk.elements.resize(chunk.size - take);
+      chunk.size -= take;
+      Touch(&chunk);
+    }
+  }
+  return Status::OK();
+}
+
+Status ChunkedList::PushFront(const rocksdb::Slice& value) {
+  if (!chunks_.empty()) {
+    Status s = Load(0, 0);
+    if (!s.ok()) {
+      return s;
+    }
+  }
+  if (chunks_.empty() || Full(chunks_.front())) {
+    NewChunk(0);
+  }
+  Chunk& chunk = chunks_.front();
+  chunk.elements.insert(chunk.elements.begin(), value.ToString());
+  chunk.size++;
+  chunk.bytes += value.size();
+  size_++;
+  Touch(&chunk);
+  return Status::OK();
+}
+
+Status ChunkedList::PushBack(const rocksdb::Slice& value) {
+  if (!chunks_.empty()) {
+    Status s = Load(chunks_.size() - 1, chunks_.size() - 1);
+    if (!s.ok()) {
+      return s;
+    }
+  }
+  if (chunks_.empty() || Full(chunks_.back())) {
+    NewChunk(chunks_.size());
+  }
+  Chunk& chunk = chunks_.back();
+  chunk.elements.push_back(value.ToString());
+  chunk.size++;
+  chunk.bytes += value.size();
+  size_++;
+  Touch(&chunk);
+  return Status::OK();
+}
+
+void ChunkedList::Flush(rocksdb::WriteBatch* batch, std::string* user_value) {
+  for (const auto& id : removed_) {
+    ListsDataKey lists_data_key(key_, version_, id);
+    batch->Delete(handle_, lists_data_key.Encode());
+  }
+  removed_.clear();
+
+  std::string chunk_value;
+  std::vector<ListsChunk> table(chunks_.size());
+  for (size_t pos = 0; pos < chunks_.size(); ++pos) {
+    Chunk& chunk = chunks_[pos];
+    if (chunk.dirty) {
+      ListsDataKey lists_data_key(key_, version_, chunk.id);
+      EncodeListsChunk(chunk.elements, &chunk_value);
+      batch->Put(handle_, lists_data_key.Encode(), chunk_value);
+      chunk.dirty = false;
+    }
+    table[pos].id = chunk.id;
+    table[pos].size = chunk.size;
+  }
+  EncodeListsChunkTable(size_, next_id_, table, user_value);
+}
+
+}  // namespace storage
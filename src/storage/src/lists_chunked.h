@@ -0,0 +1,100 @@
+//  Copyright (c) 2017-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef SRC_LISTS_CHUNKED_H_
+#define SRC_LISTS_CHUNKED_H_
+
+#include <string>
+#include <vector>
+
+#include "rocksdb/db.h"
+#include "rocksdb/status.h"
+#include "rocksdb/write_batch.h"
+
+#include "src/lists_chunk_format.h"
+
+namespace storage {
+
+using Status = rocksdb::Status;
+
+/*
+ * Operates on one version of a chunked list. Chunks are read lazily and
+ * modified in memory, Flush() writes back only the chunks that changed, so
+ * positional edits cost one chunk instead of the elements behind them.
+ * Indexes are zero based positions from the head, the caller is expected
+ * to validate them against size().
+ */
+class ChunkedList {
+ public:
+  ChunkedList(rocksdb::DB* db, rocksdb::ColumnFamilyHandle* handle, const rocksdb::ReadOptions& read_options,
+              const rocksdb::Slice& key, int32_t version, uint32_t chunk_size);
+
+  // Parses the chunk table, a user value without one starts an empty list
+  Status Init(const rocksdb::Slice& user_value);
+
+  uint64_t size() const { return size_; }
+  // Number of chunks rewritten or dropped so far
+  uint64_t modified() const { return modified_; }
+
+  Status Index(uint64_t index, std::string* element);
+  // Elements in [start, stop]
+  Status Range(uint64_t start, uint64_t stop, std::vector<std::string>* elements);
+  Status Set(uint64_t index, const rocksdb::Slice& value);
+  // Inserts before the element at index, index == size() appends
+  Status Insert(uint64_t index, const rocksdb::Slice& value);
+  // Position of the first element equal to value, NotFound if there is none
+  Status Find(const rocksdb::Slice& value, uint64_t* index);
+  // Same semantics as LREM count value
+  Status Remove(int64_t count, const rocksdb::Slice& value, uint64_t* removed);
+  // Keeps the elements in [start, stop]
+  Status Trim(uint64_t start, uint64_t stop);
+  Status PopFront(uint64_t count, std::vector<std::string>* elements);
+  Status PopBack(uint64_t count, std::vector<std::string>* elements);
+  Status PushFront(const rocksdb::Slice& value);
+  Status PushBack(const rocksdb::Slice& value);
+
+  // Writes the changed chunks and returns the new user value of the meta value
+  void Flush(rocksdb::WriteBatch* batch, std::string* user_value);
+
+ private:
+  struct Chunk {
+    uint64_t id = 0;
+    uint32_t size = 0;
+    bool loaded = false;
+    bool dirty = false;
+    size_t bytes = 0;
+    std::vector<std::string> elements;
+  };
+
+  // Reads the chunks in [first, last] that are not loaded yet with one MultiGet
+  Status Load(size_t first, size_t last);
+  // Finds the chunk holding the element at index and its offset in the chunk
+  void Locate(uint64_t index, size_t* pos, uint32_t* offset) const;
+  // Adds an empty chunk at pos
+  void NewChunk(size_t pos);
+  void EraseChunk(size_t pos);
+  // Splits an overfull chunk in halves
+  void SplitIfNeeded(size_t pos);
+  bool Full(const Chunk& chunk) const;
+  // How many times the chunk size and kListsChunkMaxBytes a chunk may hold
+  uint64_t LimitScale() const { return 1 + chunks_.size() / kListsChunkTableSoftLimit; }
+  void Touch(Chunk* chunk);
+
+  rocksdb::DB* db_;
+  rocksdb::ColumnFamilyHandle* handle_;
+  const rocksdb::ReadOptions& read_options_;
+  rocksdb::Slice key_;
+  int32_t version_ = 0;
+  uint32_t chunk_size_ = 0;
+
+  uint64_t next_id_ = 0;
+  uint64_t size_ = 0;
+  uint64_t modified_ = 0;
+  std::vector<Chunk> chunks_;
+  std::vector<uint64_t> removed_;
+};
+
+}  // namespace storage
+#endif  // SRC_LISTS_CHUNKED_H_
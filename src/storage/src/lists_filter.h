@@ -12,6 +12,7 @@
 
 #include "rocksdb/compaction_filter.h"
 #include "rocksdb/db.h"
+#include "src/base_filter.h"
 #include "src/debug.h"
 #include "src/lists_data_key_format.h"
 #include "src/lists_meta_value_format.h"
@@ -20,7 +21,7 @@ namespace storage {
 
 class ListsMetaFilter : public rocksdb::CompactionFilter {
  public:
-  ListsMetaFilter() = default;
+  explicit ListsMetaFilter(KeyStatistics* key_statistics = nullptr) : key_statistics_(key_statistics) {}
   bool Filter(int level, const rocksdb::Slice& key, const rocksdb::Slice& value, std::string* new_value,
               bool* value_changed) const override {
     int64_t unix_time;
@@ -35,6 +36,9 @@ class ListsMetaFilter : public rocksdb::CompactionFilter {
     if (parsed_lists_meta_value.timestamp() != 0 && parsed_lists_meta_value.timestamp() < cur_time &&
         parsed_lists_meta_value.version() < cur_time) {
       TRACE("Drop[Stale & version < cur_time]");
+      if (key_statistics_ != nullptr) {
+        key_statistics_->Drop({parsed_lists_meta_value.count() != 0, parsed_lists_meta_value.timestamp()});
+      }
       return true;
     }
     if (parsed_lists_meta_value.count() == 0 && parsed_lists_meta_value.version() < cur_time) {
@@ -46,24 +50,30 @@ class ListsMetaFilter : public rocksdb::CompactionFilter {
   }
 
   const char* Name() const override { return "ListsMetaFilter"; }
+
+ private:
+  KeyStatistics* key_statistics_ = nullptr;
 };
 
 class ListsMetaFilterFactory : public rocksdb::CompactionFilterFactory {
  public:
-  ListsMetaFilterFactory() = default;
+  // The expired keys dropped are taken out of key_statistics
+  explicit ListsMetaFilterFactory(KeyStatistics* key_statistics = nullptr) : key_statistics_(key_statistics) {}
   std::unique_ptr<rocksdb::CompactionFilter> CreateCompactionFilter(
       const rocksdb::CompactionFilter::Context& context) override {
-    return std::unique_ptr<rocksdb::CompactionFilter>(new ListsMetaFilter());
+    return std::unique_ptr<rocksdb::CompactionFilter>(new ListsMetaFilter(key_statistics_));
   }
   const char* Name() const override { return "ListsMetaFilterFactory"; }
+
+ private:
+  KeyStatistics* key_statistics_ = nullptr;
 };
 
 class ListsDataFilter : public rocksdb::CompactionFilter {
  public:
-  ListsDataFilter(rocksdb::DB* db, std::vector<rocksdb::ColumnFamilyHandle*>* cf_handles_ptr)
-      : db_(db),
-        cf_handles_ptr_(cf_handles_ptr)
-        {}
+  ListsDataFilter(rocksdb::DB* db, std::vector<rocksdb::ColumnFamilyHandle*>* cf_handles_ptr,
+                  DataFilterStatistics* statistics = nullptr)
+      : db_(db), cf_handles_ptr_(cf_handles_ptr), statistics_(statistics) {}
 
   bool Filter(int level, const rocksdb::Slice& key, const rocksdb::Slice& value, std::string* new_value,
               bool* value_changed) const override {
@@ -72,19 +82,19 @@ class ListsDataFilter : public rocksdb::CompactionFilter {
     TRACE("[DataFilter], key: %s, index = %llu, data = %s, version = %d", parsed_lists_data_key.key().ToString().c_str(),
           parsed_lists_data_key.index(), value.ToString().c_str(), parsed_lists_data_key.version());
 
-    if (parsed_lists_data_key.key().ToString() != cur_key_) {
+    if (parsed_lists_data_key.key() != Slice(cur_key_)) {
       cur_key_ = parsed_lists_data_key.key().ToString();
-      std::string meta_value;
       // destroyed when close the database, Reserve Current key value
       if (cf_handles_ptr_->empty()) {
         return false;
       }
-      rocksdb::Status s = db_->Get(default_read_options_, (*cf_handles_ptr_)[0], cur_key_, &meta_value);
+      if (!meta_reader_) {
+        meta_reader_ =
+            std::make_unique<DataFilterMetaReader<ParsedListsMetaValue>>(db_, (*cf_handles_ptr_)[0], statistics_);
+      }
+      rocksdb::Status s = meta_reader_->Lookup(cur_key_, &cur_meta_version_, &cur_meta_timestamp_);
       if (s.ok()) {
         meta_not_found_ = false;
-        ParsedListsMetaValue parsed_lists_meta_value(&meta_value);
-        cur_meta_version_ = parsed_lists_meta_value.version();
-        cur_meta_timestamp_ = parsed_lists_meta_value.timestamp();
       } else if (s.IsNotFound()) {
         meta_not_found_ = true;
       } else {
@@ -120,7 +130,8 @@ class ListsDataFilter : public rocksdb::CompactionFilter {
  private:
   rocksdb::DB* db_ = nullptr;
   std::vector<rocksdb::ColumnFamilyHandle*>* cf_handles_ptr_ = nullptr;
-  rocksdb::ReadOptions default_read_options_;
+  DataFilterStatistics* statistics_ = nullptr;
+  mutable std::unique_ptr<DataFilterMetaReader<ParsedListsMetaValue>> meta_reader_;
   mutable std::string cur_key_;
   mutable bool meta_not_found_ = false;
   mutable int32_t cur_meta_version_ = 0;
@@ -129,18 +140,20 @@ class ListsDataFilter : public rocksdb::CompactionFilter {
 
 class ListsDataFilterFactory : public rocksdb::CompactionFilterFactory {
  public:
-  ListsDataFilterFactory(rocksdb::DB** db_ptr, std::vector<rocksdb::ColumnFamilyHandle*>* handles_ptr)
-      : db_ptr_(db_ptr), cf_handles_ptr_(handles_ptr) {}
+  ListsDataFilterFactory(rocksdb::DB** db_ptr, std::vector<rocksdb::ColumnFamilyHandle*>* handles_ptr,
+                         DataFilterStatistics* statistics = nullptr)
+      : db_ptr_(db_ptr), cf_handles_ptr_(handles_ptr), statistics_(statistics) {}
 
   std::unique_ptr<rocksdb::CompactionFilter> CreateCompactionFilter(
       const rocksdb::CompactionFilter::Context& context) override {
-    return std::unique_ptr<rocksdb::CompactionFilter>(new ListsDataFilter(*db_ptr_, cf_handles_ptr_));
+    return std::unique_ptr<rocksdb::CompactionFilter>(new ListsDataFilter(*db_ptr_, cf_handles_ptr_, statistics_));
   }
   const char* Name() const override { return "ListsDataFilterFactory"; }
 
  private:
   rocksdb::DB** db_ptr_ = nullptr;
   std::vector<rocksdb::ColumnFamilyHandle*>* cf_handles_ptr_ = nullptr;
+  DataFilterStatistics* statistics_ = nullptr;
 };
 
 }  //  namespace storage
@@ -6,9 +6,13 @@
 #ifndef SRC_LRU_CACHE_H_
 #define SRC_LRU_CACHE_H_
 
+#include <atomic>
 #include <cassert>
 #include <cstdio>
+#include <functional>
+#include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include "rocksdb/status.h"
 
@@ -53,31 +57,30 @@ size_t HandleTable<T1, T2>::TableSize() {
 
 template <typename T1, typename T2>
 LRUHandle<T1, T2>* HandleTable<T1, T2>::Lookup(const T1& key) {
-  if (table_.find(key) != table_.end()) {
-    return table_[key];
-  } else {
-    return nullptr;
-  }
+  auto iter = table_.find(key);
+  return iter != table_.end() ? iter->second : nullptr;
 }
 
 template <typename T1, typename T2>
 LRUHandle<T1, T2>* HandleTable<T1, T2>::Remove(const T1& key) {
-  LRUHandle<T1, T2>* old = nullptr;
-  if (table_.find(key) != table_.end()) {
-    old = table_[key];
-    table_.erase(key);
+  auto iter = table_.find(key);
+  if (iter == table_.end()) {
+    return nullptr;
   }
+  LRUHandle<T1, T2>* old = iter->second;
+  table_.erase(iter);
   return old;
 }
 
 template <typename T1, typename T2>
 LRUHandle<T1, T2>* HandleTable<T1, T2>::Insert(const T1& key, LRUHandle<T1, T2>* const handle) {
-  LRUHandle<T1, T2>* old = nullptr;
-  if (table_.find(key) != table_.end()) {
-    old = table_[key];
-    table_.erase(key);
+  // One lookup, the key is copied only if it is new
+  auto [iter, inserted] = table_.try_emplace(key, handle);
+  if (inserted) {
+    return nullptr;
   }
-  table_.insert({key, handle});
+  LRUHandle<T1, T2>* old = iter->second;
+  iter->second = handle;
   return old;
 }
 
@@ -175,17 +178,25 @@ rocksdb::Status LRUCache<T1, T2>::Insert(const T1& key, const T2& value, size_t
   std::lock_guard l(mutex_);
   if (capacity_ == 0) {
     return rocksdb::Status::Corruption("capacity is empty");
+  }
+  LRUHandle<T1, T2>* handle = handle_table_.Lookup(key);
+  if (handle) {
+    // Updated in place, no allocation for the keys written again and again
+    usage_ = usage_ - handle->charge + charge;
+    handle->value = value;
+    handle->charge = charge;
+    LRU_MoveToHead(handle);
   } else {
-    auto handle = new LRUHandle<T1, T2>();
+    handle = new LRUHandle<T1, T2>();
     handle->key = key;
     handle->value = value;
     handle->charge = charge;
     LRU_Append(handle);
     size_++;
     usage_ += charge;
-    FinishErase(handle_table_.Insert(key, handle));
-    LRU_Trim();
+    handle_table_.Insert(key, handle);
   }
+  LRU_Trim();
   return rocksdb::Status::OK();
 }
 
@@ -293,5 +304,110 @@ bool LRUCache<T1, T2>::FinishErase(LRUHandle<T1, T2>* const e) {
   return erased;
 }
 
+/*
+ * An LRUCache split into shards by the hash of the key, each with a mutex of
+ * its own on a cache line of its own, so the threads working on different
+ * keys do not serialize on one lock. Every shard evicts within its share of
+ * the capacity, rounded up so each shard holds at least one entry, the
+ * eviction order is least recently used per shard only.
+ */
+template <typename T1, typename T2>
+class ShardedLRUCache {
+ public:
+  static const size_t kDefaultNumShardBits = 4;
+
+  explicit ShardedLRUCache(size_t num_shard_bits = kDefaultNumShardBits);
+
+  size_t Size();
+  size_t TotalCharge();
+  // Read without locking, the write paths check it before every update
+  size_t Capacity() { return capacity_.load(std::memory_order_relaxed); }
+  void SetCapacity(size_t capacity);
+
+  rocksdb::Status Lookup(const T1& key, T2* value);
+  rocksdb::Status Insert(const T1& key, const T2& value, size_t charge = 1);
+  rocksdb::Status Remove(const T1& key);
+  rocksdb::Status Clear();
+
+  // Just for test
+  size_t NumShards() { return num_shards_; }
+  bool LRUAndHandleTableConsistent();
+
+ private:
+  struct alignas(64) Shard {
+    LRUCache<T1, T2> cache;
+  };
+
+  LRUCache<T1, T2>& GetShard(const T1& key) { return shards_[std::hash<T1>()(key) & (num_shards_ - 1)].cache; }
+
+  std::atomic<size_t> capacity_ = 0;
+  const size_t num_shards_;
+  std::unique_ptr<Shard[]> shards_;
+};
+
+template <typename T1, typename T2>
+ShardedLRUCache<T1, T2>::ShardedLRUCache(size_t num_shard_bits)
+    : num_shards_(static_cast<size_t>(1) << num_shard_bits), shards_(new Shard[num_shards_]) {}
+
+template <typename T1, typename T2>
+size_t ShardedLRUCache<T1, T2>::Size() {
+  size_t size = 0;
+  for (size_t idx = 0; idx < num_shards_; idx++) {
+    size += shards_[idx].cache.Size();
+  }
+  return size;
+}
+
+template <typename T1, typename T2>
+size_t ShardedLRUCache<T1, T2>::TotalCharge() {
+  size_t charge = 0;
+  for (size_t idx = 0; idx < num_shards_; idx++) {
+    charge += shards_[idx].cache.TotalCharge();
+  }
+  return charge;
+}
+
+template <typename T1, typename T2>
+void ShardedLRUCache<T1, T2>::SetCapacity(size_t capacity) {
+  capacity_.store(capacity, std::memory_order_relaxed);
+  size_t shard_capacity = (capacity + num_shards_ - 1) / num_shards_;
+  for (size_t idx = 0; idx < num_shards_; idx++) {
+    shards_[idx].cache.SetCapacity(shard_capacity);
+  }
+}
+
+template <typename T1, typename T2>
+rocksdb::Status ShardedLRUCache<T1, T2>::Lookup(const T1& key, T2* const value) {
+  return GetShard(key).Lookup(key, value);
+}
+
+template <typename T1, typename T2>
+rocksdb::Status ShardedLRUCache<T1, T2>::Insert(const T1& key, const T2& value, size_t charge) {
+  return GetShard(key).Insert(key, value, charge);
+}
+
+template <typename T1, typename T2>
+rocksdb::Status ShardedLRUCache<T1, T2>::Remove(const T1& key) {
+  return GetShard(key).Remove(key);
+}
+
+template <typename T1, typename T2>
+rocksdb::Status ShardedLRUCache<T1, T2>::Clear() {
+  for (size_t idx = 0; idx < num_shards_; idx++) {
+    shards_[idx].cache.Clear();
+  }
+  return rocksdb::Status::OK();
+}
+
+template <typename T1, typename T2>
+bool ShardedLRUCache<T1, T2>::LRUAndHandleTableConsistent() {
+  for (size_t idx = 0; idx < num_shards_; idx++) {
+    if (!shards_[idx].cache.LRUAndHandleTableConsistent()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 }  //  namespace storage
 #endif  // SRC_LRU_CACHE_H_
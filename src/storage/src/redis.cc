@@ -4,17 +4,23 @@
 //  of patent rights can be found in the PATENTS file in the same directory.
 
 #include "src/redis.h"
+#include <algorithm>
 #include <sstream>
 
+#include "rocksdb/utilities/table_properties_collectors.h"
+
+#include "src/expire_index_format.h"
+#include "src/scope_record_lock.h"
+
 namespace storage {
 
 Redis::Redis(Storage* const s, const DataType& type)
     : storage_(s),
       type_(type),
-      lock_mgr_(std::make_shared<LockMgr>(1000, 0, std::make_shared<MutexFactoryImpl>())),
+      lock_mgr_(std::make_shared<LockMgr>(1000, 0)),
       small_compaction_threshold_(5000) {
-  statistics_store_ = std::make_unique<LRUCache<std::string, size_t>>();
-  scan_cursors_store_ = std::make_unique<LRUCache<std::string, std::string>>();
+  statistics_store_ = std::make_unique<ShardedLRUCache<std::string, size_t>>();
+  scan_cursors_store_ = std::make_unique<ShardedLRUCache<std::string, std::string>>();
   scan_cursors_store_->SetCapacity(5000);
   default_compact_range_options_.exclusive_manual_compaction = false;
   default_compact_range_options_.change_level = true;
@@ -22,6 +28,9 @@ Redis::Redis(Storage* const s, const DataType& type)
 }
 
 Redis::~Redis() {
+  if (db_ != nullptr && !key_statistics_path_.empty()) {
+    PersistKeyStatistics(true);
+  }
   std::vector<rocksdb::ColumnFamilyHandle*> tmp_handles = handles_;
   handles_.clear();
   for (auto handle : tmp_handles) {
@@ -30,6 +39,192 @@ Redis::~Redis() {
   delete db_;
 }
 
+void Redis::SetMetaMemtableBloom(rocksdb::ColumnFamilyOptions* meta_cf_ops) {
+  meta_cf_ops->memtable_whole_key_filtering = true;
+  if (meta_cf_ops->memtable_prefix_bloom_size_ratio == 0) {
+    meta_cf_ops->memtable_prefix_bloom_size_ratio = 0.02;
+  }
+}
+
+const std::string Redis::kExpireIndexColumnFamilyName = "expire_cf";
+
+void Redis::SetExpireIndexOptions(rocksdb::ColumnFamilyOptions* expire_cf_ops) {
+  // ActiveExpire deletes the entries from the front, compact the files they
+  // leave full of tombstones instead of seeking over them every cycle
+  expire_cf_ops->table_properties_collector_factories.emplace_back(
+      rocksdb::NewCompactOnDeletionCollectorFactory(1024, 512));
+}
+
+Status Redis::WriteWithExpireIndex(rocksdb::WriteBatch* batch, const Slice& key, const KeyState& before,
+                                   const KeyState& after) {
+  int32_t before_timestamp = before.exists ? before.timestamp : 0;
+  int32_t after_timestamp = after.exists ? after.timestamp : 0;
+  if (before_timestamp != after_timestamp) {
+    if (before_timestamp != 0) {
+      batch->Delete(expire_handle(), ExpireIndexKey(before_timestamp, key).Encode());
+    }
+    if (after_timestamp != 0) {
+      batch->Put(expire_handle(), ExpireIndexKey(after_timestamp, key).Encode(), Slice());
+    }
+  }
+  Status s = db_->Write(default_write_options_, batch);
+  InvalidateCachedValue(key);
+  if (s.ok() && after_timestamp != 0 && after_timestamp != before_timestamp) {
+    int64_t unix_time;
+    rocksdb::Env::Default()->GetCurrentTime(&unix_time);
+    if (after_timestamp <= unix_time) {
+      // Already due, a running ActiveExpire may have passed it by
+      std::lock_guard l(expire_cursor_mu_);
+      expire_cursor_ = std::min(expire_cursor_, after_timestamp);
+      expire_cursor_moved_ = true;
+    }
+  }
+  return s;
+}
+
+Status Redis::PutMetaValue(const Slice& key, const Slice& meta_value, const KeyState& before, const KeyState& after) {
+  rocksdb::WriteBatch batch;
+  batch.Put(handles_[0], key, meta_value);
+  return WriteWithExpireIndex(&batch, key, before, after);
+}
+
+std::string Redis::ValueCacheKey(const Slice& key) const {
+  std::string cache_key;
+  cache_key.reserve(key.size() + 1);
+  cache_key.push_back(DataTypeTag[type_]);
+  cache_key.append(key.data(), key.size());
+  return cache_key;
+}
+
+void Redis::InvalidateCachedValue(const Slice& key) {
+  if (value_cache_ != nullptr) {
+    value_cache_->Invalidate(ValueCacheKey(key));
+  }
+}
+
+void Redis::ClearCachedValues() {
+  if (value_cache_ != nullptr) {
+    value_cache_->Clear();
+  }
+}
+
+bool Redis::DeleteVersionData(rocksdb::ColumnFamilyHandle* handle, const Slice& key, const Slice& seek_key,
+                              size_t* budget, rocksdb::WriteBatch* batch) {
+  // Every data key starts with the key size, the key and the version
+  Slice prefix(seek_key.data(), sizeof(int32_t) * 2 + key.size());
+  rocksdb::ReadOptions read_options;
+  read_options.fill_cache = false;
+  std::unique_ptr<rocksdb::Iterator> iter(db_->NewIterator(read_options, handle));
+  for (iter->Seek(seek_key); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
+    if (*budget == 0) {
+      return false;
+    }
+    batch->Delete(handle, iter->key());
+    --*budget;
+  }
+  return iter->status().ok();
+}
+
+Status Redis::ActiveExpire(size_t budget) {
+  int64_t unix_time;
+  rocksdb::Env::Default()->GetCurrentTime(&unix_time);
+  int32_t cursor;
+  {
+    std::lock_guard l(expire_cursor_mu_);
+    cursor = expire_cursor_;
+    expire_cursor_moved_ = false;
+  }
+
+  // The entries of the keys expired by now
+  std::string upper_bound = ExpireIndexKey(static_cast<int32_t>(unix_time), Slice()).ToString();
+  Slice upper_bound_slice(upper_bound);
+  rocksdb::ReadOptions read_options;
+  read_options.fill_cache = false;
+  read_options.iterate_upper_bound = &upper_bound_slice;
+  std::unique_ptr<rocksdb::Iterator> iter(db_->NewIterator(read_options, expire_handle()));
+
+  Status s;
+  for (iter->Seek(ExpireIndexKey(cursor, Slice()).Encode()); iter->Valid() && budget > 0; iter->Next()) {
+    ParsedExpireIndexKey parsed_index_key(iter->key());
+    cursor = parsed_index_key.timestamp();
+    --budget;
+
+    ScopeRecordLock l(lock_mgr_, parsed_index_key.key());
+    rocksdb::WriteBatch batch;
+    ExpiredKey expired_key;
+    s = ReclaimExpiredKey(parsed_index_key.key(), parsed_index_key.timestamp(), &budget, &batch, &expired_key);
+    if (!s.ok()) {
+      break;
+    }
+    if (expired_key.obsolete || expired_key.deleted) {
+      batch.Delete(expire_handle(), iter->key());
+    }
+    s = db_->Write(default_write_options_, &batch);
+    if (!s.ok()) {
+      break;
+    }
+    if (expired_key.deleted) {
+      InvalidateCachedValue(parsed_index_key.key());
+      key_statistics_.Update(expired_key.before, KeyState());
+      active_expired_keys_++;
+    } else if (expired_key.obsolete) {
+      obsolete_expire_entries_++;
+    } else {
+      // The rest of its data is deleted by the next call
+      break;
+    }
+  }
+  if (s.ok()) {
+    s = iter->status();
+  }
+
+  std::lock_guard l(expire_cursor_mu_);
+  if (!expire_cursor_moved_) {
+    expire_cursor_ = std::max(expire_cursor_, cursor);
+  }
+  return s;
+}
+
+Status Redis::LoadKeyStatistics(const std::string& db_path) {
+  if (!key_statistics_kept_) {
+    // What a previous run saved is exact again only if nothing is written
+    return Status::OK();
+  }
+  key_statistics_path_ = db_path + "/KEY_STATISTICS";
+  rocksdb::SequenceNumber sequence = db_->GetLatestSequenceNumber();
+  Status s = key_statistics_.Load(key_statistics_path_, sequence);
+  if (!s.ok() && sequence != 0) {
+    // Written before the statistics were kept, or they were lost
+    uint64_t keys = 0;
+    db_->GetIntProperty(db_->DefaultColumnFamily(), "rocksdb.estimate-num-keys", &keys);
+    key_statistics_.Estimate(keys);
+  }
+  return s;
+}
+
+Status Redis::PersistKeyStatistics(bool clean) {
+  if (key_statistics_path_.empty()) {
+    return Status::OK();
+  }
+  return key_statistics_.Save(key_statistics_path_, clean, db_->GetLatestSequenceNumber());
+}
+
+void Redis::GetKeyStatistics(KeyInfo* key_info) {
+  if (key_statistics_kept_) {
+    key_statistics_.GetKeyInfo(key_info);
+    return;
+  }
+  uint64_t keys = 0;
+  uint64_t expires = 0;
+  db_->GetIntProperty(db_->DefaultColumnFamily(), "rocksdb.estimate-num-keys", &keys);
+  // The expire index may still hold the entries of keys overwritten since
+  db_->GetIntProperty(expire_handle(), "rocksdb.estimate-num-keys", &expires);
+  key_info->keys = keys;
+  key_info->expires = std::min(expires, keys);
+  key_info->avg_ttl = 0;
+  key_info->invaild_keys = 0;
+}
+
 Status Redis::GetScanStartPoint(const Slice& key, const Slice& pattern, int64_t cursor, std::string* start_point) {
   std::string index_key = key.ToString() + "_" + pattern.ToString() + "_" + std::to_string(cursor);
   return scan_cursors_store_->Lookup(index_key, start_point);
@@ -41,6 +236,35 @@ Status Redis::StoreScanNextPoint(const Slice& key, const Slice& pattern, int64_t
   return scan_cursors_store_->Insert(index_key, next_point);
 }
 
+void Redis::MultiGet(const rocksdb::ReadOptions& read_options, rocksdb::ColumnFamilyHandle* column_family,
+                     const std::vector<Slice>& keys, std::vector<rocksdb::PinnableSlice>* values,
+                     std::vector<Status>* statuses) {
+  values->clear();
+  values->resize(keys.size());
+  statuses->assign(keys.size(), Status::OK());
+  if (keys.empty()) {
+    return;
+  }
+  // MultiGet sorts the keys by the comparator of the column family, looks
+  // them up against one consistent view of the memtables and sst files, and
+  // batches the block reads of the same file; async_io lets the reads of
+  // different files overlap when rocksdb is built with coroutine support
+  rocksdb::ReadOptions multiget_options(read_options);
+  multiget_options.async_io = true;
+  db_->MultiGet(multiget_options, column_family, keys.size(), keys.data(), values->data(), statuses->data());
+}
+
+void Redis::MultiExists(const std::vector<std::string>& keys, std::vector<Status>* statuses) {
+  std::vector<Slice> meta_keys(keys.begin(), keys.end());
+  std::vector<rocksdb::PinnableSlice> meta_values;
+  MultiGet(default_read_options_, db_->DefaultColumnFamily(), meta_keys, &meta_values, statuses);
+  for (size_t idx = 0; idx < keys.size(); ++idx) {
+    if ((*statuses)[idx].ok() && !IsValidMetaValue(meta_values[idx])) {
+      (*statuses)[idx] = Status::NotFound();
+    }
+  }
+}
+
 Status Redis::SetMaxCacheStatisticKeys(size_t max_cache_statistic_keys) {
   statistics_store_->SetCapacity(max_cache_statistic_keys);
   return Status::OK();
@@ -91,6 +315,9 @@ Status Redis::SetOptions(const OptionType& option_type, const std::unordered_map
 void Redis::GetRocksDBInfo(std::string &info, const char *prefix) {
     std::ostringstream string_stream;
     string_stream << "#" << prefix << "RocksDB" << "\r\n";
+    string_stream << prefix << "open_time_ms:" << open_time_us_ / 1000 << "\r\n";
+    string_stream << prefix << "active_expired_keys:" << active_expired_keys_ << "\r\n";
+    string_stream << prefix << "obsolete_expire_entries:" << obsolete_expire_entries_ << "\r\n";
 
     auto write_stream_key_value=[&](const Slice& property, const char *metric) {
         uint64_t value;
@@ -158,6 +385,16 @@ void Redis::GetRocksDBInfo(std::string &info, const char *prefix) {
     write_stream_key_value(rocksdb::DB::Properties::kTotalBlobFileSize, "total_blob_file_size");
     write_stream_key_value(rocksdb::DB::Properties::kLiveBlobFileSize, "live_blob_file_size");
     
+    // meta lookups of the data filters
+    uint64_t lookups = data_filter_statistics_.lookups;
+    uint64_t iterator_hits = data_filter_statistics_.iterator_hits;
+    string_stream << prefix << "data_filter_lookups:" << lookups << "\r\n";
+    string_stream << prefix << "data_filter_iterator_hits:" << iterator_hits << "\r\n";
+    string_stream << prefix << "data_filter_seeks:" << data_filter_statistics_.seeks << "\r\n";
+    string_stream << prefix << "data_filter_gets:" << data_filter_statistics_.gets << "\r\n";
+    string_stream << prefix << "data_filter_iterator_hit_rate:" << (lookups != 0 ? iterator_hits * 100 / lookups : 0)
+                  << "%\r\n";
+
     // column family stats
     std::map<std::string, std::string> mapvalues;
     db_->rocksdb::DB::GetMapProperty(rocksdb::DB::Properties::kCFStats,&mapvalues);
@@ -6,17 +6,22 @@
 #ifndef SRC_REDIS_H_
 #define SRC_REDIS_H_
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 #include "rocksdb/db.h"
 #include "rocksdb/slice.h"
 #include "rocksdb/status.h"
+#include "rocksdb/write_batch.h"
 
+#include "src/base_filter.h"
+#include "src/key_statistics.h"
 #include "src/lock_mgr.h"
 #include "src/lru_cache.h"
-#include "src/mutex_impl.h"
+#include "src/value_cache.h"
 #include "storage/storage.h"
 
 namespace storage {
@@ -53,10 +58,40 @@ class Redis {
   virtual Status Persist(const Slice& key) = 0;
   virtual Status TTL(const Slice& key, int64_t* timestamp) = 0;
 
+  // Check keys with one batched lookup of the meta column family,
+  // (*statuses)[i] is OK if keys[i] exists, NotFound if it does not
+  // exist or is stale, otherwise the error of the lookup
+  void MultiExists(const std::vector<std::string>& keys, std::vector<Status>* statuses);
+
   Status SetMaxCacheStatisticKeys(size_t max_cache_statistic_keys);
   Status SetSmallCompactionThreshold(size_t small_compaction_threshold);
   void GetRocksDBInfo(std::string &info, const char *prefix);
 
+  // The keyspace statistics kept by the write paths, loaded from db_path after
+  // Open, estimated if they are missing or older than the data
+  Status LoadKeyStatistics(const std::string& db_path);
+  // clean means no write can come in anymore
+  Status PersistKeyStatistics(bool clean);
+  // Estimated by rocksdb if the write paths do not keep them
+  void GetKeyStatistics(KeyInfo* key_info);
+  bool IsKeyStatisticsExact() const { return key_statistics_kept_ && key_statistics_.exact(); }
+  // False if only rocksdb estimates the keys, a recount does not help then
+  bool IsKeyStatisticsKept() const { return key_statistics_kept_; }
+
+  // Deletes the keys of the expire index that are due, spending at most
+  // about budget deletions of index entries, keys and their data on it, a key
+  // with more data than that is deleted over several calls
+  Status ActiveExpire(size_t budget);
+  uint64_t active_expired_keys() const { return active_expired_keys_; }
+
+  // The cache of hot values the types share, for those that cache theirs,
+  // nullptr if it is disabled
+  void set_value_cache(ValueCache* value_cache) { value_cache_ = value_cache; }
+
+  // How long Open took, replaying the MANIFEST and the WAL included
+  void set_open_time_us(uint64_t open_time_us) { open_time_us_ = open_time_us; }
+  uint64_t open_time_us() const { return open_time_us_; }
+
  protected:
   Storage* const storage_;
   DataType type_;
@@ -69,17 +104,93 @@ class Redis {
   rocksdb::CompactRangeOptions default_compact_range_options_;
 
   // For Scan
-  std::unique_ptr<LRUCache<std::string, std::string>> scan_cursors_store_;
+  std::unique_ptr<ShardedLRUCache<std::string, std::string>> scan_cursors_store_;
+
+  // Builds a whole key bloom filter for the memtable of the meta column
+  // family, so a probe for a key owned by another type is answered without
+  // searching the memtable
+  static void SetMetaMemtableBloom(rocksdb::ColumnFamilyOptions* meta_cf_ops);
+
+  // The expire index is the last column family of every type db, missing in
+  // the databases created by older versions
+  static const std::string kExpireIndexColumnFamilyName;
+  static void SetExpireIndexOptions(rocksdb::ColumnFamilyOptions* expire_cf_ops);
+  rocksdb::ColumnFamilyHandle* expire_handle() { return handles_.back(); }
+
+  // Writes batch along with the changes of the expire index from key going
+  // from before to after, entries left behind by other writes are dropped by
+  // ActiveExpire once they are due
+  Status WriteWithExpireIndex(rocksdb::WriteBatch* batch, const Slice& key, const KeyState& before,
+                              const KeyState& after);
+  // Writes the meta value of key, for the types keeping it in handles_[0]
+  Status PutMetaValue(const Slice& key, const Slice& meta_value, const KeyState& before, const KeyState& after);
+
+  // What ReclaimExpiredKey found for an entry of the expire index
+  struct ExpiredKey {
+    // The key does not expire at the timestamp of the entry anymore
+    bool obsolete = false;
+    // The batch deletes the key, not only part of its data
+    bool deleted = false;
+    KeyState before;
+  };
+  // Called with key locked, adds to batch the deletion of up to *budget
+  // entries of the data of key, then of key itself once none is left, if key
+  // still expired at timestamp
+  virtual Status ReclaimExpiredKey(const Slice& key, int32_t timestamp, size_t* budget, rocksdb::WriteBatch* batch,
+                                   ExpiredKey* expired_key) = 0;
+  // Adds to batch the deletion of up to *budget entries of handle from
+  // seek_key on that belong to the same key and version, returns whether none
+  // of them is left
+  bool DeleteVersionData(rocksdb::ColumnFamilyHandle* handle, const Slice& key, const Slice& seek_key, size_t* budget,
+                         rocksdb::WriteBatch* batch);
 
   Status GetScanStartPoint(const Slice& key, const Slice& pattern, int64_t cursor, std::string* start_point);
   Status StoreScanNextPoint(const Slice& key, const Slice& pattern, int64_t cursor, const std::string& next_point);
 
   // For Statistics
   std::atomic<size_t> small_compaction_threshold_;
-  std::unique_ptr<LRUCache<std::string, size_t>> statistics_store_;
+  std::unique_ptr<ShardedLRUCache<std::string, size_t>> statistics_store_;
+
+  uint64_t open_time_us_ = 0;
+
+  // Shared by the data filters of the compactions
+  DataFilterStatistics data_filter_statistics_;
+
+  // For Active Expiration
+  // The index entries before the cursor were all handled, unless a write
+  // added a due entry since, which moves it back
+  std::mutex expire_cursor_mu_;
+  int32_t expire_cursor_ = 0;
+  bool expire_cursor_moved_ = false;
+  std::atomic<uint64_t> active_expired_keys_ = 0;
+  std::atomic<uint64_t> obsolete_expire_entries_ = 0;
+
+  // For Value Cache
+  ValueCache* value_cache_ = nullptr;
+  // The key of the cached value of key, tagged with the type
+  std::string ValueCacheKey(const Slice& key) const;
+  // Called after every write of key
+  void InvalidateCachedValue(const Slice& key);
+  // Called after writes that cannot name their keys
+  void ClearCachedValues();
+
+  // For Keyspace Statistics
+  KeyStatistics key_statistics_;
+  std::string key_statistics_path_;
+  // Cleared by a type db whose writes may not know the previous state of
+  // their key, its statistics are then neither reported nor saved
+  bool key_statistics_kept_ = true;
 
   Status UpdateSpecificKeyStatistics(const std::string& key, size_t count);
   Status AddCompactKeyTaskIfNeeded(const std::string& key, size_t total);
+
+  // Batched point lookups of one column family, values and statuses are
+  // returned in the order of keys
+  void MultiGet(const rocksdb::ReadOptions& read_options, rocksdb::ColumnFamilyHandle* column_family,
+                const std::vector<Slice>& keys, std::vector<rocksdb::PinnableSlice>* values,
+                std::vector<Status>* statuses);
+  // Whether the value stored in the meta column family belongs to an alive key
+  virtual bool IsValidMetaValue(const Slice& meta_value) = 0;
 };
 
 }  //  namespace storage
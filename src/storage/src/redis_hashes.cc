@@ -11,14 +11,97 @@
 #include <glog/logging.h>
 
 #include "src/base_filter.h"
+#include "src/scan_range.h"
 #include "src/scope_record_lock.h"
 #include "src/scope_snapshot.h"
 #include "storage/util.h"
+#include "pstd/include/pstd_glob.h"
 
 namespace storage {
 
 RedisHashes::RedisHashes(Storage* const s, const DataType& type) : Redis(s, type) {}
 
+// The state of a key whose meta value was read
+static KeyState MetaKeyState(const Slice& meta_value) {
+  ParsedHashesMetaValue parsed_meta_value(meta_value);
+  return {parsed_meta_value.count() != 0, parsed_meta_value.timestamp()};
+}
+
+// A hash of at most that many fields is cached whole by HGet and HGetall
+static const uint32_t kMaxCachedHashFields = 64;
+
+/*
+ * The cached value of a hash:
+ *
+ * | <Meta Value Size> | <Meta Value> | (<Field Size> | <Field> | <Value Size> | <Value>)...
+ *       4 Bytes                           4 Bytes                 4 Bytes
+ */
+static void AppendCachedSlice(std::string* entry, const Slice& slice) {
+  char buf[sizeof(uint32_t)];
+  EncodeFixed32(buf, static_cast<uint32_t>(slice.size()));
+  entry->append(buf, sizeof(buf));
+  entry->append(slice.data(), slice.size());
+}
+
+static bool ConsumeCachedSlice(Slice* entry, Slice* slice) {
+  if (entry->size() < sizeof(uint32_t)) {
+    return false;
+  }
+  uint32_t size = DecodeFixed32(entry->data());
+  entry->remove_prefix(sizeof(uint32_t));
+  if (entry->size() < size) {
+    return false;
+  }
+  *slice = Slice(entry->data(), size);
+  entry->remove_prefix(size);
+  return true;
+}
+
+static std::string EncodeCachedHash(const Slice& meta_value, const std::vector<FieldValue>& fvs) {
+  std::string entry;
+  AppendCachedSlice(&entry, meta_value);
+  for (const auto& fv : fvs) {
+    AppendCachedSlice(&entry, fv.field);
+    AppendCachedSlice(&entry, fv.value);
+  }
+  return entry;
+}
+
+// Consumes the meta value of a cached hash, false if the hash expired since
+static bool ConsumeCachedMetaValue(Slice* entry) {
+  Slice meta_value;
+  return ConsumeCachedSlice(entry, &meta_value) && !ParsedHashesMetaValue(meta_value).IsStale();
+}
+
+static Status GetCachedField(const std::string& entry, const Slice& field, std::string* value) {
+  Slice input(entry);
+  if (!ConsumeCachedMetaValue(&input)) {
+    return Status::NotFound("Stale");
+  }
+  Slice cached_field;
+  Slice cached_value;
+  while (ConsumeCachedSlice(&input, &cached_field) && ConsumeCachedSlice(&input, &cached_value)) {
+    if (cached_field == field) {
+      value->assign(cached_value.data(), cached_value.size());
+      return Status::OK();
+    }
+  }
+  return Status::NotFound();
+}
+
+static Status GetCachedFieldValues(const std::string& entry, std::vector<FieldValue>* fvs) {
+  Slice input(entry);
+  if (!ConsumeCachedMetaValue(&input)) {
+    return Status::NotFound("Stale");
+  }
+  Slice cached_field;
+  Slice cached_value;
+  while (ConsumeCachedSlice(&input, &cached_field) && ConsumeCachedSlice(&input, &cached_value)) {
+    fvs->push_back({cached_field.ToString(), cached_value.ToString()});
+  }
+  return Status::OK();
+}
+
 Status RedisHashes::Open(const StorageOptions& storage_options, const std::string& db_path) {
   statistics_store_->SetCapacity(storage_options.statistics_max_size);
   small_compaction_threshold_ = storage_options.small_compaction_threshold;
@@ -39,10 +122,15 @@ Status RedisHashes::Open(const StorageOptions& storage_options, const std::strin
 
   // Open
   rocksdb::DBOptions db_ops(storage_options.options);
+  // expire_cf is missing in databases created by older versions
+  db_ops.create_missing_column_families = true;
   rocksdb::ColumnFamilyOptions meta_cf_ops(storage_options.options);
   rocksdb::ColumnFamilyOptions data_cf_ops(storage_options.options);
-  meta_cf_ops.compaction_filter_factory = std::make_shared<HashesMetaFilterFactory>();
-  data_cf_ops.compaction_filter_factory = std::make_shared<HashesDataFilterFactory>(&db_, &handles_);
+  rocksdb::ColumnFamilyOptions expire_cf_ops(storage_options.options);
+  meta_cf_ops.compaction_filter_factory = std::make_shared<HashesMetaFilterFactory>(&key_statistics_);
+  SetMetaMemtableBloom(&meta_cf_ops);
+  data_cf_ops.compaction_filter_factory =
+      std::make_shared<HashesDataFilterFactory>(&db_, &handles_, &data_filter_statistics_);
 
   // use the bloom filter policy to reduce disk reads
   rocksdb::BlockBasedTableOptions table_ops(storage_options.table_options);
@@ -55,12 +143,15 @@ Status RedisHashes::Open(const StorageOptions& storage_options, const std::strin
   }
   meta_cf_ops.table_factory.reset(rocksdb::NewBlockBasedTableFactory(meta_cf_table_ops));
   data_cf_ops.table_factory.reset(rocksdb::NewBlockBasedTableFactory(data_cf_table_ops));
+  SetExpireIndexOptions(&expire_cf_ops);
 
   std::vector<rocksdb::ColumnFamilyDescriptor> column_families;
   // Meta CF
   column_families.emplace_back(rocksdb::kDefaultColumnFamilyName, meta_cf_ops);
   // Data CF
   column_families.emplace_back("data_cf", data_cf_ops);
+  // Expire CF
+  column_families.emplace_back(kExpireIndexColumnFamilyName, expire_cf_ops);
   return rocksdb::DB::Open(db_ops, db_path, column_families, &handles_, &db_);
 }
 
@@ -89,6 +180,10 @@ Status RedisHashes::ScanKeyNum(KeyInfo* key_info) {
   uint64_t ttl_sum = 0;
   uint64_t invaild_keys = 0;
 
+  // Writes made from here on are applied on top of the scanned statistics
+  KeyStatistics scanned;
+  uint64_t recount = key_statistics_.StartRecount();
+
   rocksdb::ReadOptions iterator_options;
   const rocksdb::Snapshot* snapshot;
   ScopeSnapshot ss(db_, &snapshot);
@@ -101,6 +196,7 @@ Status RedisHashes::ScanKeyNum(KeyInfo* key_info) {
   rocksdb::Iterator* iter = db_->NewIterator(iterator_options, handles_[0]);
   for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
     ParsedHashesMetaValue parsed_hashes_meta_value(iter->value());
+    scanned.Update(KeyState(), MetaKeyState(iter->value()));
     if (parsed_hashes_meta_value.IsStale() || parsed_hashes_meta_value.count() == 0) {
       invaild_keys++;
     } else {
@@ -112,6 +208,7 @@ Status RedisHashes::ScanKeyNum(KeyInfo* key_info) {
     }
   }
   delete iter;
+  key_statistics_.FinishRecount(recount, &scanned);
 
   key_info->keys = keys;
   key_info->expires = expires;
@@ -128,12 +225,15 @@ Status RedisHashes::ScanKeys(const std::string& pattern, std::vector<std::string
   iterator_options.snapshot = snapshot;
   iterator_options.fill_cache = false;
 
+  pstd::GlobMatcher matcher(pattern);
+  ScanRange range(matcher);
+  range.Bound(&iterator_options);
   rocksdb::Iterator* iter = db_->NewIterator(iterator_options, handles_[0]);
-  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+  for (iter->Seek(range.prefix()); iter->Valid(); iter->Next()) {
     ParsedHashesMetaValue parsed_hashes_meta_value(iter->value());
     if (!parsed_hashes_meta_value.IsStale() && parsed_hashes_meta_value.count() != 0) {
       key = iter->key().ToString();
-      if (StringMatch(pattern.data(), pattern.size(), key.data(), key.size(), 0) != 0) {
+      if (matcher.Match(key.data(), key.size())) {
         keys->push_back(key);
       }
     }
@@ -154,22 +254,32 @@ Status RedisHashes::PKPatternMatchDel(const std::string& pattern, int32_t* ret)
   int32_t total_delete = 0;
   Status s;
   rocksdb::WriteBatch batch;
+  std::vector<KeyState> befores;
+  pstd::GlobMatcher matcher(pattern);
+  ScanRange range(matcher);
+  range.Bound(&iterator_options);
   rocksdb::Iterator* iter = db_->NewIterator(iterator_options, handles_[0]);
-  iter->SeekToFirst();
+  iter->Seek(range.prefix());
   while (iter->Valid()) {
     key = iter->key().ToString();
     meta_value = iter->value().ToString();
     ParsedHashesMetaValue parsed_hashes_meta_value(&meta_value);
     if (!parsed_hashes_meta_value.IsStale() && (parsed_hashes_meta_value.count() != 0) &&
-        (StringMatch(pattern.data(), pattern.size(), key.data(), key.size(), 0) != 0)) {
+        matcher.Match(key.data(), key.size())) {
+      befores.push_back(MetaKeyState(meta_value));
       parsed_hashes_meta_value.InitialMetaValue();
       batch.Put(handles_[0], key, meta_value);
     }
     if (static_cast<size_t>(batch.Count()) >= BATCH_DELETE_LIMIT) {
       s = db_->Write(default_write_options_, &batch);
+      ClearCachedValues();
       if (s.ok()) {
         total_delete += static_cast<int32_t>( batch.Count());
         batch.Clear();
+        for (const auto& before : befores) {
+          key_statistics_.Update(before, KeyState());
+        }
+        befores.clear();
       } else {
         *ret = total_delete;
         return s;
@@ -179,9 +289,14 @@ Status RedisHashes::PKPatternMatchDel(const std::string& pattern, int32_t* ret)
   }
   if (batch.Count() != 0U) {
     s = db_->Write(default_write_options_, &batch);
+    ClearCachedValues();
     if (s.ok()) {
       total_delete += static_cast<int32_t>(batch.Count());
       batch.Clear();
+      for (const auto& before : befores) {
+        key_statistics_.Update(before, KeyState());
+      }
+      befores.clear();
     }
   }
 
@@ -212,6 +327,8 @@ Status RedisHashes::HDel(const Slice& key, const std::vector<std::string>& field
   ScopeSnapshot ss(db_, &snapshot);
   read_options.snapshot = snapshot;
   Status s = db_->Get(read_options, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   if (s.ok()) {
     ParsedHashesMetaValue parsed_hashes_meta_value(&meta_value);
     if (parsed_hashes_meta_value.IsStale() || parsed_hashes_meta_value.count() == 0) {
@@ -239,6 +356,7 @@ Status RedisHashes::HDel(const Slice& key, const std::vector<std::string>& field
       }
       parsed_hashes_meta_value.ModifyCount(-del_cnt);
       batch.Put(handles_[0], key, meta_value);
+      after = MetaKeyState(meta_value);
     }
   } else if (s.IsNotFound()) {
     *ret = 0;
@@ -247,6 +365,10 @@ Status RedisHashes::HDel(const Slice& key, const std::vector<std::string>& field
     return s;
   }
   s = db_->Write(default_write_options_, &batch);
+  InvalidateCachedValue(key);
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
   UpdateSpecificKeyStatistics(key.ToString(), statistic);
   return s;
 }
@@ -257,6 +379,16 @@ Status RedisHashes::HExists(const Slice& key, const Slice& field) {
 }
 
 Status RedisHashes::HGet(const Slice& key, const Slice& field, std::string* value) {
+  std::string cache_key;
+  uint64_t ticket = 0;
+  if (value_cache_ != nullptr) {
+    cache_key = ValueCacheKey(key);
+    std::string entry;
+    if (value_cache_->Lookup(cache_key, &entry, &ticket)) {
+      return GetCachedField(entry, field, value);
+    }
+  }
+
   std::string meta_value;
   int32_t version = 0;
   rocksdb::ReadOptions read_options;
@@ -270,6 +402,15 @@ Status RedisHashes::HGet(const Slice& key, const Slice& field, std::string* valu
       return Status::NotFound("Stale");
     } else if (parsed_hashes_meta_value.count() == 0) {
       return Status::NotFound();
+    } else if (ticket != 0 && parsed_hashes_meta_value.count() <= kMaxCachedHashFields) {
+      // Reads the whole hash from the same snapshot to cache it
+      std::vector<FieldValue> fvs;
+      s = GetFieldValues(read_options, key, parsed_hashes_meta_value.version(), &fvs);
+      if (s.ok()) {
+        std::string entry = EncodeCachedHash(meta_value, fvs);
+        value_cache_->Fill(cache_key, entry, ticket);
+        s = GetCachedField(entry, field, value);
+      }
     } else {
       version = parsed_hashes_meta_value.version();
       HashesDataKey data_key(key, version, field);
@@ -279,7 +420,29 @@ Status RedisHashes::HGet(const Slice& key, const Slice& field, std::string* valu
   return s;
 }
 
+Status RedisHashes::GetFieldValues(const rocksdb::ReadOptions& read_options, const Slice& key, int32_t version,
+                                   std::vector<FieldValue>* fvs) {
+  HashesDataKey hashes_data_key(key, version, "");
+  Slice prefix = hashes_data_key.Encode();
+  std::unique_ptr<rocksdb::Iterator> iter(db_->NewIterator(read_options, handles_[1]));
+  for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
+    ParsedHashesDataKey parsed_hashes_data_key(iter->key());
+    fvs->push_back({parsed_hashes_data_key.field().ToString(), iter->value().ToString()});
+  }
+  return iter->status();
+}
+
 Status RedisHashes::HGetall(const Slice& key, std::vector<FieldValue>* fvs) {
+  std::string cache_key;
+  uint64_t ticket = 0;
+  if (value_cache_ != nullptr) {
+    cache_key = ValueCacheKey(key);
+    std::string entry;
+    if (value_cache_->Lookup(cache_key, &entry, &ticket)) {
+      return GetCachedFieldValues(entry, fvs);
+    }
+  }
+
   rocksdb::ReadOptions read_options;
   const rocksdb::Snapshot* snapshot;
 
@@ -296,14 +459,10 @@ Status RedisHashes::HGetall(const Slice& key, std::vector<FieldValue>* fvs) {
       return Status::NotFound();
     } else {
       version = parsed_hashes_meta_value.version();
-      HashesDataKey hashes_data_key(key, version, "");
-      Slice prefix = hashes_data_key.Encode();
-      auto iter = db_->NewIterator(read_options, handles_[1]);
-      for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
-        ParsedHashesDataKey parsed_hashes_data_key(iter->key());
-        fvs->push_back({parsed_hashes_data_key.field().ToString(), iter->value().ToString()});
+      s = GetFieldValues(read_options, key, version, fvs);
+      if (s.ok() && ticket != 0 && parsed_hashes_meta_value.count() <= kMaxCachedHashFields) {
+        value_cache_->Fill(cache_key, EncodeCachedHash(meta_value, *fvs), ticket);
       }
-      delete iter;
     }
   }
   return s;
@@ -320,6 +479,8 @@ Status RedisHashes::HIncrby(const Slice& key, const Slice& field, int64_t value,
   std::string meta_value;
 
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   char value_buf[32] = {0};
   char meta_value_buf[4] = {0};
   if (s.ok()) {
@@ -329,6 +490,7 @@ Status RedisHashes::HIncrby(const Slice& key, const Slice& field, int64_t value,
       parsed_hashes_meta_value.set_count(1);
       parsed_hashes_meta_value.set_timestamp(0);
       batch.Put(handles_[0], key, meta_value);
+      after = MetaKeyState(meta_value);
       HashesDataKey hashes_data_key(key, version, field);
       Int64ToStr(value_buf, 32, value);
       batch.Put(handles_[1], hashes_data_key.Encode(), value_buf);
@@ -356,6 +518,7 @@ Status RedisHashes::HIncrby(const Slice& key, const Slice& field, int64_t value,
         }
         parsed_hashes_meta_value.ModifyCount(1);
         batch.Put(handles_[0], key, meta_value);
+        after = MetaKeyState(meta_value);
         batch.Put(handles_[1], hashes_data_key.Encode(), value_buf);
         *ret = value;
       } else {
@@ -367,6 +530,7 @@ Status RedisHashes::HIncrby(const Slice& key, const Slice& field, int64_t value,
     HashesMetaValue hashes_meta_value(Slice(meta_value_buf, sizeof(int32_t)));
     version = hashes_meta_value.UpdateVersion();
     batch.Put(handles_[0], key, hashes_meta_value.Encode());
+    after = MetaKeyState(hashes_meta_value.Encode());
     HashesDataKey hashes_data_key(key, version, field);
 
     Int64ToStr(value_buf, 32, value);
@@ -376,6 +540,10 @@ Status RedisHashes::HIncrby(const Slice& key, const Slice& field, int64_t value,
     return s;
   }
   s = db_->Write(default_write_options_, &batch);
+  InvalidateCachedValue(key);
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
   UpdateSpecificKeyStatistics(key.ToString(), statistic);
   return s;
 }
@@ -396,6 +564,8 @@ Status RedisHashes::HIncrbyfloat(const Slice& key, const Slice& field, const Sli
   }
 
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   char meta_value_buf[4] = {0};
   if (s.ok()) {
     ParsedHashesMetaValue parsed_hashes_meta_value(&meta_value);
@@ -404,6 +574,7 @@ Status RedisHashes::HIncrbyfloat(const Slice& key, const Slice& field, const Sli
       parsed_hashes_meta_value.set_count(1);
       parsed_hashes_meta_value.set_timestamp(0);
       batch.Put(handles_[0], key, meta_value);
+      after = MetaKeyState(meta_value);
       HashesDataKey hashes_data_key(key, version, field);
 
       LongDoubleToStr(long_double_by, new_value);
@@ -432,6 +603,7 @@ Status RedisHashes::HIncrbyfloat(const Slice& key, const Slice& field, const Sli
         }
         parsed_hashes_meta_value.ModifyCount(1);
         batch.Put(handles_[0], key, meta_value);
+        after = MetaKeyState(meta_value);
         batch.Put(handles_[1], hashes_data_key.Encode(), *new_value);
       } else {
         return s;
@@ -442,6 +614,7 @@ Status RedisHashes::HIncrbyfloat(const Slice& key, const Slice& field, const Sli
     HashesMetaValue hashes_meta_value(Slice(meta_value_buf, sizeof(int32_t)));
     version = hashes_meta_value.UpdateVersion();
     batch.Put(handles_[0], key, hashes_meta_value.Encode());
+    after = MetaKeyState(hashes_meta_value.Encode());
 
     HashesDataKey hashes_data_key(key, version, field);
     LongDoubleToStr(long_double_by, new_value);
@@ -450,6 +623,10 @@ Status RedisHashes::HIncrbyfloat(const Slice& key, const Slice& field, const Sli
     return s;
   }
   s = db_->Write(default_write_options_, &batch);
+  InvalidateCachedValue(key);
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
   UpdateSpecificKeyStatistics(key.ToString(), statistic);
   return s;
 }
@@ -509,7 +686,6 @@ Status RedisHashes::HMGet(const Slice& key, const std::vector<std::string>& fiel
 
   int32_t version = 0;
   bool is_stale = false;
-  std::string value;
   std::string meta_value;
   rocksdb::ReadOptions read_options;
   const rocksdb::Snapshot* snapshot;
@@ -525,11 +701,21 @@ Status RedisHashes::HMGet(const Slice& key, const std::vector<std::string>& fiel
       return Status::NotFound(is_stale ? "Stale" : "");
     } else {
       version = parsed_hashes_meta_value.version();
+      std::vector<std::string> data_keys;
+      data_keys.reserve(fields.size());
       for (const auto& field : fields) {
         HashesDataKey hashes_data_key(key, version, field);
-        s = db_->Get(read_options, handles_[1], hashes_data_key.Encode(), &value);
+        data_keys.push_back(hashes_data_key.Encode().ToString());
+      }
+      std::vector<Slice> data_key_slices(data_keys.begin(), data_keys.end());
+      std::vector<rocksdb::PinnableSlice> values;
+      std::vector<Status> statuses;
+      MultiGet(read_options, handles_[1], data_key_slices, &values, &statuses);
+      vss->reserve(fields.size());
+      for (size_t idx = 0; idx < fields.size(); ++idx) {
+        s = statuses[idx];
         if (s.ok()) {
-          vss->push_back({value, Status::OK()});
+          vss->push_back({values[idx].ToString(), Status::OK()});
         } else if (s.IsNotFound()) {
           vss->push_back({std::string(), Status::NotFound()});
         } else {
@@ -565,6 +751,8 @@ Status RedisHashes::HMSet(const Slice& key, const std::vector<FieldValue>& fvs)
   int32_t version = 0;
   std::string meta_value;
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   char meta_value_buf[4] = {0};
   if (s.ok()) {
     ParsedHashesMetaValue parsed_hashes_meta_value(&meta_value);
@@ -575,6 +763,7 @@ Status RedisHashes::HMSet(const Slice& key, const std::vector<FieldValue>& fvs)
       }
       parsed_hashes_meta_value.set_count(static_cast<int32_t>(filtered_fvs.size()));
       batch.Put(handles_[0], key, meta_value);
+      after = MetaKeyState(meta_value);
       for (const auto& fv : filtered_fvs) {
         HashesDataKey hashes_data_key(key, version, fv.field);
         batch.Put(handles_[1], hashes_data_key.Encode(), fv.value);
@@ -601,18 +790,24 @@ Status RedisHashes::HMSet(const Slice& key, const std::vector<FieldValue>& fvs)
       }
       parsed_hashes_meta_value.ModifyCount(count);
       batch.Put(handles_[0], key, meta_value);
+      after = MetaKeyState(meta_value);
     }
   } else if (s.IsNotFound()) {
     EncodeFixed32(meta_value_buf, filtered_fvs.size());
     HashesMetaValue hashes_meta_value(Slice(meta_value_buf, sizeof(int32_t)));
     version = hashes_meta_value.UpdateVersion();
     batch.Put(handles_[0], key, hashes_meta_value.Encode());
+    after = MetaKeyState(hashes_meta_value.Encode());
     for (const auto& fv : filtered_fvs) {
       HashesDataKey hashes_data_key(key, version, fv.field);
       batch.Put(handles_[1], hashes_data_key.Encode(), fv.value);
     }
   }
   s = db_->Write(default_write_options_, &batch);
+  InvalidateCachedValue(key);
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
   UpdateSpecificKeyStatistics(key.ToString(), statistic);
   return s;
 }
@@ -625,6 +820,8 @@ Status RedisHashes::HSet(const Slice& key, const Slice& field, const Slice& valu
   uint32_t statistic = 0;
   std::string meta_value;
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   char meta_value_buf[4] = {0};
   if (s.ok()) {
     ParsedHashesMetaValue parsed_hashes_meta_value(&meta_value);
@@ -632,6 +829,7 @@ Status RedisHashes::HSet(const Slice& key, const Slice& field, const Slice& valu
       version = parsed_hashes_meta_value.InitialMetaValue();
       parsed_hashes_meta_value.set_count(1);
       batch.Put(handles_[0], key, meta_value);
+      after = MetaKeyState(meta_value);
       HashesDataKey data_key(key, version, field);
       batch.Put(handles_[1], data_key.Encode(), value);
       *res = 1;
@@ -654,6 +852,7 @@ Status RedisHashes::HSet(const Slice& key, const Slice& field, const Slice& valu
         }
         parsed_hashes_meta_value.ModifyCount(1);
         batch.Put(handles_[0], key, meta_value);
+        after = MetaKeyState(meta_value);
         batch.Put(handles_[1], hashes_data_key.Encode(), value);
         *res = 1;
       } else {
@@ -665,6 +864,7 @@ Status RedisHashes::HSet(const Slice& key, const Slice& field, const Slice& valu
     HashesMetaValue meta_value(Slice(meta_value_buf, sizeof(int32_t)));
     version = meta_value.UpdateVersion();
     batch.Put(handles_[0], key, meta_value.Encode());
+    after = MetaKeyState(meta_value.Encode());
     HashesDataKey data_key(key, version, field);
     batch.Put(handles_[1], data_key.Encode(), value);
     *res = 1;
@@ -672,6 +872,10 @@ Status RedisHashes::HSet(const Slice& key, const Slice& field, const Slice& valu
     return s;
   }
   s = db_->Write(default_write_options_, &batch);
+  InvalidateCachedValue(key);
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
   UpdateSpecificKeyStatistics(key.ToString(), statistic);
   return s;
 }
@@ -683,6 +887,8 @@ Status RedisHashes::HSetnx(const Slice& key, const Slice& field, const Slice& va
   int32_t version = 0;
   std::string meta_value;
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   char meta_value_buf[4] = {0};
   if (s.ok()) {
     ParsedHashesMetaValue parsed_hashes_meta_value(&meta_value);
@@ -690,6 +896,7 @@ Status RedisHashes::HSetnx(const Slice& key, const Slice& field, const Slice& va
       version = parsed_hashes_meta_value.InitialMetaValue();
       parsed_hashes_meta_value.set_count(1);
       batch.Put(handles_[0], key, meta_value);
+      after = MetaKeyState(meta_value);
       HashesDataKey hashes_data_key(key, version, field);
       batch.Put(handles_[1], hashes_data_key.Encode(), value);
       *ret = 1;
@@ -706,6 +913,7 @@ Status RedisHashes::HSetnx(const Slice& key, const Slice& field, const Slice& va
         }
         parsed_hashes_meta_value.ModifyCount(1);
         batch.Put(handles_[0], key, meta_value);
+        after = MetaKeyState(meta_value);
         batch.Put(handles_[1], hashes_data_key.Encode(), value);
         *ret = 1;
       } else {
@@ -717,13 +925,19 @@ Status RedisHashes::HSetnx(const Slice& key, const Slice& field, const Slice& va
     HashesMetaValue hashes_meta_value(Slice(meta_value_buf, sizeof(int32_t)));
     version = hashes_meta_value.UpdateVersion();
     batch.Put(handles_[0], key, hashes_meta_value.Encode());
+    after = MetaKeyState(hashes_meta_value.Encode());
     HashesDataKey hashes_data_key(key, version, field);
     batch.Put(handles_[1], hashes_data_key.Encode(), value);
     *ret = 1;
   } else {
     return s;
   }
-  return db_->Write(default_write_options_, &batch);
+  s = db_->Write(default_write_options_, &batch);
+  InvalidateCachedValue(key);
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
+  return s;
 }
 
 Status RedisHashes::HVals(const Slice& key, std::vector<std::string>* values) {
@@ -807,12 +1021,13 @@ Status RedisHashes::HScan(const Slice& key, int64_t cursor, const std::string& p
       HashesDataKey hashes_data_prefix(key, version, sub_field);
       HashesDataKey hashes_start_data_key(key, version, start_point);
       std::string prefix = hashes_data_prefix.Encode().ToString();
+      pstd::GlobMatcher matcher(pattern);
       rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[1]);
       for (iter->Seek(hashes_start_data_key.Encode()); iter->Valid() && rest > 0 && iter->key().starts_with(prefix);
            iter->Next()) {
         ParsedHashesDataKey parsed_hashes_data_key(iter->key());
         std::string field = parsed_hashes_data_key.field().ToString();
-        if (StringMatch(pattern.data(), pattern.size(), field.data(), field.size(), 0) != 0) {
+        if (matcher.Match(field.data(), field.size())) {
           field_values->push_back({field, iter->value().ToString()});
         }
         rest--;
@@ -857,12 +1072,13 @@ Status RedisHashes::HScanx(const Slice& key, const std::string& start_field, con
       HashesDataKey hashes_data_prefix(key, version, Slice());
       HashesDataKey hashes_start_data_key(key, version, start_field);
       std::string prefix = hashes_data_prefix.Encode().ToString();
+      pstd::GlobMatcher matcher(pattern);
       rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[1]);
       for (iter->Seek(hashes_start_data_key.Encode()); iter->Valid() && rest > 0 && iter->key().starts_with(prefix);
            iter->Next()) {
         ParsedHashesDataKey parsed_hashes_data_key(iter->key());
         std::string field = parsed_hashes_data_key.field().ToString();
-        if (StringMatch(pattern.data(), pattern.size(), field.data(), field.size(), 0) != 0) {
+        if (matcher.Match(field.data(), field.size())) {
           field_values->push_back({field, iter->value().ToString()});
         }
         rest--;
@@ -913,6 +1129,7 @@ Status RedisHashes::PKHScanRange(const Slice& key, const Slice& field_start, con
       HashesDataKey hashes_data_prefix(key, version, Slice());
       HashesDataKey hashes_start_data_key(key, version, field_start);
       std::string prefix = hashes_data_prefix.Encode().ToString();
+      pstd::GlobMatcher matcher(pattern.data(), pattern.size(), false);
       rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[1]);
       for (iter->Seek(start_no_limit ? prefix : hashes_start_data_key.Encode());
            iter->Valid() && remain > 0 && iter->key().starts_with(prefix); iter->Next()) {
@@ -921,7 +1138,7 @@ Status RedisHashes::PKHScanRange(const Slice& key, const Slice& field_start, con
         if (!end_no_limit && field.compare(field_end) > 0) {
           break;
         }
-        if (StringMatch(pattern.data(), pattern.size(), field.data(), field.size(), 0) != 0) {
+        if (matcher.Match(field.data(), field.size())) {
           field_values->push_back({field, iter->value().ToString()});
         }
         remain--;
@@ -973,6 +1190,7 @@ Status RedisHashes::PKHRScanRange(const Slice& key, const Slice& field_start, co
       HashesDataKey hashes_data_prefix(key, version, Slice());
       HashesDataKey hashes_start_data_key(key, start_key_version, start_key_field);
       std::string prefix = hashes_data_prefix.Encode().ToString();
+      pstd::GlobMatcher matcher(pattern.data(), pattern.size(), false);
       rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[1]);
       for (iter->SeekForPrev(hashes_start_data_key.Encode().ToString());
            iter->Valid() && remain > 0 && iter->key().starts_with(prefix); iter->Prev()) {
@@ -981,7 +1199,7 @@ Status RedisHashes::PKHRScanRange(const Slice& key, const Slice& field_start, co
         if (!end_no_limit && field.compare(field_end) < 0) {
           break;
         }
-        if (StringMatch(pattern.data(), pattern.size(), field.data(), field.size(), 0) != 0) {
+        if (matcher.Match(field.data(), field.size())) {
           field_values->push_back({field, iter->value().ToString()});
         }
         remain--;
@@ -1027,13 +1245,14 @@ Status RedisHashes::PKScanRange(const Slice& key_start, const Slice& key_end, co
     it->Seek(key_start);
   }
 
+  pstd::GlobMatcher matcher(pattern.data(), pattern.size(), false);
   while (it->Valid() && remain > 0 && (end_no_limit || it->key().compare(key_end) <= 0)) {
     ParsedHashesMetaValue parsed_hashes_meta_value(it->value());
     if (parsed_hashes_meta_value.IsStale() || parsed_hashes_meta_value.count() == 0) {
       it->Next();
     } else {
       key = it->key().ToString();
-      if (StringMatch(pattern.data(), pattern.size(), key.data(), key.size(), 0) != 0) {
+      if (matcher.Match(key.data(), key.size())) {
         keys->push_back(key);
       }
       remain--;
@@ -1080,13 +1299,14 @@ Status RedisHashes::PKRScanRange(const Slice& key_start, const Slice& key_end, c
     it->SeekForPrev(key_start);
   }
 
+  pstd::GlobMatcher matcher(pattern.data(), pattern.size(), false);
   while (it->Valid() && remain > 0 && (end_no_limit || it->key().compare(key_end) >= 0)) {
     ParsedHashesMetaValue parsed_hashes_meta_value(it->value());
     if (parsed_hashes_meta_value.IsStale() || parsed_hashes_meta_value.count() == 0) {
       it->Prev();
     } else {
       key = it->key().ToString();
-      if (StringMatch(pattern.data(), pattern.size(), key.data(), key.size(), 0) != 0) {
+      if (matcher.Match(key.data(), key.size())) {
         keys->push_back(key);
       }
       remain--;
@@ -1107,10 +1327,44 @@ Status RedisHashes::PKRScanRange(const Slice& key_start, const Slice& key_end, c
   return Status::OK();
 }
 
+bool RedisHashes::IsValidMetaValue(const Slice& meta_value) {
+  ParsedHashesMetaValue parsed_hashes_meta_value(meta_value);
+  return !parsed_hashes_meta_value.IsStale() && parsed_hashes_meta_value.count() != 0;
+}
+
+Status RedisHashes::ReclaimExpiredKey(const Slice& key, int32_t timestamp, size_t* budget, rocksdb::WriteBatch* batch,
+                                      ExpiredKey* expired_key) {
+  std::string meta_value;
+  Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  if (s.IsNotFound()) {
+    expired_key->obsolete = true;
+    return Status::OK();
+  } else if (!s.ok()) {
+    return s;
+  }
+  ParsedHashesMetaValue parsed_hashes_meta_value(&meta_value);
+  if (parsed_hashes_meta_value.timestamp() != timestamp || !parsed_hashes_meta_value.IsStale()) {
+    expired_key->obsolete = true;
+    return Status::OK();
+  }
+
+  int32_t version = parsed_hashes_meta_value.version();
+  HashesDataKey hashes_data_key(key, version, Slice());
+  if (!DeleteVersionData(handles_[1], key, hashes_data_key.Encode(), budget, batch)) {
+    return Status::OK();
+  }
+  batch->Delete(handles_[0], key);
+  expired_key->before = MetaKeyState(meta_value);
+  expired_key->deleted = true;
+  return Status::OK();
+}
+
 Status RedisHashes::Expire(const Slice& key, int32_t ttl) {
   std::string meta_value;
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   if (s.ok()) {
     ParsedHashesMetaValue parsed_hashes_meta_value(&meta_value);
     if (parsed_hashes_meta_value.IsStale()) {
@@ -1121,12 +1375,17 @@ Status RedisHashes::Expire(const Slice& key, int32_t ttl) {
 
     if (ttl > 0) {
       parsed_hashes_meta_value.SetRelativeTimestamp(ttl);
-      s = db_->Put(default_write_options_, handles_[0], key, meta_value);
+      after = MetaKeyState(meta_value);
+      s = PutMetaValue(key, meta_value, before, after);
     } else {
       parsed_hashes_meta_value.InitialMetaValue();
-      s = db_->Put(default_write_options_, handles_[0], key, meta_value);
+      after = MetaKeyState(meta_value);
+      s = PutMetaValue(key, meta_value, before, after);
     }
   }
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
   return s;
 }
 
@@ -1134,6 +1393,8 @@ Status RedisHashes::Del(const Slice& key) {
   std::string meta_value;
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   if (s.ok()) {
     ParsedHashesMetaValue parsed_hashes_meta_value(&meta_value);
     if (parsed_hashes_meta_value.IsStale()) {
@@ -1143,10 +1404,14 @@ Status RedisHashes::Del(const Slice& key) {
     } else {
       uint32_t statistic = parsed_hashes_meta_value.count();
       parsed_hashes_meta_value.InitialMetaValue();
-      s = db_->Put(default_write_options_, handles_[0], key, meta_value);
+      after = MetaKeyState(meta_value);
+      s = PutMetaValue(key, meta_value, before, after);
       UpdateSpecificKeyStatistics(key.ToString(), statistic);
     }
   }
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
   return s;
 }
 
@@ -1160,9 +1425,12 @@ bool RedisHashes::Scan(const std::string& start_key, const std::string& pattern,
   iterator_options.snapshot = snapshot;
   iterator_options.fill_cache = false;
 
+  pstd::GlobMatcher matcher(pattern);
+  ScanRange range(matcher);
+  range.Bound(&iterator_options);
   rocksdb::Iterator* it = db_->NewIterator(iterator_options, handles_[0]);
 
-  it->Seek(start_key);
+  it->Seek(range.SeekKey(start_key));
   while (it->Valid() && (*count) > 0) {
     ParsedHashesMetaValue parsed_meta_value(it->value());
     if (parsed_meta_value.IsStale() || parsed_meta_value.count() == 0) {
@@ -1170,7 +1438,7 @@ bool RedisHashes::Scan(const std::string& start_key, const std::string& pattern,
       continue;
     } else {
       meta_key = it->key().ToString();
-      if (StringMatch(pattern.data(), pattern.size(), meta_key.data(), meta_key.size(), 0) != 0) {
+      if (matcher.Match(meta_key.data(), meta_key.size())) {
         keys->push_back(meta_key);
       }
       (*count)--;
@@ -1178,8 +1446,7 @@ bool RedisHashes::Scan(const std::string& start_key, const std::string& pattern,
     }
   }
 
-  std::string prefix = isTailWildcard(pattern) ? pattern.substr(0, pattern.size() - 1) : "";
-  if (it->Valid() && (it->key().compare(prefix) <= 0 || it->key().starts_with(prefix))) {
+  if (it->Valid()) {
     *next_key = it->key().ToString();
     is_finish = false;
   } else {
@@ -1229,6 +1496,8 @@ Status RedisHashes::Expireat(const Slice& key, int32_t timestamp) {
   std::string meta_value;
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   if (s.ok()) {
     ParsedHashesMetaValue parsed_hashes_meta_value(&meta_value);
     if (parsed_hashes_meta_value.IsStale()) {
@@ -1241,9 +1510,13 @@ Status RedisHashes::Expireat(const Slice& key, int32_t timestamp) {
       } else {
         parsed_hashes_meta_value.InitialMetaValue();
       }
-      s = db_->Put(default_write_options_, handles_[0], key, meta_value);
+      after = MetaKeyState(meta_value);
+      s = PutMetaValue(key, meta_value, before, after);
     }
   }
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
   return s;
 }
 
@@ -1251,6 +1524,8 @@ Status RedisHashes::Persist(const Slice& key) {
   std::string meta_value;
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   if (s.ok()) {
     ParsedHashesMetaValue parsed_hashes_meta_value(&meta_value);
     if (parsed_hashes_meta_value.IsStale()) {
@@ -1263,10 +1538,14 @@ Status RedisHashes::Persist(const Slice& key) {
         return Status::NotFound("Not have an associated timeout");
       } else {
         parsed_hashes_meta_value.set_timestamp(0);
-        s = db_->Put(default_write_options_, handles_[0], key, meta_value);
+        after = MetaKeyState(meta_value);
+        s = PutMetaValue(key, meta_value, before, after);
       }
     }
   }
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
   return s;
 }
 
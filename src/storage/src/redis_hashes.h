@@ -69,6 +69,14 @@ class RedisHashes : public Redis {
 
   // Iterate all data
   void ScanDatabase();
+
+ protected:
+  bool IsValidMetaValue(const Slice& meta_value) override;
+  // Reads the fields and values of key at version
+  Status GetFieldValues(const rocksdb::ReadOptions& read_options, const Slice& key, int32_t version,
+                        std::vector<FieldValue>* fvs);
+  Status ReclaimExpiredKey(const Slice& key, int32_t timestamp, size_t* budget, rocksdb::WriteBatch* batch,
+                           ExpiredKey* expired_key) override;
 };
 
 }  //  namespace storage
@@ -8,11 +8,14 @@
 #include <fmt/core.h>
 #include <glog/logging.h>
 
+#include "src/lists_chunk_format.h"
 #include "src/lists_filter.h"
 #include "src/redis_lists.h"
+#include "src/scan_range.h"
 #include "src/scope_record_lock.h"
 #include "src/scope_snapshot.h"
 #include "storage/util.h"
+#include "pstd/include/pstd_glob.h"
 
 namespace storage {
 
@@ -23,9 +26,16 @@ const rocksdb::Comparator* ListsDataKeyComparator() {
 
 RedisLists::RedisLists(Storage* const s, const DataType& type) : Redis(s, type) {}
 
+// The state of a key whose meta value was read
+static KeyState MetaKeyState(const Slice& meta_value) {
+  ParsedListsMetaValue parsed_meta_value(meta_value);
+  return {parsed_meta_value.count() != 0, parsed_meta_value.timestamp()};
+}
+
 Status RedisLists::Open(const StorageOptions& storage_options, const std::string& db_path) {
   statistics_store_->SetCapacity(storage_options.statistics_max_size);
   small_compaction_threshold_ = storage_options.small_compaction_threshold;
+  lists_chunk_size_ = storage_options.lists_chunk_size;
 
   rocksdb::Options ops(storage_options.options);
   Status s = rocksdb::DB::Open(ops, db_path, &db_);
@@ -45,10 +55,15 @@ Status RedisLists::Open(const StorageOptions& storage_options, const std::string
 
   // Open
   rocksdb::DBOptions db_ops(storage_options.options);
+  // expire_cf is missing in databases created by older versions
+  db_ops.create_missing_column_families = true;
   rocksdb::ColumnFamilyOptions meta_cf_ops(storage_options.options);
   rocksdb::ColumnFamilyOptions data_cf_ops(storage_options.options);
-  meta_cf_ops.compaction_filter_factory = std::make_shared<ListsMetaFilterFactory>();
-  data_cf_ops.compaction_filter_factory = std::make_shared<ListsDataFilterFactory>(&db_, &handles_);
+  rocksdb::ColumnFamilyOptions expire_cf_ops(storage_options.options);
+  meta_cf_ops.compaction_filter_factory = std::make_shared<ListsMetaFilterFactory>(&key_statistics_);
+  SetMetaMemtableBloom(&meta_cf_ops);
+  data_cf_ops.compaction_filter_factory =
+      std::make_shared<ListsDataFilterFactory>(&db_, &handles_, &data_filter_statistics_);
   data_cf_ops.comparator = ListsDataKeyComparator();
 
   // use the bloom filter policy to reduce disk reads
@@ -62,12 +77,15 @@ Status RedisLists::Open(const StorageOptions& storage_options, const std::string
   }
   meta_cf_ops.table_factory.reset(rocksdb::NewBlockBasedTableFactory(meta_cf_table_ops));
   data_cf_ops.table_factory.reset(rocksdb::NewBlockBasedTableFactory(data_cf_table_ops));
+  SetExpireIndexOptions(&expire_cf_ops);
 
   std::vector<rocksdb::ColumnFamilyDescriptor> column_families;
   // Meta CF
   column_families.emplace_back(rocksdb::kDefaultColumnFamilyName, meta_cf_ops);
   // Data CF
   column_families.emplace_back("data_cf", data_cf_ops);
+  // Expire CF
+  column_families.emplace_back(kExpireIndexColumnFamilyName, expire_cf_ops);
   return rocksdb::DB::Open(db_ops, db_path, column_families, &handles_, &db_);
 }
 
@@ -96,6 +114,10 @@ Status RedisLists::ScanKeyNum(KeyInfo* key_info) {
   uint64_t ttl_sum = 0;
   uint64_t invaild_keys = 0;
 
+  // Writes made from here on are applied on top of the scanned statistics
+  KeyStatistics scanned;
+  uint64_t recount = key_statistics_.StartRecount();
+
   rocksdb::ReadOptions iterator_options;
   const rocksdb::Snapshot* snapshot;
   ScopeSnapshot ss(db_, &snapshot);
@@ -108,6 +130,7 @@ Status RedisLists::ScanKeyNum(KeyInfo* key_info) {
   rocksdb::Iterator* iter = db_->NewIterator(iterator_options, handles_[0]);
   for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
     ParsedListsMetaValue parsed_lists_meta_value(iter->value());
+    scanned.Update(KeyState(), MetaKeyState(iter->value()));
     if (parsed_lists_meta_value.IsStale() || parsed_lists_meta_value.count() == 0) {
       invaild_keys++;
     } else {
@@ -119,6 +142,7 @@ Status RedisLists::ScanKeyNum(KeyInfo* key_info) {
     }
   }
   delete iter;
+  key_statistics_.FinishRecount(recount, &scanned);
 
   key_info->keys = keys;
   key_info->expires = expires;
@@ -135,12 +159,15 @@ Status RedisLists::ScanKeys(const std::string& pattern, std::vector<std::string>
   iterator_options.snapshot = snapshot;
   iterator_options.fill_cache = false;
 
+  pstd::GlobMatcher matcher(pattern);
+  ScanRange range(matcher);
+  range.Bound(&iterator_options);
   rocksdb::Iterator* iter = db_->NewIterator(iterator_options, handles_[0]);
-  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+  for (iter->Seek(range.prefix()); iter->Valid(); iter->Next()) {
     ParsedListsMetaValue parsed_lists_meta_value(iter->value());
     if (!parsed_lists_meta_value.IsStale() && parsed_lists_meta_value.count() != 0) {
       key = iter->key().ToString();
-      if (StringMatch(pattern.data(), pattern.size(), key.data(), key.size(), 0) != 0) {
+      if (matcher.Match(key.data(), key.size())) {
         keys->push_back(key);
       }
     }
@@ -161,14 +188,19 @@ Status RedisLists::PKPatternMatchDel(const std::string& pattern, int32_t* ret) {
   int32_t total_delete = 0;
   Status s;
   rocksdb::WriteBatch batch;
+  std::vector<KeyState> befores;
+  pstd::GlobMatcher matcher(pattern);
+  ScanRange range(matcher);
+  range.Bound(&iterator_options);
   rocksdb::Iterator* iter = db_->NewIterator(iterator_options, handles_[0]);
-  iter->SeekToFirst();
+  iter->Seek(range.prefix());
   while (iter->Valid()) {
     key = iter->key().ToString();
     meta_value = iter->value().ToString();
     ParsedListsMetaValue parsed_lists_meta_value(&meta_value);
     if (!parsed_lists_meta_value.IsStale() && (parsed_lists_meta_value.count() != 0U) &&
-        (StringMatch(pattern.data(), pattern.size(), key.data(), key.size(), 0) != 0)) {
+        matcher.Match(key.data(), key.size())) {
+      befores.push_back(MetaKeyState(meta_value));
       parsed_lists_meta_value.InitialMetaValue();
       batch.Put(handles_[0], key, meta_value);
     }
@@ -177,6 +209,10 @@ Status RedisLists::PKPatternMatchDel(const std::string& pattern, int32_t* ret) {
       if (s.ok()) {
         total_delete += static_cast<int32_t>(batch.Count());
         batch.Clear();
+        for (const auto& before : befores) {
+          key_statistics_.Update(before, KeyState());
+        }
+        befores.clear();
       } else {
         *ret = total_delete;
         return s;
@@ -189,6 +225,10 @@ Status RedisLists::PKPatternMatchDel(const std::string& pattern, int32_t* ret) {
     if (s.ok()) {
       total_delete += static_cast<int32_t>(batch.Count());
       batch.Clear();
+      for (const auto& before : befores) {
+        key_statistics_.Update(before, KeyState());
+      }
+      befores.clear();
     }
   }
 
@@ -211,6 +251,17 @@ Status RedisLists::LIndex(const Slice& key, int64_t index, std::string* element)
       return Status::NotFound("Stale");
     } else if (parsed_lists_meta_value.count() == 0) {
       return Status::NotFound();
+    } else if (IsChunkedListsUserValue(parsed_lists_meta_value.user_value())) {
+      auto size = static_cast<int64_t>(parsed_lists_meta_value.count());
+      if (index >= size || index < -size) {
+        return Status::NotFound();
+      }
+      ChunkedList list(db_, handles_[1], read_options, key, version, lists_chunk_size_);
+      s = list.Init(parsed_lists_meta_value.user_value());
+      if (s.ok()) {
+        s = list.Index(index >= 0 ? index : size + index, element);
+      }
+      return s;
     } else {
       std::string tmp_element;
       uint64_t target_index =
@@ -236,12 +287,38 @@ Status RedisLists::LInsert(const Slice& key, const BeforeOrAfter& before_or_afte
   ScopeRecordLock l(lock_mgr_, key);
   std::string meta_value;
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
   if (s.ok()) {
     ParsedListsMetaValue parsed_lists_meta_value(&meta_value);
     if (parsed_lists_meta_value.IsStale()) {
       return Status::NotFound("Stale");
     } else if (parsed_lists_meta_value.count() == 0) {
       return Status::NotFound();
+    } else if (IsChunkedListsUserValue(parsed_lists_meta_value.user_value())) {
+      uint64_t pivot_index = 0;
+      ChunkedList list(db_, handles_[1], default_read_options_, key, parsed_lists_meta_value.version(),
+                       lists_chunk_size_);
+      s = list.Init(parsed_lists_meta_value.user_value());
+      if (s.ok()) {
+        s = list.Find(pivot, &pivot_index);
+      }
+      if (s.IsNotFound()) {
+        *ret = -1;
+        return s;
+      } else if (s.ok()) {
+        s = list.Insert(before_or_after == Before ? pivot_index : pivot_index + 1, value);
+      }
+      if (!s.ok()) {
+        return s;
+      }
+      FlushChunkedList(key, &list, &meta_value, &batch);
+      *ret = static_cast<int64_t>(list.size());
+      s = db_->Write(default_write_options_, &batch);
+      if (s.ok()) {
+        key_statistics_.Update(before, MetaKeyState(meta_value));
+      }
+      UpdateSpecificKeyStatistics(key.ToString(), list.modified());
+      return s;
     } else {
       bool find_pivot = false;
       uint64_t pivot_index = 0;
@@ -316,7 +393,11 @@ Status RedisLists::LInsert(const Slice& key, const BeforeOrAfter& before_or_afte
         ListsDataKey lists_target_key(key, version, target_index);
         batch.Put(handles_[1], lists_target_key.Encode(), value);
         *ret = static_cast<int32_t>(parsed_lists_meta_value.count());
-        return db_->Write(default_write_options_, &batch);
+        s = db_->Write(default_write_options_, &batch);
+        if (s.ok()) {
+          key_statistics_.Update(before, MetaKeyState(meta_value));
+        }
+        return s;
       }
     }
   } else if (s.IsNotFound()) {
@@ -352,12 +433,25 @@ Status RedisLists::LPop(const Slice& key, int64_t count, std::vector<std::string
 
   std::string meta_value;
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
   if (s.ok()) {
     ParsedListsMetaValue parsed_lists_meta_value(&meta_value);
     if (parsed_lists_meta_value.IsStale()) {
       return Status::NotFound("Stale");
     } else if (parsed_lists_meta_value.count() == 0) {
       return Status::NotFound();
+    } else if (IsChunkedListsUserValue(parsed_lists_meta_value.user_value())) {
+      ChunkedList list(db_, handles_[1], default_read_options_, key, parsed_lists_meta_value.version(),
+                       lists_chunk_size_);
+      s = list.Init(parsed_lists_meta_value.user_value());
+      if (s.ok()) {
+        s = list.PopFront(count > 0 ? count : 0, elements);
+      }
+      if (!s.ok()) {
+        return s;
+      }
+      FlushChunkedList(key, &list, &meta_value, &batch);
+      statistic = static_cast<uint32_t>(list.modified());
     } else {
       auto size = static_cast<int64_t>(parsed_lists_meta_value.count());
       int32_t version = parsed_lists_meta_value.version();
@@ -381,6 +475,7 @@ Status RedisLists::LPop(const Slice& key, int64_t count, std::vector<std::string
   if (batch.Count() != 0U) {
     s = db_->Write(default_write_options_, &batch);
     if (s.ok()) {
+      key_statistics_.Update(before, MetaKeyState(meta_value));
       batch.Clear();
     }
     UpdateSpecificKeyStatistics(key.ToString(), statistic);
@@ -397,13 +492,29 @@ Status RedisLists::LPush(const Slice& key, const std::vector<std::string>& value
   int32_t version = 0;
   std::string meta_value;
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
   if (s.ok()) {
     ParsedListsMetaValue parsed_lists_meta_value(&meta_value);
+    bool chunked = IsChunkedListsUserValue(parsed_lists_meta_value.user_value());
     if (parsed_lists_meta_value.IsStale() || parsed_lists_meta_value.count() == 0) {
       version = parsed_lists_meta_value.InitialMetaValue();
+      // A recreated list takes the layout of new lists
+      ReplaceListsUserValue(&meta_value, ParsedListsMetaValue::kListsMetaValueSuffixLength, std::string(8, '\0'));
+      chunked = lists_chunk_size_ != 0;
     } else {
       version = parsed_lists_meta_value.version();
     }
+    if (chunked) {
+      s = ChunkedPush(key, values, true, &meta_value, &batch, ret);
+      if (!s.ok()) {
+        return s;
+      }
+      s = db_->Write(default_write_options_, &batch);
+      if (s.ok()) {
+        key_statistics_.Update(before, MetaKeyState(meta_value));
+      }
+      return s;
+    }
     for (const auto& value : values) {
       index = parsed_lists_meta_value.left_index();
       parsed_lists_meta_value.ModifyLeftIndex(1);
@@ -413,6 +524,12 @@ Status RedisLists::LPush(const Slice& key, const std::vector<std::string>& value
     }
     batch.Put(handles_[0], key, meta_value);
     *ret = parsed_lists_meta_value.count();
+  } else if (s.IsNotFound() && lists_chunk_size_ != 0) {
+    meta_value.clear();
+    s = ChunkedPush(key, values, true, &meta_value, &batch, ret);
+    if (!s.ok()) {
+      return s;
+    }
   } else if (s.IsNotFound()) {
     char str[8];
     EncodeFixed64(str, values.size());
@@ -424,12 +541,17 @@ Status RedisLists::LPush(const Slice& key, const std::vector<std::string>& value
       ListsDataKey lists_data_key(key, version, index);
       batch.Put(handles_[1], lists_data_key.Encode(), value);
     }
-    batch.Put(handles_[0], key, lists_meta_value.Encode());
+    meta_value = lists_meta_value.Encode().ToString();
+    batch.Put(handles_[0], key, meta_value);
     *ret = lists_meta_value.right_index() - lists_meta_value.left_index() - 1;
   } else {
     return s;
   }
-  return db_->Write(default_write_options_, &batch);
+  s = db_->Write(default_write_options_, &batch);
+  if (s.ok()) {
+    key_statistics_.Update(before, MetaKeyState(meta_value));
+  }
+  return s;
 }
 
 Status RedisLists::LPushx(const Slice& key, const std::vector<std::string>& values, uint64_t* len) {
@@ -439,12 +561,23 @@ Status RedisLists::LPushx(const Slice& key, const std::vector<std::string>& valu
 
   std::string meta_value;
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
   if (s.ok()) {
     ParsedListsMetaValue parsed_lists_meta_value(&meta_value);
     if (parsed_lists_meta_value.IsStale()) {
       return Status::NotFound("Stale");
     } else if (parsed_lists_meta_value.count() == 0) {
       return Status::NotFound();
+    } else if (IsChunkedListsUserValue(parsed_lists_meta_value.user_value())) {
+      s = ChunkedPush(key, values, true, &meta_value, &batch, len);
+      if (!s.ok()) {
+        return s;
+      }
+      s = db_->Write(default_write_options_, &batch);
+      if (s.ok()) {
+        key_statistics_.Update(before, MetaKeyState(meta_value));
+      }
+      return s;
     } else {
       int32_t version = parsed_lists_meta_value.version();
       for (const auto& value : values) {
@@ -456,7 +589,11 @@ Status RedisLists::LPushx(const Slice& key, const std::vector<std::string>& valu
       }
       batch.Put(handles_[0], key, meta_value);
       *len = parsed_lists_meta_value.count();
-      return db_->Write(default_write_options_, &batch);
+      s = db_->Write(default_write_options_, &batch);
+      if (s.ok()) {
+        key_statistics_.Update(before, MetaKeyState(meta_value));
+      }
+      return s;
     }
   }
   return s;
@@ -477,6 +614,21 @@ Status RedisLists::LRange(const Slice& key, int64_t start, int64_t stop, std::ve
       return Status::NotFound("Stale");
     } else if (parsed_lists_meta_value.count() == 0) {
       return Status::NotFound();
+    } else if (IsChunkedListsUserValue(parsed_lists_meta_value.user_value())) {
+      auto size = static_cast<int64_t>(parsed_lists_meta_value.count());
+      int64_t start_index = start >= 0 ? start : size + start;
+      int64_t stop_index = stop >= 0 ? stop : size + stop;
+      start_index = start_index < 0 ? 0 : start_index;
+      stop_index = stop_index >= size ? size - 1 : stop_index;
+      if (start_index > stop_index) {
+        return Status::OK();
+      }
+      ChunkedList list(db_, handles_[1], read_options, key, parsed_lists_meta_value.version(), lists_chunk_size_);
+      s = list.Init(parsed_lists_meta_value.user_value());
+      if (s.ok()) {
+        s = list.Range(start_index, stop_index, ret);
+      }
+      return s;
     } else {
       int32_t version = parsed_lists_meta_value.version();
       uint64_t origin_left_index = parsed_lists_meta_value.left_index() + 1;
@@ -516,12 +668,32 @@ Status RedisLists::LRem(const Slice& key, int64_t count, const Slice& value, uin
   ScopeRecordLock l(lock_mgr_, key);
   std::string meta_value;
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
   if (s.ok()) {
     ParsedListsMetaValue parsed_lists_meta_value(&meta_value);
     if (parsed_lists_meta_value.IsStale()) {
       return Status::NotFound("Stale");
     } else if (parsed_lists_meta_value.count() == 0) {
       return Status::NotFound();
+    } else if (IsChunkedListsUserValue(parsed_lists_meta_value.user_value())) {
+      ChunkedList list(db_, handles_[1], default_read_options_, key, parsed_lists_meta_value.version(),
+                       lists_chunk_size_);
+      s = list.Init(parsed_lists_meta_value.user_value());
+      if (s.ok()) {
+        s = list.Remove(count, value, ret);
+      }
+      if (!s.ok()) {
+        return s;
+      } else if (*ret == 0) {
+        return Status::NotFound();
+      }
+      FlushChunkedList(key, &list, &meta_value, &batch);
+      s = db_->Write(default_write_options_, &batch);
+      if (s.ok()) {
+        key_statistics_.Update(before, MetaKeyState(meta_value));
+      }
+      UpdateSpecificKeyStatistics(key.ToString(), list.modified());
+      return s;
     } else {
       uint64_t current_index;
       std::vector<uint64_t> target_index;
@@ -618,7 +790,11 @@ Status RedisLists::LRem(const Slice& key, int64_t count, const Slice& value, uin
           batch.Delete(handles_[1], lists_data_key.Encode());
         }
         *ret = target_index.size();
-        return db_->Write(default_write_options_, &batch);
+        s = db_->Write(default_write_options_, &batch);
+        if (s.ok()) {
+          key_statistics_.Update(before, MetaKeyState(meta_value));
+        }
+        return s;
       }
     }
   } else if (s.IsNotFound()) {
@@ -632,12 +808,35 @@ Status RedisLists::LSet(const Slice& key, int64_t index, const Slice& value) {
   ScopeRecordLock l(lock_mgr_, key);
   std::string meta_value;
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
   if (s.ok()) {
     ParsedListsMetaValue parsed_lists_meta_value(&meta_value);
     if (parsed_lists_meta_value.IsStale()) {
       return Status::NotFound("Stale");
     } else if (parsed_lists_meta_value.count() == 0) {
       return Status::NotFound();
+    } else if (IsChunkedListsUserValue(parsed_lists_meta_value.user_value())) {
+      auto size = static_cast<int64_t>(parsed_lists_meta_value.count());
+      if (index >= size || index < -size) {
+        return Status::Corruption("index out of range");
+      }
+      rocksdb::WriteBatch batch;
+      ChunkedList list(db_, handles_[1], default_read_options_, key, parsed_lists_meta_value.version(),
+                       lists_chunk_size_);
+      s = list.Init(parsed_lists_meta_value.user_value());
+      if (s.ok()) {
+        s = list.Set(index >= 0 ? index : size + index, value);
+      }
+      if (!s.ok()) {
+        return s;
+      }
+      FlushChunkedList(key, &list, &meta_value, &batch);
+      s = db_->Write(default_write_options_, &batch);
+      if (s.ok()) {
+        key_statistics_.Update(before, MetaKeyState(meta_value));
+      }
+      UpdateSpecificKeyStatistics(key.ToString(), list.modified());
+      return s;
     } else {
       int32_t version = parsed_lists_meta_value.version();
       uint64_t target_index =
@@ -663,6 +862,7 @@ Status RedisLists::LTrim(const Slice& key, int64_t start, int64_t stop) {
   uint32_t statistic = 0;
   std::string meta_value;
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
   if (s.ok()) {
     ParsedListsMetaValue parsed_lists_meta_value(&meta_value);
     int32_t version = parsed_lists_meta_value.version();
@@ -670,6 +870,27 @@ Status RedisLists::LTrim(const Slice& key, int64_t start, int64_t stop) {
       return Status::NotFound("Stale");
     } else if (parsed_lists_meta_value.count() == 0) {
       return Status::NotFound();
+    } else if (IsChunkedListsUserValue(parsed_lists_meta_value.user_value())) {
+      auto size = static_cast<int64_t>(parsed_lists_meta_value.count());
+      int64_t start_index = start >= 0 ? start : size + start;
+      int64_t stop_index = stop >= 0 ? stop : size + stop;
+      start_index = start_index < 0 ? 0 : start_index;
+      stop_index = stop_index >= size ? size - 1 : stop_index;
+      if (start_index > stop_index) {
+        parsed_lists_meta_value.InitialMetaValue();
+        batch.Put(handles_[0], key, meta_value);
+      } else {
+        ChunkedList list(db_, handles_[1], default_read_options_, key, version, lists_chunk_size_);
+        s = list.Init(parsed_lists_meta_value.user_value());
+        if (s.ok()) {
+          s = list.Trim(start_index, stop_index);
+        }
+        if (!s.ok()) {
+          return s;
+        }
+        FlushChunkedList(key, &list, &meta_value, &batch);
+        statistic = static_cast<uint32_t>(list.modified());
+      }
     } else {
       uint64_t origin_left_index = parsed_lists_meta_value.left_index() + 1;
       uint64_t origin_right_index = parsed_lists_meta_value.right_index() - 1;
@@ -711,6 +932,9 @@ Status RedisLists::LTrim(const Slice& key, int64_t start, int64_t stop) {
     return s;
   }
   s = db_->Write(default_write_options_, &batch);
+  if (s.ok()) {
+    key_statistics_.Update(before, MetaKeyState(meta_value));
+  }
   UpdateSpecificKeyStatistics(key.ToString(), statistic);
   return s;
 }
@@ -724,12 +948,25 @@ Status RedisLists::RPop(const Slice& key, int64_t count, std::vector<std::string
 
   std::string meta_value;
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
   if (s.ok()) {
     ParsedListsMetaValue parsed_lists_meta_value(&meta_value);
     if (parsed_lists_meta_value.IsStale()) {
       return Status::NotFound("Stale");
     } else if (parsed_lists_meta_value.count() == 0) {
       return Status::NotFound();
+    } else if (IsChunkedListsUserValue(parsed_lists_meta_value.user_value())) {
+      ChunkedList list(db_, handles_[1], default_read_options_, key, parsed_lists_meta_value.version(),
+                       lists_chunk_size_);
+      s = list.Init(parsed_lists_meta_value.user_value());
+      if (s.ok()) {
+        s = list.PopBack(count > 0 ? count : 0, elements);
+      }
+      if (!s.ok()) {
+        return s;
+      }
+      FlushChunkedList(key, &list, &meta_value, &batch);
+      statistic = static_cast<uint32_t>(list.modified());
     } else {
       auto size = static_cast<int64_t>(parsed_lists_meta_value.count());
       int32_t version = parsed_lists_meta_value.version();
@@ -753,6 +990,7 @@ Status RedisLists::RPop(const Slice& key, int64_t count, std::vector<std::string
   if (batch.Count() != 0U) {
     s = db_->Write(default_write_options_, &batch);
     if (s.ok()) {
+      key_statistics_.Update(before, MetaKeyState(meta_value));
       batch.Clear();
     }
     UpdateSpecificKeyStatistics(key.ToString(), statistic);
@@ -775,6 +1013,28 @@ Status RedisLists::RPoplpush(const Slice& source, const Slice& destination, std:
         return Status::NotFound("Stale");
       } else if (parsed_lists_meta_value.count() == 0) {
         return Status::NotFound();
+      } else if (IsChunkedListsUserValue(parsed_lists_meta_value.user_value())) {
+        std::vector<std::string> elements;
+        ChunkedList list(db_, handles_[1], default_read_options_, source, parsed_lists_meta_value.version(),
+                         lists_chunk_size_);
+        s = list.Init(parsed_lists_meta_value.user_value());
+        if (s.ok()) {
+          s = list.PopBack(1, &elements);
+        }
+        if (s.ok()) {
+          s = list.PushFront(elements.front());
+        }
+        if (!s.ok()) {
+          return s;
+        }
+        *element = elements.front();
+        if (list.size() == 1) {
+          return Status::OK();
+        }
+        FlushChunkedList(source, &list, &meta_value, &batch);
+        s = db_->Write(default_write_options_, &batch);
+        UpdateSpecificKeyStatistics(source.ToString(), list.modified());
+        return s;
       } else {
         std::string target;
         int32_t version = parsed_lists_meta_value.version();
@@ -811,12 +1071,27 @@ Status RedisLists::RPoplpush(const Slice& source, const Slice& destination, std:
   std::string target;
   std::string source_meta_value;
   s = db_->Get(default_read_options_, handles_[0], source, &source_meta_value);
+  KeyState source_before = s.ok() ? MetaKeyState(source_meta_value) : KeyState();
   if (s.ok()) {
     ParsedListsMetaValue parsed_lists_meta_value(&source_meta_value);
     if (parsed_lists_meta_value.IsStale()) {
       return Status::NotFound("Stale");
     } else if (parsed_lists_meta_value.count() == 0) {
       return Status::NotFound();
+    } else if (IsChunkedListsUserValue(parsed_lists_meta_value.user_value())) {
+      std::vector<std::string> elements;
+      ChunkedList list(db_, handles_[1], default_read_options_, source, parsed_lists_meta_value.version(),
+                       lists_chunk_size_);
+      s = list.Init(parsed_lists_meta_value.user_value());
+      if (s.ok()) {
+        s = list.PopBack(1, &elements);
+      }
+      if (!s.ok()) {
+        return s;
+      }
+      target = elements.front();
+      FlushChunkedList(source, &list, &source_meta_value, &batch);
+      statistic = static_cast<uint32_t>(list.modified());
     } else {
       version = parsed_lists_meta_value.version();
       uint64_t last_node_index = parsed_lists_meta_value.right_index() - 1;
@@ -838,19 +1113,39 @@ Status RedisLists::RPoplpush(const Slice& source, const Slice& destination, std:
 
   std::string destination_meta_value;
   s = db_->Get(default_read_options_, handles_[0], destination, &destination_meta_value);
+  KeyState destination_before = s.ok() ? MetaKeyState(destination_meta_value) : KeyState();
   if (s.ok()) {
     ParsedListsMetaValue parsed_lists_meta_value(&destination_meta_value);
+    bool chunked = IsChunkedListsUserValue(parsed_lists_meta_value.user_value());
     if (parsed_lists_meta_value.IsStale() || parsed_lists_meta_value.count() == 0) {
       version = parsed_lists_meta_value.InitialMetaValue();
+      ReplaceListsUserValue(&destination_meta_value, ParsedListsMetaValue::kListsMetaValueSuffixLength,
+                            std::string(8, '\0'));
+      chunked = lists_chunk_size_ != 0;
     } else {
       version = parsed_lists_meta_value.version();
     }
-    uint64_t target_index = parsed_lists_meta_value.left_index();
-    ListsDataKey lists_data_key(destination, version, target_index);
-    batch.Put(handles_[1], lists_data_key.Encode(), target);
-    parsed_lists_meta_value.ModifyCount(1);
-    parsed_lists_meta_value.ModifyLeftIndex(1);
-    batch.Put(handles_[0], destination, destination_meta_value);
+    if (chunked) {
+      uint64_t len = 0;
+      s = ChunkedPush(destination, {target}, true, &destination_meta_value, &batch, &len);
+      if (!s.ok()) {
+        return s;
+      }
+    } else {
+      uint64_t target_index = parsed_lists_meta_value.left_index();
+      ListsDataKey lists_data_key(destination, version, target_index);
+      batch.Put(handles_[1], lists_data_key.Encode(), target);
+      parsed_lists_meta_value.ModifyCount(1);
+      parsed_lists_meta_value.ModifyLeftIndex(1);
+      batch.Put(handles_[0], destination, destination_meta_value);
+    }
+  } else if (s.IsNotFound() && lists_chunk_size_ != 0) {
+    uint64_t len = 0;
+    destination_meta_value.clear();
+    s = ChunkedPush(destination, {target}, true, &destination_meta_value, &batch, &len);
+    if (!s.ok()) {
+      return s;
+    }
   } else if (s.IsNotFound()) {
     char str[8];
     EncodeFixed64(str, 1);
@@ -860,7 +1155,8 @@ Status RedisLists::RPoplpush(const Slice& source, const Slice& destination, std:
     ListsDataKey lists_data_key(destination, version, target_index);
     batch.Put(handles_[1], lists_data_key.Encode(), target);
     lists_meta_value.ModifyLeftIndex(1);
-    batch.Put(handles_[0], destination, lists_meta_value.Encode());
+    destination_meta_value = lists_meta_value.Encode().ToString();
+    batch.Put(handles_[0], destination, destination_meta_value);
   } else {
     return s;
   }
@@ -868,6 +1164,8 @@ Status RedisLists::RPoplpush(const Slice& source, const Slice& destination, std:
   s = db_->Write(default_write_options_, &batch);
   UpdateSpecificKeyStatistics(source.ToString(), statistic);
   if (s.ok()) {
+    key_statistics_.Update(source_before, MetaKeyState(source_meta_value));
+    key_statistics_.Update(destination_before, MetaKeyState(destination_meta_value));
     *element = target;
   }
   return s;
@@ -876,18 +1174,35 @@ Status RedisLists::RPoplpush(const Slice& source, const Slice& destination, std:
 Status RedisLists::RPush(const Slice& key, const std::vector<std::string>& values, uint64_t* ret) {
   *ret = 0;
   rocksdb::WriteBatch batch;
+  ScopeRecordLock l(lock_mgr_, key);
 
   uint64_t index = 0;
   int32_t version = 0;
   std::string meta_value;
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
   if (s.ok()) {
     ParsedListsMetaValue parsed_lists_meta_value(&meta_value);
+    bool chunked = IsChunkedListsUserValue(parsed_lists_meta_value.user_value());
     if (parsed_lists_meta_value.IsStale() || parsed_lists_meta_value.count() == 0) {
       version = parsed_lists_meta_value.InitialMetaValue();
+      // A recreated list takes the layout of new lists
+      ReplaceListsUserValue(&meta_value, ParsedListsMetaValue::kListsMetaValueSuffixLength, std::string(8, '\0'));
+      chunked = lists_chunk_size_ != 0;
     } else {
       version = parsed_lists_meta_value.version();
     }
+    if (chunked) {
+      s = ChunkedPush(key, values, false, &meta_value, &batch, ret);
+      if (!s.ok()) {
+        return s;
+      }
+      s = db_->Write(default_write_options_, &batch);
+      if (s.ok()) {
+        key_statistics_.Update(before, MetaKeyState(meta_value));
+      }
+      return s;
+    }
     for (const auto& value : values) {
       index = parsed_lists_meta_value.right_index();
       parsed_lists_meta_value.ModifyRightIndex(1);
@@ -897,6 +1212,12 @@ Status RedisLists::RPush(const Slice& key, const std::vector<std::string>& value
     }
     batch.Put(handles_[0], key, meta_value);
     *ret = parsed_lists_meta_value.count();
+  } else if (s.IsNotFound() && lists_chunk_size_ != 0) {
+    meta_value.clear();
+    s = ChunkedPush(key, values, false, &meta_value, &batch, ret);
+    if (!s.ok()) {
+      return s;
+    }
   } else if (s.IsNotFound()) {
     char str[8];
     EncodeFixed64(str, values.size());
@@ -908,12 +1229,17 @@ Status RedisLists::RPush(const Slice& key, const std::vector<std::string>& value
       ListsDataKey lists_data_key(key, version, index);
       batch.Put(handles_[1], lists_data_key.Encode(), value);
     }
-    batch.Put(handles_[0], key, lists_meta_value.Encode());
+    meta_value = lists_meta_value.Encode().ToString();
+    batch.Put(handles_[0], key, meta_value);
     *ret = lists_meta_value.right_index() - lists_meta_value.left_index() - 1;
   } else {
     return s;
   }
-  return db_->Write(default_write_options_, &batch);
+  s = db_->Write(default_write_options_, &batch);
+  if (s.ok()) {
+    key_statistics_.Update(before, MetaKeyState(meta_value));
+  }
+  return s;
 }
 
 Status RedisLists::RPushx(const Slice& key, const std::vector<std::string>& values, uint64_t* len) {
@@ -923,12 +1249,23 @@ Status RedisLists::RPushx(const Slice& key, const std::vector<std::string>& valu
   ScopeRecordLock l(lock_mgr_, key);
   std::string meta_value;
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
   if (s.ok()) {
     ParsedListsMetaValue parsed_lists_meta_value(&meta_value);
     if (parsed_lists_meta_value.IsStale()) {
       return Status::NotFound("Stale");
     } else if (parsed_lists_meta_value.count() == 0) {
       return Status::NotFound();
+    } else if (IsChunkedListsUserValue(parsed_lists_meta_value.user_value())) {
+      s = ChunkedPush(key, values, false, &meta_value, &batch, len);
+      if (!s.ok()) {
+        return s;
+      }
+      s = db_->Write(default_write_options_, &batch);
+      if (s.ok()) {
+        key_statistics_.Update(before, MetaKeyState(meta_value));
+      }
+      return s;
     } else {
       int32_t version = parsed_lists_meta_value.version();
       for (const auto& value : values) {
@@ -940,12 +1277,62 @@ Status RedisLists::RPushx(const Slice& key, const std::vector<std::string>& valu
       }
       batch.Put(handles_[0], key, meta_value);
       *len = parsed_lists_meta_value.count();
-      return db_->Write(default_write_options_, &batch);
+      s = db_->Write(default_write_options_, &batch);
+      if (s.ok()) {
+        key_statistics_.Update(before, MetaKeyState(meta_value));
+      }
+      return s;
     }
   }
   return s;
 }
 
+void RedisLists::FlushChunkedList(const Slice& key, ChunkedList* list, std::string* meta_value,
+                                  rocksdb::WriteBatch* batch) {
+  std::string user_value;
+  list->Flush(batch, &user_value);
+  ReplaceListsUserValue(meta_value, ParsedListsMetaValue::kListsMetaValueSuffixLength, user_value);
+  batch->Put(handles_[0], key, *meta_value);
+}
+
+Status RedisLists::ChunkedPush(const Slice& key, const std::vector<std::string>& values, bool front,
+                               std::string* meta_value, rocksdb::WriteBatch* batch, uint64_t* len) {
+  int32_t version = 0;
+  std::string user_value;
+  if (meta_value->empty()) {
+    ListsMetaValue lists_meta_value(Slice());
+    version = lists_meta_value.UpdateVersion();
+  } else {
+    ParsedListsMetaValue parsed_lists_meta_value(meta_value);
+    version = parsed_lists_meta_value.version();
+    user_value = parsed_lists_meta_value.user_value().ToString();
+  }
+
+  ChunkedList list(db_, handles_[1], default_read_options_, key, version, lists_chunk_size_);
+  Status s = list.Init(user_value);
+  for (const auto& value : values) {
+    if (!s.ok()) {
+      return s;
+    }
+    s = front ? list.PushFront(value) : list.PushBack(value);
+  }
+  if (!s.ok()) {
+    return s;
+  }
+
+  if (meta_value->empty()) {
+    list.Flush(batch, &user_value);
+    ListsMetaValue lists_meta_value(user_value);
+    lists_meta_value.set_version(version);
+    meta_value->assign(lists_meta_value.Encode().ToString());
+    batch->Put(handles_[0], key, *meta_value);
+  } else {
+    FlushChunkedList(key, &list, meta_value, batch);
+  }
+  *len = list.size();
+  return Status::OK();
+}
+
 Status RedisLists::PKScanRange(const Slice& key_start, const Slice& key_end, const Slice& pattern, int32_t limit,
                                std::vector<std::string>* keys, std::string* next_key) {
   next_key->clear();
@@ -972,13 +1359,14 @@ Status RedisLists::PKScanRange(const Slice& key_start, const Slice& key_end, con
     it->Seek(key_start);
   }
 
+  pstd::GlobMatcher matcher(pattern.data(), pattern.size(), false);
   while (it->Valid() && remain > 0 && (end_no_limit || it->key().compare(key_end) <= 0)) {
     ParsedListsMetaValue parsed_lists_meta_value(it->value());
     if (parsed_lists_meta_value.IsStale() || parsed_lists_meta_value.count() == 0) {
       it->Next();
     } else {
       key = it->key().ToString();
-      if (StringMatch(pattern.data(), pattern.size(), key.data(), key.size(), 0) != 0) {
+      if (matcher.Match(key.data(), key.size())) {
         keys->push_back(key);
       }
       remain--;
@@ -1025,13 +1413,14 @@ Status RedisLists::PKRScanRange(const Slice& key_start, const Slice& key_end, co
     it->SeekForPrev(key_start);
   }
 
+  pstd::GlobMatcher matcher(pattern.data(), pattern.size(), false);
   while (it->Valid() && remain > 0 && (end_no_limit || it->key().compare(key_end) >= 0)) {
     ParsedListsMetaValue parsed_lists_meta_value(it->value());
     if (parsed_lists_meta_value.IsStale() || parsed_lists_meta_value.count() == 0) {
       it->Prev();
     } else {
       key = it->key().ToString();
-      if (StringMatch(pattern.data(), pattern.size(), key.data(), key.size(), 0) != 0) {
+      if (matcher.Match(key.data(), key.size())) {
         keys->push_back(key);
       }
       remain--;
@@ -1052,10 +1441,45 @@ Status RedisLists::PKRScanRange(const Slice& key_start, const Slice& key_end, co
   return Status::OK();
 }
 
+bool RedisLists::IsValidMetaValue(const Slice& meta_value) {
+  ParsedListsMetaValue parsed_lists_meta_value(meta_value);
+  return !parsed_lists_meta_value.IsStale() && parsed_lists_meta_value.count() != 0;
+}
+
+Status RedisLists::ReclaimExpiredKey(const Slice& key, int32_t timestamp, size_t* budget, rocksdb::WriteBatch* batch,
+                                     ExpiredKey* expired_key) {
+  std::string meta_value;
+  Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  if (s.IsNotFound()) {
+    expired_key->obsolete = true;
+    return Status::OK();
+  } else if (!s.ok()) {
+    return s;
+  }
+  ParsedListsMetaValue parsed_lists_meta_value(&meta_value);
+  if (parsed_lists_meta_value.timestamp() != timestamp || !parsed_lists_meta_value.IsStale()) {
+    expired_key->obsolete = true;
+    return Status::OK();
+  }
+
+  int32_t version = parsed_lists_meta_value.version();
+  // Plain and chunked lists alike, the data keys start at index 0
+  ListsDataKey lists_data_key(key, version, 0);
+  if (!DeleteVersionData(handles_[1], key, lists_data_key.Encode(), budget, batch)) {
+    return Status::OK();
+  }
+  batch->Delete(handles_[0], key);
+  expired_key->before = MetaKeyState(meta_value);
+  expired_key->deleted = true;
+  return Status::OK();
+}
+
 Status RedisLists::Expire(const Slice& key, int32_t ttl) {
   std::string meta_value;
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   if (s.ok()) {
     ParsedListsMetaValue parsed_lists_meta_value(&meta_value);
     if (parsed_lists_meta_value.IsStale()) {
@@ -1066,12 +1490,17 @@ Status RedisLists::Expire(const Slice& key, int32_t ttl) {
 
     if (ttl > 0) {
       parsed_lists_meta_value.SetRelativeTimestamp(ttl);
-      s = db_->Put(default_write_options_, handles_[0], key, meta_value);
+      after = MetaKeyState(meta_value);
+      s = PutMetaValue(key, meta_value, before, after);
     } else {
       parsed_lists_meta_value.InitialMetaValue();
-      s = db_->Put(default_write_options_, handles_[0], key, meta_value);
+      after = MetaKeyState(meta_value);
+      s = PutMetaValue(key, meta_value, before, after);
     }
   }
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
   return s;
 }
 
@@ -1079,6 +1508,8 @@ Status RedisLists::Del(const Slice& key) {
   std::string meta_value;
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   if (s.ok()) {
     ParsedListsMetaValue parsed_lists_meta_value(&meta_value);
     if (parsed_lists_meta_value.IsStale()) {
@@ -1088,10 +1519,14 @@ Status RedisLists::Del(const Slice& key) {
     } else {
       uint32_t statistic = parsed_lists_meta_value.count();
       parsed_lists_meta_value.InitialMetaValue();
-      s = db_->Put(default_write_options_, handles_[0], key, meta_value);
+      after = MetaKeyState(meta_value);
+      s = PutMetaValue(key, meta_value, before, after);
       UpdateSpecificKeyStatistics(key.ToString(), statistic);
     }
   }
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
   return s;
 }
 
@@ -1105,9 +1540,12 @@ bool RedisLists::Scan(const std::string& start_key, const std::string& pattern,
   iterator_options.snapshot = snapshot;
   iterator_options.fill_cache = false;
 
+  pstd::GlobMatcher matcher(pattern);
+  ScanRange range(matcher);
+  range.Bound(&iterator_options);
   rocksdb::Iterator* it = db_->NewIterator(iterator_options, handles_[0]);
 
-  it->Seek(start_key);
+  it->Seek(range.SeekKey(start_key));
   while (it->Valid() && (*count) > 0) {
     ParsedListsMetaValue parsed_lists_meta_value(it->value());
     if (parsed_lists_meta_value.IsStale() || parsed_lists_meta_value.count() == 0) {
@@ -1115,7 +1553,7 @@ bool RedisLists::Scan(const std::string& start_key, const std::string& pattern,
       continue;
     } else {
       meta_key = it->key().ToString();
-      if (StringMatch(pattern.data(), pattern.size(), meta_key.data(), meta_key.size(), 0) != 0) {
+      if (matcher.Match(meta_key.data(), meta_key.size())) {
         keys->push_back(meta_key);
       }
       (*count)--;
@@ -1123,8 +1561,7 @@ bool RedisLists::Scan(const std::string& start_key, const std::string& pattern,
     }
   }
 
-  std::string prefix = isTailWildcard(pattern) ? pattern.substr(0, pattern.size() - 1) : "";
-  if (it->Valid() && (it->key().compare(prefix) <= 0 || it->key().starts_with(prefix))) {
+  if (it->Valid()) {
     *next_key = it->key().ToString();
     is_finish = false;
   } else {
@@ -1173,6 +1610,8 @@ Status RedisLists::Expireat(const Slice& key, int32_t timestamp) {
   std::string meta_value;
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   if (s.ok()) {
     ParsedListsMetaValue parsed_lists_meta_value(&meta_value);
     if (parsed_lists_meta_value.IsStale()) {
@@ -1185,9 +1624,13 @@ Status RedisLists::Expireat(const Slice& key, int32_t timestamp) {
       } else {
         parsed_lists_meta_value.InitialMetaValue();
       }
-      return db_->Put(default_write_options_, handles_[0], key, meta_value);
+      after = MetaKeyState(meta_value);
+      s = PutMetaValue(key, meta_value, before, after);
     }
   }
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
   return s;
 }
 
@@ -1195,6 +1638,8 @@ Status RedisLists::Persist(const Slice& key) {
   std::string meta_value;
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   if (s.ok()) {
     ParsedListsMetaValue parsed_lists_meta_value(&meta_value);
     if (parsed_lists_meta_value.IsStale()) {
@@ -1207,10 +1652,14 @@ Status RedisLists::Persist(const Slice& key) {
         return Status::NotFound("Not have an associated timeout");
       } else {
         parsed_lists_meta_value.set_timestamp(0);
-        return db_->Put(default_write_options_, handles_[0], key, meta_value);
+        after = MetaKeyState(meta_value);
+        s = PutMetaValue(key, meta_value, before, after);
       }
     }
   }
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
   return s;
 }
 
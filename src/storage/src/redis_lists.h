@@ -11,6 +11,7 @@
 #include <vector>
 
 #include "src/custom_comparator.h"
+#include "src/lists_chunked.h"
 #include "src/redis.h"
 
 namespace storage {
@@ -63,6 +64,22 @@ class RedisLists : public Redis {
 
   // Iterate all data
   void ScanDatabase();
+
+ protected:
+  bool IsValidMetaValue(const Slice& meta_value) override;
+  Status ReclaimExpiredKey(const Slice& key, int32_t timestamp, size_t* budget, rocksdb::WriteBatch* batch,
+                           ExpiredKey* expired_key) override;
+
+ private:
+  // Writes the chunks changed by list and puts meta_value with its new chunk table
+  void FlushChunkedList(const Slice& key, ChunkedList* list, std::string* meta_value, rocksdb::WriteBatch* batch);
+  // Pushes values to the head or the tail of a chunked list, an empty
+  // meta_value creates the list, meta_value is replaced by the new one
+  Status ChunkedPush(const Slice& key, const std::vector<std::string>& values, bool front, std::string* meta_value,
+                     rocksdb::WriteBatch* batch, uint64_t* len);
+
+  // Elements per chunk of the lists created from now on, 0 keeps the plain layout
+  uint32_t lists_chunk_size_ = 0;
 };
 
 }  //  namespace storage
@@ -14,19 +14,27 @@
 #include <fmt/core.h>
 
 #include "src/base_filter.h"
+#include "src/scan_range.h"
 #include "src/scope_record_lock.h"
 #include "src/scope_snapshot.h"
 #include "storage/util.h"
+#include "pstd/include/pstd_glob.h"
 
 namespace storage {
 
 RedisSets::RedisSets(Storage* const s, const DataType& type) : Redis(s, type) {
-  spop_counts_store_ = std::make_unique<LRUCache<std::string, size_t>>();
+  spop_counts_store_ = std::make_unique<ShardedLRUCache<std::string, size_t>>();
   spop_counts_store_->SetCapacity(1000);
 }
 
 RedisSets::~RedisSets() = default;
 
+// The state of a key whose meta value was read
+static KeyState MetaKeyState(const Slice& meta_value) {
+  ParsedSetsMetaValue parsed_meta_value(meta_value);
+  return {parsed_meta_value.count() != 0, parsed_meta_value.timestamp()};
+}
+
 rocksdb::Status RedisSets::Open(const StorageOptions& storage_options, const std::string& db_path) {
   statistics_store_->SetCapacity(storage_options.statistics_max_size);
   small_compaction_threshold_ = storage_options.small_compaction_threshold;
@@ -48,10 +56,15 @@ rocksdb::Status RedisSets::Open(const StorageOptions& storage_options, const std
 
   // Open
   rocksdb::DBOptions db_ops(storage_options.options);
+  // expire_cf is missing in databases created by older versions
+  db_ops.create_missing_column_families = true;
   rocksdb::ColumnFamilyOptions meta_cf_ops(storage_options.options);
   rocksdb::ColumnFamilyOptions member_cf_ops(storage_options.options);
-  meta_cf_ops.compaction_filter_factory = std::make_shared<SetsMetaFilterFactory>();
-  member_cf_ops.compaction_filter_factory = std::make_shared<SetsMemberFilterFactory>(&db_, &handles_);
+  rocksdb::ColumnFamilyOptions expire_cf_ops(storage_options.options);
+  meta_cf_ops.compaction_filter_factory = std::make_shared<SetsMetaFilterFactory>(&key_statistics_);
+  SetMetaMemtableBloom(&meta_cf_ops);
+  member_cf_ops.compaction_filter_factory =
+      std::make_shared<SetsMemberFilterFactory>(&db_, &handles_, &data_filter_statistics_);
 
   // use the bloom filter policy to reduce disk reads
   rocksdb::BlockBasedTableOptions table_ops(storage_options.table_options);
@@ -64,12 +77,15 @@ rocksdb::Status RedisSets::Open(const StorageOptions& storage_options, const std
   }
   meta_cf_ops.table_factory.reset(rocksdb::NewBlockBasedTableFactory(meta_cf_table_ops));
   member_cf_ops.table_factory.reset(rocksdb::NewBlockBasedTableFactory(member_cf_table_ops));
+  SetExpireIndexOptions(&expire_cf_ops);
 
   std::vector<rocksdb::ColumnFamilyDescriptor> column_families;
   // Meta CF
   column_families.emplace_back(rocksdb::kDefaultColumnFamilyName, meta_cf_ops);
   // Member CF
   column_families.emplace_back("member_cf", member_cf_ops);
+  // Expire CF
+  column_families.emplace_back(kExpireIndexColumnFamilyName, expire_cf_ops);
   return rocksdb::DB::Open(db_ops, db_path, column_families, &handles_, &db_);
 }
 
@@ -98,6 +114,10 @@ rocksdb::Status RedisSets::ScanKeyNum(KeyInfo* key_info) {
   uint64_t ttl_sum = 0;
   uint64_t invaild_keys = 0;
 
+  // Writes made from here on are applied on top of the scanned statistics
+  KeyStatistics scanned;
+  uint64_t recount = key_statistics_.StartRecount();
+
   rocksdb::ReadOptions iterator_options;
   const rocksdb::Snapshot* snapshot;
   ScopeSnapshot ss(db_, &snapshot);
@@ -110,6 +130,7 @@ rocksdb::Status RedisSets::ScanKeyNum(KeyInfo* key_info) {
   rocksdb::Iterator* iter = db_->NewIterator(iterator_options, handles_[0]);
   for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
     ParsedSetsMetaValue parsed_sets_meta_value(iter->value());
+    scanned.Update(KeyState(), MetaKeyState(iter->value()));
     if (parsed_sets_meta_value.IsStale() || parsed_sets_meta_value.count() == 0) {
       invaild_keys++;
     } else {
@@ -121,6 +142,7 @@ rocksdb::Status RedisSets::ScanKeyNum(KeyInfo* key_info) {
     }
   }
   delete iter;
+  key_statistics_.FinishRecount(recount, &scanned);
 
   key_info->keys = keys;
   key_info->expires = expires;
@@ -137,12 +159,15 @@ rocksdb::Status RedisSets::ScanKeys(const std::string& pattern, std::vector<std:
   iterator_options.snapshot = snapshot;
   iterator_options.fill_cache = false;
 
+  pstd::GlobMatcher matcher(pattern);
+  ScanRange range(matcher);
+  range.Bound(&iterator_options);
   rocksdb::Iterator* iter = db_->NewIterator(iterator_options, handles_[0]);
-  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+  for (iter->Seek(range.prefix()); iter->Valid(); iter->Next()) {
     ParsedSetsMetaValue parsed_sets_meta_value(iter->value());
     if (!parsed_sets_meta_value.IsStale() && parsed_sets_meta_value.count() != 0) {
       key = iter->key().ToString();
-      if (StringMatch(pattern.data(), pattern.size(), key.data(), key.size(), 0) != 0) {
+      if (matcher.Match(key.data(), key.size())) {
         keys->push_back(key);
       }
     }
@@ -163,14 +188,19 @@ rocksdb::Status RedisSets::PKPatternMatchDel(const std::string& pattern, int32_t
   int32_t total_delete = 0;
   rocksdb::Status s;
   rocksdb::WriteBatch batch;
+  std::vector<KeyState> befores;
+  pstd::GlobMatcher matcher(pattern);
+  ScanRange range(matcher);
+  range.Bound(&iterator_options);
   rocksdb::Iterator* iter = db_->NewIterator(iterator_options, handles_[0]);
-  iter->SeekToFirst();
+  iter->Seek(range.prefix());
   while (iter->Valid()) {
     key = iter->key().ToString();
     meta_value = iter->value().ToString();
     ParsedSetsMetaValue parsed_sets_meta_value(&meta_value);
     if (!parsed_sets_meta_value.IsStale() && (parsed_sets_meta_value.count() != 0) &&
-        (StringMatch(pattern.data(), pattern.size(), key.data(), key.size(), 0) != 0)) {
+        matcher.Match(key.data(), key.size())) {
+      befores.push_back(MetaKeyState(meta_value));
       parsed_sets_meta_value.InitialMetaValue();
       batch.Put(handles_[0], key, meta_value);
     }
@@ -179,6 +209,10 @@ rocksdb::Status RedisSets::PKPatternMatchDel(const std::string& pattern, int32_t
       if (s.ok()) {
         total_delete += static_cast<int32_t>(batch.Count());
         batch.Clear();
+        for (const auto& before : befores) {
+          key_statistics_.Update(before, KeyState());
+        }
+        befores.clear();
       } else {
         *ret = total_delete;
         return s;
@@ -191,6 +225,10 @@ rocksdb::Status RedisSets::PKPatternMatchDel(const std::string& pattern, int32_t
     if (s.ok()) {
       total_delete += static_cast<int32_t>(batch.Count());
       batch.Clear();
+      for (const auto& before : befores) {
+        key_statistics_.Update(before, KeyState());
+      }
+      befores.clear();
     }
   }
 
@@ -213,6 +251,8 @@ rocksdb::Status RedisSets::SAdd(const Slice& key, const std::vector<std::string>
   int32_t version = 0;
   std::string meta_value;
   rocksdb::Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   if (s.ok()) {
     ParsedSetsMetaValue parsed_sets_meta_value(&meta_value);
     if (parsed_sets_meta_value.IsStale() || parsed_sets_meta_value.count() == 0) {
@@ -222,6 +262,7 @@ rocksdb::Status RedisSets::SAdd(const Slice& key, const std::vector<std::string>
       }
       parsed_sets_meta_value.set_count(static_cast<int32_t>(filtered_members.size()));
       batch.Put(handles_[0], key, meta_value);
+      after = MetaKeyState(meta_value);
       for (const auto& member : filtered_members) {
         SetsMemberKey sets_member_key(key, version, member);
         batch.Put(handles_[1], sets_member_key.Encode(), Slice());
@@ -251,6 +292,7 @@ rocksdb::Status RedisSets::SAdd(const Slice& key, const std::vector<std::string>
         }
         parsed_sets_meta_value.ModifyCount(cnt);
         batch.Put(handles_[0], key, meta_value);
+        after = MetaKeyState(meta_value);
       }
     }
   } else if (s.IsNotFound()) {
@@ -259,6 +301,7 @@ rocksdb::Status RedisSets::SAdd(const Slice& key, const std::vector<std::string>
     SetsMetaValue sets_meta_value(Slice(str, sizeof(int32_t)));
     version = sets_meta_value.UpdateVersion();
     batch.Put(handles_[0], key, sets_meta_value.Encode());
+    after = MetaKeyState(sets_meta_value.Encode());
     for (const auto& member : filtered_members) {
       SetsMemberKey sets_member_key(key, version, member);
       batch.Put(handles_[1], sets_member_key.Encode(), Slice());
@@ -267,7 +310,11 @@ rocksdb::Status RedisSets::SAdd(const Slice& key, const std::vector<std::string>
   } else {
     return s;
   }
-  return db_->Write(default_write_options_, &batch);
+  s = db_->Write(default_write_options_, &batch);
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
+  return s;
 }
 
 rocksdb::Status RedisSets::SCard(const Slice& key, int32_t* ret) {
@@ -422,6 +469,8 @@ rocksdb::Status RedisSets::SDiffstore(const Slice& destination, const std::vecto
 
   uint32_t statistic = 0;
   s = db_->Get(read_options, handles_[0], destination, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   if (s.ok()) {
     ParsedSetsMetaValue parsed_sets_meta_value(&meta_value);
     statistic = parsed_sets_meta_value.count();
@@ -431,12 +480,14 @@ rocksdb::Status RedisSets::SDiffstore(const Slice& destination, const std::vecto
       }
     parsed_sets_meta_value.set_count(static_cast<int32_t>(members.size()));
     batch.Put(handles_[0], destination, meta_value);
+    after = MetaKeyState(meta_value);
   } else if (s.IsNotFound()) {
     char str[4];
     EncodeFixed32(str, members.size());
     SetsMetaValue sets_meta_value(Slice(str, sizeof(int32_t)));
     version = sets_meta_value.UpdateVersion();
     batch.Put(handles_[0], destination, sets_meta_value.Encode());
+    after = MetaKeyState(sets_meta_value.Encode());
   } else {
     return s;
   }
@@ -446,6 +497,9 @@ rocksdb::Status RedisSets::SDiffstore(const Slice& destination, const std::vecto
   }
   *ret = static_cast<int32_t>(members.size());
   s = db_->Write(default_write_options_, &batch);
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
   UpdateSpecificKeyStatistics(destination.ToString(), statistic);
   value_to_dest = std::move(members);
   return s;
@@ -608,6 +662,8 @@ rocksdb::Status RedisSets::SInterstore(const Slice& destination, const std::vect
 
   uint32_t statistic = 0;
   s = db_->Get(read_options, handles_[0], destination, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   if (s.ok()) {
     ParsedSetsMetaValue parsed_sets_meta_value(&meta_value);
     statistic = parsed_sets_meta_value.count();
@@ -617,12 +673,14 @@ rocksdb::Status RedisSets::SInterstore(const Slice& destination, const std::vect
     }
     parsed_sets_meta_value.set_count(static_cast<int32_t>(members.size()));
     batch.Put(handles_[0], destination, meta_value);
+    after = MetaKeyState(meta_value);
   } else if (s.IsNotFound()) {
     char str[4];
     EncodeFixed32(str, members.size());
     SetsMetaValue sets_meta_value(Slice(str, sizeof(int32_t)));
     version = sets_meta_value.UpdateVersion();
     batch.Put(handles_[0], destination, sets_meta_value.Encode());
+    after = MetaKeyState(sets_meta_value.Encode());
   } else {
     return s;
   }
@@ -632,6 +690,9 @@ rocksdb::Status RedisSets::SInterstore(const Slice& destination, const std::vect
   }
   *ret = static_cast<int32_t>(members.size());
   s = db_->Write(default_write_options_, &batch);
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
   UpdateSpecificKeyStatistics(destination.ToString(), statistic);
   value_to_dest = std::move(members);
   return s;
@@ -713,6 +774,8 @@ rocksdb::Status RedisSets::SMove(const Slice& source, const Slice& destination,
   }
 
   rocksdb::Status s = db_->Get(default_read_options_, handles_[0], source, &meta_value);
+  KeyState source_before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState source_after = source_before;
   if (s.ok()) {
     ParsedSetsMetaValue parsed_sets_meta_value(&meta_value);
     if (parsed_sets_meta_value.IsStale()) {
@@ -731,6 +794,7 @@ rocksdb::Status RedisSets::SMove(const Slice& source, const Slice& destination,
         }
         parsed_sets_meta_value.ModifyCount(-1);
         batch.Put(handles_[0], source, meta_value);
+        source_after = MetaKeyState(meta_value);
         batch.Delete(handles_[1], sets_member_key.Encode());
         statistic++;
       } else if (s.IsNotFound()) {
@@ -748,12 +812,15 @@ rocksdb::Status RedisSets::SMove(const Slice& source, const Slice& destination,
   }
 
   s = db_->Get(default_read_options_, handles_[0], destination, &meta_value);
+  KeyState destination_before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState destination_after = destination_before;
   if (s.ok()) {
     ParsedSetsMetaValue parsed_sets_meta_value(&meta_value);
     if (parsed_sets_meta_value.IsStale() || parsed_sets_meta_value.count() == 0) {
       version = parsed_sets_meta_value.InitialMetaValue();
       parsed_sets_meta_value.set_count(1);
       batch.Put(handles_[0], destination, meta_value);
+      destination_after = MetaKeyState(meta_value);
       SetsMemberKey sets_member_key(destination, version, member);
       batch.Put(handles_[1], sets_member_key.Encode(), Slice());
     } else {
@@ -767,6 +834,7 @@ rocksdb::Status RedisSets::SMove(const Slice& source, const Slice& destination,
         }
         parsed_sets_meta_value.ModifyCount(1);
         batch.Put(handles_[0], destination, meta_value);
+        destination_after = MetaKeyState(meta_value);
         batch.Put(handles_[1], sets_member_key.Encode(), Slice());
       } else if (!s.ok()) {
         return s;
@@ -778,12 +846,17 @@ rocksdb::Status RedisSets::SMove(const Slice& source, const Slice& destination,
     SetsMetaValue sets_meta_value(Slice(str, sizeof(int32_t)));
     version = sets_meta_value.UpdateVersion();
     batch.Put(handles_[0], destination, sets_meta_value.Encode());
+    destination_after = MetaKeyState(sets_meta_value.Encode());
     SetsMemberKey sets_member_key(destination, version, member);
     batch.Put(handles_[1], sets_member_key.Encode(), Slice());
   } else {
     return s;
   }
   s = db_->Write(default_write_options_, &batch);
+  if (s.ok()) {
+    key_statistics_.Update(source_before, source_after);
+    key_statistics_.Update(destination_before, destination_after);
+  }
   UpdateSpecificKeyStatistics(source.ToString(), 1);
   return s;
 }
@@ -797,6 +870,8 @@ rocksdb::Status RedisSets::SPop(const Slice& key, std::vector<std::string>* memb
 
   uint64_t start_us = pstd::NowMicros();
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   if (s.ok()) {
     ParsedSetsMetaValue parsed_sets_meta_value(&meta_value);
     if (parsed_sets_meta_value.IsStale()) {
@@ -824,6 +899,7 @@ rocksdb::Status RedisSets::SPop(const Slice& key, std::vector<std::string>* memb
         //parsed_sets_meta_value.ModifyCount(-cnt);
         //batch.Put(handles_[0], key, meta_value);
         batch.Delete(handles_[0], key);
+        after = KeyState();
         delete iter;   
 
       } else {
@@ -866,6 +942,7 @@ rocksdb::Status RedisSets::SPop(const Slice& key, std::vector<std::string>* memb
         }
         parsed_sets_meta_value.ModifyCount(static_cast<int32_t>(-cnt));
         batch.Put(handles_[0], key, meta_value);
+        after = MetaKeyState(meta_value);
         delete iter;
 
       }
@@ -882,7 +959,11 @@ rocksdb::Status RedisSets::SPop(const Slice& key, std::vector<std::string>* memb
     *need_compact = true;
     ResetSpopCount(key.ToString());
   }
-  return db_->Write(default_write_options_, &batch);
+  s = db_->Write(default_write_options_, &batch);
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
+  return s;
 }
 
 rocksdb::Status RedisSets::ResetSpopCount(const std::string& key) { return spop_counts_store_->Remove(key); }
@@ -972,6 +1053,8 @@ rocksdb::Status RedisSets::SRem(const Slice& key, const std::vector<std::string>
   uint32_t statistic = 0;
   std::string meta_value;
   rocksdb::Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   if (s.ok()) {
     ParsedSetsMetaValue parsed_sets_meta_value(&meta_value);
     if (parsed_sets_meta_value.IsStale()) {
@@ -1000,6 +1083,7 @@ rocksdb::Status RedisSets::SRem(const Slice& key, const std::vector<std::string>
       }
       parsed_sets_meta_value.ModifyCount(-cnt);
       batch.Put(handles_[0], key, meta_value);
+      after = MetaKeyState(meta_value);
     }
   } else if (s.IsNotFound()) {
     *ret = 0;
@@ -1008,6 +1092,9 @@ rocksdb::Status RedisSets::SRem(const Slice& key, const std::vector<std::string>
     return s;
   }
   s = db_->Write(default_write_options_, &batch);
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
   UpdateSpecificKeyStatistics(key.ToString(), statistic);
   return s;
 }
@@ -1106,6 +1193,8 @@ rocksdb::Status RedisSets::SUnionstore(const Slice& destination, const std::vect
 
   uint32_t statistic = 0;
   s = db_->Get(read_options, handles_[0], destination, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   if (s.ok()) {
     ParsedSetsMetaValue parsed_sets_meta_value(&meta_value);
     statistic = parsed_sets_meta_value.count();
@@ -1115,12 +1204,14 @@ rocksdb::Status RedisSets::SUnionstore(const Slice& destination, const std::vect
     }
     parsed_sets_meta_value.set_count(static_cast<int32_t>(members.size()));
     batch.Put(handles_[0], destination, meta_value);
+    after = MetaKeyState(meta_value);
   } else if (s.IsNotFound()) {
     char str[4];
     EncodeFixed32(str, members.size());
     SetsMetaValue sets_meta_value(Slice(str, sizeof(int32_t)));
     version = sets_meta_value.UpdateVersion();
     batch.Put(handles_[0], destination, sets_meta_value.Encode());
+    after = MetaKeyState(sets_meta_value.Encode());
   } else {
     return s;
   }
@@ -1130,6 +1221,9 @@ rocksdb::Status RedisSets::SUnionstore(const Slice& destination, const std::vect
   }
   *ret = static_cast<int32_t>(members.size());
   s = db_->Write(default_write_options_, &batch);
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
   UpdateSpecificKeyStatistics(destination.ToString(), statistic);
   value_to_dest = std::move(members);
   return s;
@@ -1176,12 +1270,13 @@ rocksdb::Status RedisSets::SScan(const Slice& key, int64_t cursor, const std::st
       SetsMemberKey sets_member_prefix(key, version, sub_member);
       SetsMemberKey sets_member_key(key, version, start_point);
       std::string prefix = sets_member_prefix.Encode().ToString();
+      pstd::GlobMatcher matcher(pattern);
       rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[1]);
       for (iter->Seek(sets_member_key.Encode()); iter->Valid() && rest > 0 && iter->key().starts_with(prefix);
            iter->Next()) {
         ParsedSetsMemberKey parsed_sets_member_key(iter->key());
         std::string member = parsed_sets_member_key.member().ToString();
-        if (StringMatch(pattern.data(), pattern.size(), member.data(), member.size(), 0) != 0) {
+        if (matcher.Match(member.data(), member.size())) {
           members->push_back(member);
         }
         rest--;
@@ -1230,13 +1325,14 @@ rocksdb::Status RedisSets::PKScanRange(const Slice& key_start, const Slice& key_
     it->Seek(key_start);
   }
 
+  pstd::GlobMatcher matcher(pattern.data(), pattern.size(), false);
   while (it->Valid() && remain > 0 && (end_no_limit || it->key().compare(key_end) <= 0)) {
     ParsedSetsMetaValue parsed_meta_value(it->value());
     if (parsed_meta_value.IsStale() || parsed_meta_value.count() == 0) {
       it->Next();
     } else {
       key = it->key().ToString();
-      if (StringMatch(pattern.data(), pattern.size(), key.data(), key.size(), 0) != 0) {
+      if (matcher.Match(key.data(), key.size())) {
         keys->push_back(key);
       }
       remain--;
@@ -1283,13 +1379,14 @@ rocksdb::Status RedisSets::PKRScanRange(const Slice& key_start, const Slice& key
     it->SeekForPrev(key_start);
   }
 
+  pstd::GlobMatcher matcher(pattern.data(), pattern.size(), false);
   while (it->Valid() && remain > 0 && (end_no_limit || it->key().compare(key_end) >= 0)) {
     ParsedSetsMetaValue parsed_sets_meta_value(it->value());
     if (parsed_sets_meta_value.IsStale() || parsed_sets_meta_value.count() == 0) {
       it->Prev();
     } else {
       key = it->key().ToString();
-      if (StringMatch(pattern.data(), pattern.size(), key.data(), key.size(), 0) != 0) {
+      if (matcher.Match(key.data(), key.size())) {
         keys->push_back(key);
       }
       remain--;
@@ -1310,10 +1407,44 @@ rocksdb::Status RedisSets::PKRScanRange(const Slice& key_start, const Slice& key
   return rocksdb::Status::OK();
 }
 
+bool RedisSets::IsValidMetaValue(const Slice& meta_value) {
+  ParsedSetsMetaValue parsed_sets_meta_value(meta_value);
+  return !parsed_sets_meta_value.IsStale() && parsed_sets_meta_value.count() != 0;
+}
+
+Status RedisSets::ReclaimExpiredKey(const Slice& key, int32_t timestamp, size_t* budget, rocksdb::WriteBatch* batch,
+                                    ExpiredKey* expired_key) {
+  std::string meta_value;
+  Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  if (s.IsNotFound()) {
+    expired_key->obsolete = true;
+    return Status::OK();
+  } else if (!s.ok()) {
+    return s;
+  }
+  ParsedSetsMetaValue parsed_sets_meta_value(&meta_value);
+  if (parsed_sets_meta_value.timestamp() != timestamp || !parsed_sets_meta_value.IsStale()) {
+    expired_key->obsolete = true;
+    return Status::OK();
+  }
+
+  int32_t version = parsed_sets_meta_value.version();
+  SetsMemberKey sets_member_key(key, version, Slice());
+  if (!DeleteVersionData(handles_[1], key, sets_member_key.Encode(), budget, batch)) {
+    return Status::OK();
+  }
+  batch->Delete(handles_[0], key);
+  expired_key->before = MetaKeyState(meta_value);
+  expired_key->deleted = true;
+  return Status::OK();
+}
+
 rocksdb::Status RedisSets::Expire(const Slice& key, int32_t ttl) {
   std::string meta_value;
   ScopeRecordLock l(lock_mgr_, key);
   rocksdb::Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   if (s.ok()) {
     ParsedSetsMetaValue parsed_sets_meta_value(&meta_value);
     if (parsed_sets_meta_value.IsStale()) {
@@ -1324,12 +1455,17 @@ rocksdb::Status RedisSets::Expire(const Slice& key, int32_t ttl) {
 
     if (ttl > 0) {
       parsed_sets_meta_value.SetRelativeTimestamp(ttl);
-      s = db_->Put(default_write_options_, handles_[0], key, meta_value);
+      after = MetaKeyState(meta_value);
+      s = PutMetaValue(key, meta_value, before, after);
     } else {
       parsed_sets_meta_value.InitialMetaValue();
-      s = db_->Put(default_write_options_, handles_[0], key, meta_value);
+      after = MetaKeyState(meta_value);
+      s = PutMetaValue(key, meta_value, before, after);
     }
   }
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
   return s;
 }
 
@@ -1337,6 +1473,8 @@ rocksdb::Status RedisSets::Del(const Slice& key) {
   std::string meta_value;
   ScopeRecordLock l(lock_mgr_, key);
   rocksdb::Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   if (s.ok()) {
     ParsedSetsMetaValue parsed_sets_meta_value(&meta_value);
     if (parsed_sets_meta_value.IsStale()) {
@@ -1346,10 +1484,14 @@ rocksdb::Status RedisSets::Del(const Slice& key) {
     } else {
       uint32_t statistic = parsed_sets_meta_value.count();
       parsed_sets_meta_value.InitialMetaValue();
-      s = db_->Put(default_write_options_, handles_[0], key, meta_value);
+      after = MetaKeyState(meta_value);
+      s = PutMetaValue(key, meta_value, before, after);
       UpdateSpecificKeyStatistics(key.ToString(), statistic);
     }
   }
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
   return s;
 }
 
@@ -1363,9 +1505,12 @@ bool RedisSets::Scan(const std::string& start_key, const std::string& pattern, s
   iterator_options.snapshot = snapshot;
   iterator_options.fill_cache = false;
 
+  pstd::GlobMatcher matcher(pattern);
+  ScanRange range(matcher);
+  range.Bound(&iterator_options);
   rocksdb::Iterator* it = db_->NewIterator(iterator_options, handles_[0]);
 
-  it->Seek(start_key);
+  it->Seek(range.SeekKey(start_key));
   while (it->Valid() && (*count) > 0) {
     ParsedSetsMetaValue parsed_meta_value(it->value());
     if (parsed_meta_value.IsStale() || parsed_meta_value.count() == 0) {
@@ -1373,7 +1518,7 @@ bool RedisSets::Scan(const std::string& start_key, const std::string& pattern, s
       continue;
     } else {
       meta_key = it->key().ToString();
-      if (StringMatch(pattern.data(), pattern.size(), meta_key.data(), meta_key.size(), 0) != 0) {
+      if (matcher.Match(meta_key.data(), meta_key.size())) {
         keys->push_back(meta_key);
       }
       (*count)--;
@@ -1381,8 +1526,7 @@ bool RedisSets::Scan(const std::string& start_key, const std::string& pattern, s
     }
   }
 
-  std::string prefix = isTailWildcard(pattern) ? pattern.substr(0, pattern.size() - 1) : "";
-  if (it->Valid() && (it->key().compare(prefix) <= 0 || it->key().starts_with(prefix))) {
+  if (it->Valid()) {
     *next_key = it->key().ToString();
     is_finish = false;
   } else {
@@ -1431,6 +1575,7 @@ rocksdb::Status RedisSets::Expireat(const Slice& key, int32_t timestamp) {
   std::string meta_value;
   ScopeRecordLock l(lock_mgr_, key);
   rocksdb::Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
   if (s.ok()) {
     ParsedSetsMetaValue parsed_sets_meta_value(&meta_value);
     if (parsed_sets_meta_value.IsStale()) {
@@ -1443,7 +1588,12 @@ rocksdb::Status RedisSets::Expireat(const Slice& key, int32_t timestamp) {
       } else {
         parsed_sets_meta_value.InitialMetaValue();
       }
-      return db_->Put(default_write_options_, handles_[0], key, meta_value);
+      KeyState after = MetaKeyState(meta_value);
+      s = PutMetaValue(key, meta_value, before, after);
+      if (s.ok()) {
+        key_statistics_.Update(before, after);
+      }
+      return s;
     }
   }
   return s;
@@ -1453,6 +1603,7 @@ rocksdb::Status RedisSets::Persist(const Slice& key) {
   std::string meta_value;
   ScopeRecordLock l(lock_mgr_, key);
   rocksdb::Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
   if (s.ok()) {
     ParsedSetsMetaValue parsed_sets_meta_value(&meta_value);
     if (parsed_sets_meta_value.IsStale()) {
@@ -1465,7 +1616,12 @@ rocksdb::Status RedisSets::Persist(const Slice& key) {
         return rocksdb::Status::NotFound("Not have an associated timeout");
       } else {
         parsed_sets_meta_value.set_timestamp(0);
-        return db_->Put(default_write_options_, handles_[0], key, meta_value);
+        KeyState after = MetaKeyState(meta_value);
+        s = PutMetaValue(key, meta_value, before, after);
+        if (s.ok()) {
+          key_statistics_.Update(before, after);
+        }
+        return s;
       }
     }
   }
@@ -71,9 +71,14 @@ class RedisSets : public Redis {
   // Iterate all data
   void ScanDatabase();
 
+ protected:
+  bool IsValidMetaValue(const Slice& meta_value) override;
+  Status ReclaimExpiredKey(const Slice& key, int32_t timestamp, size_t* budget, rocksdb::WriteBatch* batch,
+                           ExpiredKey* expired_key) override;
+
  private:
   // For compact in time after multiple spop
-  std::unique_ptr<LRUCache<std::string, size_t>> spop_counts_store_;
+  std::unique_ptr<ShardedLRUCache<std::string, size_t>> spop_counts_store_;
   Status ResetSpopCount(const std::string& key);
   Status AddAndGetSpopCount(const std::string& key, uint64_t* count);
 };
@@ -9,23 +9,68 @@
 #include <climits>
 #include <limits>
 #include <memory>
+#include <unordered_map>
 
 #include <fmt/core.h>
 #include <glog/logging.h>
 #include <iostream>
 
+#include "src/scan_range.h"
 #include "src/scope_record_lock.h"
 #include "src/scope_snapshot.h"
 #include "src/strings_filter.h"
 #include "storage/util.h"
+#include "pstd/include/pstd_glob.h"
 
 namespace storage {
 
 RedisStrings::RedisStrings(Storage* const s, const DataType& type) : Redis(s, type) {}
 
+// The state of a key whose value was read
+static KeyState ValueState(const Slice& value) { return {true, ParsedStringsValue(value).timestamp()}; }
+
+Status RedisStrings::PutValue(const Slice& key, const Slice& value, const KeyState& before) {
+  KeyState after = ValueState(value);
+  Status s;
+  if ((before.exists ? before.timestamp : 0) == after.timestamp) {
+    // Leaves the expire index as it is
+    s = db_->Put(default_write_options_, key, value);
+    InvalidateCachedValue(key);
+  } else {
+    rocksdb::WriteBatch batch;
+    batch.Put(key, value);
+    s = WriteWithExpireIndex(&batch, key, before, after);
+  }
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
+  return s;
+}
+
+Status RedisStrings::DeleteValue(const Slice& key, const KeyState& before) {
+  rocksdb::WriteBatch batch;
+  batch.Delete(key);
+  Status s = WriteWithExpireIndex(&batch, key, before, KeyState());
+  if (s.ok()) {
+    key_statistics_.Update(before, KeyState());
+  }
+  return s;
+}
+
+KeyState RedisStrings::GetKeyState(const Slice& key) {
+  if (!key_statistics_kept_) {
+    return KeyState();
+  }
+  rocksdb::PinnableSlice value;
+  Status s = db_->Get(default_read_options_, db_->DefaultColumnFamily(), key, &value);
+  return s.ok() ? ValueState(value) : KeyState();
+}
+
 Status RedisStrings::Open(const StorageOptions& storage_options, const std::string& db_path) {
+  key_statistics_kept_ = storage_options.exact_key_statistics;
   rocksdb::Options ops(storage_options.options);
-  ops.compaction_filter_factory = std::make_shared<StringsFilterFactory>();
+  ops.compaction_filter_factory = std::make_shared<StringsFilterFactory>(&key_statistics_);
+  SetMetaMemtableBloom(&ops);
 
   // use the bloom filter policy to reduce disk reads
   rocksdb::BlockBasedTableOptions table_ops(storage_options.table_options);
@@ -35,7 +80,15 @@ Status RedisStrings::Open(const StorageOptions& storage_options, const std::stri
   table_ops.filter_policy.reset(rocksdb::NewBloomFilterPolicy(10, true));
   ops.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_ops));
 
-  return rocksdb::DB::Open(ops, db_path, &db_);
+  // expire_cf is missing in databases created by older versions
+  ops.create_missing_column_families = true;
+  rocksdb::ColumnFamilyOptions expire_cf_ops(storage_options.options);
+  SetExpireIndexOptions(&expire_cf_ops);
+
+  std::vector<rocksdb::ColumnFamilyDescriptor> column_families;
+  column_families.emplace_back(rocksdb::kDefaultColumnFamilyName, ops);
+  column_families.emplace_back(kExpireIndexColumnFamilyName, expire_cf_ops);
+  return rocksdb::DB::Open(ops, db_path, column_families, &handles_, &db_);
 }
 
 Status RedisStrings::CompactRange(const rocksdb::Slice* begin, const rocksdb::Slice* end,
@@ -56,6 +109,10 @@ Status RedisStrings::ScanKeyNum(KeyInfo* key_info) {
   uint64_t ttl_sum = 0;
   uint64_t invaild_keys = 0;
 
+  // Writes made from here on are applied on top of the scanned statistics
+  KeyStatistics scanned;
+  uint64_t recount = key_statistics_.StartRecount();
+
   rocksdb::ReadOptions iterator_options;
   const rocksdb::Snapshot* snapshot;
   ScopeSnapshot ss(db_, &snapshot);
@@ -70,6 +127,7 @@ Status RedisStrings::ScanKeyNum(KeyInfo* key_info) {
   rocksdb::Iterator* iter = db_->NewIterator(iterator_options);
   for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
     ParsedStringsValue parsed_strings_value(iter->value());
+    scanned.Update(KeyState(), {true, parsed_strings_value.timestamp()});
     if (parsed_strings_value.IsStale()) {
       invaild_keys++;
     } else {
@@ -81,6 +139,7 @@ Status RedisStrings::ScanKeyNum(KeyInfo* key_info) {
     }
   }
   delete iter;
+  key_statistics_.FinishRecount(recount, &scanned);
 
   key_info->keys = keys;
   key_info->expires = expires;
@@ -97,14 +156,17 @@ Status RedisStrings::ScanKeys(const std::string& pattern, std::vector<std::strin
   iterator_options.snapshot = snapshot;
   iterator_options.fill_cache = false;
 
+  pstd::GlobMatcher matcher(pattern);
+  ScanRange range(matcher);
+  range.Bound(&iterator_options);
   // Note: This is a string type and does not need to pass the column family as
   // a parameter, use the default column family
   rocksdb::Iterator* iter = db_->NewIterator(iterator_options);
-  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+  for (iter->Seek(range.prefix()); iter->Valid(); iter->Next()) {
     ParsedStringsValue parsed_strings_value(iter->value());
     if (!parsed_strings_value.IsStale()) {
       key = iter->key().ToString();
-      if (StringMatch(pattern.data(), pattern.size(), key.data(), key.size(), 0) != 0) {
+      if (matcher.Match(key.data(), key.size())) {
         keys->push_back(key);
       }
     }
@@ -125,21 +187,31 @@ Status RedisStrings::PKPatternMatchDel(const std::string& pattern, int32_t* ret)
   int32_t total_delete = 0;
   Status s;
   rocksdb::WriteBatch batch;
+  std::vector<KeyState> befores;
+  pstd::GlobMatcher matcher(pattern);
+  ScanRange range(matcher);
+  range.Bound(&iterator_options);
   rocksdb::Iterator* iter = db_->NewIterator(iterator_options);
-  iter->SeekToFirst();
+  iter->Seek(range.prefix());
   while (iter->Valid()) {
     key = iter->key().ToString();
     value = iter->value().ToString();
     ParsedStringsValue parsed_strings_value(&value);
-    if (!parsed_strings_value.IsStale() && (StringMatch(pattern.data(), pattern.size(), key.data(), key.size(), 0) != 0)) {
+    if (!parsed_strings_value.IsStale() && matcher.Match(key.data(), key.size())) {
       batch.Delete(key);
+      befores.push_back({true, parsed_strings_value.timestamp()});
     }
     // In order to be more efficient, we use batch deletion here
     if (static_cast<size_t>(batch.Count()) >= BATCH_DELETE_LIMIT) {
       s = db_->Write(default_write_options_, &batch);
+      ClearCachedValues();
       if (s.ok()) {
         total_delete += static_cast<int32_t>(batch.Count());
         batch.Clear();
+        for (const auto& before : befores) {
+          key_statistics_.Update(before, KeyState());
+        }
+        befores.clear();
       } else {
         *ret = total_delete;
         return s;
@@ -149,9 +221,13 @@ Status RedisStrings::PKPatternMatchDel(const std::string& pattern, int32_t* ret)
   }
   if (batch.Count() != 0U) {
     s = db_->Write(default_write_options_, &batch);
+    ClearCachedValues();
     if (s.ok()) {
       total_delete += static_cast<int32_t>( batch.Count());
       batch.Clear();
+      for (const auto& before : befores) {
+        key_statistics_.Update(before, KeyState());
+      }
     }
   }
 
@@ -164,12 +240,13 @@ Status RedisStrings::Append(const Slice& key, const Slice& value, int32_t* ret)
   *ret = 0;
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, key, &old_value);
+  KeyState before = s.ok() ? ValueState(old_value) : KeyState();
   if (s.ok()) {
     ParsedStringsValue parsed_strings_value(&old_value);
     if (parsed_strings_value.IsStale()) {
       *ret = static_cast<int32_t>(value.size());
       StringsValue strings_value(value);
-      return db_->Put(default_write_options_, key, strings_value.Encode());
+      return PutValue(key, strings_value.Encode(), before);
     } else {
       int32_t timestamp = parsed_strings_value.timestamp();
       std::string old_user_value = parsed_strings_value.value().ToString();
@@ -177,12 +254,12 @@ Status RedisStrings::Append(const Slice& key, const Slice& value, int32_t* ret)
       StringsValue strings_value(new_value);
       strings_value.set_timestamp(timestamp);
       *ret = static_cast<int32_t>(new_value.size());
-      return db_->Put(default_write_options_, key, strings_value.Encode());
+      return PutValue(key, strings_value.Encode(), before);
     }
   } else if (s.IsNotFound()) {
     *ret = static_cast<int32_t>(value.size());
     StringsValue strings_value(value);
-    return db_->Put(default_write_options_, key, strings_value.Encode());
+    return PutValue(key, strings_value.Encode(), before);
   }
   return s;
 }
@@ -329,7 +406,7 @@ Status RedisStrings::BitOp(BitOpType op, const std::string& dest_key, const std:
 
   StringsValue strings_value(Slice(dest_value.c_str(), max_len));
   ScopeRecordLock l(lock_mgr_, dest_key);
-  return db_->Put(default_write_options_, dest_key, strings_value.Encode());
+  return PutValue(dest_key, strings_value.Encode(), GetKeyState(dest_key));
 }
 
 Status RedisStrings::Decrby(const Slice& key, int64_t value, int64_t* ret) {
@@ -337,13 +414,14 @@ Status RedisStrings::Decrby(const Slice& key, int64_t value, int64_t* ret) {
   std::string new_value;
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, key, &old_value);
+  KeyState before = s.ok() ? ValueState(old_value) : KeyState();
   if (s.ok()) {
     ParsedStringsValue parsed_strings_value(&old_value);
     if (parsed_strings_value.IsStale()) {
       *ret = -value;
       new_value = std::to_string(*ret);
       StringsValue strings_value(new_value);
-      return db_->Put(default_write_options_, key, strings_value.Encode());
+      return PutValue(key, strings_value.Encode(), before);
     } else {
       int32_t timestamp = parsed_strings_value.timestamp();
       std::string old_user_value = parsed_strings_value.value().ToString();
@@ -360,13 +438,13 @@ Status RedisStrings::Decrby(const Slice& key, int64_t value, int64_t* ret) {
       new_value = std::to_string(*ret);
       StringsValue strings_value(new_value);
       strings_value.set_timestamp(timestamp);
-      return db_->Put(default_write_options_, key, strings_value.Encode());
+      return PutValue(key, strings_value.Encode(), before);
     }
   } else if (s.IsNotFound()) {
     *ret = -value;
     new_value = std::to_string(*ret);
     StringsValue strings_value(new_value);
-    return db_->Put(default_write_options_, key, strings_value.Encode());
+    return PutValue(key, strings_value.Encode(), before);
   } else {
     return s;
   }
@@ -374,7 +452,20 @@ Status RedisStrings::Decrby(const Slice& key, int64_t value, int64_t* ret) {
 
 Status RedisStrings::Get(const Slice& key, std::string* value) {
   value->clear();
-  Status s = db_->Get(default_read_options_, key, value);
+  Status s;
+  if (value_cache_ == nullptr) {
+    s = db_->Get(default_read_options_, key, value);
+  } else {
+    // The cached value is the stored one, its expire time is checked below
+    std::string cache_key = ValueCacheKey(key);
+    uint64_t ticket = 0;
+    if (!value_cache_->Lookup(cache_key, value, &ticket)) {
+      s = db_->Get(default_read_options_, key, value);
+      if (s.ok()) {
+        value_cache_->Fill(cache_key, *value, ticket);
+      }
+    }
+  }
   if (s.ok()) {
     ParsedStringsValue parsed_strings_value(value);
     if (parsed_strings_value.IsStale()) {
@@ -450,6 +541,7 @@ Status RedisStrings::Getrange(const Slice& key, int64_t start_offset, int64_t en
 Status RedisStrings::GetSet(const Slice& key, const Slice& value, std::string* old_value) {
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, key, old_value);
+  KeyState before = s.ok() ? ValueState(*old_value) : KeyState();
   if (s.ok()) {
     ParsedStringsValue parsed_strings_value(old_value);
     if (parsed_strings_value.IsStale()) {
@@ -461,7 +553,7 @@ Status RedisStrings::GetSet(const Slice& key, const Slice& value, std::string* o
     return s;
   }
   StringsValue strings_value(value);
-  return db_->Put(default_write_options_, key, strings_value.Encode());
+  return PutValue(key, strings_value.Encode(), before);
 }
 
 Status RedisStrings::Incrby(const Slice& key, int64_t value, int64_t* ret) {
@@ -469,6 +561,7 @@ Status RedisStrings::Incrby(const Slice& key, int64_t value, int64_t* ret) {
   std::string new_value;
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, key, &old_value);
+  KeyState before = s.ok() ? ValueState(old_value) : KeyState();
   char buf[32] = {0};
   if (s.ok()) {
     ParsedStringsValue parsed_strings_value(&old_value);
@@ -476,7 +569,7 @@ Status RedisStrings::Incrby(const Slice& key, int64_t value, int64_t* ret) {
       *ret = value;
       Int64ToStr(buf, 32, value);
       StringsValue strings_value(buf);
-      return db_->Put(default_write_options_, key, strings_value.Encode());
+      return PutValue(key, strings_value.Encode(), before);
     } else {
       int32_t timestamp = parsed_strings_value.timestamp();
       std::string old_user_value = parsed_strings_value.value().ToString();
@@ -492,13 +585,13 @@ Status RedisStrings::Incrby(const Slice& key, int64_t value, int64_t* ret) {
       new_value = std::to_string(*ret);
       StringsValue strings_value(new_value);
       strings_value.set_timestamp(timestamp);
-      return db_->Put(default_write_options_, key, strings_value.Encode());
+      return PutValue(key, strings_value.Encode(), before);
     }
   } else if (s.IsNotFound()) {
     *ret = value;
     Int64ToStr(buf, 32, value);
     StringsValue strings_value(buf);
-    return db_->Put(default_write_options_, key, strings_value.Encode());
+    return PutValue(key, strings_value.Encode(), before);
   } else {
     return s;
   }
@@ -513,13 +606,14 @@ Status RedisStrings::Incrbyfloat(const Slice& key, const Slice& value, std::stri
   }
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, key, &old_value);
+  KeyState before = s.ok() ? ValueState(old_value) : KeyState();
   if (s.ok()) {
     ParsedStringsValue parsed_strings_value(&old_value);
     if (parsed_strings_value.IsStale()) {
       LongDoubleToStr(long_double_by, &new_value);
       *ret = new_value;
       StringsValue strings_value(new_value);
-      return db_->Put(default_write_options_, key, strings_value.Encode());
+      return PutValue(key, strings_value.Encode(), before);
     } else {
       int32_t timestamp = parsed_strings_value.timestamp();
       std::string old_user_value = parsed_strings_value.value().ToString();
@@ -535,13 +629,13 @@ Status RedisStrings::Incrbyfloat(const Slice& key, const Slice& value, std::stri
       *ret = new_value;
       StringsValue strings_value(new_value);
       strings_value.set_timestamp(timestamp);
-      return db_->Put(default_write_options_, key, strings_value.Encode());
+      return PutValue(key, strings_value.Encode(), before);
     }
   } else if (s.IsNotFound()) {
     LongDoubleToStr(long_double_by, &new_value);
     *ret = new_value;
     StringsValue strings_value(new_value);
-    return db_->Put(default_write_options_, key, strings_value.Encode());
+    return PutValue(key, strings_value.Encode(), before);
   } else {
     return s;
   }
@@ -549,17 +643,18 @@ Status RedisStrings::Incrbyfloat(const Slice& key, const Slice& value, std::stri
 
 Status RedisStrings::MGet(const std::vector<std::string>& keys, std::vector<ValueStatus>* vss) {
   vss->clear();
-
-  Status s;
-  std::string value;
-  rocksdb::ReadOptions read_options;
-  const rocksdb::Snapshot* snapshot;
-  ScopeSnapshot ss(db_, &snapshot);
-  read_options.snapshot = snapshot;
-  for (const auto& key : keys) {
-    s = db_->Get(read_options, key, &value);
+  vss->reserve(keys.size());
+
+  // All the keys are read from one consistent view by MultiGet,
+  // so there is no need to take a snapshot here
+  std::vector<Slice> key_slices(keys.begin(), keys.end());
+  std::vector<rocksdb::PinnableSlice> values;
+  std::vector<Status> statuses;
+  MultiGet(default_read_options_, db_->DefaultColumnFamily(), key_slices, &values, &statuses);
+  for (size_t idx = 0; idx < keys.size(); ++idx) {
+    const Status& s = statuses[idx];
     if (s.ok()) {
-      ParsedStringsValue parsed_strings_value(&value);
+      ParsedStringsValue parsed_strings_value(values[idx]);
       if (parsed_strings_value.IsStale()) {
         vss->push_back({std::string(), Status::NotFound("Stale")});
       } else {
@@ -584,11 +679,23 @@ for (const auto& kv : kvs) {
 
   MultiScopeRecordLock ml(lock_mgr_, keys);
   rocksdb::WriteBatch batch;
+  // A key set twice is counted once
+  std::unordered_map<std::string, KeyState> befores;
   for (const auto& kv : kvs) {
     StringsValue strings_value(kv.value);
     batch.Put(kv.key, strings_value.Encode());
+    if (befores.find(kv.key) == befores.end()) {
+      befores.emplace(kv.key, GetKeyState(kv.key));
+    }
+  }
+  Status s = db_->Write(default_write_options_, &batch);
+  for (const auto& [key, before] : befores) {
+    InvalidateCachedValue(key);
+    if (s.ok()) {
+      key_statistics_.Update(before, {true, 0});
+    }
   }
-  return db_->Write(default_write_options_, &batch);
+  return s;
 }
 
 Status RedisStrings::MSetnx(const std::vector<KeyValue>& kvs, int32_t* ret) {
@@ -618,7 +725,7 @@ Status RedisStrings::MSetnx(const std::vector<KeyValue>& kvs, int32_t* ret) {
 Status RedisStrings::Set(const Slice& key, const Slice& value) {
   StringsValue strings_value(value);
   ScopeRecordLock l(lock_mgr_, key);
-  return db_->Put(default_write_options_, key, strings_value.Encode());
+  return PutValue(key, strings_value.Encode(), GetKeyState(key));
 }
 
 Status RedisStrings::Setxx(const Slice& key, const Slice& value, int32_t* ret, const int32_t ttl) {
@@ -627,6 +734,7 @@ Status RedisStrings::Setxx(const Slice& key, const Slice& value, int32_t* ret, c
   StringsValue strings_value(value);
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, key, &old_value);
+  KeyState before = s.ok() ? ValueState(old_value) : KeyState();
   if (s.ok()) {
     ParsedStringsValue parsed_strings_value(old_value);
     if (!parsed_strings_value.IsStale()) {
@@ -644,7 +752,7 @@ Status RedisStrings::Setxx(const Slice& key, const Slice& value, int32_t* ret, c
     if (ttl > 0) {
       strings_value.SetRelativeTimestamp(ttl);
     }
-    return db_->Put(default_write_options_, key, strings_value.Encode());
+    return PutValue(key, strings_value.Encode(), before);
   }
 }
 
@@ -656,6 +764,7 @@ Status RedisStrings::SetBit(const Slice& key, int64_t offset, int32_t on, int32_
 
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, key, &meta_value);
+  KeyState before = s.ok() ? ValueState(meta_value) : KeyState();
   if (s.ok() || s.IsNotFound()) {
     std::string data_value;
     int32_t timestamp = 0;
@@ -690,7 +799,7 @@ Status RedisStrings::SetBit(const Slice& key, int64_t offset, int32_t on, int32_
     }
     StringsValue strings_value(data_value);
     strings_value.set_timestamp(timestamp);
-    return db_->Put(rocksdb::WriteOptions(), key, strings_value.Encode());
+    return PutValue(key, strings_value.Encode(), before);
   } else {
     return s;
   }
@@ -706,7 +815,7 @@ Status RedisStrings::Setex(const Slice& key, const Slice& value, int32_t ttl) {
     return s;
   }
   ScopeRecordLock l(lock_mgr_, key);
-  return db_->Put(default_write_options_, key, strings_value.Encode());
+  return PutValue(key, strings_value.Encode(), GetKeyState(key));
 }
 
 Status RedisStrings::Setnx(const Slice& key, const Slice& value, int32_t* ret, const int32_t ttl) {
@@ -714,6 +823,7 @@ Status RedisStrings::Setnx(const Slice& key, const Slice& value, int32_t* ret, c
   std::string old_value;
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, key, &old_value);
+  KeyState before = s.ok() ? ValueState(old_value) : KeyState();
   if (s.ok()) {
     ParsedStringsValue parsed_strings_value(&old_value);
     if (parsed_strings_value.IsStale()) {
@@ -721,7 +831,7 @@ Status RedisStrings::Setnx(const Slice& key, const Slice& value, int32_t* ret, c
       if (ttl > 0) {
         strings_value.SetRelativeTimestamp(ttl);
       }
-      s = db_->Put(default_write_options_, key, strings_value.Encode());
+      s = PutValue(key, strings_value.Encode(), before);
       if (s.ok()) {
         *ret = 1;
       }
@@ -731,7 +841,7 @@ Status RedisStrings::Setnx(const Slice& key, const Slice& value, int32_t* ret, c
     if (ttl > 0) {
       strings_value.SetRelativeTimestamp(ttl);
     }
-    s = db_->Put(default_write_options_, key, strings_value.Encode());
+    s = PutValue(key, strings_value.Encode(), before);
     if (s.ok()) {
       *ret = 1;
     }
@@ -745,6 +855,7 @@ Status RedisStrings::Setvx(const Slice& key, const Slice& value, const Slice& ne
   std::string old_value;
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, key, &old_value);
+  KeyState before = s.ok() ? ValueState(old_value) : KeyState();
   if (s.ok()) {
     ParsedStringsValue parsed_strings_value(&old_value);
     if (parsed_strings_value.IsStale()) {
@@ -755,7 +866,7 @@ Status RedisStrings::Setvx(const Slice& key, const Slice& value, const Slice& ne
         if (ttl > 0) {
           strings_value.SetRelativeTimestamp(ttl);
         }
-        s = db_->Put(default_write_options_, key, strings_value.Encode());
+        s = PutValue(key, strings_value.Encode(), before);
         if (!s.ok()) {
           return s;
         }
@@ -777,6 +888,7 @@ Status RedisStrings::Delvx(const Slice& key, const Slice& value, int32_t* ret) {
   std::string old_value;
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, key, &old_value);
+  KeyState before = s.ok() ? ValueState(old_value) : KeyState();
   if (s.ok()) {
     ParsedStringsValue parsed_strings_value(&old_value);
     if (parsed_strings_value.IsStale()) {
@@ -785,7 +897,7 @@ Status RedisStrings::Delvx(const Slice& key, const Slice& value, int32_t* ret) {
     } else {
       if (value.compare(parsed_strings_value.value()) == 0) {
         *ret = 1;
-        return db_->Delete(default_write_options_, key);
+        return DeleteValue(key, before);
       } else {
         *ret = -1;
       }
@@ -805,6 +917,7 @@ Status RedisStrings::Setrange(const Slice& key, int64_t start_offset, const Slic
 
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, key, &old_value);
+  KeyState before = s.ok() ? ValueState(old_value) : KeyState();
   if (s.ok()) {
     int32_t timestamp = 0;
     ParsedStringsValue parsed_strings_value(&old_value);
@@ -830,13 +943,13 @@ Status RedisStrings::Setrange(const Slice& key, int64_t start_offset, const Slic
     *ret = static_cast<int32_t>(new_value.length());
     StringsValue strings_value(new_value);
     strings_value.set_timestamp(timestamp);
-    return db_->Put(default_write_options_, key, strings_value.Encode());
+    return PutValue(key, strings_value.Encode(), before);
   } else if (s.IsNotFound()) {
     std::string tmp(start_offset, '\0');
     new_value = tmp.append(value.data());
     *ret = static_cast<int32_t>(new_value.length());
     StringsValue strings_value(new_value);
-    return db_->Put(default_write_options_, key, strings_value.Encode());
+    return PutValue(key, strings_value.Encode(), before);
   }
   return s;
 }
@@ -1042,7 +1155,7 @@ Status RedisStrings::PKSetexAt(const Slice& key, const Slice& value, int32_t tim
   StringsValue strings_value(value);
   ScopeRecordLock l(lock_mgr_, key);
   strings_value.set_timestamp(timestamp);
-  return db_->Put(default_write_options_, key, strings_value.Encode());
+  return PutValue(key, strings_value.Encode(), GetKeyState(key));
 }
 
 Status RedisStrings::PKScanRange(const Slice& key_start, const Slice& key_end, const Slice& pattern, int32_t limit,
@@ -1074,6 +1187,7 @@ Status RedisStrings::PKScanRange(const Slice& key_start, const Slice& key_end, c
     it->Seek(key_start);
   }
 
+  pstd::GlobMatcher matcher(pattern.data(), pattern.size(), false);
   while (it->Valid() && remain > 0 && (end_no_limit || it->key().compare(key_end) <= 0)) {
     ParsedStringsValue parsed_strings_value(it->value());
     if (parsed_strings_value.IsStale()) {
@@ -1081,7 +1195,7 @@ Status RedisStrings::PKScanRange(const Slice& key_start, const Slice& key_end, c
     } else {
       key = it->key().ToString();
       value = parsed_strings_value.value().ToString();
-      if (StringMatch(pattern.data(), pattern.size(), key.data(), key.size(), 0) != 0) {
+      if (matcher.Match(key.data(), key.size())) {
         kvs->push_back({key, value});
       }
       remain--;
@@ -1129,6 +1243,7 @@ Status RedisStrings::PKRScanRange(const Slice& key_start, const Slice& key_end,
     it->SeekForPrev(key_start);
   }
 
+  pstd::GlobMatcher matcher(pattern.data(), pattern.size(), false);
   while (it->Valid() && remain > 0 && (end_no_limit || it->key().compare(key_end) >= 0)) {
     ParsedStringsValue parsed_strings_value(it->value());
     if (parsed_strings_value.IsStale()) {
@@ -1136,7 +1251,7 @@ Status RedisStrings::PKRScanRange(const Slice& key_start, const Slice& key_end,
     } else {
       key = it->key().ToString();
       value = parsed_strings_value.value().ToString();
-      if (StringMatch(pattern.data(), pattern.size(), key.data(), key.size(), 0) != 0) {
+      if (matcher.Match(key.data(), key.size())) {
         kvs->push_back({key, value});
       }
       remain--;
@@ -1157,10 +1272,37 @@ Status RedisStrings::PKRScanRange(const Slice& key_start, const Slice& key_end,
   return Status::OK();
 }
 
+bool RedisStrings::IsValidMetaValue(const Slice& meta_value) {
+  ParsedStringsValue parsed_strings_value(meta_value);
+  return !parsed_strings_value.IsStale();
+}
+
+Status RedisStrings::ReclaimExpiredKey(const Slice& key, int32_t timestamp, size_t* budget, rocksdb::WriteBatch* batch,
+                                       ExpiredKey* expired_key) {
+  std::string value;
+  Status s = db_->Get(default_read_options_, key, &value);
+  if (s.IsNotFound()) {
+    expired_key->obsolete = true;
+    return Status::OK();
+  } else if (!s.ok()) {
+    return s;
+  }
+  ParsedStringsValue parsed_strings_value(&value);
+  if (parsed_strings_value.timestamp() != timestamp || !parsed_strings_value.IsStale()) {
+    expired_key->obsolete = true;
+    return Status::OK();
+  }
+  batch->Delete(key);
+  expired_key->before = ValueState(value);
+  expired_key->deleted = true;
+  return Status::OK();
+}
+
 Status RedisStrings::Expire(const Slice& key, int32_t ttl) {
   std::string value;
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, key, &value);
+  KeyState before = s.ok() ? ValueState(value) : KeyState();
   if (s.ok()) {
     ParsedStringsValue parsed_strings_value(&value);
     if (parsed_strings_value.IsStale()) {
@@ -1168,9 +1310,9 @@ Status RedisStrings::Expire(const Slice& key, int32_t ttl) {
     }
     if (ttl > 0) {
       parsed_strings_value.SetRelativeTimestamp(ttl);
-      return db_->Put(default_write_options_, key, value);
+      return PutValue(key, value, before);
     } else {
-      return db_->Delete(default_write_options_, key);
+      return DeleteValue(key, before);
     }
   }
   return s;
@@ -1180,12 +1322,13 @@ Status RedisStrings::Del(const Slice& key) {
   std::string value;
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, key, &value);
+  KeyState before = s.ok() ? ValueState(value) : KeyState();
   if (s.ok()) {
     ParsedStringsValue parsed_strings_value(&value);
     if (parsed_strings_value.IsStale()) {
       return Status::NotFound("Stale");
     }
-    return db_->Delete(default_write_options_, key);
+    return DeleteValue(key, before);
   }
   return s;
 }
@@ -1200,11 +1343,14 @@ bool RedisStrings::Scan(const std::string& start_key, const std::string& pattern
   iterator_options.snapshot = snapshot;
   iterator_options.fill_cache = false;
 
+  pstd::GlobMatcher matcher(pattern);
+  ScanRange range(matcher);
+  range.Bound(&iterator_options);
   // Note: This is a string type and does not need to pass the column family as
   // a parameter, use the default column family
   rocksdb::Iterator* it = db_->NewIterator(iterator_options);
 
-  it->Seek(start_key);
+  it->Seek(range.SeekKey(start_key));
   while (it->Valid() && (*count) > 0) {
     ParsedStringsValue parsed_strings_value(it->value());
     if (parsed_strings_value.IsStale()) {
@@ -1212,7 +1358,7 @@ bool RedisStrings::Scan(const std::string& start_key, const std::string& pattern
       continue;
     } else {
       key = it->key().ToString();
-      if (StringMatch(pattern.data(), pattern.size(), key.data(), key.size(), 0) != 0) {
+      if (matcher.Match(key.data(), key.size())) {
         keys->push_back(key);
       }
       (*count)--;
@@ -1220,8 +1366,7 @@ bool RedisStrings::Scan(const std::string& start_key, const std::string& pattern
     }
   }
 
-  std::string prefix = isTailWildcard(pattern) ? pattern.substr(0, pattern.size() - 1) : "";
-  if (it->Valid() && (it->key().compare(prefix) <= 0 || it->key().starts_with(prefix))) {
+  if (it->Valid()) {
     is_finish = false;
     *next_key = it->key().ToString();
   } else {
@@ -1271,6 +1416,7 @@ Status RedisStrings::Expireat(const Slice& key, int32_t timestamp) {
   std::string value;
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, key, &value);
+  KeyState before = s.ok() ? ValueState(value) : KeyState();
   if (s.ok()) {
     ParsedStringsValue parsed_strings_value(&value);
     if (parsed_strings_value.IsStale()) {
@@ -1278,9 +1424,9 @@ Status RedisStrings::Expireat(const Slice& key, int32_t timestamp) {
     } else {
       if (timestamp > 0) {
         parsed_strings_value.set_timestamp(timestamp);
-        return db_->Put(default_write_options_, key, value);
+        return PutValue(key, value, before);
       } else {
-        return db_->Delete(default_write_options_, key);
+        return DeleteValue(key, before);
       }
     }
   }
@@ -1291,6 +1437,7 @@ Status RedisStrings::Persist(const Slice& key) {
   std::string value;
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, key, &value);
+  KeyState before = s.ok() ? ValueState(value) : KeyState();
   if (s.ok()) {
     ParsedStringsValue parsed_strings_value(&value);
     if (parsed_strings_value.IsStale()) {
@@ -1301,7 +1448,7 @@ Status RedisStrings::Persist(const Slice& key) {
         return Status::NotFound("Not have an associated timeout");
       } else {
         parsed_strings_value.set_timestamp(0);
-        return db_->Put(default_write_options_, key, value);
+        return PutValue(key, value, before);
       }
     }
   }
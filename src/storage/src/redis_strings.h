@@ -74,6 +74,22 @@ class RedisStrings : public Redis {
 
   // Iterate all data
   void ScanDatabase();
+
+ protected:
+  bool IsValidMetaValue(const Slice& meta_value) override;
+  Status ReclaimExpiredKey(const Slice& key, int32_t timestamp, size_t* budget, rocksdb::WriteBatch* batch,
+                           ExpiredKey* expired_key) override;
+
+ private:
+  // Put and Delete keeping the keyspace statistics, before is the state of
+  // key read under its record lock
+  Status PutValue(const Slice& key, const Slice& value, const KeyState& before);
+  Status DeleteValue(const Slice& key, const KeyState& before);
+  // For the writes that do not read the old value anyway. Unless the
+  // statistics are kept exact the key is not read and taken as missing, which
+  // may leave an entry of its old expire time in the index for ActiveExpire
+  // to drop
+  KeyState GetKeyState(const Slice& key);
 };
 
 }  //  namespace storage
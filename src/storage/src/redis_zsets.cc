@@ -14,10 +14,12 @@
 #include <fmt/core.h>
 
 #include "iostream"
+#include "src/scan_range.h"
 #include "src/scope_record_lock.h"
 #include "src/scope_snapshot.h"
 #include "src/zsets_filter.h"
 #include "storage/util.h"
+#include "pstd/include/pstd_glob.h"
 
 namespace storage {
 
@@ -28,9 +30,16 @@ rocksdb::Comparator* ZSetsScoreKeyComparator() {
 
 RedisZSets::RedisZSets(Storage* const s, const DataType& type) : Redis(s, type) {}
 
+// The state of a key whose meta value was read
+static KeyState MetaKeyState(const Slice& meta_value) {
+  ParsedZSetsMetaValue parsed_meta_value(meta_value);
+  return {parsed_meta_value.count() != 0, parsed_meta_value.timestamp()};
+}
+
 Status RedisZSets::Open(const StorageOptions& storage_options, const std::string& db_path) {
   statistics_store_->SetCapacity(storage_options.statistics_max_size);
   small_compaction_threshold_ = storage_options.small_compaction_threshold;
+  rank_index_enabled_ = storage_options.zset_rank_index;
 
   rocksdb::Options ops(storage_options.options);
   Status s = rocksdb::DB::Open(ops, db_path, &db_);
@@ -53,13 +62,33 @@ Status RedisZSets::Open(const StorageOptions& storage_options, const std::string
   }
 
   rocksdb::DBOptions db_ops(storage_options.options);
+  // expire_cf is missing in databases created by older versions, and so is
+  // rank_cf in the ones never opened with the rank index enabled
+  db_ops.create_missing_column_families = true;
+  bool open_rank_cf = rank_index_enabled_;
+  if (!open_rank_cf) {
+    std::vector<std::string> cf_names;
+    s = rocksdb::DB::ListColumnFamilies(db_ops, db_path, &cf_names);
+    if (!s.ok()) {
+      return s;
+    }
+    open_rank_cf = std::find(cf_names.begin(), cf_names.end(), "rank_cf") != cf_names.end();
+  }
   rocksdb::ColumnFamilyOptions meta_cf_ops(storage_options.options);
   rocksdb::ColumnFamilyOptions data_cf_ops(storage_options.options);
   rocksdb::ColumnFamilyOptions score_cf_ops(storage_options.options);
-  meta_cf_ops.compaction_filter_factory = std::make_shared<ZSetsMetaFilterFactory>();
-  data_cf_ops.compaction_filter_factory = std::make_shared<ZSetsDataFilterFactory>(&db_, &handles_);
-  score_cf_ops.compaction_filter_factory = std::make_shared<ZSetsScoreFilterFactory>(&db_, &handles_);
+  rocksdb::ColumnFamilyOptions rank_cf_ops(storage_options.options);
+  rocksdb::ColumnFamilyOptions expire_cf_ops(storage_options.options);
+  meta_cf_ops.compaction_filter_factory = std::make_shared<ZSetsMetaFilterFactory>(&key_statistics_);
+  SetMetaMemtableBloom(&meta_cf_ops);
+  data_cf_ops.compaction_filter_factory =
+      std::make_shared<ZSetsDataFilterFactory>(&db_, &handles_, &data_filter_statistics_);
+  score_cf_ops.compaction_filter_factory =
+      std::make_shared<ZSetsScoreFilterFactory>(&db_, &handles_, &data_filter_statistics_);
   score_cf_ops.comparator = ZSetsScoreKeyComparator();
+  rank_cf_ops.compaction_filter_factory =
+      std::make_shared<ZSetsDataFilterFactory>(&db_, &handles_, &data_filter_statistics_);
+  rank_cf_ops.merge_operator = std::make_shared<ZSetsRankCountMergeOperator>();
 
   // use the bloom filter policy to reduce disk reads
   rocksdb::BlockBasedTableOptions table_ops(storage_options.table_options);
@@ -67,20 +96,36 @@ Status RedisZSets::Open(const StorageOptions& storage_options, const std::string
   rocksdb::BlockBasedTableOptions meta_cf_table_ops(table_ops);
   rocksdb::BlockBasedTableOptions data_cf_table_ops(table_ops);
   rocksdb::BlockBasedTableOptions score_cf_table_ops(table_ops);
+  rocksdb::BlockBasedTableOptions rank_cf_table_ops(table_ops);
   if (!storage_options.share_block_cache && storage_options.block_cache_size > 0) {
     meta_cf_table_ops.block_cache = rocksdb::NewLRUCache(storage_options.block_cache_size);
     data_cf_table_ops.block_cache = rocksdb::NewLRUCache(storage_options.block_cache_size);
     score_cf_table_ops.block_cache = rocksdb::NewLRUCache(storage_options.block_cache_size);
+    rank_cf_table_ops.block_cache = rocksdb::NewLRUCache(storage_options.block_cache_size);
   }
   meta_cf_ops.table_factory.reset(rocksdb::NewBlockBasedTableFactory(meta_cf_table_ops));
   data_cf_ops.table_factory.reset(rocksdb::NewBlockBasedTableFactory(data_cf_table_ops));
   score_cf_ops.table_factory.reset(rocksdb::NewBlockBasedTableFactory(score_cf_table_ops));
+  rank_cf_ops.table_factory.reset(rocksdb::NewBlockBasedTableFactory(rank_cf_table_ops));
+  SetExpireIndexOptions(&expire_cf_ops);
 
   std::vector<rocksdb::ColumnFamilyDescriptor> column_families;
   column_families.emplace_back(rocksdb::kDefaultColumnFamilyName, meta_cf_ops);
   column_families.emplace_back("data_cf", data_cf_ops);
   column_families.emplace_back("score_cf", score_cf_ops);
-  return rocksdb::DB::Open(db_ops, db_path, column_families, &handles_, &db_);
+  if (open_rank_cf) {
+    column_families.emplace_back("rank_cf", rank_cf_ops);
+  }
+  column_families.emplace_back(kExpireIndexColumnFamilyName, expire_cf_ops);
+  s = rocksdb::DB::Open(db_ops, db_path, column_families, &handles_, &db_);
+  if (s.ok() && open_rank_cf) {
+    rank_handle_ = handles_[3];
+    if (!rank_index_enabled_) {
+      // Writes are not tracked while the index is disabled, drop what is left
+      s = ClearRankIndexes();
+    }
+  }
+  return s;
 }
 
 Status RedisZSets::CompactRange(const rocksdb::Slice* begin, const rocksdb::Slice* end, const ColumnFamilyType& type) {
@@ -90,6 +135,12 @@ Status RedisZSets::CompactRange(const rocksdb::Slice* begin, const rocksdb::Slic
   if (type == kData || type == kMetaAndData) {
     db_->CompactRange(default_compact_range_options_, handles_[1], begin, end);
     db_->CompactRange(default_compact_range_options_, handles_[2], begin, end);
+    if (rank_handle_) {
+      db_->CompactRange(default_compact_range_options_, rank_handle_, begin, end);
+    }
+  }
+  if (rank_index_enabled_ && begin == nullptr && end == nullptr) {
+    BuildRankIndexes();
   }
   return Status::OK();
 }
@@ -102,6 +153,10 @@ Status RedisZSets::GetProperty(const std::string& property, uint64_t* out) {
   *out += std::strtoull(value.c_str(), nullptr, 10);
   db_->GetProperty(handles_[2], property, &value);
   *out += std::strtoull(value.c_str(), nullptr, 10);
+  if (rank_handle_) {
+    db_->GetProperty(rank_handle_, property, &value);
+    *out += std::strtoull(value.c_str(), nullptr, 10);
+  }
   return Status::OK();
 }
 
@@ -111,6 +166,10 @@ Status RedisZSets::ScanKeyNum(KeyInfo* key_info) {
   uint64_t ttl_sum = 0;
   uint64_t invaild_keys = 0;
 
+  // Writes made from here on are applied on top of the scanned statistics
+  KeyStatistics scanned;
+  uint64_t recount = key_statistics_.StartRecount();
+
   rocksdb::ReadOptions iterator_options;
   const rocksdb::Snapshot* snapshot;
   ScopeSnapshot ss(db_, &snapshot);
@@ -123,6 +182,7 @@ Status RedisZSets::ScanKeyNum(KeyInfo* key_info) {
   rocksdb::Iterator* iter = db_->NewIterator(iterator_options, handles_[0]);
   for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
     ParsedZSetsMetaValue parsed_zsets_meta_value(iter->value());
+    scanned.Update(KeyState(), MetaKeyState(iter->value()));
     if (parsed_zsets_meta_value.IsStale() || parsed_zsets_meta_value.count() == 0) {
       invaild_keys++;
     } else {
@@ -134,6 +194,7 @@ Status RedisZSets::ScanKeyNum(KeyInfo* key_info) {
     }
   }
   delete iter;
+  key_statistics_.FinishRecount(recount, &scanned);
 
   key_info->keys = keys;
   key_info->expires = expires;
@@ -150,12 +211,15 @@ Status RedisZSets::ScanKeys(const std::string& pattern, std::vector<std::string>
   iterator_options.snapshot = snapshot;
   iterator_options.fill_cache = false;
 
+  pstd::GlobMatcher matcher(pattern);
+  ScanRange range(matcher);
+  range.Bound(&iterator_options);
   rocksdb::Iterator* iter = db_->NewIterator(iterator_options, handles_[0]);
-  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+  for (iter->Seek(range.prefix()); iter->Valid(); iter->Next()) {
     ParsedZSetsMetaValue parsed_zsets_meta_value(iter->value());
     if (!parsed_zsets_meta_value.IsStale() && parsed_zsets_meta_value.count() != 0) {
       key = iter->key().ToString();
-      if (StringMatch(pattern.data(), pattern.size(), key.data(), key.size(), 0) != 0) {
+      if (matcher.Match(key.data(), key.size())) {
         keys->push_back(key);
       }
     }
@@ -176,14 +240,19 @@ Status RedisZSets::PKPatternMatchDel(const std::string& pattern, int32_t* ret) {
   int32_t total_delete = 0;
   Status s;
   rocksdb::WriteBatch batch;
+  std::vector<KeyState> befores;
+  pstd::GlobMatcher matcher(pattern);
+  ScanRange range(matcher);
+  range.Bound(&iterator_options);
   rocksdb::Iterator* iter = db_->NewIterator(iterator_options, handles_[0]);
-  iter->SeekToFirst();
+  iter->Seek(range.prefix());
   while (iter->Valid()) {
     key = iter->key().ToString();
     meta_value = iter->value().ToString();
     ParsedZSetsMetaValue parsed_zsets_meta_value(&meta_value);
     if (!parsed_zsets_meta_value.IsStale() && (parsed_zsets_meta_value.count() != 0) &&
-        (StringMatch(pattern.data(), pattern.size(), key.data(), key.size(), 0) != 0)) {
+        matcher.Match(key.data(), key.size())) {
+      befores.push_back(MetaKeyState(meta_value));
       parsed_zsets_meta_value.InitialMetaValue();
       batch.Put(handles_[0], key, meta_value);
     }
@@ -192,6 +261,10 @@ Status RedisZSets::PKPatternMatchDel(const std::string& pattern, int32_t* ret) {
       if (s.ok()) {
         total_delete += static_cast<int32_t>(batch.Count());
         batch.Clear();
+        for (const auto& before : befores) {
+          key_statistics_.Update(before, KeyState());
+        }
+        befores.clear();
       } else {
         *ret = total_delete;
         return s;
@@ -204,6 +277,10 @@ Status RedisZSets::PKPatternMatchDel(const std::string& pattern, int32_t* ret) {
     if (s.ok()) {
       total_delete += static_cast<int32_t>(batch.Count());
       batch.Clear();
+      for (const auto& before : befores) {
+        key_statistics_.Update(before, KeyState());
+      }
+      befores.clear();
     }
   }
 
@@ -218,6 +295,8 @@ Status RedisZSets::ZPopMax(const Slice& key, const int64_t count, std::vector<Sc
   ScopeRecordLock l(lock_mgr_, key);
   std::string meta_value;
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   if (s.ok()) {
     ParsedZSetsMetaValue parsed_zsets_meta_value(&meta_value);
     if (parsed_zsets_meta_value.IsStale()) {
@@ -228,6 +307,8 @@ Status RedisZSets::ZPopMax(const Slice& key, const int64_t count, std::vector<Sc
       int64_t num = parsed_zsets_meta_value.count();
       num = num <= count ? num : count;
       int32_t version = parsed_zsets_meta_value.version();
+      ZSetsRankDelta rank_delta;
+      InitRankDelta(key, version, false, &rank_delta);
       ZSetsScoreKey zsets_score_key(key, version, std::numeric_limits<double>::max(), Slice());
       rocksdb::Iterator* iter = db_->NewIterator(default_read_options_, handles_[2]);
       int32_t del_cnt = 0;
@@ -240,6 +321,7 @@ Status RedisZSets::ZPopMax(const Slice& key, const int64_t count, std::vector<Sc
         ++del_cnt;
         batch.Delete(handles_[1], zsets_member_key.Encode());
         batch.Delete(handles_[2], iter->key());
+        rank_delta.Add(parsed_zsets_score_key.score(), -1);
       }
       delete iter;
       if (!parsed_zsets_meta_value.CheckModifyCount(-del_cnt)){
@@ -247,7 +329,12 @@ Status RedisZSets::ZPopMax(const Slice& key, const int64_t count, std::vector<Sc
       }
       parsed_zsets_meta_value.ModifyCount(-del_cnt);
       batch.Put(handles_[0], key, meta_value);
+      after = MetaKeyState(meta_value);
+      rank_delta.MergeTo(&batch, rank_handle_);
       s = db_->Write(default_write_options_, &batch);
+      if (s.ok()) {
+        key_statistics_.Update(before, after);
+      }
       UpdateSpecificKeyStatistics(key.ToString(), statistic);
       return s;
     }
@@ -263,6 +350,8 @@ Status RedisZSets::ZPopMin(const Slice& key, const int64_t count, std::vector<Sc
   ScopeRecordLock l(lock_mgr_, key);
   std::string meta_value;
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   if (s.ok()) {
     ParsedZSetsMetaValue parsed_zsets_meta_value(&meta_value);
     if (parsed_zsets_meta_value.IsStale()) {
@@ -273,6 +362,8 @@ Status RedisZSets::ZPopMin(const Slice& key, const int64_t count, std::vector<Sc
       int64_t num = parsed_zsets_meta_value.count();
       num = num <= count ? num : count;
       int32_t version = parsed_zsets_meta_value.version();
+      ZSetsRankDelta rank_delta;
+      InitRankDelta(key, version, false, &rank_delta);
       ZSetsScoreKey zsets_score_key(key, version, std::numeric_limits<double>::lowest(), Slice());
       rocksdb::Iterator* iter = db_->NewIterator(default_read_options_, handles_[2]);
       int32_t del_cnt = 0;
@@ -285,6 +376,7 @@ Status RedisZSets::ZPopMin(const Slice& key, const int64_t count, std::vector<Sc
         ++del_cnt;
         batch.Delete(handles_[1], zsets_member_key.Encode());
         batch.Delete(handles_[2], iter->key());
+        rank_delta.Add(parsed_zsets_score_key.score(), -1);
       }
       delete iter;
       if (!parsed_zsets_meta_value.CheckModifyCount(-del_cnt)){
@@ -292,7 +384,12 @@ Status RedisZSets::ZPopMin(const Slice& key, const int64_t count, std::vector<Sc
       }
       parsed_zsets_meta_value.ModifyCount(-del_cnt);
       batch.Put(handles_[0], key, meta_value);
+      after = MetaKeyState(meta_value);
+      rank_delta.MergeTo(&batch, rank_handle_);
       s = db_->Write(default_write_options_, &batch);
+      if (s.ok()) {
+        key_statistics_.Update(before, after);
+      }
       UpdateSpecificKeyStatistics(key.ToString(), statistic);
       return s;
     }
@@ -317,8 +414,11 @@ Status RedisZSets::ZAdd(const Slice& key, const std::vector<ScoreMember>& score_
   int32_t version = 0;
   std::string meta_value;
   rocksdb::WriteBatch batch;
+  ZSetsRankDelta rank_delta;
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   if (s.ok()) {
     bool vaild = true;
     ParsedZSetsMetaValue parsed_zsets_meta_value(&meta_value);
@@ -329,6 +429,7 @@ Status RedisZSets::ZAdd(const Slice& key, const std::vector<ScoreMember>& score_
       vaild = true;
       version = parsed_zsets_meta_value.version();
     }
+    InitRankDelta(key, version, !vaild, &rank_delta);
 
     int32_t cnt = 0;
     std::string data_value;
@@ -347,6 +448,7 @@ Status RedisZSets::ZAdd(const Slice& key, const std::vector<ScoreMember>& score_
           } else {
             ZSetsScoreKey zsets_score_key(key, version, old_score, sm.member);
             batch.Delete(handles_[2], zsets_score_key.Encode());
+            rank_delta.Add(old_score, -1);
             // delete old zsets_score_key and overwirte zsets_member_key
             // but in different column_families so we accumulative 1
             statistic++;
@@ -362,6 +464,7 @@ Status RedisZSets::ZAdd(const Slice& key, const std::vector<ScoreMember>& score_
 
       ZSetsScoreKey zsets_score_key(key, version, sm.score, sm.member);
       batch.Put(handles_[2], zsets_score_key.Encode(), Slice());
+      rank_delta.Add(sm.score, 1);
       if (not_found) {
         cnt++;
       }
@@ -371,6 +474,7 @@ Status RedisZSets::ZAdd(const Slice& key, const std::vector<ScoreMember>& score_
     }
     parsed_zsets_meta_value.ModifyCount(cnt);
     batch.Put(handles_[0], key, meta_value);
+    after = MetaKeyState(meta_value);
     *ret = cnt;
   } else if (s.IsNotFound()) {
     char buf[4];
@@ -378,6 +482,8 @@ Status RedisZSets::ZAdd(const Slice& key, const std::vector<ScoreMember>& score_
     ZSetsMetaValue zsets_meta_value(Slice(buf, sizeof(int32_t)));
     version = zsets_meta_value.UpdateVersion();
     batch.Put(handles_[0], key, zsets_meta_value.Encode());
+    after = MetaKeyState(zsets_meta_value.Encode());
+    InitRankDelta(key, version, true, &rank_delta);
     for (const auto& sm : filtered_score_members) {
       ZSetsMemberKey zsets_member_key(key, version, sm.member);
       const void* ptr_score = reinterpret_cast<const void*>(&sm.score);
@@ -386,12 +492,17 @@ Status RedisZSets::ZAdd(const Slice& key, const std::vector<ScoreMember>& score_
 
       ZSetsScoreKey zsets_score_key(key, version, sm.score, sm.member);
       batch.Put(handles_[2], zsets_score_key.Encode(), Slice());
+      rank_delta.Add(sm.score, 1);
     }
     *ret = static_cast<int32_t>(filtered_score_members.size());
   } else {
     return s;
   }
+  rank_delta.MergeTo(&batch, rank_handle_);
   s = db_->Write(default_write_options_, &batch);
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
   UpdateSpecificKeyStatistics(key.ToString(), statistic);
   return s;
 }
@@ -479,14 +590,19 @@ Status RedisZSets::ZIncrby(const Slice& key, const Slice& member, double increme
   int32_t version = 0;
   std::string meta_value;
   rocksdb::WriteBatch batch;
+  ZSetsRankDelta rank_delta;
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   if (s.ok()) {
     ParsedZSetsMetaValue parsed_zsets_meta_value(&meta_value);
     if (parsed_zsets_meta_value.IsStale() || parsed_zsets_meta_value.count() == 0) {
       version = parsed_zsets_meta_value.InitialMetaValue();
+      InitRankDelta(key, version, true, &rank_delta);
     } else {
       version = parsed_zsets_meta_value.version();
+      InitRankDelta(key, version, false, &rank_delta);
     }
     std::string data_value;
     ZSetsMemberKey zsets_member_key(key, version, member);
@@ -498,6 +614,7 @@ Status RedisZSets::ZIncrby(const Slice& key, const Slice& member, double increme
       score = old_score + increment;
       ZSetsScoreKey zsets_score_key(key, version, old_score, member);
       batch.Delete(handles_[2], zsets_score_key.Encode());
+      rank_delta.Add(old_score, -1);
       // delete old zsets_score_key and overwirte zsets_member_key
       // but in different column_families so we accumulative 1
       statistic++;
@@ -508,6 +625,7 @@ Status RedisZSets::ZIncrby(const Slice& key, const Slice& member, double increme
       }
       parsed_zsets_meta_value.ModifyCount(1);
       batch.Put(handles_[0], key, meta_value);
+      after = MetaKeyState(meta_value);
     } else {
       return s;
     }
@@ -517,6 +635,8 @@ Status RedisZSets::ZIncrby(const Slice& key, const Slice& member, double increme
     ZSetsMetaValue zsets_meta_value(Slice(buf, sizeof(int32_t)));
     version = zsets_meta_value.UpdateVersion();
     batch.Put(handles_[0], key, zsets_meta_value.Encode());
+    after = MetaKeyState(zsets_meta_value.Encode());
+    InitRankDelta(key, version, true, &rank_delta);
     score = increment;
   } else {
     return s;
@@ -528,8 +648,13 @@ Status RedisZSets::ZIncrby(const Slice& key, const Slice& member, double increme
 
   ZSetsScoreKey zsets_score_key(key, version, score, member);
   batch.Put(handles_[2], zsets_score_key.Encode(), Slice());
+  rank_delta.Add(score, 1);
+  rank_delta.MergeTo(&batch, rank_handle_);
   *ret = score;
   s = db_->Write(default_write_options_, &batch);
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
   UpdateSpecificKeyStatistics(key.ToString(), statistic);
   return s;
 }
@@ -562,9 +687,15 @@ Status RedisZSets::ZRange(const Slice& key, int32_t start, int32_t stop, std::ve
       }
       int32_t cur_index = 0;
       ScoreMember score_member;
-      ZSetsScoreKey zsets_score_key(key, version, std::numeric_limits<double>::lowest(), Slice());
       rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[2]);
-      for (iter->Seek(zsets_score_key.Encode()); iter->Valid() && cur_index <= stop_index; iter->Next(), ++cur_index) {
+      if (RankIndexed(read_options, key, version, count) &&
+          SeekByIndex(read_options, key, version, start_index, iter).ok()) {
+        cur_index = start_index;
+      } else {
+        ZSetsScoreKey zsets_score_key(key, version, std::numeric_limits<double>::lowest(), Slice());
+        iter->Seek(zsets_score_key.Encode());
+      }
+      for (; iter->Valid() && cur_index <= stop_index; iter->Next(), ++cur_index) {
         if (cur_index >= start_index) {
           ParsedZSetsScoreKey parsed_zsets_score_key(iter->key());
           score_member.score = parsed_zsets_score_key.score();
@@ -663,6 +794,18 @@ Status RedisZSets::ZRank(const Slice& key, const Slice& member, int32_t* rank) {
       int32_t version = parsed_zsets_meta_value.version();
       int32_t index = 0;
       int32_t stop_index = parsed_zsets_meta_value.count() - 1;
+      if (RankIndexed(read_options, key, version, parsed_zsets_meta_value.count())) {
+        std::string data_value;
+        ZSetsMemberKey zsets_member_key(key, version, member);
+        s = db_->Get(read_options, handles_[1], zsets_member_key.Encode(), &data_value);
+        if (s.ok()) {
+          uint64_t tmp = DecodeFixed64(data_value.data());
+          const void* ptr_tmp = reinterpret_cast<const void*>(&tmp);
+          double score = *reinterpret_cast<const double*>(ptr_tmp);
+          s = RankByIndex(read_options, key, version, score, member, rank);
+        }
+        return s;
+      }
       ScoreMember score_member;
       ZSetsScoreKey zsets_score_key(key, version, std::numeric_limits<double>::lowest(), Slice());
       rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[2]);
@@ -701,6 +844,8 @@ Status RedisZSets::ZRem(const Slice& key, const std::vector<std::string>& member
   rocksdb::WriteBatch batch;
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   if (s.ok()) {
     ParsedZSetsMetaValue parsed_zsets_meta_value(&meta_value);
     if (parsed_zsets_meta_value.IsStale()) {
@@ -711,6 +856,8 @@ Status RedisZSets::ZRem(const Slice& key, const std::vector<std::string>& member
       int32_t del_cnt = 0;
       std::string data_value;
       int32_t version = parsed_zsets_meta_value.version();
+      ZSetsRankDelta rank_delta;
+      InitRankDelta(key, version, false, &rank_delta);
       for (const auto& member : filtered_members) {
         ZSetsMemberKey zsets_member_key(key, version, member);
         s = db_->Get(default_read_options_, handles_[1], zsets_member_key.Encode(), &data_value);
@@ -724,6 +871,7 @@ Status RedisZSets::ZRem(const Slice& key, const std::vector<std::string>& member
 
           ZSetsScoreKey zsets_score_key(key, version, score, member);
           batch.Delete(handles_[2], zsets_score_key.Encode());
+          rank_delta.Add(score, -1);
         } else if (!s.IsNotFound()) {
           return s;
         }
@@ -734,11 +882,16 @@ Status RedisZSets::ZRem(const Slice& key, const std::vector<std::string>& member
       }
       parsed_zsets_meta_value.ModifyCount(-del_cnt);
       batch.Put(handles_[0], key, meta_value);
+      after = MetaKeyState(meta_value);
+      rank_delta.MergeTo(&batch, rank_handle_);
     }
   } else {
     return s;
   }
   s = db_->Write(default_write_options_, &batch);
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
   UpdateSpecificKeyStatistics(key.ToString(), statistic);
   return s;
 }
@@ -750,6 +903,8 @@ Status RedisZSets::ZRemrangebyrank(const Slice& key, int32_t start, int32_t stop
   rocksdb::WriteBatch batch;
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   if (s.ok()) {
     ParsedZSetsMetaValue parsed_zsets_meta_value(&meta_value);
     if (parsed_zsets_meta_value.IsStale()) {
@@ -769,14 +924,23 @@ Status RedisZSets::ZRemrangebyrank(const Slice& key, int32_t start, int32_t stop
       if (start_index > stop_index || start_index >= count) {
         return s;
       }
-      ZSetsScoreKey zsets_score_key(key, version, std::numeric_limits<double>::lowest(), Slice());
+      ZSetsRankDelta rank_delta;
+      InitRankDelta(key, version, false, &rank_delta);
       rocksdb::Iterator* iter = db_->NewIterator(default_read_options_, handles_[2]);
-      for (iter->Seek(zsets_score_key.Encode()); iter->Valid() && cur_index <= stop_index; iter->Next(), ++cur_index) {
+      if (RankIndexed(default_read_options_, key, version, count) &&
+          SeekByIndex(default_read_options_, key, version, start_index, iter).ok()) {
+        cur_index = start_index;
+      } else {
+        ZSetsScoreKey zsets_score_key(key, version, std::numeric_limits<double>::lowest(), Slice());
+        iter->Seek(zsets_score_key.Encode());
+      }
+      for (; iter->Valid() && cur_index <= stop_index; iter->Next(), ++cur_index) {
         if (cur_index >= start_index) {
           ParsedZSetsScoreKey parsed_zsets_score_key(iter->key());
           ZSetsMemberKey zsets_member_key(key, version, parsed_zsets_score_key.member());
           batch.Delete(handles_[1], zsets_member_key.Encode());
           batch.Delete(handles_[2], iter->key());
+          rank_delta.Add(parsed_zsets_score_key.score(), -1);
           del_cnt++;
           statistic++;
         }
@@ -788,11 +952,16 @@ Status RedisZSets::ZRemrangebyrank(const Slice& key, int32_t start, int32_t stop
       }
       parsed_zsets_meta_value.ModifyCount(-del_cnt);
       batch.Put(handles_[0], key, meta_value);
+      after = MetaKeyState(meta_value);
+      rank_delta.MergeTo(&batch, rank_handle_);
     }
   } else {
     return s;
   }
   s = db_->Write(default_write_options_, &batch);
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
   UpdateSpecificKeyStatistics(key.ToString(), statistic);
   return s;
 }
@@ -805,6 +974,8 @@ Status RedisZSets::ZRemrangebyscore(const Slice& key, double min, double max, bo
   rocksdb::WriteBatch batch;
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   if (s.ok()) {
     ParsedZSetsMetaValue parsed_zsets_meta_value(&meta_value);
     if (parsed_zsets_meta_value.IsStale()) {
@@ -817,6 +988,8 @@ Status RedisZSets::ZRemrangebyscore(const Slice& key, double min, double max, bo
       int32_t cur_index = 0;
       int32_t stop_index = parsed_zsets_meta_value.count() - 1;
       int32_t version = parsed_zsets_meta_value.version();
+      ZSetsRankDelta rank_delta;
+      InitRankDelta(key, version, false, &rank_delta);
       ZSetsScoreKey zsets_score_key(key, version, min, Slice());
       rocksdb::Iterator* iter = db_->NewIterator(default_read_options_, handles_[2]);
       for (iter->Seek(zsets_score_key.Encode()); iter->Valid() && cur_index <= stop_index; iter->Next(), ++cur_index) {
@@ -841,6 +1014,7 @@ Status RedisZSets::ZRemrangebyscore(const Slice& key, double min, double max, bo
           ZSetsMemberKey zsets_member_key(key, version, parsed_zsets_score_key.member());
           batch.Delete(handles_[1], zsets_member_key.Encode());
           batch.Delete(handles_[2], iter->key());
+          rank_delta.Add(parsed_zsets_score_key.score(), -1);
           del_cnt++;
           statistic++;
         }
@@ -855,11 +1029,16 @@ Status RedisZSets::ZRemrangebyscore(const Slice& key, double min, double max, bo
       }
       parsed_zsets_meta_value.ModifyCount(-del_cnt);
       batch.Put(handles_[0], key, meta_value);
+      after = MetaKeyState(meta_value);
+      rank_delta.MergeTo(&batch, rank_handle_);
     }
   } else {
     return s;
   }
   s = db_->Write(default_write_options_, &batch);
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
   UpdateSpecificKeyStatistics(key.ToString(), statistic);
   return s;
 }
@@ -892,10 +1071,15 @@ Status RedisZSets::ZRevrange(const Slice& key, int32_t start, int32_t stop, std:
       }
       int32_t cur_index = count - 1;
       ScoreMember score_member;
-      ZSetsScoreKey zsets_score_key(key, version, std::numeric_limits<double>::max(), Slice());
       rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[2]);
-      for (iter->SeekForPrev(zsets_score_key.Encode()); iter->Valid() && cur_index >= start_index;
-           iter->Prev(), --cur_index) {
+      if (RankIndexed(read_options, key, version, count) &&
+          SeekByIndex(read_options, key, version, stop_index, iter).ok()) {
+        cur_index = stop_index;
+      } else {
+        ZSetsScoreKey zsets_score_key(key, version, std::numeric_limits<double>::max(), Slice());
+        iter->SeekForPrev(zsets_score_key.Encode());
+      }
+      for (; iter->Valid() && cur_index >= start_index; iter->Prev(), --cur_index) {
         if (cur_index <= stop_index) {
           ParsedZSetsScoreKey parsed_zsets_score_key(iter->key());
           score_member.score = parsed_zsets_score_key.score();
@@ -994,6 +1178,21 @@ Status RedisZSets::ZRevrank(const Slice& key, const Slice& member, int32_t* rank
       int32_t rev_index = 0;
       int32_t left = parsed_zsets_meta_value.count();
       int32_t version = parsed_zsets_meta_value.version();
+      if (RankIndexed(read_options, key, version, left)) {
+        std::string data_value;
+        ZSetsMemberKey zsets_member_key(key, version, member);
+        s = db_->Get(read_options, handles_[1], zsets_member_key.Encode(), &data_value);
+        if (s.ok()) {
+          uint64_t tmp = DecodeFixed64(data_value.data());
+          const void* ptr_tmp = reinterpret_cast<const void*>(&tmp);
+          double score = *reinterpret_cast<const double*>(ptr_tmp);
+          s = RankByIndex(read_options, key, version, score, member, &rev_index);
+          if (s.ok()) {
+            *rank = left - rev_index - 1;
+          }
+        }
+        return s;
+      }
       ZSetsScoreKey zsets_score_key(key, version, std::numeric_limits<double>::max(), Slice());
       rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[2]);
       for (iter->SeekForPrev(zsets_score_key.Encode()); iter->Valid() && left >= 0; iter->Prev(), --left, ++rev_index) {
@@ -1110,6 +1309,8 @@ Status RedisZSets::ZUnionstore(const Slice& destination, const std::vector<std::
   }
 
   s = db_->Get(read_options, handles_[0], destination, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   if (s.ok()) {
     ParsedZSetsMetaValue parsed_zsets_meta_value(&meta_value);
     statistic = parsed_zsets_meta_value.count();
@@ -1119,15 +1320,19 @@ Status RedisZSets::ZUnionstore(const Slice& destination, const std::vector<std::
     }
     parsed_zsets_meta_value.set_count(static_cast<int32_t>(member_score_map.size()));
     batch.Put(handles_[0], destination, meta_value);
+    after = MetaKeyState(meta_value);
   } else {
     char buf[4];
     EncodeFixed32(buf, member_score_map.size());
     ZSetsMetaValue zsets_meta_value(Slice(buf, sizeof(int32_t)));
     version = zsets_meta_value.UpdateVersion();
     batch.Put(handles_[0], destination, zsets_meta_value.Encode());
+    after = MetaKeyState(zsets_meta_value.Encode());
   }
 
   char score_buf[8];
+  ZSetsRankDelta rank_delta;
+  InitRankDelta(destination, version, true, &rank_delta);
   for (const auto& sm : member_score_map) {
     ZSetsMemberKey zsets_member_key(destination, version, sm.first);
 
@@ -1137,9 +1342,14 @@ Status RedisZSets::ZUnionstore(const Slice& destination, const std::vector<std::
 
     ZSetsScoreKey zsets_score_key(destination, version, sm.second, sm.first);
     batch.Put(handles_[2], zsets_score_key.Encode(), Slice());
+    rank_delta.Add(sm.second, 1);
   }
+  rank_delta.MergeTo(&batch, rank_handle_);
   *ret = static_cast<int32_t>(member_score_map.size());
   s = db_->Write(default_write_options_, &batch);
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
   UpdateSpecificKeyStatistics(destination.ToString(), statistic);
   value_to_dest = std::move(member_score_map);
   return s;
@@ -1240,6 +1450,8 @@ Status RedisZSets::ZInterstore(const Slice& destination, const std::vector<std::
   }
 
   s = db_->Get(read_options, handles_[0], destination, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   if (s.ok()) {
     ParsedZSetsMetaValue parsed_zsets_meta_value(&meta_value);
     statistic = parsed_zsets_meta_value.count();
@@ -1249,14 +1461,18 @@ Status RedisZSets::ZInterstore(const Slice& destination, const std::vector<std::
     }
     parsed_zsets_meta_value.set_count(static_cast<int32_t>(final_score_members.size()));
     batch.Put(handles_[0], destination, meta_value);
+    after = MetaKeyState(meta_value);
   } else {
     char buf[4];
     EncodeFixed32(buf, final_score_members.size());
     ZSetsMetaValue zsets_meta_value(Slice(buf, sizeof(int32_t)));
     version = zsets_meta_value.UpdateVersion();
     batch.Put(handles_[0], destination, zsets_meta_value.Encode());
+    after = MetaKeyState(zsets_meta_value.Encode());
   }
   char score_buf[8];
+  ZSetsRankDelta rank_delta;
+  InitRankDelta(destination, version, true, &rank_delta);
   for (const auto& sm : final_score_members) {
     ZSetsMemberKey zsets_member_key(destination, version, sm.member);
 
@@ -1266,9 +1482,14 @@ Status RedisZSets::ZInterstore(const Slice& destination, const std::vector<std::
 
     ZSetsScoreKey zsets_score_key(destination, version, sm.score, sm.member);
     batch.Put(handles_[2], zsets_score_key.Encode(), Slice());
+    rank_delta.Add(sm.score, 1);
   }
+  rank_delta.MergeTo(&batch, rank_handle_);
   *ret = static_cast<int32_t>(final_score_members.size());
   s = db_->Write(default_write_options_, &batch);
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
   UpdateSpecificKeyStatistics(destination.ToString(), statistic);
   value_to_dest = std::move(final_score_members);
   return s;
@@ -1347,7 +1568,10 @@ Status RedisZSets::ZRemrangebylex(const Slice& key, const Slice& min, const Slic
 
   int32_t del_cnt = 0;
   std::string meta_value;
+  ZSetsRankDelta rank_delta;
   Status s = db_->Get(read_options, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   if (s.ok()) {
     ParsedZSetsMetaValue parsed_zsets_meta_value(&meta_value);
     if (parsed_zsets_meta_value.IsStale() || parsed_zsets_meta_value.count() == 0) {
@@ -1356,6 +1580,7 @@ Status RedisZSets::ZRemrangebylex(const Slice& key, const Slice& min, const Slic
       int32_t version = parsed_zsets_meta_value.version();
       int32_t cur_index = 0;
       int32_t stop_index = parsed_zsets_meta_value.count() - 1;
+      InitRankDelta(key, version, false, &rank_delta);
       ZSetsMemberKey zsets_member_key(key, version, Slice());
       rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[1]);
       for (iter->Seek(zsets_member_key.Encode()); iter->Valid() && cur_index <= stop_index; iter->Next(), ++cur_index) {
@@ -1377,6 +1602,7 @@ Status RedisZSets::ZRemrangebylex(const Slice& key, const Slice& min, const Slic
           double score = *reinterpret_cast<const double*>(ptr_tmp);
           ZSetsScoreKey zsets_score_key(key, version, score, member);
           batch.Delete(handles_[2], zsets_score_key.Encode());
+          rank_delta.Add(score, -1);
           del_cnt++;
           statistic++;
         }
@@ -1392,20 +1618,277 @@ Status RedisZSets::ZRemrangebylex(const Slice& key, const Slice& min, const Slic
       }
       parsed_zsets_meta_value.ModifyCount(-del_cnt);
       batch.Put(handles_[0], key, meta_value);
+      after = MetaKeyState(meta_value);
+      rank_delta.MergeTo(&batch, rank_handle_);
       *ret = del_cnt;
     }
   } else {
     return s;
   }
   s = db_->Write(default_write_options_, &batch);
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
   UpdateSpecificKeyStatistics(key.ToString(), statistic);
   return s;
 }
 
+bool RedisZSets::IsValidMetaValue(const Slice& meta_value) {
+  ParsedZSetsMetaValue parsed_zsets_meta_value(meta_value);
+  return !parsed_zsets_meta_value.IsStale() && parsed_zsets_meta_value.count() != 0;
+}
+
+Status RedisZSets::ReclaimExpiredKey(const Slice& key, int32_t timestamp, size_t* budget, rocksdb::WriteBatch* batch,
+                                     ExpiredKey* expired_key) {
+  std::string meta_value;
+  Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  if (s.IsNotFound()) {
+    expired_key->obsolete = true;
+    return Status::OK();
+  } else if (!s.ok()) {
+    return s;
+  }
+  ParsedZSetsMetaValue parsed_zsets_meta_value(&meta_value);
+  if (parsed_zsets_meta_value.timestamp() != timestamp || !parsed_zsets_meta_value.IsStale()) {
+    expired_key->obsolete = true;
+    return Status::OK();
+  }
+
+  int32_t version = parsed_zsets_meta_value.version();
+  // The member and rank keys both start with the BaseDataKey prefix
+  ZSetsMemberKey zsets_member_key(key, version, Slice());
+  ZSetsScoreKey zsets_score_key(key, version, std::numeric_limits<double>::lowest(), Slice());
+  if (!DeleteVersionData(handles_[1], key, zsets_member_key.Encode(), budget, batch) ||
+      !DeleteVersionData(handles_[2], key, zsets_score_key.Encode(), budget, batch) ||
+      (rank_handle_ && !DeleteVersionData(rank_handle_, key, zsets_member_key.Encode(), budget, batch))) {
+    return Status::OK();
+  }
+  batch->Delete(handles_[0], key);
+  expired_key->before = MetaKeyState(meta_value);
+  expired_key->deleted = true;
+  return Status::OK();
+}
+
+bool RedisZSets::RankIndexed(const rocksdb::ReadOptions& read_options, const Slice& key, int32_t version,
+                             int32_t count) {
+  if (!rank_index_enabled_) {
+    return false;
+  }
+  std::string root_value;
+  ZSetsRankKey root_key(key, version, 0, 0);
+  Status s = db_->Get(read_options, rank_handle_, root_key.Encode(), &root_value);
+  return s.ok() && DecodeZSetsRankCount(root_value) == count;
+}
+
+void RedisZSets::InitRankDelta(const Slice& key, int32_t version, bool fresh, ZSetsRankDelta* rank_delta) {
+  if (!rank_index_enabled_) {
+    return;
+  }
+  if (!fresh) {
+    // Keys written before the index was enabled wait for BuildRankIndex()
+    std::string root_value;
+    ZSetsRankKey root_key(key, version, 0, 0);
+    Status s = db_->Get(default_read_options_, rank_handle_, root_key.Encode(), &root_value);
+    if (!s.ok()) {
+      return;
+    }
+  }
+  rank_delta->Init(key, version);
+}
+
+Status RedisZSets::RankByIndex(const rocksdb::ReadOptions& read_options, const Slice& key, int32_t version,
+                               double score, const Slice& member, int32_t* rank) {
+  int64_t index = 0;
+  uint32_t bucket = ZSetsRankBucket(score);
+
+  // Add up the nodes on the left of the path from the root to the bucket
+  rocksdb::Iterator* iter = db_->NewIterator(read_options, rank_handle_);
+  for (int32_t level = 1; level <= kZSetsRankLevels; ++level) {
+    uint32_t node = ZSetsRankPrefix(bucket, level);
+    ZSetsRankKey rank_key(key, version, level, ZSetsRankPrefix(bucket, level - 1));
+    Slice level_prefix = rank_key.EncodeLevelPrefix();
+    for (iter->Seek(rank_key.Encode()); iter->Valid() && iter->key().starts_with(level_prefix); iter->Next()) {
+      ParsedZSetsRankKey parsed_zsets_rank_key(iter->key());
+      if (parsed_zsets_rank_key.prefix() >= node) {
+        break;
+      }
+      index += DecodeZSetsRankCount(iter->value());
+    }
+  }
+  Status s = iter->status();
+  delete iter;
+  if (!s.ok()) {
+    return s;
+  }
+
+  // Then count the members in front of it inside the bucket
+  bool found = false;
+  ZSetsScoreKey zsets_score_key(key, version, ZSetsRankBucketLowerBound(bucket), Slice());
+  iter = db_->NewIterator(read_options, handles_[2]);
+  for (iter->Seek(zsets_score_key.Encode()); iter->Valid(); iter->Next(), ++index) {
+    ParsedZSetsScoreKey parsed_zsets_score_key(iter->key());
+    if (parsed_zsets_score_key.key() != key || parsed_zsets_score_key.version() != version ||
+        parsed_zsets_score_key.score() > score) {
+      break;
+    }
+    if (parsed_zsets_score_key.score() == score && parsed_zsets_score_key.member().compare(member) == 0) {
+      found = true;
+      break;
+    }
+  }
+  delete iter;
+  if (!found) {
+    return Status::NotFound();
+  }
+  *rank = static_cast<int32_t>(index);
+  return Status::OK();
+}
+
+Status RedisZSets::SeekByIndex(const rocksdb::ReadOptions& read_options, const Slice& key, int32_t version,
+                               int32_t rank, rocksdb::Iterator* score_iter) {
+  int64_t left = rank;
+  uint32_t prefix = 0;
+
+  // Walk down to the bucket holding the rank, skipping whole subtrees on the way
+  rocksdb::Iterator* iter = db_->NewIterator(read_options, rank_handle_);
+  for (int32_t level = 1; level <= kZSetsRankLevels; ++level) {
+    bool descended = false;
+    uint64_t parent_end = static_cast<uint64_t>(prefix) + ZSetsRankSpan(level - 1);
+    ZSetsRankKey rank_key(key, version, level, prefix);
+    Slice level_prefix = rank_key.EncodeLevelPrefix();
+    for (iter->Seek(rank_key.Encode()); iter->Valid() && iter->key().starts_with(level_prefix); iter->Next()) {
+      ParsedZSetsRankKey parsed_zsets_rank_key(iter->key());
+      if (parsed_zsets_rank_key.prefix() >= parent_end) {
+        break;
+      }
+      int64_t count = DecodeZSetsRankCount(iter->value());
+      if (left < count) {
+        prefix = parsed_zsets_rank_key.prefix();
+        descended = true;
+        break;
+      }
+      left -= count;
+    }
+    if (!descended) {
+      Status s = iter->status();
+      delete iter;
+      return s.ok() ? Status::Corruption("zset rank index mismatch") : s;
+    }
+  }
+  delete iter;
+
+  ZSetsScoreKey zsets_score_key(key, version, ZSetsRankBucketLowerBound(prefix), Slice());
+  for (score_iter->Seek(zsets_score_key.Encode()); score_iter->Valid() && left > 0; score_iter->Next()) {
+    --left;
+  }
+  if (!score_iter->Valid()) {
+    return Status::Corruption("zset rank index mismatch");
+  }
+  return Status::OK();
+}
+
+Status RedisZSets::BuildRankIndex(const Slice& key) {
+  std::string meta_value;
+  rocksdb::WriteBatch batch;
+  ScopeRecordLock l(lock_mgr_, key);
+  Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  if (!s.ok()) {
+    return s;
+  }
+  ParsedZSetsMetaValue parsed_zsets_meta_value(&meta_value);
+  if (parsed_zsets_meta_value.IsStale() || parsed_zsets_meta_value.count() == 0) {
+    return Status::NotFound();
+  }
+  int32_t count = parsed_zsets_meta_value.count();
+  int32_t version = parsed_zsets_meta_value.version();
+  std::string root_value;
+  ZSetsRankKey root_key(key, version, 0, 0);
+  s = db_->Get(default_read_options_, rank_handle_, root_key.Encode(), &root_value);
+  if (s.ok()) {
+    if (DecodeZSetsRankCount(root_value) == count) {
+      return Status::OK();
+    }
+    // Out of sync, throw the old nodes away before writing the new ones
+    ZSetsRankKey end_key(key, version, kZSetsRankLevels + 1, 0);
+    batch.DeleteRange(rank_handle_, root_key.Encode(), end_key.Encode());
+  } else if (!s.IsNotFound()) {
+    return s;
+  }
+
+  int32_t cur_index = 0;
+  ZSetsRankDelta rank_delta;
+  rank_delta.Init(key, version);
+  ZSetsScoreKey zsets_score_key(key, version, -std::numeric_limits<double>::infinity(), Slice());
+  rocksdb::ReadOptions iterator_options;
+  iterator_options.fill_cache = false;
+  rocksdb::Iterator* iter = db_->NewIterator(iterator_options, handles_[2]);
+  for (iter->Seek(zsets_score_key.Encode()); iter->Valid() && cur_index < count; iter->Next(), ++cur_index) {
+    ParsedZSetsScoreKey parsed_zsets_score_key(iter->key());
+    if (parsed_zsets_score_key.key() != key || parsed_zsets_score_key.version() != version) {
+      break;
+    }
+    rank_delta.Add(parsed_zsets_score_key.score(), 1);
+  }
+  s = iter->status();
+  delete iter;
+  if (!s.ok()) {
+    return s;
+  }
+  if (cur_index != count) {
+    return Status::Corruption("zset members do not match the meta count");
+  }
+  rank_delta.PutTo(&batch, rank_handle_);
+  return db_->Write(default_write_options_, &batch);
+}
+
+void RedisZSets::BuildRankIndexes() {
+  rocksdb::ReadOptions iterator_options;
+  const rocksdb::Snapshot* snapshot;
+  ScopeSnapshot ss(db_, &snapshot);
+  iterator_options.snapshot = snapshot;
+  iterator_options.fill_cache = false;
+
+  uint64_t built = 0;
+  rocksdb::Iterator* iter = db_->NewIterator(iterator_options, handles_[0]);
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    ParsedZSetsMetaValue parsed_zsets_meta_value(iter->value());
+    if (parsed_zsets_meta_value.IsStale() || parsed_zsets_meta_value.count() == 0 ||
+        RankIndexed(iterator_options, iter->key(), parsed_zsets_meta_value.version(),
+                    parsed_zsets_meta_value.count())) {
+      continue;
+    }
+    Status s = BuildRankIndex(iter->key());
+    if (s.ok()) {
+      built++;
+    } else if (!s.IsNotFound()) {
+      LOG(WARNING) << "Build rank index for zset " << iter->key().ToString() << " failed, " << s.ToString();
+    }
+  }
+  delete iter;
+  if (built != 0) {
+    LOG(INFO) << "Built rank index for " << built << " zsets";
+  }
+}
+
+Status RedisZSets::ClearRankIndexes() {
+  rocksdb::Iterator* iter = db_->NewIterator(default_read_options_, rank_handle_);
+  iter->SeekToFirst();
+  bool empty = !iter->Valid();
+  delete iter;
+  if (empty) {
+    return Status::OK();
+  }
+  // Data keys start with the 4 bytes key size, nothing sorts after this
+  std::string end_key(sizeof(int32_t) + 1, static_cast<char>(0xff));
+  return db_->DeleteRange(default_write_options_, rank_handle_, Slice(), end_key);
+}
+
 Status RedisZSets::Expire(const Slice& key, int32_t ttl) {
   std::string meta_value;
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   if (s.ok()) {
     ParsedZSetsMetaValue parsed_zsets_meta_value(&meta_value);
     if (parsed_zsets_meta_value.IsStale()) {
@@ -1419,7 +1902,11 @@ Status RedisZSets::Expire(const Slice& key, int32_t ttl) {
     } else {
       parsed_zsets_meta_value.InitialMetaValue();
     }
-    s = db_->Put(default_write_options_, handles_[0], key, meta_value);
+    after = MetaKeyState(meta_value);
+    s = PutMetaValue(key, meta_value, before, after);
+  }
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
   }
   return s;
 }
@@ -1428,6 +1915,8 @@ Status RedisZSets::Del(const Slice& key) {
   std::string meta_value;
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
+  KeyState after = before;
   if (s.ok()) {
     ParsedZSetsMetaValue parsed_zsets_meta_value(&meta_value);
     if (parsed_zsets_meta_value.IsStale()) {
@@ -1437,10 +1926,14 @@ Status RedisZSets::Del(const Slice& key) {
     } else {
       uint32_t statistic = parsed_zsets_meta_value.count();
       parsed_zsets_meta_value.InitialMetaValue();
-      s = db_->Put(default_write_options_, handles_[0], key, meta_value);
+      after = MetaKeyState(meta_value);
+      s = PutMetaValue(key, meta_value, before, after);
       UpdateSpecificKeyStatistics(key.ToString(), statistic);
     }
   }
+  if (s.ok()) {
+    key_statistics_.Update(before, after);
+  }
   return s;
 }
 
@@ -1454,9 +1947,12 @@ bool RedisZSets::Scan(const std::string& start_key, const std::string& pattern,
   iterator_options.snapshot = snapshot;
   iterator_options.fill_cache = false;
 
+  pstd::GlobMatcher matcher(pattern);
+  ScanRange range(matcher);
+  range.Bound(&iterator_options);
   rocksdb::Iterator* it = db_->NewIterator(iterator_options, handles_[0]);
 
-  it->Seek(start_key);
+  it->Seek(range.SeekKey(start_key));
   while (it->Valid() && (*count) > 0) {
     ParsedZSetsMetaValue parsed_zsets_meta_value(it->value());
     if (parsed_zsets_meta_value.IsStale() || parsed_zsets_meta_value.count() == 0) {
@@ -1464,7 +1960,7 @@ bool RedisZSets::Scan(const std::string& start_key, const std::string& pattern,
       continue;
     } else {
       meta_key = it->key().ToString();
-      if (StringMatch(pattern.data(), pattern.size(), meta_key.data(), meta_key.size(), 0) != 0) {
+      if (matcher.Match(meta_key.data(), meta_key.size())) {
         keys->push_back(meta_key);
       }
       (*count)--;
@@ -1472,8 +1968,7 @@ bool RedisZSets::Scan(const std::string& start_key, const std::string& pattern,
     }
   }
 
-  std::string prefix = isTailWildcard(pattern) ? pattern.substr(0, pattern.size() - 1) : "";
-  if (it->Valid() && (it->key().compare(prefix) <= 0 || it->key().starts_with(prefix))) {
+  if (it->Valid()) {
     *next_key = it->key().ToString();
     is_finish = false;
   } else {
@@ -1522,6 +2017,7 @@ Status RedisZSets::Expireat(const Slice& key, int32_t timestamp) {
   std::string meta_value;
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
   if (s.ok()) {
     ParsedZSetsMetaValue parsed_zsets_meta_value(&meta_value);
     if (parsed_zsets_meta_value.IsStale()) {
@@ -1534,7 +2030,12 @@ Status RedisZSets::Expireat(const Slice& key, int32_t timestamp) {
       } else {
         parsed_zsets_meta_value.InitialMetaValue();
       }
-      return db_->Put(default_write_options_, handles_[0], key, meta_value);
+      KeyState after = MetaKeyState(meta_value);
+      s = PutMetaValue(key, meta_value, before, after);
+      if (s.ok()) {
+        key_statistics_.Update(before, after);
+      }
+      return s;
     }
   }
   return s;
@@ -1581,12 +2082,13 @@ Status RedisZSets::ZScan(const Slice& key, int64_t cursor, const std::string& pa
       ZSetsMemberKey zsets_member_prefix(key, version, sub_member);
       ZSetsMemberKey zsets_member_key(key, version, start_point);
       std::string prefix = zsets_member_prefix.Encode().ToString();
+      pstd::GlobMatcher matcher(pattern);
       rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[1]);
       for (iter->Seek(zsets_member_key.Encode()); iter->Valid() && rest > 0 && iter->key().starts_with(prefix);
            iter->Next()) {
         ParsedZSetsMemberKey parsed_zsets_member_key(iter->key());
         std::string member = parsed_zsets_member_key.member().ToString();
-        if (StringMatch(pattern.data(), pattern.size(), member.data(), member.size(), 0) != 0) {
+        if (matcher.Match(member.data(), member.size())) {
           uint64_t tmp = DecodeFixed64(iter->value().data());
           const void* ptr_tmp = reinterpret_cast<const void*>(&tmp);
           double score = *reinterpret_cast<const double*>(ptr_tmp);
@@ -1638,13 +2140,14 @@ Status RedisZSets::PKScanRange(const Slice& key_start, const Slice& key_end, con
     it->Seek(key_start);
   }
 
+  pstd::GlobMatcher matcher(pattern.data(), pattern.size(), false);
   while (it->Valid() && remain > 0 && (end_no_limit || it->key().compare(key_end) <= 0)) {
     ParsedZSetsMetaValue parsed_zsets_meta_value(it->value());
     if (parsed_zsets_meta_value.IsStale() || parsed_zsets_meta_value.count() == 0) {
       it->Next();
     } else {
       key = it->key().ToString();
-      if (StringMatch(pattern.data(), pattern.size(), key.data(), key.size(), 0) != 0) {
+      if (matcher.Match(key.data(), key.size())) {
         keys->push_back(key);
       }
       remain--;
@@ -1691,13 +2194,14 @@ Status RedisZSets::PKRScanRange(const Slice& key_start, const Slice& key_end, co
     it->SeekForPrev(key_start);
   }
 
+  pstd::GlobMatcher matcher(pattern.data(), pattern.size(), false);
   while (it->Valid() && remain > 0 && (end_no_limit || it->key().compare(key_end) >= 0)) {
     ParsedZSetsMetaValue parsed_zsets_meta_value(it->value());
     if (parsed_zsets_meta_value.IsStale() || parsed_zsets_meta_value.count() == 0) {
       it->Prev();
     } else {
       key = it->key().ToString();
-      if (StringMatch(pattern.data(), pattern.size(), key.data(), key.size(), 0) != 0) {
+      if (matcher.Match(key.data(), key.size())) {
         keys->push_back(key);
       }
       remain--;
@@ -1722,6 +2226,7 @@ Status RedisZSets::Persist(const Slice& key) {
   std::string meta_value;
   ScopeRecordLock l(lock_mgr_, key);
   Status s = db_->Get(default_read_options_, handles_[0], key, &meta_value);
+  KeyState before = s.ok() ? MetaKeyState(meta_value) : KeyState();
   if (s.ok()) {
     ParsedZSetsMetaValue parsed_zsets_meta_value(&meta_value);
     if (parsed_zsets_meta_value.IsStale()) {
@@ -1734,7 +2239,12 @@ Status RedisZSets::Persist(const Slice& key) {
         return Status::NotFound("Not have an associated timeout");
       } else {
         parsed_zsets_meta_value.set_timestamp(0);
-        return db_->Put(default_write_options_, handles_[0], key, meta_value);
+        KeyState after = MetaKeyState(meta_value);
+        s = PutMetaValue(key, meta_value, before, after);
+        if (s.ok()) {
+          key_statistics_.Update(before, after);
+        }
+        return s;
       }
     }
   }
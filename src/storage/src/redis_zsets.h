@@ -12,6 +12,7 @@
 
 #include "src/custom_comparator.h"
 #include "src/redis.h"
+#include "src/zsets_rank_index.h"
 
 namespace storage {
 
@@ -78,6 +79,29 @@ class RedisZSets : public Redis {
 
   // Iterate all data
   void ScanDatabase();
+
+ protected:
+  bool IsValidMetaValue(const Slice& meta_value) override;
+  Status ReclaimExpiredKey(const Slice& key, int32_t timestamp, size_t* budget, rocksdb::WriteBatch* batch,
+                           ExpiredKey* expired_key) override;
+
+ private:
+  // Rank index
+  bool RankIndexed(const rocksdb::ReadOptions& read_options, const Slice& key, int32_t version, int32_t count);
+  void InitRankDelta(const Slice& key, int32_t version, bool fresh, ZSetsRankDelta* rank_delta);
+  Status RankByIndex(const rocksdb::ReadOptions& read_options, const Slice& key, int32_t version, double score,
+                     const Slice& member, int32_t* rank);
+  Status SeekByIndex(const rocksdb::ReadOptions& read_options, const Slice& key, int32_t version, int32_t rank,
+                     rocksdb::Iterator* score_iter);
+  Status BuildRankIndex(const Slice& key);
+  void BuildRankIndexes();
+  Status ClearRankIndexes();
+
+  bool rank_index_enabled_ = false;
+  // rank_cf is only opened while the index is enabled, or to clear what is
+  // left of it once disabled, so databases never indexed stay readable by
+  // the versions without it. nullptr when not opened
+  rocksdb::ColumnFamilyHandle* rank_handle_ = nullptr;
 };
 
 }  // namespace storage
@@ -0,0 +1,64 @@
+//  Copyright (c) 2017-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef SRC_SCAN_RANGE_H_
+#define SRC_SCAN_RANGE_H_
+
+#include <string>
+
+#include "rocksdb/options.h"
+#include "rocksdb/slice.h"
+
+#include "pstd/include/noncopyable.h"
+#include "pstd/include/pstd_glob.h"
+
+namespace storage {
+
+/*
+ * The meta keys a pattern can match, the ones starting with its literal
+ * prefix. The bounds are kept here, so it must outlive the iterators it
+ * bounds.
+ */
+class ScanRange : public pstd::noncopyable {
+ public:
+  explicit ScanRange(const pstd::GlobMatcher& matcher) : lower_(matcher.literal_prefix()), upper_(lower_) {
+    // The smallest key above every key starting with the prefix, none if
+    // the prefix is all 0xff
+    while (!upper_.empty() && static_cast<unsigned char>(upper_.back()) == 0xff) {
+      upper_.pop_back();
+    }
+    if (!upper_.empty()) {
+      upper_.back() = static_cast<char>(static_cast<unsigned char>(upper_.back()) + 1);
+    }
+    lower_slice_ = lower_;
+    upper_slice_ = upper_;
+  }
+
+  // Stops the iterators created with options at the end of the range
+  void Bound(rocksdb::ReadOptions* options) const {
+    if (!lower_.empty()) {
+      options->iterate_lower_bound = &lower_slice_;
+    }
+    if (!upper_.empty()) {
+      options->iterate_upper_bound = &upper_slice_;
+    }
+  }
+
+  // Where a scan resuming at start_key seeks to
+  rocksdb::Slice SeekKey(const rocksdb::Slice& start_key) const {
+    return start_key.compare(lower_slice_) < 0 ? lower_slice_ : start_key;
+  }
+
+  const std::string& prefix() const { return lower_; }
+
+ private:
+  std::string lower_;
+  std::string upper_;
+  rocksdb::Slice lower_slice_;
+  rocksdb::Slice upper_slice_;
+};
+
+}  // namespace storage
+#endif  // SRC_SCAN_RANGE_H_
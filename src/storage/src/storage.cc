@@ -8,11 +8,13 @@
 
 #include <glog/logging.h>
 
+#include <chrono>
 #include <utility>
 
+#include "pstd/include/pstd_glob.h"
+#include "pstd/include/pstd_parallel.h"
 #include "scope_snapshot.h"
 #include "src/lru_cache.h"
-#include "src/mutex_impl.h"
 #include "src/options_helper.h"
 #include "src/redis_hashes.h"
 #include "src/redis_hyperloglog.h"
@@ -20,9 +22,13 @@
 #include "src/redis_sets.h"
 #include "src/redis_strings.h"
 #include "src/redis_zsets.h"
+#include "src/value_cache.h"
 
 namespace storage {
 
+// How often the bg thread persists the keyspace statistics when it has nothing else to do
+static const std::chrono::seconds kKeyStatisticsPersistInterval(60);
+
 Status StorageOptions::ResetOptions(const OptionType& option_type,
                                     const std::unordered_map<std::string, std::string>& options_map) {
   std::unordered_map<std::string, MemberTypeInfo>& options_member_type_info = mutable_cf_options_member_type_info;
@@ -50,7 +56,7 @@ Status StorageOptions::ResetOptions(const OptionType& option_type,
 }
 
 Storage::Storage() {
-  cursors_store_ = std::make_unique<LRUCache<std::string, std::string>>();
+  cursors_store_ = std::make_unique<ShardedLRUCache<std::string, std::string>>();
   cursors_store_->SetCapacity(5000);
 
   Status s = StartBGThread();
@@ -89,38 +95,74 @@ Status Storage::Open(const StorageOptions& storage_options, const std::string& d
   mkpath(db_path.c_str(), 0755);
 
   strings_db_ = std::make_unique<RedisStrings>(this, kStrings);
-  Status s = strings_db_->Open(storage_options, AppendSubDirectory(db_path, "strings"));
-  if (!s.ok()) {
-    LOG(FATAL) << "open kv db failed, " << s.ToString();
-  }
-
   hashes_db_ = std::make_unique<RedisHashes>(this, kHashes);
-  s = hashes_db_->Open(storage_options, AppendSubDirectory(db_path, "hashes"));
-  if (!s.ok()) {
-    LOG(FATAL) << "open hashes db failed, " << s.ToString();
-  }
-
   sets_db_ = std::make_unique<RedisSets>(this, kSets);
-  s = sets_db_->Open(storage_options, AppendSubDirectory(db_path, "sets"));
-  if (!s.ok()) {
-    LOG(FATAL) << "open set db failed, " << s.ToString();
-  }
-
   lists_db_ = std::make_unique<RedisLists>(this, kLists);
-  s = lists_db_->Open(storage_options, AppendSubDirectory(db_path, "lists"));
-  if (!s.ok()) {
-    LOG(FATAL) << "open list db failed, " << s.ToString();
-  }
-
   zsets_db_ = std::make_unique<RedisZSets>(this, kZSets);
-  s = zsets_db_->Open(storage_options, AppendSubDirectory(db_path, "zsets"));
-  if (!s.ok()) {
-    LOG(FATAL) << "open zset db failed, " << s.ToString();
+  if (storage_options.value_cache_size > 0) {
+    value_cache_ = std::make_unique<ValueCache>(storage_options.value_cache_size);
+    strings_db_->set_value_cache(value_cache_.get());
+    hashes_db_->set_value_cache(value_cache_.get());
+  }
+
+  // Each type db replays its own MANIFEST and WAL, so they are opened side by side
+  const std::vector<std::pair<std::string, Redis*>> type_dbs = {{"strings", strings_db_.get()},
+                                                                {"hashes", hashes_db_.get()},
+                                                                {"sets", sets_db_.get()},
+                                                                {"lists", lists_db_.get()},
+                                                                {"zsets", zsets_db_.get()}};
+  std::vector<Status> statuses(type_dbs.size());
+  pstd::ParallelFor(storage_options.open_threads, type_dbs.size(), [&](size_t i) {
+    auto start = std::chrono::steady_clock::now();
+    statuses[i] = type_dbs[i].second->Open(storage_options, AppendSubDirectory(db_path, type_dbs[i].first));
+    if (statuses[i].ok()) {
+      type_dbs[i].second->LoadKeyStatistics(AppendSubDirectory(db_path, type_dbs[i].first));
+    }
+    auto cost = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    type_dbs[i].second->set_open_time_us(cost.count());
+  });
+  for (size_t i = 0; i < type_dbs.size(); i++) {
+    if (!statuses[i].ok()) {
+      LOG(FATAL) << "open " << type_dbs[i].first << " db failed, " << statuses[i].ToString();
+    }
+    LOG(INFO) << "open " << AppendSubDirectory(db_path, type_dbs[i].first) << " in "
+              << type_dbs[i].second->open_time_us() / 1000 << "ms";
+    if (type_dbs[i].second->IsKeyStatisticsKept() && !type_dbs[i].second->IsKeyStatisticsExact()) {
+      LOG(WARNING) << "the keyspace statistics of " << AppendSubDirectory(db_path, type_dbs[i].first)
+                   << " are estimated, run info keyspace 1 to recount them";
+    }
   }
+  active_expire_batch_size_ = storage_options.active_expire_batch_size;
+  active_expire_cycle_ms_ = storage_options.active_expire_cycle_ms;
   is_opened_.store(true);
   return Status::OK();
 }
 
+std::vector<std::pair<DataType, Redis*>> Storage::TypeDBs() {
+  return {{kStrings, strings_db_.get()},
+          {kHashes, hashes_db_.get()},
+          {kSets, sets_db_.get()},
+          {kLists, lists_db_.get()},
+          {kZSets, zsets_db_.get()}};
+}
+
+bool Storage::ProbeKeyOwners(const Slice& key, std::vector<std::pair<DataType, Redis*>>* owners,
+                             std::map<DataType, Status>* type_status) {
+  bool all_ok = true;
+  const std::vector<std::string> keys = {key.ToString()};
+  std::vector<Status> statuses;
+  for (const auto& [type, db] : TypeDBs()) {
+    db->MultiExists(keys, &statuses);
+    if (statuses[0].ok()) {
+      owners->emplace_back(type, db);
+    } else if (!statuses[0].IsNotFound()) {
+      all_ok = false;
+      (*type_status)[type] = statuses[0];
+    }
+  }
+  return all_ok;
+}
+
 Status Storage::GetStartKey(const DataType& dtype, int64_t cursor, std::string* start_key) {
   std::string index_key = DataTypeTag[dtype] + std::to_string(cursor);
   return cursors_store_->Lookup(index_key, start_key);
@@ -507,110 +549,48 @@ Status Storage::ZScan(const Slice& key, int64_t cursor, const std::string& patte
 
 // Keys Commands
 int32_t Storage::Expire(const Slice& key, int32_t ttl, std::map<DataType, Status>* type_status) {
-  int32_t ret = 0;
-  bool is_corruption = false;
-
-  // Strings
-  Status s = strings_db_->Expire(key, ttl);
-  if (s.ok()) {
-    ret++;
-  } else if (!s.IsNotFound()) {
-    is_corruption = true;
-    (*type_status)[DataType::kStrings] = s;
-  }
-
-  // Hash
-  s = hashes_db_->Expire(key, ttl);
-  if (s.ok()) {
-    ret++;
-  } else if (!s.IsNotFound()) {
-    is_corruption = true;
-    (*type_status)[DataType::kHashes] = s;
-  }
-
-  // Sets
-  s = sets_db_->Expire(key, ttl);
-  if (s.ok()) {
-    ret++;
-  } else if (!s.IsNotFound()) {
-    is_corruption = true;
-    (*type_status)[DataType::kSets] = s;
-  }
-
-  // Lists
-  s = lists_db_->Expire(key, ttl);
-  if (s.ok()) {
-    ret++;
-  } else if (!s.IsNotFound()) {
-    is_corruption = true;
-    (*type_status)[DataType::kLists] = s;
-  }
+  int32_t count = 0;
+  std::vector<std::pair<DataType, Redis*>> owners;
+  bool is_corruption = !ProbeKeyOwners(key, &owners, type_status);
 
-  // Zsets
-  s = zsets_db_->Expire(key, ttl);
-  if (s.ok()) {
-    ret++;
-  } else if (!s.IsNotFound()) {
-    is_corruption = true;
-    (*type_status)[DataType::kZSets] = s;
+  // Only the types owning the key take the record lock and rewrite the meta value
+  for (const auto& [type, db] : owners) {
+    Status s = db->Expire(key, ttl);
+    if (s.ok()) {
+      count++;
+    } else if (!s.IsNotFound()) {
+      is_corruption = true;
+      (*type_status)[type] = s;
+    }
   }
 
   if (is_corruption) {
     return -1;
   } else {
-    return ret;
+    return count;
   }
 }
 
 int64_t Storage::Del(const std::vector<std::string>& keys, std::map<DataType, Status>* type_status) {
-  Status s;
   int64_t count = 0;
   bool is_corruption = false;
-
-  for (const auto& key : keys) {
-    // Strings
-    Status s = strings_db_->Del(key);
-    if (s.ok()) {
-      count++;
-    } else if (!s.IsNotFound()) {
-      is_corruption = true;
-      (*type_status)[DataType::kStrings] = s;
-    }
-
-    // Hashes
-    s = hashes_db_->Del(key);
-    if (s.ok()) {
-      count++;
-    } else if (!s.IsNotFound()) {
-      is_corruption = true;
-      (*type_status)[DataType::kHashes] = s;
-    }
-
-    // Sets
-    s = sets_db_->Del(key);
-    if (s.ok()) {
-      count++;
-    } else if (!s.IsNotFound()) {
-      is_corruption = true;
-      (*type_status)[DataType::kSets] = s;
-    }
-
-    // Lists
-    s = lists_db_->Del(key);
-    if (s.ok()) {
-      count++;
-    } else if (!s.IsNotFound()) {
-      is_corruption = true;
-      (*type_status)[DataType::kLists] = s;
-    }
-
-    // ZSets
-    s = zsets_db_->Del(key);
-    if (s.ok()) {
-      count++;
-    } else if (!s.IsNotFound()) {
-      is_corruption = true;
-      (*type_status)[DataType::kZSets] = s;
+  std::vector<Status> statuses;
+
+  for (const auto& [type, db] : TypeDBs()) {
+    // Probe all the keys with one batched lookup, and only
+    // delete the keys that exist in this type
+    db->MultiExists(keys, &statuses);
+    for (size_t idx = 0; idx < keys.size(); ++idx) {
+      Status s = statuses[idx];
+      if (s.ok()) {
+        s = db->Del(keys[idx]);
+      }
+      if (s.ok()) {
+        count++;
+      } else if (!s.IsNotFound()) {
+        is_corruption = true;
+        (*type_status)[type] = s;
+      }
     }
   }
 
@@ -693,51 +673,18 @@ int64_t Storage::DelByType(const std::vector<std::string>& keys, const DataType&
 
 int64_t Storage::Exists(const std::vector<std::string>& keys, std::map<DataType, Status>* type_status) {
   int64_t count = 0;
-  int32_t ret;
-  uint64_t llen;
-  std::string value;
-  Status s;
   bool is_corruption = false;
-
-  for (const auto& key : keys) {
-    s = strings_db_->Get(key, &value);
-    if (s.ok()) {
-      count++;
-    } else if (!s.IsNotFound()) {
-      is_corruption = true;
-      (*type_status)[DataType::kStrings] = s;
-    }
-
-    s = hashes_db_->HLen(key, &ret);
-    if (s.ok()) {
-      count++;
-    } else if (!s.IsNotFound()) {
-      is_corruption = true;
-      (*type_status)[DataType::kHashes] = s;
-    }
-
-    s = sets_db_->SCard(key, &ret);
-    if (s.ok()) {
-      count++;
-    } else if (!s.IsNotFound()) {
-      is_corruption = true;
-      (*type_status)[DataType::kSets] = s;
-    }
-
-    s = lists_db_->LLen(key, &llen);
-    if (s.ok()) {
-      count++;
-    } else if (!s.IsNotFound()) {
-      is_corruption = true;
-      (*type_status)[DataType::kLists] = s;
-    }
-
-    s = zsets_db_->ZCard(key, &ret);
-    if (s.ok()) {
-      count++;
-    } else if (!s.IsNotFound()) {
-      is_corruption = true;
-      (*type_status)[DataType::kZSets] = s;
+  std::vector<Status> statuses;
+
+  for (const auto& [type, db] : TypeDBs()) {
+    db->MultiExists(keys, &statuses);
+    for (const auto& s : statuses) {
+      if (s.ok()) {
+        count++;
+      } else if (!s.IsNotFound()) {
+        is_corruption = true;
+        (*type_status)[type] = s;
+      }
     }
   }
 
@@ -757,9 +704,9 @@ int64_t Storage::Scan(const DataType& dtype, int64_t cursor, const std::string&
   int64_t cursor_ret = 0;
   std::string start_key;
   std::string next_key;
-  std::string prefix;
-
-  prefix = isTailWildcard(pattern) ? pattern.substr(0, pattern.size() - 1) : "";
+  // Every type db starts from the literal prefix of the pattern, the keys
+  // before it can't match
+  std::string prefix = pstd::GlobMatcher(pattern).literal_prefix();
 
   if (cursor < 0) {
     return cursor_ret;
@@ -1083,48 +1030,18 @@ Status Storage::Scanx(const DataType& data_type, const std::string& start_key, c
 }
 
 int32_t Storage::Expireat(const Slice& key, int32_t timestamp, std::map<DataType, Status>* type_status) {
-  Status s;
   int32_t count = 0;
-  bool is_corruption = false;
-
-  s = strings_db_->Expireat(key, timestamp);
-  if (s.ok()) {
-    count++;
-  } else if (!s.IsNotFound()) {
-    is_corruption = true;
-    (*type_status)[DataType::kStrings] = s;
-  }
-
-  s = hashes_db_->Expireat(key, timestamp);
-  if (s.ok()) {
-    count++;
-  } else if (!s.IsNotFound()) {
-    is_corruption = true;
-    (*type_status)[DataType::kHashes] = s;
-  }
-
-  s = sets_db_->Expireat(key, timestamp);
-  if (s.ok()) {
-    count++;
-  } else if (!s.IsNotFound()) {
-    is_corruption = true;
-    (*type_status)[DataType::kSets] = s;
-  }
-
-  s = lists_db_->Expireat(key, timestamp);
-  if (s.ok()) {
-    count++;
-  } else if (!s.IsNotFound()) {
-    is_corruption = true;
-    (*type_status)[DataType::kLists] = s;
-  }
+  std::vector<std::pair<DataType, Redis*>> owners;
+  bool is_corruption = !ProbeKeyOwners(key, &owners, type_status);
 
-  s = zsets_db_->Expireat(key, timestamp);
-  if (s.ok()) {
-    count++;
-  } else if (!s.IsNotFound()) {
-    is_corruption = true;
-    (*type_status)[DataType::kLists] = s;
+  for (const auto& [type, db] : owners) {
+    Status s = db->Expireat(key, timestamp);
+    if (s.ok()) {
+      count++;
+    } else if (!s.IsNotFound()) {
+      is_corruption = true;
+      (*type_status)[type] = s;
+    }
   }
 
   if (is_corruption) {
@@ -1135,48 +1052,18 @@ int32_t Storage::Expireat(const Slice& key, int32_t timestamp, std::map<DataType
 }
 
 int32_t Storage::Persist(const Slice& key, std::map<DataType, Status>* type_status) {
-  Status s;
   int32_t count = 0;
-  bool is_corruption = false;
-
-  s = strings_db_->Persist(key);
-  if (s.ok()) {
-    count++;
-  } else if (!s.IsNotFound()) {
-    is_corruption = true;
-    (*type_status)[DataType::kStrings] = s;
-  }
-
-  s = hashes_db_->Persist(key);
-  if (s.ok()) {
-    count++;
-  } else if (!s.IsNotFound()) {
-    is_corruption = true;
-    (*type_status)[DataType::kHashes] = s;
-  }
+  std::vector<std::pair<DataType, Redis*>> owners;
+  bool is_corruption = !ProbeKeyOwners(key, &owners, type_status);
 
-  s = sets_db_->Persist(key);
-  if (s.ok()) {
-    count++;
-  } else if (!s.IsNotFound()) {
-    is_corruption = true;
-    (*type_status)[DataType::kSets] = s;
-  }
-
-  s = lists_db_->Persist(key);
-  if (s.ok()) {
-    count++;
-  } else if (!s.IsNotFound()) {
-    is_corruption = true;
-    (*type_status)[DataType::kLists] = s;
-  }
-
-  s = zsets_db_->Persist(key);
-  if (s.ok()) {
-    count++;
-  } else if (!s.IsNotFound()) {
-    is_corruption = true;
-    (*type_status)[DataType::kLists] = s;
+  for (const auto& [type, db] : owners) {
+    Status s = db->Persist(key);
+    if (s.ok()) {
+      count++;
+    } else if (!s.IsNotFound()) {
+      is_corruption = true;
+      (*type_status)[type] = s;
+    }
   }
 
   if (is_corruption) {
@@ -1187,48 +1074,23 @@ int32_t Storage::Persist(const Slice& key, std::map<DataType, Status>* type_stat
 }
 
 std::map<DataType, int64_t> Storage::TTL(const Slice& key, std::map<DataType, Status>* type_status) {
-  Status s;
   std::map<DataType, int64_t> ret;
-  int64_t timestamp = 0;
-
-  s = strings_db_->TTL(key, &timestamp);
-  if (s.ok() || s.IsNotFound()) {
-    ret[DataType::kStrings] = timestamp;
-  } else if (!s.IsNotFound()) {
-    ret[DataType::kStrings] = -3;
-    (*type_status)[DataType::kStrings] = s;
-  }
-
-  s = hashes_db_->TTL(key, &timestamp);
-  if (s.ok() || s.IsNotFound()) {
-    ret[DataType::kHashes] = timestamp;
-  } else if (!s.IsNotFound()) {
-    ret[DataType::kHashes] = -3;
-    (*type_status)[DataType::kHashes] = s;
-  }
-
-  s = lists_db_->TTL(key, &timestamp);
-  if (s.ok() || s.IsNotFound()) {
-    ret[DataType::kLists] = timestamp;
-  } else if (!s.IsNotFound()) {
-    ret[DataType::kLists] = -3;
-    (*type_status)[DataType::kLists] = s;
-  }
-
-  s = sets_db_->TTL(key, &timestamp);
-  if (s.ok() || s.IsNotFound()) {
-    ret[DataType::kSets] = timestamp;
-  } else if (!s.IsNotFound()) {
-    ret[DataType::kSets] = -3;
-    (*type_status)[DataType::kSets] = s;
+  std::vector<std::pair<DataType, Redis*>> owners;
+  ProbeKeyOwners(key, &owners, type_status);
+  // The types without the key answer -2 as their TTL would on NotFound
+  for (const auto& [type, db] : TypeDBs()) {
+    ret[type] = type_status->count(type) != 0 ? -3 : -2;
   }
 
-  s = zsets_db_->TTL(key, &timestamp);
-  if (s.ok() || s.IsNotFound()) {
-    ret[DataType::kZSets] = timestamp;
-  } else if (!s.IsNotFound()) {
-    ret[DataType::kZSets] = -3;
-    (*type_status)[DataType::kZSets] = s;
+  int64_t timestamp = 0;
+  for (const auto& [type, db] : owners) {
+    Status s = db->TTL(key, &timestamp);
+    if (s.ok() || s.IsNotFound()) {
+      ret[type] = timestamp;
+    } else {
+      ret[type] = -3;
+      (*type_status)[type] = s;
+    }
   }
   return ret;
 }
@@ -1236,57 +1098,24 @@ std::map<DataType, int64_t> Storage::TTL(const Slice& key, std::map<DataType, St
 Status Storage::GetType(const std::string& key, bool single, std::vector<std::string>& types) {
   types.clear();
 
-  Status s;
-  std::string value;
-  s = strings_db_->Get(key, &value);
-  if (s.ok()) {
-    types.emplace_back("string");
-  } else if (!s.IsNotFound()) {
-    return s;
-  }
-  if (single && !types.empty()) {
-    return s;
-  }
-
-  int32_t hashes_len = 0;
-  s = hashes_db_->HLen(key, &hashes_len);
-  if (s.ok() && hashes_len != 0) {
-    types.emplace_back("hash");
-  } else if (!s.IsNotFound()) {
-    return s;
-  }
-  if (single && !types.empty()) {
-    return s;
-  }
-
-  uint64_t lists_len = 0;
-  s = lists_db_->LLen(key, &lists_len);
-  if (s.ok() && lists_len != 0) {
-    types.emplace_back("list");
-  } else if (!s.IsNotFound()) {
-    return s;
-  }
-  if (single && !types.empty()) {
-    return s;
-  }
-
-  int32_t zsets_size = 0;
-  s = zsets_db_->ZCard(key, &zsets_size);
-  if (s.ok() && zsets_size != 0) {
-    types.emplace_back("zset");
-  } else if (!s.IsNotFound()) {
-    return s;
-  }
-  if (single && !types.empty()) {
-    return s;
-  }
-
-  int32_t sets_size = 0;
-  s = sets_db_->SCard(key, &sets_size);
-  if (s.ok() && sets_size != 0) {
-    types.emplace_back("set");
-  } else if (!s.IsNotFound()) {
-    return s;
+  // Only probe the meta values, the string value is never copied out
+  const std::vector<std::string> keys = {key};
+  const std::pair<std::string, Redis*> type_dbs[] = {{"string", strings_db_.get()},
+                                                     {"hash", hashes_db_.get()},
+                                                     {"list", lists_db_.get()},
+                                                     {"zset", zsets_db_.get()},
+                                                     {"set", sets_db_.get()}};
+  std::vector<Status> statuses;
+  for (const auto& [type_name, db] : type_dbs) {
+    db->MultiExists(keys, &statuses);
+    if (statuses[0].ok()) {
+      types.emplace_back(type_name);
+    } else if (!statuses[0].IsNotFound()) {
+      return statuses[0];
+    }
+    if (single && !types.empty()) {
+      return Status::OK();
+    }
   }
   if (single && types.empty()) {
     types.emplace_back("none");
@@ -1507,9 +1336,17 @@ Status Storage::AddBGTask(const BGTask& bg_task) {
 
 Status Storage::RunBGTask() {
   BGTask task;
+  auto last_persist_time = std::chrono::steady_clock::now();
   while (!bg_tasks_should_exit_) {
+    // Woken up every cycle while the active expiration is on
+    std::chrono::milliseconds timeout = kKeyStatisticsPersistInterval;
+    if (active_expire_cycle_ms_ > 0) {
+      timeout = std::chrono::milliseconds(active_expire_cycle_ms_);
+    }
     std::unique_lock lock(bg_tasks_mutex_);
-    bg_tasks_cond_var_.wait(lock, [this]() { return !bg_tasks_queue_.empty() || bg_tasks_should_exit_; });
+    bool has_task = bg_tasks_cond_var_.wait_for(lock, timeout, [this]() {
+      return !bg_tasks_queue_.empty() || bg_tasks_should_exit_;
+    });
 
     if (!bg_tasks_queue_.empty()) {
       task = bg_tasks_queue_.front();
@@ -1521,6 +1358,17 @@ Status Storage::RunBGTask() {
       return Status::Incomplete("bgtask return with bg_tasks_should_exit true");
     }
 
+    if (!has_task) {
+      if (active_expire_cycle_ms_ > 0) {
+        ActiveExpire();
+      }
+      if (std::chrono::steady_clock::now() - last_persist_time >= kKeyStatisticsPersistInterval) {
+        PersistKeyStatistics();
+        last_persist_time = std::chrono::steady_clock::now();
+      }
+      continue;
+    }
+
     if (task.operation == kCleanAll) {
       DoCompact(task.type);
     } else if (task.operation == kCompactKey) {
@@ -1530,6 +1378,40 @@ Status Storage::RunBGTask() {
   return Status::OK();
 }
 
+void Storage::PersistKeyStatistics() {
+  if (!is_opened_) {
+    return;
+  }
+  const std::vector<std::pair<std::string, Redis*>> type_dbs = {{"strings", strings_db_.get()},
+                                                                {"hashes", hashes_db_.get()},
+                                                                {"sets", sets_db_.get()},
+                                                                {"lists", lists_db_.get()},
+                                                                {"zsets", zsets_db_.get()}};
+  for (const auto& [name, db] : type_dbs) {
+    Status s = db->PersistKeyStatistics(false);
+    if (!s.ok()) {
+      LOG(WARNING) << "persist the keyspace statistics of " << name << " db failed, " << s.ToString();
+    }
+  }
+}
+
+void Storage::ActiveExpire() {
+  if (!is_opened_) {
+    return;
+  }
+  const std::vector<std::pair<std::string, Redis*>> type_dbs = {{"strings", strings_db_.get()},
+                                                                {"hashes", hashes_db_.get()},
+                                                                {"sets", sets_db_.get()},
+                                                                {"lists", lists_db_.get()},
+                                                                {"zsets", zsets_db_.get()}};
+  for (const auto& [name, db] : type_dbs) {
+    Status s = db->ActiveExpire(active_expire_batch_size_);
+    if (!s.ok()) {
+      LOG(WARNING) << "active expire of " << name << " db failed, " << s.ToString();
+    }
+  }
+}
+
 Status Storage::Compact(const DataType& type, bool sync) {
   if (sync) {
     return DoCompact(type);
@@ -1696,6 +1578,41 @@ Status Storage::GetKeyNum(std::vector<KeyInfo>* key_infos) {
   return Status::OK();
 }
 
+bool Storage::GetKeyStatistics(std::vector<KeyInfo>* key_infos) {
+  bool exact = true;
+  // NOTE: keep the db order with string, hash, list, zset, set
+  std::vector<Redis*> dbs = {strings_db_.get(), hashes_db_.get(), lists_db_.get(), zsets_db_.get(), sets_db_.get()};
+  for (const auto& db : dbs) {
+    KeyInfo key_info;
+    db->GetKeyStatistics(&key_info);
+    key_infos->push_back(key_info);
+    exact = exact && db->IsKeyStatisticsExact();
+  }
+  return exact;
+}
+
+uint64_t Storage::GetActiveExpiredKeys() {
+  uint64_t keys = 0;
+  if (!is_opened_) {
+    return keys;
+  }
+  for (const auto& [type, db] : TypeDBs()) {
+    keys += db->active_expired_keys();
+  }
+  return keys;
+}
+
+void Storage::GetValueCacheInfo(ValueCacheInfo* info) {
+  *info = ValueCacheInfo();
+  if (!value_cache_) {
+    return;
+  }
+  info->hits = value_cache_->hits();
+  info->misses = value_cache_->misses();
+  info->usage = value_cache_->Usage();
+  info->entries = value_cache_->Entries();
+}
+
 Status Storage::StopScanKeyNum() {
   scan_keynum_exit_ = true;
   return Status::OK();
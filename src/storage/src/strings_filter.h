@@ -11,13 +11,14 @@
 
 #include "rocksdb/compaction_filter.h"
 #include "src/debug.h"
+#include "src/key_statistics.h"
 #include "src/strings_value_format.h"
 
 namespace storage {
 
 class StringsFilter : public rocksdb::CompactionFilter {
  public:
-  StringsFilter() = default;
+  explicit StringsFilter(KeyStatistics* key_statistics = nullptr) : key_statistics_(key_statistics) {}
   bool Filter(int level, const rocksdb::Slice& key, const rocksdb::Slice& value, std::string* new_value,
               bool* value_changed) const override {
     int64_t unix_time;
@@ -30,6 +31,9 @@ class StringsFilter : public rocksdb::CompactionFilter {
 
     if (parsed_strings_value.timestamp() != 0 && parsed_strings_value.timestamp() < cur_time) {
       TRACE("Drop[Stale]");
+      if (key_statistics_ != nullptr) {
+        key_statistics_->Drop({true, parsed_strings_value.timestamp()});
+      }
       return true;
     } else {
       TRACE("Reserve");
@@ -38,16 +42,23 @@ class StringsFilter : public rocksdb::CompactionFilter {
   }
 
   const char* Name() const override { return "StringsFilter"; }
+
+ private:
+  KeyStatistics* key_statistics_ = nullptr;
 };
 
 class StringsFilterFactory : public rocksdb::CompactionFilterFactory {
  public:
-  StringsFilterFactory() = default;
+  // The expired keys dropped are taken out of key_statistics
+  explicit StringsFilterFactory(KeyStatistics* key_statistics = nullptr) : key_statistics_(key_statistics) {}
   std::unique_ptr<rocksdb::CompactionFilter> CreateCompactionFilter(
       const rocksdb::CompactionFilter::Context& context) override {
-    return std::unique_ptr<rocksdb::CompactionFilter>(new StringsFilter());
+    return std::unique_ptr<rocksdb::CompactionFilter>(new StringsFilter(key_statistics_));
   }
   const char* Name() const override { return "StringsFilterFactory"; }
+
+ private:
+  KeyStatistics* key_statistics_ = nullptr;
 };
 
 }  //  namespace storage
@@ -0,0 +1,179 @@
+//  Copyright (c) 2017-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "src/value_cache.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace storage {
+
+// The size of a cached value the capacity is planned for
+static const size_t kAverageCharge = 256;
+
+static const uint64_t kSketchSeeds[] = {0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL, 0x9ae16a3b2f90404fULL,
+                                        0xcbf29ce484222325ULL};
+
+FrequencySketch::FrequencySketch(size_t expected_entries) {
+  expected_entries = std::max<size_t>(expected_entries, 64);
+  // About 8 counters for every entry
+  size_t words = 1;
+  while (words * 2 < expected_entries) {
+    words <<= 1;
+  }
+  table_.resize(words, 0);
+  sample_size_ = 10 * expected_entries;
+}
+
+size_t FrequencySketch::Index(uint64_t hash, int i, uint32_t* shift) const {
+  uint64_t h = (hash + kSketchSeeds[i]) * 0x9e3779b97f4a7c15ULL;
+  h ^= h >> 32;
+  *shift = static_cast<uint32_t>(h & 15) << 2;
+  return static_cast<size_t>(h >> 4) & (table_.size() - 1);
+}
+
+void FrequencySketch::Increment(uint64_t hash) {
+  bool added = false;
+  for (int i = 0; i < kDepth; i++) {
+    uint32_t shift;
+    size_t index = Index(hash, i, &shift);
+    if (((table_[index] >> shift) & 0xf) != 0xf) {
+      table_[index] += 1ULL << shift;
+      added = true;
+    }
+  }
+  if (added && ++additions_ >= sample_size_) {
+    Halve();
+  }
+}
+
+uint32_t FrequencySketch::Estimate(uint64_t hash) const {
+  uint32_t frequency = 0xf;
+  for (int i = 0; i < kDepth; i++) {
+    uint32_t shift;
+    size_t index = Index(hash, i, &shift);
+    frequency = std::min(frequency, static_cast<uint32_t>((table_[index] >> shift) & 0xf));
+  }
+  return frequency;
+}
+
+void FrequencySketch::Halve() {
+  for (auto& word : table_) {
+    word = (word >> 1) & 0x7777777777777777ULL;
+  }
+  additions_ /= 2;
+}
+
+ValueCache::Shard::Shard(size_t capacity) : capacity(capacity), sketch(capacity / kAverageCharge) {}
+
+bool ValueCache::Shard::Admit(uint64_t hash, size_t charge) const {
+  if (usage + charge <= capacity || lru.empty()) {
+    return true;
+  }
+  return sketch.Estimate(hash) > sketch.Estimate(lru.back().hash);
+}
+
+void ValueCache::Shard::Erase(std::list<Entry>::iterator entry) {
+  usage -= entry->charge;
+  map.erase(entry->key);
+  lru.erase(entry);
+}
+
+ValueCache::ValueCache(size_t capacity, size_t num_shard_bits)
+    : capacity_(capacity), shard_mask_((1ULL << num_shard_bits) - 1) {
+  size_t num_shards = 1ULL << num_shard_bits;
+  size_t shard_capacity = (capacity + num_shards - 1) / num_shards;
+  shards_.reserve(num_shards);
+  for (size_t i = 0; i < num_shards; i++) {
+    shards_.push_back(std::make_unique<Shard>(shard_capacity));
+  }
+}
+
+uint64_t ValueCache::Hash(const rocksdb::Slice& key) {
+  return std::hash<std::string_view>{}(std::string_view(key.data(), key.size()));
+}
+
+bool ValueCache::Lookup(const rocksdb::Slice& key, std::string* value, uint64_t* ticket) {
+  uint64_t hash = Hash(key);
+  Shard& shard = GetShard(hash);
+  std::lock_guard l(shard.mu);
+  shard.sketch.Increment(hash);
+  auto iter = shard.map.find(std::string_view(key.data(), key.size()));
+  if (iter != shard.map.end()) {
+    shard.lru.splice(shard.lru.begin(), shard.lru, iter->second);
+    value->assign(iter->second->value);
+    hits_++;
+    return true;
+  }
+  misses_++;
+  *ticket = shard.Admit(hash, 0) ? shard.epoch : 0;
+  return false;
+}
+
+void ValueCache::Fill(const rocksdb::Slice& key, const rocksdb::Slice& value, uint64_t ticket) {
+  if (ticket == 0) {
+    return;
+  }
+  uint64_t hash = Hash(key);
+  Shard& shard = GetShard(hash);
+  size_t charge = key.size() + value.size() + kEntryOverhead;
+  std::lock_guard l(shard.mu);
+  // A value that takes a large part of the shard would flush many hot ones
+  if (ticket != shard.epoch || charge > shard.capacity / 8 || !shard.Admit(hash, charge)) {
+    rejected_fills_++;
+    return;
+  }
+  auto iter = shard.map.find(std::string_view(key.data(), key.size()));
+  if (iter != shard.map.end()) {
+    shard.Erase(iter->second);
+  }
+  while (shard.usage + charge > shard.capacity && !shard.lru.empty()) {
+    shard.Erase(std::prev(shard.lru.end()));
+  }
+  shard.lru.push_front({key.ToString(), value.ToString(), hash, charge});
+  shard.map.emplace(shard.lru.front().key, shard.lru.begin());
+  shard.usage += charge;
+}
+
+void ValueCache::Invalidate(const rocksdb::Slice& key) {
+  uint64_t hash = Hash(key);
+  Shard& shard = GetShard(hash);
+  std::lock_guard l(shard.mu);
+  shard.epoch++;
+  auto iter = shard.map.find(std::string_view(key.data(), key.size()));
+  if (iter != shard.map.end()) {
+    shard.Erase(iter->second);
+  }
+}
+
+void ValueCache::Clear() {
+  for (auto& shard : shards_) {
+    std::lock_guard l(shard->mu);
+    shard->epoch++;
+    shard->map.clear();
+    shard->lru.clear();
+    shard->usage = 0;
+  }
+}
+
+size_t ValueCache::Usage() {
+  size_t usage = 0;
+  for (auto& shard : shards_) {
+    std::lock_guard l(shard->mu);
+    usage += shard->usage;
+  }
+  return usage;
+}
+
+size_t ValueCache::Entries() {
+  size_t entries = 0;
+  for (auto& shard : shards_) {
+    std::lock_guard l(shard->mu);
+    entries += shard->map.size();
+  }
+  return entries;
+}
+
+}  //  namespace storage
@@ -0,0 +1,131 @@
+//  Copyright (c) 2017-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef SRC_VALUE_CACHE_H_
+#define SRC_VALUE_CACHE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "rocksdb/slice.h"
+
+#include "pstd/include/noncopyable.h"
+
+namespace storage {
+
+/*
+ * A count-min sketch of 4 bit counters estimating how often a key was looked
+ * up lately. All counters are halved once the sketch counted ten times as
+ * many lookups as it has room for entries, so keys that cooled down lose
+ * their weight.
+ */
+class FrequencySketch {
+ public:
+  explicit FrequencySketch(size_t expected_entries);
+
+  void Increment(uint64_t hash);
+  uint32_t Estimate(uint64_t hash) const;
+
+ private:
+  // The number of counters of a key, the smallest of them is its estimate
+  static const int kDepth = 4;
+
+  void Halve();
+  size_t Index(uint64_t hash, int i, uint32_t* shift) const;
+
+  // 16 counters in a word
+  std::vector<uint64_t> table_;
+  size_t sample_size_;
+  size_t additions_ = 0;
+};
+
+/*
+ * A cache of the values of hot keys in front of the type dbs, split into
+ * shards that each have their own lock, lru list and frequency sketch.
+ *
+ * A key missing from the cache is only filled in by the reader if it was
+ * looked up more often lately than the key it would evict, the way TinyLFU
+ * admits entries, so a scan over cold keys does not flush the hot ones.
+ *
+ * Lookup hands out the epoch of the shard as the ticket of a fill, and every
+ * Invalidate bumps that epoch. A reader that read the database before a
+ * concurrent write and invalidation then fails to fill in its outdated value.
+ */
+class ValueCache : public pstd::noncopyable {
+ public:
+  static const size_t kDefaultNumShardBits = 5;
+
+  // capacity is in bytes, split evenly among the shards
+  explicit ValueCache(size_t capacity, size_t num_shard_bits = kDefaultNumShardBits);
+
+  // Returns true with the cached value of key, otherwise *ticket is what Fill
+  // needs to cache the value read from the database afterwards, 0 if key
+  // would not be admitted, so there is no need to build its value
+  bool Lookup(const rocksdb::Slice& key, std::string* value, uint64_t* ticket);
+  void Fill(const rocksdb::Slice& key, const rocksdb::Slice& value, uint64_t ticket);
+
+  // Called after every write of key
+  void Invalidate(const rocksdb::Slice& key);
+  // Called after writes that cannot name their keys
+  void Clear();
+
+  size_t capacity() const { return capacity_; }
+  size_t Usage();
+  size_t Entries();
+  uint64_t hits() const { return hits_; }
+  uint64_t misses() const { return misses_; }
+  // Values that were not cached, because the admission declined them or a
+  // write came in between
+  uint64_t rejected_fills() const { return rejected_fills_; }
+
+ private:
+  // The bookkeeping of an entry on top of its key and value
+  static const size_t kEntryOverhead = 64;
+
+  struct Entry {
+    std::string key;
+    std::string value;
+    uint64_t hash;
+    size_t charge;
+  };
+
+  struct alignas(64) Shard {
+    explicit Shard(size_t capacity);
+
+    std::mutex mu;
+    // Front is the most recently used, the keys of map point into the entries
+    std::list<Entry> lru;
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> map;
+    size_t capacity;
+    size_t usage = 0;
+    // 0 is no ticket
+    uint64_t epoch = 1;
+    FrequencySketch sketch;
+
+    bool Admit(uint64_t hash, size_t charge) const;
+    void Erase(std::list<Entry>::iterator entry);
+  };
+
+  static uint64_t Hash(const rocksdb::Slice& key);
+  Shard& GetShard(uint64_t hash) { return *shards_[(hash >> 32) & shard_mask_]; }
+
+  const size_t capacity_;
+  const uint64_t shard_mask_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  std::atomic<uint64_t> hits_ = 0;
+  std::atomic<uint64_t> misses_ = 0;
+  std::atomic<uint64_t> rejected_fills_ = 0;
+};
+
+}  //  namespace storage
+#endif  //  SRC_VALUE_CACHE_H_
@@ -20,8 +20,9 @@ namespace storage {
 
 class ZSetsScoreFilter : public rocksdb::CompactionFilter {
  public:
-  ZSetsScoreFilter(rocksdb::DB* db, std::vector<rocksdb::ColumnFamilyHandle*>* handles_ptr)
-      : db_(db), cf_handles_ptr_(handles_ptr) {}
+  ZSetsScoreFilter(rocksdb::DB* db, std::vector<rocksdb::ColumnFamilyHandle*>* handles_ptr,
+                   DataFilterStatistics* statistics = nullptr)
+      : db_(db), cf_handles_ptr_(handles_ptr), statistics_(statistics) {}
 
   bool Filter(int level, const rocksdb::Slice& key, const rocksdb::Slice& value, std::string* new_value,
               bool* value_changed) const override {
@@ -31,19 +32,19 @@ class ZSetsScoreFilter : public rocksdb::CompactionFilter {
           parsed_zsets_score_key.key().ToString().c_str(), parsed_zsets_score_key.score(),
           parsed_zsets_score_key.member().ToString().c_str(), parsed_zsets_score_key.version());
 
-    if (parsed_zsets_score_key.key().ToString() != cur_key_) {
+    if (parsed_zsets_score_key.key() != Slice(cur_key_)) {
       cur_key_ = parsed_zsets_score_key.key().ToString();
-      std::string meta_value;
       // destroyed when close the database, Reserve Current key value
       if (cf_handles_ptr_->empty()) {
         return false;
       }
-      Status s = db_->Get(default_read_options_, (*cf_handles_ptr_)[0], cur_key_, &meta_value);
+      if (!meta_reader_) {
+        meta_reader_ =
+            std::make_unique<DataFilterMetaReader<ParsedZSetsMetaValue>>(db_, (*cf_handles_ptr_)[0], statistics_);
+      }
+      Status s = meta_reader_->Lookup(cur_key_, &cur_meta_version_, &cur_meta_timestamp_);
       if (s.ok()) {
         meta_not_found_ = false;
-        ParsedZSetsMetaValue parsed_zsets_meta_value(&meta_value);
-        cur_meta_version_ = parsed_zsets_meta_value.version();
-        cur_meta_timestamp_ = parsed_zsets_meta_value.timestamp();
       } else if (s.IsNotFound()) {
         meta_not_found_ = true;
       } else {
@@ -78,7 +79,8 @@ class ZSetsScoreFilter : public rocksdb::CompactionFilter {
  private:
   rocksdb::DB* db_ = nullptr;
   std::vector<rocksdb::ColumnFamilyHandle*>* cf_handles_ptr_ = nullptr;
-  rocksdb::ReadOptions default_read_options_;
+  DataFilterStatistics* statistics_ = nullptr;
+  mutable std::unique_ptr<DataFilterMetaReader<ParsedZSetsMetaValue>> meta_reader_;
   mutable std::string cur_key_;
   mutable bool meta_not_found_ = false;
   mutable int32_t cur_meta_version_ = 0;
@@ -87,12 +89,13 @@ class ZSetsScoreFilter : public rocksdb::CompactionFilter {
 
 class ZSetsScoreFilterFactory : public rocksdb::CompactionFilterFactory {
  public:
-  ZSetsScoreFilterFactory(rocksdb::DB** db_ptr, std::vector<rocksdb::ColumnFamilyHandle*>* handles_ptr)
-      : db_ptr_(db_ptr), cf_handles_ptr_(handles_ptr) {}
+  ZSetsScoreFilterFactory(rocksdb::DB** db_ptr, std::vector<rocksdb::ColumnFamilyHandle*>* handles_ptr,
+                          DataFilterStatistics* statistics = nullptr)
+      : db_ptr_(db_ptr), cf_handles_ptr_(handles_ptr), statistics_(statistics) {}
 
   std::unique_ptr<rocksdb::CompactionFilter> CreateCompactionFilter(
       const rocksdb::CompactionFilter::Context& context) override {
-    return std::make_unique<ZSetsScoreFilter>(*db_ptr_, cf_handles_ptr_);
+    return std::make_unique<ZSetsScoreFilter>(*db_ptr_, cf_handles_ptr_, statistics_);
   }
 
   const char* Name() const override { return "ZSetsScoreFilterFactory"; }
@@ -100,6 +103,7 @@ class ZSetsScoreFilterFactory : public rocksdb::CompactionFilterFactory {
  private:
   rocksdb::DB** db_ptr_ = nullptr;
   std::vector<rocksdb::ColumnFamilyHandle*>* cf_handles_ptr_ = nullptr;
+  DataFilterStatistics* statistics_ = nullptr;
 };
 
 }  //  namespace storage
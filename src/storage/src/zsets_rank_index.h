@@ -0,0 +1,210 @@
+//  Copyright (c) 2017-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef SRC_ZSETS_RANK_INDEX_H_
+#define SRC_ZSETS_RANK_INDEX_H_
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "rocksdb/merge_operator.h"
+#include "rocksdb/write_batch.h"
+
+#include "src/base_data_key_format.h"
+#include "src/coding.h"
+
+namespace storage {
+
+/*
+ * The rank index of a zset is a radix tree of member counts over the top
+ * 32 bits of the order preserving encoding of the score, stored in the
+ * rank column family:
+ *
+ * |  <Key Size>  |      <Key>      | <Version> | <Level> |  <Prefix>  |
+ *      4 Bytes      key size Bytes    4 Bytes     1 Byte     4 Bytes
+ *
+ * The prefix is big endian so that the children of a node are adjacent,
+ * and the value is the signed 64 bit number of members under the node.
+ * Level 0 is the root, its presence means the index of this version of
+ * the key is complete. A rank lookup reads at most
+ * kZSetsRankLevels * (1 << kZSetsRankFanoutBits) counters plus the members
+ * of a single leaf bucket.
+ */
+const int32_t kZSetsRankFanoutBits = 4;
+const int32_t kZSetsRankLevels = 8;
+
+// Maps a score to its leaf bucket, buckets are ordered like the scores
+inline uint32_t ZSetsRankBucket(double score) {
+  // -0.0 and 0.0 compare equal in the score column family
+  if (score == 0) {
+    score = 0;
+  }
+  uint64_t bits;
+  memcpy(&bits, &score, sizeof(bits));
+  bits = (bits & (1ULL << 63)) != 0 ? ~bits : bits | (1ULL << 63);
+  return static_cast<uint32_t>(bits >> 32);
+}
+
+// The smallest score that falls into the bucket, used to seek the score column family
+inline double ZSetsRankBucketLowerBound(uint32_t bucket) {
+  uint64_t bits = static_cast<uint64_t>(bucket) << 32;
+  bits = (bits & (1ULL << 63)) != 0 ? bits & ~(1ULL << 63) : ~bits;
+  double score;
+  memcpy(&score, &bits, sizeof(score));
+  if (std::isnan(score)) {
+    return -std::numeric_limits<double>::infinity();
+  }
+  return score;
+}
+
+// Number of leaf buckets covered by one node of the level
+inline uint64_t ZSetsRankSpan(int32_t level) { return 1ULL << (32 - level * kZSetsRankFanoutBits); }
+
+inline uint32_t ZSetsRankPrefix(uint32_t bucket, int32_t level) {
+  return static_cast<uint32_t>(bucket & ~(ZSetsRankSpan(level) - 1));
+}
+
+class ZSetsRankKey {
+ public:
+  ZSetsRankKey(const Slice& key, int32_t version, int32_t level, uint32_t prefix)
+      : key_(key), version_(version) {
+    node_[0] = static_cast<char>(level);
+    node_[1] = static_cast<char>(prefix >> 24);
+    node_[2] = static_cast<char>(prefix >> 16);
+    node_[3] = static_cast<char>(prefix >> 8);
+    node_[4] = static_cast<char>(prefix);
+  }
+
+  Slice Encode() {
+    if (!base_data_key_) {
+      base_data_key_ = std::make_unique<BaseDataKey>(key_, version_, Slice(node_, sizeof(node_)));
+      encoded_ = base_data_key_->Encode();
+    }
+    return encoded_;
+  }
+
+  // The bytes shared by all the nodes of the level
+  Slice EncodeLevelPrefix() {
+    Slice encoded = Encode();
+    return Slice(encoded.data(), encoded.size() - sizeof(uint32_t));
+  }
+
+ private:
+  Slice key_;
+  int32_t version_ = 0;
+  char node_[5];
+  std::unique_ptr<BaseDataKey> base_data_key_;
+  Slice encoded_;
+};
+
+class ParsedZSetsRankKey {
+ public:
+  explicit ParsedZSetsRankKey(const Slice& key) {
+    const char* ptr = key.data() + key.size() - sizeof(uint32_t);
+    prefix_ = (static_cast<uint32_t>(static_cast<unsigned char>(ptr[0])) << 24) |
+              (static_cast<uint32_t>(static_cast<unsigned char>(ptr[1])) << 16) |
+              (static_cast<uint32_t>(static_cast<unsigned char>(ptr[2])) << 8) |
+              static_cast<uint32_t>(static_cast<unsigned char>(ptr[3]));
+    level_ = static_cast<unsigned char>(ptr[-1]);
+  }
+
+  int32_t level() const { return level_; }
+  uint32_t prefix() const { return prefix_; }
+
+ private:
+  int32_t level_ = 0;
+  uint32_t prefix_ = 0;
+};
+
+inline int64_t DecodeZSetsRankCount(const Slice& value) {
+  return value.size() == sizeof(uint64_t) ? static_cast<int64_t>(DecodeFixed64(value.data())) : 0;
+}
+
+/*
+ * Collects the counter changes of one write to a zset, so every touched node
+ * is updated once per WriteBatch. Does nothing until Init() is called, which
+ * keeps the write path free of work for keys that are not indexed.
+ */
+class ZSetsRankDelta {
+ public:
+  void Init(const Slice& key, int32_t version) {
+    key_ = key.ToString();
+    version_ = version;
+    active_ = true;
+  }
+
+  bool active() const { return active_; }
+
+  void Add(double score, int64_t delta) {
+    if (!active_) {
+      return;
+    }
+    uint32_t bucket = ZSetsRankBucket(score);
+    for (int32_t level = 0; level <= kZSetsRankLevels; ++level) {
+      counts_[{level, ZSetsRankPrefix(bucket, level)}] += delta;
+    }
+  }
+
+  // Merge the changes into an existing index
+  void MergeTo(rocksdb::WriteBatch* batch, rocksdb::ColumnFamilyHandle* handle) {
+    WriteTo(batch, handle, false);
+  }
+
+  // Write the collected counts as a complete new index
+  void PutTo(rocksdb::WriteBatch* batch, rocksdb::ColumnFamilyHandle* handle) {
+    WriteTo(batch, handle, true);
+  }
+
+ private:
+  void WriteTo(rocksdb::WriteBatch* batch, rocksdb::ColumnFamilyHandle* handle, bool put) {
+    if (!active_) {
+      return;
+    }
+    char buf[8];
+    // The root is always written, it marks the index as complete
+    counts_.emplace(std::make_pair(0, 0U), 0);
+    for (const auto& item : counts_) {
+      if (item.second == 0 && (item.first.first != 0 || !put)) {
+        continue;
+      }
+      ZSetsRankKey rank_key(key_, version_, item.first.first, item.first.second);
+      EncodeFixed64(buf, static_cast<uint64_t>(item.second));
+      if (put) {
+        batch->Put(handle, rank_key.Encode(), Slice(buf, sizeof(buf)));
+      } else {
+        batch->Merge(handle, rank_key.Encode(), Slice(buf, sizeof(buf)));
+      }
+    }
+  }
+
+  bool active_ = false;
+  std::string key_;
+  int32_t version_ = 0;
+  std::map<std::pair<int32_t, uint32_t>, int64_t> counts_;
+};
+
+// Adds up the signed counters of the rank index
+class ZSetsRankCountMergeOperator : public rocksdb::AssociativeMergeOperator {
+ public:
+  bool Merge(const rocksdb::Slice& key, const rocksdb::Slice* existing_value, const rocksdb::Slice& value,
+             std::string* new_value, rocksdb::Logger* logger) const override {
+    int64_t count = existing_value != nullptr ? DecodeZSetsRankCount(*existing_value) : 0;
+    count += DecodeZSetsRankCount(value);
+    char buf[8];
+    EncodeFixed64(buf, static_cast<uint64_t>(count));
+    new_value->assign(buf, sizeof(buf));
+    return true;
+  }
+
+  const char* Name() const override { return "ZSetsRankCountMergeOperator"; }
+};
+
+}  // namespace storage
+#endif  // SRC_ZSETS_RANK_INDEX_H_
@@ -26,6 +26,7 @@ class KeysTest : public ::testing::Test {
       mkdir(path.c_str(), 0755);
     }
     storage_options.options.create_if_missing = true;
+    storage_options.exact_key_statistics = true;
     s = db.Open(storage_options, path);
   }
 
@@ -4870,6 +4871,57 @@ TEST_F(KeysTest, ScanCaseSingleTest) {  // NOLINT
   db.Compact(DataType::kAll, true);
 }
 
+// Scan, Keys and Scanx by a pattern with a literal prefix
+TEST_F(KeysTest, ScanPrefixTest) {  // NOLINT
+  int32_t int32_ret;
+  int64_t cursor;
+  std::vector<std::string> keys;
+  std::vector<std::string> total_keys;
+  std::string next_key;
+  std::map<DataType, Status> type_status;
+
+  std::vector<std::string> delete_keys = {"PREFIX_SCAN_A", "PREFIX_SCAN_KEY*1", "PREFIX_SCAN_KEY*2",
+                                          "PREFIX_SCAN_KEY*3", "PREFIX_SCAN_KEYX", "PREFIX_SCAN_Z"};
+  for (const auto& key : delete_keys) {
+    s = db.Set(key, "PREFIX_SCAN_VALUE");
+    s = db.HSet(key, "PREFIX_SCAN_FIELD", "PREFIX_SCAN_VALUE", &int32_ret);
+  }
+
+  // The escaped star is a part of the prefix
+  cursor = 0;
+  do {
+    cursor = db.Scan(DataType::kAll, cursor, "PREFIX_SCAN_KEY\\*[0-9]", 1, &keys);
+    total_keys.insert(total_keys.end(), keys.begin(), keys.end());
+  } while (cursor != 0);
+  ASSERT_TRUE(key_match(total_keys, {"PREFIX_SCAN_KEY*1", "PREFIX_SCAN_KEY*2", "PREFIX_SCAN_KEY*3",
+                                     "PREFIX_SCAN_KEY*1", "PREFIX_SCAN_KEY*2", "PREFIX_SCAN_KEY*3"}));
+
+  // The whole range fits in one call
+  cursor = db.Scan(DataType::kStrings, 0, "PREFIX_SCAN_KEY*", 4, &keys);
+  ASSERT_EQ(cursor, 0);
+  ASSERT_TRUE(key_match(keys, {"PREFIX_SCAN_KEY*1", "PREFIX_SCAN_KEY*2", "PREFIX_SCAN_KEY*3", "PREFIX_SCAN_KEYX"}));
+
+  s = db.Keys(DataType::kHashes, "PREFIX_SCAN_KEY*[13]", &keys);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(key_match(keys, {"PREFIX_SCAN_KEY*1", "PREFIX_SCAN_KEY*3"}));
+
+  s = db.Scanx(DataType::kStrings, "PREFIX_SCAN_KEY*2", "PREFIX_SCAN_KEY*", 3, &keys, &next_key);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(key_match(keys, {"PREFIX_SCAN_KEY*2", "PREFIX_SCAN_KEY*3", "PREFIX_SCAN_KEYX"}));
+  ASSERT_EQ(next_key, "");
+
+  // A start key before the prefix resumes at the prefix
+  s = db.Scanx(DataType::kStrings, "PREFIX_SCAN_A", "PREFIX_SCAN_KEY*", 2, &keys, &next_key);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(key_match(keys, {"PREFIX_SCAN_KEY*1", "PREFIX_SCAN_KEY*2"}));
+  ASSERT_EQ(next_key, "PREFIX_SCAN_KEY*3");
+
+  int32_t del_num = db.Del(delete_keys, &type_status);
+  ASSERT_EQ(del_num, 12);
+  sleep(2);
+  db.Compact(DataType::kAll, true);
+}
+
 TEST_F(KeysTest, PKExpireScanCaseAllTest) {  // NOLINT
   int64_t cursor;
   int64_t next_cursor;
@@ -8017,6 +8069,297 @@ TEST_F(KeysTest, TTLTest) {
   }
 }
 
+// GetKeyStatistics
+TEST_F(KeysTest, GetKeyStatisticsTest) {
+  int32_t ret;
+  uint64_t llen;
+  std::map<storage::DataType, Status> type_status;
+  std::vector<storage::KeyInfo> key_infos;
+
+  for (const std::string& key : {"KEY_STATISTICS_KEY1", "KEY_STATISTICS_KEY2", "KEY_STATISTICS_KEY3"}) {
+    s = db.Set(key, "VALUE");
+    ASSERT_TRUE(s.ok());
+    s = db.HSet(key, "FIELD", "VALUE", &ret);
+    ASSERT_TRUE(s.ok());
+    s = db.SAdd(key, {"MEMBER"}, &ret);
+    ASSERT_TRUE(s.ok());
+    s = db.RPush(key, {"NODE"}, &llen);
+    ASSERT_TRUE(s.ok());
+    s = db.ZAdd(key, {{1, "MEMBER"}}, &ret);
+    ASSERT_TRUE(s.ok());
+  }
+  // Writing an existing key again does not count it twice
+  s = db.Set("KEY_STATISTICS_KEY1", "VALUE");
+  ASSERT_TRUE(s.ok());
+  s = db.RPush("KEY_STATISTICS_KEY1", {"NODE"}, &llen);
+  ASSERT_TRUE(s.ok());
+
+  ASSERT_TRUE(db.GetKeyStatistics(&key_infos));
+  ASSERT_EQ(key_infos.size(), 5);
+  for (const auto& key_info : key_infos) {
+    ASSERT_EQ(key_info.keys, 3);
+    ASSERT_EQ(key_info.expires, 0);
+  }
+
+  ret = db.Expire("KEY_STATISTICS_KEY2", 100, &type_status);
+  ASSERT_EQ(ret, 5);
+  ret = db.Del({"KEY_STATISTICS_KEY3"}, &type_status);
+  ASSERT_EQ(ret, 5);
+  key_infos.clear();
+  ASSERT_TRUE(db.GetKeyStatistics(&key_infos));
+  for (const auto& key_info : key_infos) {
+    ASSERT_EQ(key_info.keys, 2);
+    ASSERT_EQ(key_info.expires, 1);
+    ASSERT_GT(key_info.avg_ttl, 0);
+    ASSERT_LE(key_info.avg_ttl, 100);
+  }
+
+  // A recount agrees with the statistics kept by the writes
+  std::vector<storage::KeyInfo> scanned_key_infos;
+  s = db.GetKeyNum(&scanned_key_infos);
+  ASSERT_TRUE(s.ok());
+  key_infos.clear();
+  ASSERT_TRUE(db.GetKeyStatistics(&key_infos));
+  for (size_t idx = 0; idx < key_infos.size(); ++idx) {
+    ASSERT_EQ(key_infos[idx].keys, scanned_key_infos[idx].keys);
+    ASSERT_EQ(key_infos[idx].expires, scanned_key_infos[idx].expires);
+  }
+}
+
+// Expired keys dropped by the compaction leave the statistics
+TEST_F(KeysTest, KeyStatisticsCompactionTest) {
+  std::string path = "./db/key_statistics";
+  if (access(path.c_str(), F_OK) != 0) {
+    mkdir(path.c_str(), 0755);
+  }
+  // Nothing but the compaction deletes the expired keys
+  storage::StorageOptions statistics_options;
+  statistics_options.options.create_if_missing = true;
+  statistics_options.exact_key_statistics = true;
+  statistics_options.active_expire_cycle_ms = 0;
+  storage::Storage statistics_db;
+  s = statistics_db.Open(statistics_options, path);
+  ASSERT_TRUE(s.ok());
+
+  int32_t ret;
+  std::map<storage::DataType, Status> type_status;
+  std::vector<storage::KeyInfo> key_infos;
+  for (const std::string& key : {"KEY_STATISTICS_KEY1", "KEY_STATISTICS_KEY2", "KEY_STATISTICS_KEY3"}) {
+    s = statistics_db.Setex(key, "VALUE", 1);
+    ASSERT_TRUE(s.ok());
+    s = statistics_db.HSet(key, "FIELD", "VALUE", &ret);
+    ASSERT_TRUE(s.ok());
+    ASSERT_EQ(statistics_db.Expire(key, 1, &type_status), 2);
+  }
+  s = statistics_db.Set("KEY_STATISTICS_PERSIST_KEY", "VALUE");
+  ASSERT_TRUE(s.ok());
+  std::this_thread::sleep_for(std::chrono::milliseconds(2000));
+
+  // Counted as keys until their bucket has passed, then as invalid keys
+  ASSERT_TRUE(statistics_db.GetKeyStatistics(&key_infos));
+  ASSERT_EQ(key_infos[0].keys + key_infos[0].invaild_keys, 4);
+  ASSERT_EQ(key_infos[1].keys + key_infos[1].invaild_keys, 3);
+
+  s = statistics_db.Compact(DataType::kAll, true);
+  ASSERT_TRUE(s.ok());
+  key_infos.clear();
+  ASSERT_TRUE(statistics_db.GetKeyStatistics(&key_infos));
+  ASSERT_EQ(key_infos[0].keys, 1);
+  ASSERT_EQ(key_infos[0].invaild_keys, 0);
+  ASSERT_EQ(key_infos[1].keys, 0);
+  ASSERT_EQ(key_infos[1].invaild_keys, 0);
+
+  storage::DeleteFiles(path.c_str());
+}
+
+// Without exact statistics the strings are estimated by rocksdb
+TEST_F(KeysTest, KeyStatisticsEstimatedTest) {
+  std::string path = "./db/key_statistics_estimated";
+  if (access(path.c_str(), F_OK) != 0) {
+    mkdir(path.c_str(), 0755);
+  }
+  storage::StorageOptions statistics_options;
+  statistics_options.options.create_if_missing = true;
+  storage::Storage statistics_db;
+  s = statistics_db.Open(statistics_options, path);
+  ASSERT_TRUE(s.ok());
+
+  int32_t ret;
+  std::vector<storage::KeyInfo> key_infos;
+  for (const std::string& key : {"KEY_STATISTICS_KEY1", "KEY_STATISTICS_KEY2"}) {
+    s = statistics_db.Set(key, "VALUE");
+    ASSERT_TRUE(s.ok());
+    s = statistics_db.HSet(key, "FIELD", "VALUE", &ret);
+    ASSERT_TRUE(s.ok());
+  }
+  ASSERT_FALSE(statistics_db.GetKeyStatistics(&key_infos));
+  ASSERT_EQ(key_infos[0].keys, 2);
+  ASSERT_EQ(key_infos[0].expires, 0);
+  ASSERT_EQ(key_infos[1].keys, 2);
+
+  storage::DeleteFiles(path.c_str());
+}
+
+TEST_F(KeysTest, ActiveExpireTest) {
+  std::string path = "./db/active_expire";
+  if (access(path.c_str(), F_OK) != 0) {
+    mkdir(path.c_str(), 0755);
+  }
+  // Driven by hand below, with rounds too small for a whole key
+  storage::StorageOptions active_expire_options;
+  active_expire_options.options.create_if_missing = true;
+  active_expire_options.active_expire_cycle_ms = 0;
+  active_expire_options.active_expire_batch_size = 4;
+  storage::Storage active_expire_db;
+  s = active_expire_db.Open(active_expire_options, path);
+  ASSERT_TRUE(s.ok());
+
+  int32_t ret;
+  uint64_t llen;
+  std::map<storage::DataType, Status> type_status;
+  std::vector<std::string> fields;
+  std::vector<storage::FieldValue> field_values;
+  std::vector<storage::ScoreMember> score_members;
+  for (int i = 0; i < 10; i++) {
+    fields.push_back("FIELD" + std::to_string(i));
+    field_values.push_back({"FIELD" + std::to_string(i), "VALUE"});
+    score_members.push_back({static_cast<double>(i), "MEMBER" + std::to_string(i)});
+  }
+  for (const std::string& key : {"ACTIVE_EXPIRE_KEY", "ACTIVE_EXPIRE_PERSIST_KEY", "ACTIVE_EXPIRE_LONG_KEY"}) {
+    s = active_expire_db.Set(key, "VALUE");
+    ASSERT_TRUE(s.ok());
+    s = active_expire_db.HMSet(key, field_values);
+    ASSERT_TRUE(s.ok());
+    s = active_expire_db.SAdd(key, fields, &ret);
+    ASSERT_TRUE(s.ok());
+    s = active_expire_db.RPush(key, fields, &llen);
+    ASSERT_TRUE(s.ok());
+    s = active_expire_db.ZAdd(key, score_members, &ret);
+    ASSERT_TRUE(s.ok());
+  }
+  ret = active_expire_db.Expire("ACTIVE_EXPIRE_KEY", 1, &type_status);
+  ASSERT_EQ(ret, 5);
+  ret = active_expire_db.Expire("ACTIVE_EXPIRE_PERSIST_KEY", 1, &type_status);
+  ASSERT_EQ(ret, 5);
+  ret = active_expire_db.Persist("ACTIVE_EXPIRE_PERSIST_KEY", &type_status);
+  ASSERT_EQ(ret, 5);
+  ret = active_expire_db.Expire("ACTIVE_EXPIRE_LONG_KEY", 100, &type_status);
+  ASSERT_EQ(ret, 5);
+  std::this_thread::sleep_for(std::chrono::milliseconds(2000));
+
+  // Every round deletes a few entries, the hash, set, list and zset take several
+  int rounds = 0;
+  while (active_expire_db.GetActiveExpiredKeys() < 5 && rounds < 100) {
+    active_expire_db.ActiveExpire();
+    rounds++;
+  }
+  ASSERT_EQ(active_expire_db.GetActiveExpiredKeys(), 5);
+  ASSERT_GT(rounds, 1);
+
+  // The expired keys are gone, not only hidden, the others are left alone
+  std::vector<storage::KeyInfo> key_infos;
+  s = active_expire_db.GetKeyNum(&key_infos);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(key_infos.size(), 5);
+  for (const auto& key_info : key_infos) {
+    ASSERT_EQ(key_info.keys, 2);
+    ASSERT_EQ(key_info.expires, 1);
+    ASSERT_EQ(key_info.invaild_keys, 0);
+  }
+  std::map<storage::DataType, int64_t> ttls = active_expire_db.TTL("ACTIVE_EXPIRE_PERSIST_KEY", &type_status);
+  for (const auto& item : ttls) {
+    ASSERT_EQ(item.second, -1);
+  }
+
+  // A key written again after it expired starts empty
+  s = active_expire_db.HSet("ACTIVE_EXPIRE_KEY", "FIELD", "VALUE", &ret);
+  ASSERT_TRUE(s.ok());
+  int32_t hlen = 0;
+  s = active_expire_db.HLen("ACTIVE_EXPIRE_KEY", &hlen);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(hlen, 1);
+
+  storage::DeleteFiles(path.c_str());
+}
+
+// Reads served by the value cache see every write
+TEST_F(KeysTest, ValueCacheTest) {
+  std::string path = "./db/value_cache";
+  if (access(path.c_str(), F_OK) != 0) {
+    mkdir(path.c_str(), 0755);
+  }
+  storage::StorageOptions value_cache_options;
+  value_cache_options.options.create_if_missing = true;
+  value_cache_options.value_cache_size = 1 << 20;
+  storage::Storage value_cache_db;
+  s = value_cache_db.Open(value_cache_options, path);
+  ASSERT_TRUE(s.ok());
+
+  int32_t ret;
+  std::string value;
+  std::vector<storage::FieldValue> fvs;
+  std::map<storage::DataType, Status> type_status;
+  // The second read of a key is a hit
+  for (int i = 0; i < 2; i++) {
+    s = value_cache_db.Set("VALUE_CACHE_KEY", "VALUE");
+    ASSERT_TRUE(s.ok());
+    s = value_cache_db.HMSet("VALUE_CACHE_KEY", {{"FIELD1", "VALUE1"}, {"FIELD2", "VALUE2"}});
+    ASSERT_TRUE(s.ok());
+    for (int j = 0; j < 2; j++) {
+      s = value_cache_db.Get("VALUE_CACHE_KEY", &value);
+      ASSERT_TRUE(s.ok());
+      ASSERT_EQ(value, "VALUE");
+      s = value_cache_db.HGet("VALUE_CACHE_KEY", "FIELD1", &value);
+      ASSERT_TRUE(s.ok());
+      ASSERT_EQ(value, "VALUE1");
+      s = value_cache_db.HGet("VALUE_CACHE_KEY", "FIELD3", &value);
+      ASSERT_TRUE(s.IsNotFound());
+    }
+
+    s = value_cache_db.Set("VALUE_CACHE_KEY", "NEW_VALUE");
+    ASSERT_TRUE(s.ok());
+    s = value_cache_db.Get("VALUE_CACHE_KEY", &value);
+    ASSERT_TRUE(s.ok());
+    ASSERT_EQ(value, "NEW_VALUE");
+    s = value_cache_db.HSet("VALUE_CACHE_KEY", "FIELD3", "VALUE3", &ret);
+    ASSERT_TRUE(s.ok());
+    s = value_cache_db.HGet("VALUE_CACHE_KEY", "FIELD3", &value);
+    ASSERT_TRUE(s.ok());
+    ASSERT_EQ(value, "VALUE3");
+    fvs.clear();
+    s = value_cache_db.HGetall("VALUE_CACHE_KEY", &fvs);
+    ASSERT_TRUE(s.ok());
+    ASSERT_EQ(fvs.size(), 3);
+
+    // Deleted keys are gone from the cache, and the new version of a hash
+    // written again does not show the old fields
+    ret = value_cache_db.Del({"VALUE_CACHE_KEY"}, &type_status);
+    ASSERT_EQ(ret, 2);
+    s = value_cache_db.Get("VALUE_CACHE_KEY", &value);
+    ASSERT_TRUE(s.IsNotFound());
+    fvs.clear();
+    s = value_cache_db.HGetall("VALUE_CACHE_KEY", &fvs);
+    ASSERT_TRUE(s.IsNotFound());
+  }
+
+  s = value_cache_db.Set("VALUE_CACHE_KEY", "VALUE");
+  ASSERT_TRUE(s.ok());
+  s = value_cache_db.Get("VALUE_CACHE_KEY", &value);
+  ASSERT_TRUE(s.ok());
+  ret = value_cache_db.Expire("VALUE_CACHE_KEY", 1, &type_status);
+  ASSERT_EQ(ret, 1);
+  std::this_thread::sleep_for(std::chrono::milliseconds(2000));
+  s = value_cache_db.Get("VALUE_CACHE_KEY", &value);
+  ASSERT_TRUE(s.IsNotFound());
+
+  storage::ValueCacheInfo value_cache_info;
+  value_cache_db.GetValueCacheInfo(&value_cache_info);
+  ASSERT_GT(value_cache_info.hits, 0);
+  ASSERT_GT(value_cache_info.misses, 0);
+
+  storage::DeleteFiles(path.c_str());
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -11,6 +11,7 @@
 #include "src/redis.h"
 #include "storage/storage.h"
 
+using storage::DataFilterStatistics;
 using storage::EncodeFixed64;
 using storage::ListsDataFilter;
 using storage::ListsDataKey;
@@ -211,6 +212,43 @@ TEST_F(ListsFilterTest, DataFilterTest) {
   ASSERT_EQ(filter_result, true);
 }
 
+// Data Filter, the meta values of consecutive keys are read by stepping forward
+TEST_F(ListsFilterTest, DataFilterSequentialLookupTest) {
+  char str[8];
+  bool value_changed;
+  std::string new_value;
+  std::vector<int32_t> versions;
+  DataFilterStatistics statistics;
+
+  for (int32_t idx = 0; idx < 20; idx++) {
+    EncodeFixed64(str, 1);
+    ListsMetaValue lists_meta_value(Slice(str, sizeof(uint64_t)));
+    versions.push_back(lists_meta_value.UpdateVersion());
+    s = meta_db->Put(rocksdb::WriteOptions(), handles[0], "SEQUENTIAL_KEY_" + std::to_string(100 + idx * 2),
+                     lists_meta_value.Encode());
+    ASSERT_TRUE(s.ok());
+  }
+
+  {
+    auto lists_data_filter = std::make_unique<ListsDataFilter>(meta_db, &handles, &statistics);
+    for (int32_t idx = 0; idx < 40; idx++) {
+      // The odd keys have no meta value
+      ListsDataKey lists_data_key("SEQUENTIAL_KEY_" + std::to_string(100 + idx), versions[idx / 2], 1);
+      bool filter_result =
+          lists_data_filter->Filter(0, lists_data_key.Encode(), "FILTER_TEST_VALUE", &new_value, &value_changed);
+      ASSERT_EQ(filter_result, idx % 2 != 0);
+    }
+  }
+  ASSERT_EQ(statistics.lookups, 40);
+  ASSERT_EQ(statistics.seeks, 1);
+  ASSERT_EQ(statistics.iterator_hits, 39);
+
+  for (int32_t idx = 0; idx < 20; idx++) {
+    s = meta_db->Delete(rocksdb::WriteOptions(), handles[0], "SEQUENTIAL_KEY_" + std::to_string(100 + idx * 2));
+    ASSERT_TRUE(s.ok());
+  }
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
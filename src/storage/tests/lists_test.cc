@@ -4,6 +4,7 @@
 //  of patent rights can be found in the PATENTS file in the same directory.
 
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <iostream>
 #include <thread>
 
@@ -2699,6 +2700,156 @@ TEST_F(ListsTest, RPushxTest) {  // NOLINT
   ASSERT_TRUE(s.ok());
 }
 
+// Chunked layout
+TEST_F(ListsTest, ChunkedListTest) {  // NOLINT
+  std::string path = "./db/lists_chunked";
+  if (access(path.c_str(), F_OK) != 0) {
+    mkdir(path.c_str(), 0755);
+  }
+  uint64_t num;
+  int64_t ret;
+  std::string element;
+  std::vector<std::string> elements;
+
+  // Written in the plain layout
+  std::vector<std::string> plain_nodes{"a", "b", "c", "d", "e"};
+  {
+    storage::Storage plain_db;
+    ASSERT_TRUE(plain_db.Open(storage_options, path).ok());
+    ASSERT_TRUE(plain_db.RPush("GP1_CHUNKED_KEY", plain_nodes, &num).ok());
+  }
+
+  storage::StorageOptions chunked_options = storage_options;
+  chunked_options.lists_chunk_size = 4;
+  std::vector<std::string> chunked_nodes;
+  for (int32_t idx = 0; idx < 100; ++idx) {
+    chunked_nodes.push_back("NODE_" + std::to_string(idx));
+  }
+  {
+    storage::Storage chunked_db;
+    ASSERT_TRUE(chunked_db.Open(chunked_options, path).ok());
+
+    // The plain list is still readable and writable
+    ASSERT_TRUE(elements_match(&chunked_db, "GP1_CHUNKED_KEY", plain_nodes));
+    ASSERT_TRUE(chunked_db.LInsert("GP1_CHUNKED_KEY", storage::Before, "c", "x", &ret).ok());
+    ASSERT_EQ(ret, 6);
+    plain_nodes.insert(plain_nodes.begin() + 2, "x");
+    ASSERT_TRUE(elements_match(&chunked_db, "GP1_CHUNKED_KEY", plain_nodes));
+
+    // New lists are chunked
+    ASSERT_TRUE(chunked_db.RPush("GP2_CHUNKED_KEY", chunked_nodes, &num).ok());
+    ASSERT_EQ(num, 100);
+    ASSERT_TRUE(elements_match(&chunked_db, "GP2_CHUNKED_KEY", chunked_nodes));
+    ASSERT_TRUE(len_match(&chunked_db, "GP2_CHUNKED_KEY", 100));
+
+    ASSERT_TRUE(chunked_db.LInsert("GP2_CHUNKED_KEY", storage::After, "NODE_50", "NODE_INSERT", &ret).ok());
+    ASSERT_EQ(ret, 101);
+    chunked_nodes.insert(chunked_nodes.begin() + 51, "NODE_INSERT");
+    ASSERT_TRUE(chunked_db.LInsert("GP2_CHUNKED_KEY", storage::Before, "NODE_NOT_EXIST", "x", &ret).IsNotFound());
+    ASSERT_EQ(ret, -1);
+    ASSERT_TRUE(elements_match(&chunked_db, "GP2_CHUNKED_KEY", chunked_nodes));
+
+    ASSERT_TRUE(chunked_db.LSet("GP2_CHUNKED_KEY", -3, "NODE_SET").ok());
+    chunked_nodes[chunked_nodes.size() - 3] = "NODE_SET";
+    ASSERT_TRUE(chunked_db.LSet("GP2_CHUNKED_KEY", 101, "NODE_SET").IsCorruption());
+    ASSERT_TRUE(chunked_db.LIndex("GP2_CHUNKED_KEY", -3, &element).ok());
+    ASSERT_EQ(element, "NODE_SET");
+    ASSERT_TRUE(chunked_db.LIndex("GP2_CHUNKED_KEY", 101, &element).IsNotFound());
+
+    ASSERT_TRUE(chunked_db.LRem("GP2_CHUNKED_KEY", 0, "NODE_INSERT", &num).ok());
+    ASSERT_EQ(num, 1);
+    chunked_nodes.erase(chunked_nodes.begin() + 51);
+    ASSERT_TRUE(chunked_db.LRem("GP2_CHUNKED_KEY", -1, "NODE_NOT_EXIST", &num).IsNotFound());
+    ASSERT_TRUE(elements_match(&chunked_db, "GP2_CHUNKED_KEY", chunked_nodes));
+
+    ASSERT_TRUE(chunked_db.LTrim("GP2_CHUNKED_KEY", 5, -6).ok());
+    chunked_nodes = std::vector<std::string>(chunked_nodes.begin() + 5, chunked_nodes.end() - 5);
+    ASSERT_TRUE(elements_match(&chunked_db, "GP2_CHUNKED_KEY", chunked_nodes));
+
+    ASSERT_TRUE(chunked_db.LPop("GP2_CHUNKED_KEY", 6, &elements).ok());
+    ASSERT_TRUE(elements_match(elements, std::vector<std::string>(chunked_nodes.begin(), chunked_nodes.begin() + 6)));
+    chunked_nodes.erase(chunked_nodes.begin(), chunked_nodes.begin() + 6);
+    ASSERT_TRUE(chunked_db.RPop("GP2_CHUNKED_KEY", 1, &elements).ok());
+    ASSERT_TRUE(elements_match(elements, {chunked_nodes.back()}));
+    chunked_nodes.pop_back();
+    ASSERT_TRUE(chunked_db.LPush("GP2_CHUNKED_KEY", {"NODE_HEAD"}, &num).ok());
+    chunked_nodes.insert(chunked_nodes.begin(), "NODE_HEAD");
+    ASSERT_TRUE(elements_match(&chunked_db, "GP2_CHUNKED_KEY", chunked_nodes));
+
+    // Moves between both layouts
+    ASSERT_TRUE(chunked_db.RPoplpush("GP2_CHUNKED_KEY", "GP1_CHUNKED_KEY", &element).ok());
+    ASSERT_EQ(element, chunked_nodes.back());
+    plain_nodes.insert(plain_nodes.begin(), chunked_nodes.back());
+    chunked_nodes.pop_back();
+    ASSERT_TRUE(chunked_db.RPoplpush("GP1_CHUNKED_KEY", "GP2_CHUNKED_KEY", &element).ok());
+    ASSERT_EQ(element, plain_nodes.back());
+    chunked_nodes.insert(chunked_nodes.begin(), plain_nodes.back());
+    plain_nodes.pop_back();
+    ASSERT_TRUE(chunked_db.RPoplpush("GP2_CHUNKED_KEY", "GP2_CHUNKED_KEY", &element).ok());
+    chunked_nodes.insert(chunked_nodes.begin(), chunked_nodes.back());
+    chunked_nodes.pop_back();
+    ASSERT_TRUE(elements_match(&chunked_db, "GP1_CHUNKED_KEY", plain_nodes));
+    ASSERT_TRUE(elements_match(&chunked_db, "GP2_CHUNKED_KEY", chunked_nodes));
+    ASSERT_TRUE(len_match(&chunked_db, "GP2_CHUNKED_KEY", chunked_nodes.size()));
+
+    // Emptied and recreated
+    ASSERT_TRUE(chunked_db.LTrim("GP2_CHUNKED_KEY", 1, 0).ok());
+    ASSERT_TRUE(len_match(&chunked_db, "GP2_CHUNKED_KEY", 0));
+    ASSERT_TRUE(chunked_db.RPush("GP2_CHUNKED_KEY", {"x", "y", "z"}, &num).ok());
+    ASSERT_EQ(num, 3);
+    chunked_nodes = {"x", "y", "z"};
+    ASSERT_TRUE(elements_match(&chunked_db, "GP2_CHUNKED_KEY", chunked_nodes));
+  }
+
+  // Chunked lists stay readable and writable once new lists are plain again
+  {
+    storage::Storage plain_db;
+    ASSERT_TRUE(plain_db.Open(storage_options, path).ok());
+    ASSERT_TRUE(elements_match(&plain_db, "GP2_CHUNKED_KEY", chunked_nodes));
+    ASSERT_TRUE(plain_db.RPushx("GP2_CHUNKED_KEY", {"NODE_TAIL"}, &num).ok());
+    ASSERT_EQ(num, 4);
+    chunked_nodes.push_back("NODE_TAIL");
+    ASSERT_TRUE(elements_match(&plain_db, "GP2_CHUNKED_KEY", chunked_nodes));
+  }
+  storage::DeleteFiles(path.c_str());
+}
+
+// Longer than the chunk table holds at the chunk size
+TEST_F(ListsTest, ChunkedListLongTest) {  // NOLINT
+  std::string path = "./db/lists_chunked_long";
+  if (access(path.c_str(), F_OK) != 0) {
+    mkdir(path.c_str(), 0755);
+  }
+  uint64_t num;
+  int64_t ret;
+
+  storage::StorageOptions chunked_options = storage_options;
+  chunked_options.lists_chunk_size = 1;
+  storage::Storage chunked_db;
+  ASSERT_TRUE(chunked_db.Open(chunked_options, path).ok());
+
+  std::vector<std::string> nodes;
+  for (int32_t idx = 0; idx < 10000; ++idx) {
+    nodes.push_back("NODE_" + std::to_string(idx));
+  }
+  ASSERT_TRUE(chunked_db.RPush("GP1_CHUNKED_LONG_KEY", nodes, &num).ok());
+  ASSERT_EQ(num, 10000);
+  for (int32_t idx = 0; idx < 100; ++idx) {
+    ASSERT_TRUE(chunked_db.LPush("GP1_CHUNKED_LONG_KEY", {"HEAD_" + std::to_string(idx)}, &num).ok());
+    nodes.insert(nodes.begin(), "HEAD_" + std::to_string(idx));
+  }
+  ASSERT_TRUE(chunked_db.LInsert("GP1_CHUNKED_LONG_KEY", storage::Before, "NODE_5000", "NODE_INSERT", &ret).ok());
+  ASSERT_EQ(ret, 10101);
+  nodes.insert(std::find(nodes.begin(), nodes.end(), "NODE_5000"), "NODE_INSERT");
+  ASSERT_TRUE(elements_match(&chunked_db, "GP1_CHUNKED_LONG_KEY", nodes));
+  ASSERT_TRUE(len_match(&chunked_db, "GP1_CHUNKED_LONG_KEY", nodes.size()));
+
+  ASSERT_TRUE(chunked_db.LTrim("GP1_CHUNKED_LONG_KEY", 3000, -3000).ok());
+  nodes = std::vector<std::string>(nodes.begin() + 3000, nodes.end() - 2999);
+  ASSERT_TRUE(elements_match(&chunked_db, "GP1_CHUNKED_LONG_KEY", nodes));
+  storage::DeleteFiles(path.c_str());
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -3,10 +3,11 @@
 //  LICENSE file in the root directory of this source tree. An additional grant
 //  of patent rights can be found in the PATENTS file in the same directory.
 
+#include <chrono>
 #include <thread>
+#include <vector>
 
 #include "src/lock_mgr.h"
-#include "src/mutex_impl.h"
 
 using namespace storage;
 
@@ -18,9 +19,49 @@ void Func(LockMgr* mgr, int id, const std::string& key) {
   printf("thread %d UnLock %s\n", id, key.c_str());
 }
 
+// thread_num threads lock and unlock keys picked from key_num keys, by the
+// key or by its precomputed hash, every key counts the times it was locked,
+// which adds up only if no two threads held it at the same time
+bool CheckExclusive(size_t thread_num, size_t key_num, bool precomputed) {
+  const size_t ops_per_thread = 20000;
+  LockMgr mgr(1000, 0);
+  std::vector<std::string> keys;
+  std::vector<uint64_t> hashes;
+  for (size_t i = 0; i < key_num; i++) {
+    keys.push_back("key_" + std::to_string(i));
+    hashes.push_back(LockMgr::Hash(keys.back()));
+  }
+  std::vector<size_t> counts(key_num, 0);
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < thread_num; i++) {
+    threads.emplace_back([&, i]() {
+      for (size_t j = 0; j < ops_per_thread; j++) {
+        size_t k = (i * 104729 + j * 7919) % key_num;
+        if (precomputed) {
+          mgr.TryLock(hashes[k]);
+          counts[k]++;
+          mgr.UnLock(hashes[k]);
+        } else {
+          mgr.TryLock(keys[k]);
+          counts[k]++;
+          mgr.UnLock(keys[k]);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  size_t total = 0;
+  for (size_t count : counts) {
+    total += count;
+  }
+  return total == thread_num * ops_per_thread;
+}
+
 int main() {
-  std::shared_ptr<MutexFactory> factory = std::make_shared<MutexFactoryImpl>();
-  LockMgr mgr(1, 3, factory);
+  LockMgr mgr(1, 3);
 
   std::thread t1(Func, &mgr, 1, "key_1");
   std::this_thread::sleep_for(std::chrono::milliseconds(100));
@@ -40,5 +81,13 @@ int main() {
   t2.join();
   t3.join();
   t4.join();
+
+  // A few hot keys, see tools/lock_mgr_bench for the throughput
+  for (bool precomputed : {false, true}) {
+    if (!CheckExclusive(4, 4, precomputed)) {
+      printf("lost updates with 4 threads on 4 keys\n");
+      return 1;
+    }
+  }
   return 0;
 }
@@ -487,6 +487,78 @@ TEST(LRUCacheTest, TestRemoveCase1) {
   ASSERT_TRUE(lru_cache.LRUAsExpected({}));
 }
 
+TEST(ShardedLRUCacheTest, TestLookupInsertRemove) {
+  Status s;
+  std::string value;
+  storage::ShardedLRUCache<std::string, std::string> lru_cache;
+  lru_cache.SetCapacity(16000);
+  ASSERT_EQ(lru_cache.Capacity(), 16000);
+
+  // Every shard holds 1000 entries, nothing is evicted
+  for (int i = 0; i < 1000; i++) {
+    s = lru_cache.Insert("k" + std::to_string(i), "v" + std::to_string(i));
+    ASSERT_TRUE(s.ok());
+  }
+  ASSERT_EQ(lru_cache.Size(), 1000);
+  ASSERT_EQ(lru_cache.TotalCharge(), 1000);
+  for (int i = 0; i < 1000; i++) {
+    s = lru_cache.Lookup("k" + std::to_string(i), &value);
+    ASSERT_TRUE(s.ok());
+    ASSERT_EQ(value, "v" + std::to_string(i));
+  }
+
+  // Inserting an existing key replaces its value
+  s = lru_cache.Insert("k1", "v1_new");
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(lru_cache.Size(), 1000);
+  s = lru_cache.Lookup("k1", &value);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(value, "v1_new");
+
+  s = lru_cache.Remove("k1");
+  ASSERT_TRUE(s.ok());
+  s = lru_cache.Remove("k1");
+  ASSERT_TRUE(s.IsNotFound());
+  s = lru_cache.Lookup("k1", &value);
+  ASSERT_TRUE(s.IsNotFound());
+  ASSERT_EQ(lru_cache.Size(), 999);
+  ASSERT_TRUE(lru_cache.LRUAndHandleTableConsistent());
+
+  s = lru_cache.Clear();
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(lru_cache.Size(), 0);
+  ASSERT_EQ(lru_cache.TotalCharge(), 0);
+}
+
+TEST(ShardedLRUCacheTest, TestSetCapacity) {
+  Status s;
+  storage::ShardedLRUCache<std::string, std::string> lru_cache;
+  size_t num_shards = lru_cache.NumShards();
+
+  // Nothing is cached without a capacity
+  s = lru_cache.Insert("k1", "v1");
+  ASSERT_FALSE(s.ok());
+
+  // Every shard evicts within its share of the capacity
+  lru_cache.SetCapacity(num_shards * 4);
+  for (int i = 0; i < 1000; i++) {
+    lru_cache.Insert("k" + std::to_string(i), "v" + std::to_string(i));
+  }
+  ASSERT_LE(lru_cache.Size(), num_shards * 4);
+  ASSERT_GT(lru_cache.Size(), 0);
+  ASSERT_TRUE(lru_cache.LRUAndHandleTableConsistent());
+
+  // The most recently inserted key of a shard survives
+  std::string value;
+  s = lru_cache.Lookup("k999", &value);
+  ASSERT_TRUE(s.ok());
+
+  // Shrinking evicts right away
+  lru_cache.SetCapacity(num_shards);
+  ASSERT_LE(lru_cache.Size(), num_shards);
+  ASSERT_TRUE(lru_cache.LRUAndHandleTableConsistent());
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
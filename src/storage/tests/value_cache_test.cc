@@ -0,0 +1,77 @@
+//  Copyright (c) 2017-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include <gtest/gtest.h>
+#include <string>
+
+#include "src/value_cache.h"
+
+using namespace storage;
+
+TEST(ValueCacheTest, TestLookupFillInvalidate) {
+  storage::ValueCache value_cache(1 << 20, 0);
+  std::string value;
+  uint64_t ticket = 0;
+
+  ASSERT_FALSE(value_cache.Lookup("k1", &value, &ticket));
+  ASSERT_NE(ticket, 0);
+  value_cache.Fill("k1", "v1", ticket);
+  ASSERT_TRUE(value_cache.Lookup("k1", &value, &ticket));
+  ASSERT_EQ(value, "v1");
+  ASSERT_EQ(value_cache.Entries(), 1);
+
+  value_cache.Invalidate("k1");
+  ASSERT_FALSE(value_cache.Lookup("k1", &value, &ticket));
+  ASSERT_EQ(value_cache.Entries(), 0);
+  ASSERT_EQ(value_cache.Usage(), 0);
+  ASSERT_EQ(value_cache.hits(), 1);
+  ASSERT_EQ(value_cache.misses(), 2);
+
+  // A write that came in after the lookup voids the fill
+  ASSERT_FALSE(value_cache.Lookup("k2", &value, &ticket));
+  value_cache.Invalidate("k2");
+  value_cache.Fill("k2", "old", ticket);
+  ASSERT_FALSE(value_cache.Lookup("k2", &value, &ticket));
+  ASSERT_EQ(value_cache.rejected_fills(), 1);
+
+  value_cache.Fill("k2", "new", ticket);
+  ASSERT_TRUE(value_cache.Lookup("k2", &value, &ticket));
+  ASSERT_EQ(value, "new");
+
+  ASSERT_FALSE(value_cache.Lookup("k3", &value, &ticket));
+  value_cache.Clear();
+  value_cache.Fill("k3", "v3", ticket);
+  ASSERT_FALSE(value_cache.Lookup("k3", &value, &ticket));
+  ASSERT_EQ(value_cache.Entries(), 0);
+}
+
+TEST(ValueCacheTest, TestAdmission) {
+  // Room for the 10 hot keys in a single shard
+  storage::ValueCache value_cache(10 * 100, 0);
+  std::string value;
+  uint64_t ticket = 0;
+  const std::string padding(24, 'v');
+  auto read = [&](const std::string& key) {
+    if (!value_cache.Lookup(key, &value, &ticket)) {
+      value_cache.Fill(key, padding, ticket);
+    }
+  };
+
+  // Every key read once in between does not push out the hot ones
+  for (int i = 0; i < 1000; i++) {
+    read("hot_" + std::to_string(i % 10));
+    read("cold_" + std::to_string(i));
+  }
+  ASSERT_LE(value_cache.Usage(), value_cache.capacity());
+  for (int i = 0; i < 10; i++) {
+    ASSERT_TRUE(value_cache.Lookup("hot_" + std::to_string(i), &value, &ticket));
+    ASSERT_EQ(value, padding);
+  }
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
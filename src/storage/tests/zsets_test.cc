@@ -4,9 +4,12 @@
 //  of patent rights can be found in the PATENTS file in the same directory.
 
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <iostream>
 #include <thread>
 
+#include "rocksdb/db.h"
+
 #include "storage/storage.h"
 #include "storage/util.h"
 
@@ -5232,6 +5235,107 @@ TEST_F(ZSetsTest, ZScanTest) {  // NOLINT
   ASSERT_TRUE(score_members_match(score_member_out, {}));
 }
 
+// Rank index
+TEST_F(ZSetsTest, ZRankIndexTest) {  // NOLINT
+  std::string path = "./db/zsets_rank";
+  if (access(path.c_str(), F_OK) != 0) {
+    mkdir(path.c_str(), 0755);
+  }
+  std::vector<storage::ScoreMember> score_members;
+  for (int32_t idx = 0; idx < 1000; ++idx) {
+    // Duplicated, negative and zero scores, members are ordered by name on ties
+    score_members.push_back({static_cast<double>(idx % 97) - 48, "MEMBER_" + std::to_string(idx)});
+  }
+  score_members.push_back({-0.0, "MEMBER_NEGATIVE_ZERO"});
+  score_members.push_back({1e300, "MEMBER_HUGE"});
+  std::vector<storage::ScoreMember> expect_sm = score_members;
+  std::sort(expect_sm.begin(), expect_sm.end(), [](const ScoreMember& a, const ScoreMember& b) {
+    return a.score < b.score || (a.score == b.score && a.member < b.member);
+  });
+
+  auto check = [&](storage::Storage* rank_db) {
+    int32_t rank = 0;
+    for (int32_t idx = 0; idx < static_cast<int32_t>(expect_sm.size()); ++idx) {
+      ASSERT_TRUE(rank_db->ZRank("GP1_ZRANK_INDEX_KEY", expect_sm[idx].member, &rank).ok());
+      ASSERT_EQ(rank, idx);
+      ASSERT_TRUE(rank_db->ZRevrank("GP1_ZRANK_INDEX_KEY", expect_sm[idx].member, &rank).ok());
+      ASSERT_EQ(rank, static_cast<int32_t>(expect_sm.size()) - idx - 1);
+    }
+    std::vector<storage::ScoreMember> sm_out;
+    ASSERT_TRUE(rank_db->ZRange("GP1_ZRANK_INDEX_KEY", 500, 509, &sm_out).ok());
+    ASSERT_EQ(sm_out.size(), 10);
+    for (int32_t idx = 0; idx < 10; ++idx) {
+      ASSERT_EQ(sm_out[idx].member, expect_sm[500 + idx].member);
+    }
+    ASSERT_TRUE(rank_db->ZRevrange("GP1_ZRANK_INDEX_KEY", 3, 5, &sm_out).ok());
+    ASSERT_EQ(sm_out.size(), 3);
+    for (int32_t idx = 0; idx < 3; ++idx) {
+      ASSERT_EQ(sm_out[idx].member, expect_sm[expect_sm.size() - 4 - idx].member);
+    }
+    ASSERT_TRUE(rank_db->ZRank("GP1_ZRANK_INDEX_KEY", "MEMBER_NOT_EXIST", &rank).IsNotFound());
+  };
+
+  auto has_rank_cf = [&]() {
+    std::vector<std::string> cf_names;
+    rocksdb::DB::ListColumnFamilies(rocksdb::DBOptions(), path + "/zsets", &cf_names);
+    return std::find(cf_names.begin(), cf_names.end(), "rank_cf") != cf_names.end();
+  };
+
+  // Written without the index, indexed by the next full compaction
+  {
+    storage::Storage plain_db;
+    ASSERT_TRUE(plain_db.Open(storage_options, path).ok());
+    int32_t ret = 0;
+    ASSERT_TRUE(plain_db.ZAdd("GP1_ZRANK_INDEX_KEY", score_members, &ret).ok());
+    ASSERT_EQ(ret, static_cast<int32_t>(score_members.size()));
+  }
+  // Never indexed, so still readable by the versions without rank_cf
+  ASSERT_FALSE(has_rank_cf());
+  storage::StorageOptions rank_options = storage_options;
+  rank_options.zset_rank_index = true;
+  {
+    storage::Storage rank_db;
+    ASSERT_TRUE(rank_db.Open(rank_options, path).ok());
+    check(&rank_db);
+    ASSERT_TRUE(rank_db.Compact(DataType::kZSets, true).ok());
+    check(&rank_db);
+
+    // Writes keep the index up to date
+    double score = 0;
+    int32_t ret = 0;
+    ASSERT_TRUE(rank_db.ZIncrby("GP1_ZRANK_INDEX_KEY", "MEMBER_0", 1000, &score).ok());
+    ASSERT_TRUE(rank_db.ZRem("GP1_ZRANK_INDEX_KEY", {"MEMBER_1", "MEMBER_2"}, &ret).ok());
+    ASSERT_TRUE(rank_db.ZAdd("GP1_ZRANK_INDEX_KEY", {{-1000, "MEMBER_NEW"}}, &ret).ok());
+    for (auto& sm : expect_sm) {
+      if (sm.member == "MEMBER_0") {
+        sm.score = score;
+      }
+    }
+    expect_sm.erase(std::remove_if(expect_sm.begin(), expect_sm.end(),
+                                   [](const ScoreMember& sm) { return sm.member == "MEMBER_1" || sm.member == "MEMBER_2"; }),
+                    expect_sm.end());
+    expect_sm.push_back({-1000, "MEMBER_NEW"});
+    std::sort(expect_sm.begin(), expect_sm.end(), [](const ScoreMember& a, const ScoreMember& b) {
+      return a.score < b.score || (a.score == b.score && a.member < b.member);
+    });
+    check(&rank_db);
+
+    ASSERT_TRUE(rank_db.ZRemrangebyrank("GP1_ZRANK_INDEX_KEY", 10, 19, &ret).ok());
+    ASSERT_EQ(ret, 10);
+    expect_sm.erase(expect_sm.begin() + 10, expect_sm.begin() + 20);
+    check(&rank_db);
+  }
+  ASSERT_TRUE(has_rank_cf());
+
+  // Disabled again, what is left of the index is cleared and not used
+  {
+    storage::Storage plain_db;
+    ASSERT_TRUE(plain_db.Open(storage_options, path).ok());
+    check(&plain_db);
+  }
+  storage::DeleteFiles(path.c_str());
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
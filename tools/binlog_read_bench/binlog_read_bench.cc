@@ -0,0 +1,225 @@
+//  Copyright (c) 2023-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+/*
+ * Reads a recorded binlog with several slaves catching up at once, the way
+ * the master reads it for them: with a read call for every header and every
+ * record of a sequential file as before, and with the chunks of
+ * BinlogChunkReader shared by the slaves. Only the physical records are
+ * parsed, nothing is sent.
+ */
+
+#include <fcntl.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pstd/include/env.h"
+
+#include "include/pika_binlog_chunk_reader.h"
+
+std::string binlog_path = "./log/";
+uint32_t first_file = 0;
+uint32_t last_file = 0;
+int32_t replicas = 4;
+bool drop_cache = false;
+
+struct ReadResult {
+  uint64_t records = 0;
+  uint64_t bytes = 0;
+  // Keeps the reads of the records from being optimized away
+  uint64_t checksum = 0;
+};
+
+static uint64_t NowMicros() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  return static_cast<uint64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+void Usage() {
+  std::cout << "Usage: " << std::endl;
+  std::cout << "\tBinlog_read_bench reads pika's binlog for several slaves catching up at once" << std::endl;
+  std::cout << "\t-h    -- displays this help information and exits" << std::endl;
+  std::cout << "\t-n    -- input binlog path" << std::endl;
+  std::cout << "\t-f    -- files to read, a number or a range like 0-99, default = 0" << std::endl;
+  std::cout << "\t-r    -- slaves reading at once, default = 4" << std::endl;
+  std::cout << "\t-d    -- drop the files from the page cache before every mode" << std::endl;
+  std::cout << "\texample: ./binlog_read_bench -n ./log -f 0-99 -r 8 -d" << std::endl;
+}
+
+std::string FileName(uint32_t filenum) { return binlog_path + "write2file" + std::to_string(filenum); }
+
+// The reads of a sequential file, as PikaBinlogReader used to do them
+class SequentialReader {
+ public:
+  static std::atomic<uint64_t> reads;
+
+  pstd::Status Open(const std::string& filename) {
+    scratch_ = std::make_unique<char[]>(kBlockSize);
+    return pstd::NewSequentialFile(filename, file_);
+  }
+  pstd::Status Read(size_t n, pstd::Slice* result) {
+    reads++;
+    return file_->Read(n, result, scratch_.get());
+  }
+  void Skip(uint64_t n) { file_->Skip(n); }
+
+ private:
+  std::unique_ptr<pstd::SequentialFile> file_;
+  std::unique_ptr<char[]> scratch_;
+};
+
+std::atomic<uint64_t> SequentialReader::reads = 0;
+
+class ChunkReader {
+ public:
+  pstd::Status Open(const std::string& filename) { return reader_.Open(filename, true); }
+  pstd::Status Read(size_t n, pstd::Slice* result) { return reader_.Read(n, result); }
+  void Skip(uint64_t n) { reader_.Skip(n); }
+
+ private:
+  BinlogChunkReader reader_;
+};
+
+// Walks the physical records of a file the way PikaBinlogReader does
+template <typename Reader>
+bool ReadFile(const std::string& filename, ReadResult* result) {
+  Reader reader;
+  if (!reader.Open(filename).ok()) {
+    std::cout << "Open " << filename << " failed" << std::endl;
+    return false;
+  }
+  uint64_t block_offset = 0;
+  while (true) {
+    if (kBlockSize - block_offset <= kHeaderSize) {
+      reader.Skip(kBlockSize - block_offset);
+      block_offset = 0;
+    }
+    pstd::Slice header;
+    if (!reader.Read(kHeaderSize, &header).ok()) {
+      return true;
+    }
+    const uint32_t a = static_cast<uint32_t>(header[0]) & 0xff;
+    const uint32_t b = static_cast<uint32_t>(header[1]) & 0xff;
+    const uint32_t c = static_cast<uint32_t>(header[2]) & 0xff;
+    const unsigned int type = header[7];
+    const uint32_t length = a | (b << 8) | (c << 16);
+    if (length > (kBlockSize - kHeaderSize)) {
+      std::cout << "Bad record in " << filename << std::endl;
+      return false;
+    }
+    if (type == kZeroType || length == 0) {
+      return true;
+    }
+    pstd::Slice record;
+    if (!reader.Read(length, &record).ok()) {
+      return true;
+    }
+    result->records++;
+    result->bytes += kHeaderSize + length;
+    result->checksum += static_cast<uint8_t>(record[0]) + static_cast<uint8_t>(record[length - 1]);
+    block_offset += kHeaderSize + length;
+  }
+}
+
+void DropCache() {
+  for (uint32_t filenum = first_file; filenum <= last_file; filenum++) {
+    int fd = open(FileName(filenum).c_str(), O_RDONLY);
+    if (fd >= 0) {
+      posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+      close(fd);
+    }
+  }
+}
+
+template <typename Reader>
+void Run(const std::string& mode, const std::function<uint64_t()>& read_calls) {
+  if (drop_cache) {
+    DropCache();
+  }
+  std::vector<ReadResult> results(replicas);
+  std::vector<std::thread> threads;
+  uint64_t calls_before = read_calls();
+  uint64_t start = NowMicros();
+  for (int32_t i = 0; i < replicas; i++) {
+    threads.emplace_back([i, &results] {
+      for (uint32_t filenum = first_file; filenum <= last_file; filenum++) {
+        if (!ReadFile<Reader>(FileName(filenum), &results[i])) {
+          return;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  uint64_t elapsed_us = NowMicros() - start + 1;
+  uint64_t records = 0;
+  uint64_t bytes = 0;
+  for (const auto& result : results) {
+    records += result.records;
+    bytes += result.bytes;
+    if (result.checksum != results[0].checksum) {
+      std::cout << mode << ": slaves read different records" << std::endl;
+    }
+  }
+  std::cout << mode << ": slaves " << replicas << ", cost " << elapsed_us / 1000 << " ms, "
+            << records * 1000000 / elapsed_us << " records/s, " << bytes / elapsed_us << " MB/s, "
+            << read_calls() - calls_before << " read calls" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  int32_t opt;
+  std::string files = "0";
+  while ((opt = getopt(argc, argv, "hn:f:r:d")) != -1) {
+    switch (opt) {
+      case 'h':
+        Usage();
+        exit(0);
+      case 'n':
+        binlog_path = optarg;
+        if (!binlog_path.empty() && binlog_path.back() != '/') {
+          binlog_path += "/";
+        }
+        break;
+      case 'f':
+        files = optarg;
+        break;
+      case 'r':
+        replicas = std::max(1, std::atoi(optarg));
+        break;
+      case 'd':
+        drop_cache = true;
+        break;
+      default:
+        break;
+    }
+  }
+  std::string::size_type pos = files.find('-');
+  first_file = std::atoi(files.substr(0, pos).c_str());
+  last_file = pos == std::string::npos ? first_file : std::atoi(files.substr(pos + 1).c_str());
+  for (uint32_t filenum = first_file; filenum <= last_file; filenum++) {
+    if (!pstd::FileExists(FileName(filenum))) {
+      std::cout << FileName(filenum) << " not found, exit..." << std::endl;
+      exit(-1);
+    }
+  }
+
+  Run<SequentialReader>("sequential", [] { return SequentialReader::reads.load(); });
+  Run<ChunkReader>("chunk", [] { return BinlogChunkReader::Stats().reads.load(); });
+  std::cout << "chunks shared: " << BinlogChunkReader::Stats().cache_hits << std::endl;
+  return 0;
+}
@@ -0,0 +1,344 @@
+//  Copyright (c) 2023-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+/*
+ * Replays a recorded binlog on the two ways a slave may spread the commands
+ * over its workers: by the hash of argv[1] over the half of the workers that
+ * applied them before, or by the keys of every command over all the workers,
+ * as PikaReplClient does now. The storage is not touched, every command costs
+ * a fixed busy wait instead, so only the scheduling is measured.
+ */
+
+#include <strings.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pstd/include/key_dependency_scheduler.h"
+
+#include "binlog_consumer.h"
+#include "binlog_transverter.h"
+#include "utils.h"
+
+std::string binlog_path = "./log/";
+std::string files_to_replay = "0";
+int64_t file_offset = 0;
+int32_t sync_thread_num = 6;
+int32_t cmd_cost_us = 10;
+
+struct ReplayCmd {
+  std::vector<std::string> argv;
+  std::vector<uint64_t> key_hashes;
+  // Its keys are unknown, it waits for every command before it
+  bool barrier = false;
+};
+
+static uint64_t NowMicros() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  return static_cast<uint64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+void Usage() {
+  std::cout << "Usage: " << std::endl;
+  std::cout << "\tBinlog_replay_bench replays pika's binlog on the workers of a slave without a storage" << std::endl;
+  std::cout << "\t-h    -- displays this help information and exits" << std::endl;
+  std::cout << "\t-n    -- input binlog path" << std::endl;
+  std::cout << "\t-f    -- files to replay, default = 0" << std::endl;
+  std::cout << "\t-o    -- the offset that the first file starts replaying" << std::endl;
+  std::cout << "\t-t    -- sync-thread-num of the slave, default = 6" << std::endl;
+  std::cout << "\t-c    -- microseconds applying a command costs, default = 10" << std::endl;
+  std::cout << "\texample: ./binlog_replay_bench -n ./log -f 526-530 -t 6 -c 10" << std::endl;
+}
+
+// The content of a binlog item is the command serialized as a RESP array
+bool ParseCommand(const std::string& content, std::vector<std::string>* argv) {
+  size_t pos = 0;
+  auto read_number = [&](char type, int64_t* number) {
+    if (pos >= content.size() || content[pos] != type) {
+      return false;
+    }
+    size_t end = content.find("\r\n", pos);
+    if (end == std::string::npos) {
+      return false;
+    }
+    *number = std::strtoll(content.c_str() + pos + 1, nullptr, 10);
+    pos = end + 2;
+    return true;
+  };
+  int64_t argc = 0;
+  if (!read_number('*', &argc) || argc <= 0) {
+    return false;
+  }
+  argv->clear();
+  for (int64_t i = 0; i < argc; i++) {
+    int64_t len = 0;
+    if (!read_number('$', &len) || len < 0 || pos + len + 2 > content.size()) {
+      return false;
+    }
+    argv->push_back(content.substr(pos, len));
+    pos += len + 2;
+  }
+  return true;
+}
+
+// The keys of the commands written to the binlog, a short list of what the
+// current_key of the commands tells a slave
+void AnalyzeKeys(ReplayCmd* cmd) {
+  const std::vector<std::string>& argv = cmd->argv;
+  const char* name = argv[0].c_str();
+  std::vector<std::string> keys;
+  if (argv.size() < 2 || strcasecmp(name, "flushdb") == 0 || strcasecmp(name, "flushall") == 0) {
+    cmd->barrier = true;
+    return;
+  }
+  if (strcasecmp(name, "mset") == 0 || strcasecmp(name, "msetnx") == 0) {
+    for (size_t i = 1; i < argv.size(); i += 2) {
+      keys.push_back(argv[i]);
+    }
+  } else if (strcasecmp(name, "del") == 0 || strcasecmp(name, "unlink") == 0 || strcasecmp(name, "pfmerge") == 0 ||
+             strcasecmp(name, "sdiffstore") == 0 || strcasecmp(name, "sinterstore") == 0 ||
+             strcasecmp(name, "sunionstore") == 0) {
+    keys.assign(argv.begin() + 1, argv.end());
+  } else if ((strcasecmp(name, "rename") == 0 || strcasecmp(name, "renamenx") == 0 ||
+              strcasecmp(name, "rpoplpush") == 0 || strcasecmp(name, "smove") == 0) &&
+             argv.size() >= 3) {
+    keys.assign(argv.begin() + 1, argv.begin() + 3);
+  } else {
+    keys.push_back(argv[1]);
+  }
+  std::hash<std::string> str_hash;
+  for (const auto& key : keys) {
+    cmd->key_hashes.push_back(str_hash(key));
+  }
+  std::sort(cmd->key_hashes.begin(), cmd->key_hashes.end());
+  cmd->key_hashes.erase(std::unique(cmd->key_hashes.begin(), cmd->key_hashes.end()), cmd->key_hashes.end());
+}
+
+void ApplyCmd(const ReplayCmd* cmd) {
+  uint64_t until = NowMicros() + cmd_cost_us;
+  while (NowMicros() < until) {
+  }
+}
+
+// A worker applying the commands queued up on it one by one
+class ReplayWorker {
+ public:
+  using Item = std::pair<pstd::KeyDependencyScheduler::Task*, const ReplayCmd*>;
+
+  explicit ReplayWorker(pstd::KeyDependencyScheduler* scheduler) : scheduler_(scheduler) {
+    thread_ = std::thread([this] { Run(); });
+  }
+
+  ~ReplayWorker() {
+    {
+      std::lock_guard l(mu_);
+      stop_ = true;
+      cv_.notify_one();
+    }
+    thread_.join();
+  }
+
+  void Schedule(const Item& item) {
+    std::lock_guard l(mu_);
+    queue_.push_back(item);
+    pending_++;
+    cv_.notify_one();
+  }
+
+  size_t pending() const { return pending_; }
+  uint64_t applied() const { return applied_; }
+
+ private:
+  void Run() {
+    while (true) {
+      Item item;
+      {
+        std::unique_lock l(mu_);
+        cv_.wait(l, [this] { return stop_ || !queue_.empty(); });
+        if (queue_.empty()) {
+          return;
+        }
+        item = queue_.front();
+        queue_.pop_front();
+        pending_--;
+      }
+      ApplyCmd(item.second);
+      if (scheduler_ != nullptr) {
+        scheduler_->Finish(item.first);
+      }
+      applied_++;
+    }
+  }
+
+  pstd::KeyDependencyScheduler* scheduler_;
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::deque<Item> queue_;
+  bool stop_ = false;
+  std::atomic<size_t> pending_ = 0;
+  std::atomic<uint64_t> applied_ = 0;
+  std::thread thread_;
+};
+
+void WaitApplied(const std::vector<std::unique_ptr<ReplayWorker>>& workers, uint64_t total) {
+  while (true) {
+    uint64_t applied = 0;
+    for (const auto& worker : workers) {
+      applied += worker->applied();
+    }
+    if (applied >= total) {
+      return;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+}
+
+void PrintResult(const std::string& mode, size_t workers, uint64_t total, uint64_t elapsed_us,
+                 const std::string& extra) {
+  std::cout << mode << ": workers " << workers << ", cmds " << total << ", cost " << elapsed_us / 1000 << " ms, "
+            << total * 1000000 / (elapsed_us + 1) << " ops/s" << extra << std::endl;
+}
+
+// By the hash of argv[1] over sync-thread-num workers
+void ReplayByHash(const std::vector<ReplayCmd>& cmds) {
+  std::vector<std::unique_ptr<ReplayWorker>> workers;
+  for (int32_t i = 0; i < sync_thread_num; i++) {
+    workers.push_back(std::make_unique<ReplayWorker>(nullptr));
+  }
+  std::hash<std::string> str_hash;
+  uint64_t start = NowMicros();
+  for (const auto& cmd : cmds) {
+    const std::string& dispatch_key = cmd.argv.size() >= 2 ? cmd.argv[1] : cmd.argv[0];
+    workers[str_hash(dispatch_key) % workers.size()]->Schedule({nullptr, &cmd});
+  }
+  WaitApplied(workers, cmds.size());
+  PrintResult("hash", workers.size(), cmds.size(), NowMicros() - start, "");
+}
+
+// By the keys of every command over 2 * sync-thread-num workers
+void ReplayByKeys(const std::vector<ReplayCmd>& cmds) {
+  std::vector<std::unique_ptr<ReplayWorker>> workers;
+  std::atomic<size_t> next_worker = 0;
+  std::hash<std::string> str_hash;
+  pstd::KeyDependencyScheduler scheduler([&](pstd::KeyDependencyScheduler::Task* task, void* arg) {
+    auto cmd = static_cast<const ReplayCmd*>(arg);
+    size_t index = str_hash(cmd->argv.size() >= 2 ? cmd->argv[1] : cmd->argv[0]) % workers.size();
+    size_t other = next_worker++ % workers.size();
+    if (workers[other]->pending() < workers[index]->pending()) {
+      index = other;
+    }
+    workers[index]->Schedule({task, cmd});
+  });
+  for (int32_t i = 0; i < 2 * sync_thread_num; i++) {
+    workers.push_back(std::make_unique<ReplayWorker>(&scheduler));
+  }
+  uint64_t start = NowMicros();
+  for (const auto& cmd : cmds) {
+    scheduler.Submit(cmd.key_hashes, cmd.barrier, const_cast<ReplayCmd*>(&cmd));
+  }
+  WaitApplied(workers, cmds.size());
+  uint64_t elapsed_us = NowMicros() - start;
+  PrintResult("keys", workers.size(), cmds.size(), elapsed_us,
+              ", waited " + std::to_string(scheduler.waited()) + ", barriers " + std::to_string(scheduler.barriers()));
+  // Before the scheduler, whose tasks they finish
+  workers.clear();
+}
+
+int main(int argc, char* argv[]) {
+  int32_t opt;
+  while ((opt = getopt(argc, argv, "hn:f:o:t:c:")) != -1) {
+    switch (opt) {
+      case 'h':
+        Usage();
+        exit(0);
+      case 'n':
+        binlog_path = optarg;
+        if (!binlog_path.empty() && binlog_path.back() != '/') {
+          binlog_path += "/";
+        }
+        break;
+      case 'f':
+        files_to_replay = optarg;
+        break;
+      case 'o':
+        file_offset = std::atoi(optarg);
+        break;
+      case 't':
+        sync_thread_num = std::max(1, std::atoi(optarg));
+        break;
+      case 'c':
+        cmd_cost_us = std::max(0, std::atoi(optarg));
+        break;
+      default:
+        break;
+    }
+  }
+
+  std::vector<uint32_t> files;
+  if (!CheckFilesStr(files_to_replay) || !GetFileList(files_to_replay, &files)) {
+    std::cout << "input illlegal binlog scope of the sequence, exit..." << std::endl;
+    exit(-1);
+  }
+  if (!CheckBinlogExists(binlog_path, files)) {
+    std::cout << "binlog files not found in " << binlog_path << ", exit..." << std::endl;
+    exit(-1);
+  }
+
+  BinlogConsumer binlog_consumer(binlog_path, files.front(), files.back(), file_offset);
+  if (!binlog_consumer.Init()) {
+    fprintf(stderr, "Binlog comsumer initialization failure, exit...\n");
+    exit(-1);
+  } else if (!binlog_consumer.trim()) {
+    fprintf(stderr, "Binlog comsumer trim failure, maybe the offset is illegal, exit...\n");
+    exit(-1);
+  }
+
+  // Read up front, so reading the binlog is not part of the replay
+  std::vector<ReplayCmd> cmds;
+  BinlogItem binlog_item;
+  while (true) {
+    std::string scratch;
+    pstd::Status s = binlog_consumer.Parse(&scratch);
+    if (s.IsComplete()) {
+      break;
+    } else if (!s.ok()) {
+      fprintf(stderr, "Binlog Parse err: %s, exit...\n", s.ToString().c_str());
+      exit(-1);
+    }
+    if (!PikaBinlogTransverter::BinlogDecode(TypeFirst, scratch, &binlog_item)) {
+      std::cout << "Binlog Decode error, exit..." << std::endl;
+      exit(-1);
+    }
+    ReplayCmd cmd;
+    if (!ParseCommand(binlog_item.content(), &cmd.argv)) {
+      std::cout << "Command parse error, exit..." << std::endl;
+      exit(-1);
+    }
+    AnalyzeKeys(&cmd);
+    cmds.push_back(std::move(cmd));
+  }
+  std::cout << "Read " << cmds.size() << " commands from " << binlog_path << std::endl;
+  if (cmds.empty()) {
+    return 0;
+  }
+
+  ReplayByHash(cmds);
+  ReplayByKeys(cmds);
+  return 0;
+}
@@ -0,0 +1,150 @@
+//  Copyright (c) 2023-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+/*
+ * Counts the heap allocations a client request costs before it reaches the
+ * storage: getting the Cmd instance, initializing it with the argv and asking
+ * it for its keys. The instance is cloned from the command table for every
+ * request the way pika did before, or taken from the pool of the thread the
+ * way PikaCmdTableManager::GetCmd does now. Nothing is executed, so neither a
+ * server nor a storage is needed.
+ */
+
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "include/pika_cmd_table_manager.h"
+#include "include/pika_command.h"
+#include "include/pika_conf.h"
+#include "include/pika_rm.h"
+#include "include/pika_server.h"
+
+// pika.cc is not linked in, the globals the sources refer to live here
+std::unique_ptr<PikaConf> g_pika_conf;
+PikaServer* g_pika_server = nullptr;
+std::unique_ptr<PikaReplicaManager> g_pika_rm;
+std::unique_ptr<PikaCmdTableManager> g_pika_cmd_table_manager;
+
+static std::atomic<uint64_t> alloc_count{0};
+
+void* operator new(size_t size) {
+  alloc_count.fetch_add(1, std::memory_order_relaxed);
+  void* p = malloc(size == 0 ? 1 : size);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+int64_t requests = 1000000;
+std::string cmd_name = "get";
+int32_t value_size = 16;
+
+static uint64_t NowMicros() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  return static_cast<uint64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+void Usage() {
+  std::cout << "Usage: " << std::endl;
+  std::cout << "\tCmd_alloc_bench counts the allocations pika makes for a request before executing it" << std::endl;
+  std::cout << "\t-h    -- displays this help information and exits" << std::endl;
+  std::cout << "\t-n    -- requests to make, default = 1000000" << std::endl;
+  std::cout << "\t-c    -- command of the requests, get or set, default = get" << std::endl;
+  std::cout << "\t-v    -- value size of set, default = 16" << std::endl;
+  std::cout << "\texample: ./cmd_alloc_bench -n 1000000 -c set -v 16" << std::endl;
+}
+
+// The argv as the redis parser hands it to the connection
+PikaCmdArgsType MakeArgv(int64_t i) {
+  PikaCmdArgsType argv;
+  argv.push_back(cmd_name);
+  argv.push_back("key:" + std::to_string(i % 10000));
+  if (cmd_name == "set") {
+    argv.push_back(std::string(value_size, 'v'));
+  }
+  return argv;
+}
+
+void Run(const std::string& mode, bool pooled) {
+  CmdTable* table = g_pika_cmd_table_manager->GetCmdTable();
+  uint64_t argv_allocs = 0;
+  uint64_t cmd_allocs = 0;
+  uint64_t key_allocs = 0;
+  uint64_t start_us = NowMicros();
+  for (int64_t i = 0; i < requests; i++) {
+    uint64_t before = alloc_count.load(std::memory_order_relaxed);
+    PikaCmdArgsType argv = MakeArgv(i);
+    uint64_t after_argv = alloc_count.load(std::memory_order_relaxed);
+
+    std::shared_ptr<Cmd> c_ptr;
+    if (pooled) {
+      c_ptr = g_pika_cmd_table_manager->GetCmd(cmd_name);
+    } else {
+      c_ptr = std::shared_ptr<Cmd>(GetCmdFromDB(cmd_name, *table)->Clone());
+    }
+    c_ptr->Initial(std::move(argv), "db0");
+    uint64_t after_cmd = alloc_count.load(std::memory_order_relaxed);
+
+    std::vector<std::string> keys = c_ptr->current_key();
+    uint64_t after_keys = alloc_count.load(std::memory_order_relaxed);
+
+    argv_allocs += after_argv - before;
+    cmd_allocs += after_cmd - after_argv;
+    key_allocs += after_keys - after_cmd;
+  }
+  uint64_t cost_us = NowMicros() - start_us;
+
+  auto per_request = [](uint64_t count) { return static_cast<double>(count) / static_cast<double>(requests); };
+  std::cout << mode << ": " << requests << " " << cmd_name << " requests in " << cost_us << " us" << std::endl;
+  std::cout << "\tallocations per request, argv: " << per_request(argv_allocs)
+            << ", cmd: " << per_request(cmd_allocs) << ", current_key: " << per_request(key_allocs) << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  int opt;
+  while ((opt = getopt(argc, argv, "hn:c:v:")) != -1) {
+    switch (opt) {
+      case 'h':
+        Usage();
+        exit(0);
+      case 'n':
+        requests = std::atoll(optarg);
+        break;
+      case 'c':
+        cmd_name = optarg;
+        break;
+      case 'v':
+        value_size = std::atoi(optarg);
+        break;
+      default:
+        Usage();
+        exit(-1);
+    }
+  }
+  if (requests <= 0 || (cmd_name != "get" && cmd_name != "set")) {
+    Usage();
+    exit(-1);
+  }
+
+  g_pika_cmd_table_manager = std::make_unique<PikaCmdTableManager>();
+  Run("clone", false);
+  Run("pool", true);
+  return 0;
+}
@@ -0,0 +1,87 @@
+//  Copyright (c) 2023-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+/*
+ * Matches a set of keys against a few patterns with stringmatchlen, which
+ * reads the pattern again for every key, and with a GlobMatcher compiled
+ * once, the way scans and pubsub match keys now.
+ */
+
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "pstd/include/pstd_glob.h"
+#include "pstd/include/pstd_string.h"
+
+int32_t key_num = 100000;
+
+static uint64_t NowMicros() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  return static_cast<uint64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+void Usage() {
+  std::cout << "Usage: " << std::endl;
+  std::cout << "\tGlob_match_bench compares stringmatchlen with a compiled GlobMatcher" << std::endl;
+  std::cout << "\t-h    -- displays this help information and exits" << std::endl;
+  std::cout << "\t-n    -- keys to match, default = 100000" << std::endl;
+  std::cout << "\texample: ./glob_match_bench -n 100000" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  int opt;
+  while ((opt = getopt(argc, argv, "hn:")) != -1) {
+    switch (opt) {
+      case 'h':
+        Usage();
+        exit(0);
+      case 'n':
+        key_num = std::atoi(optarg);
+        break;
+      default:
+        Usage();
+        exit(-1);
+    }
+  }
+
+  std::vector<std::string> keys;
+  for (int32_t i = 0; i < key_num; i++) {
+    keys.push_back("user:" + std::to_string(i) + ":session:" + std::to_string(i * 7));
+  }
+  for (const char* pattern : {"user:*", "*:session:7*", "user:*[0-5]:session:*0", "*a*b*c*"}) {
+    const int pattern_len = static_cast<int>(strlen(pattern));
+    size_t expect = 0;
+    uint64_t start = NowMicros();
+    for (const auto& key : keys) {
+      expect += pstd::stringmatchlen(pattern, pattern_len, key.data(), static_cast<int>(key.size()), 0) != 0 ? 1 : 0;
+    }
+    uint64_t stringmatch_cost = NowMicros() - start;
+
+    size_t matched = 0;
+    start = NowMicros();
+    pstd::GlobMatcher matcher(pattern);
+    for (const auto& key : keys) {
+      matched += matcher.Match(key) ? 1 : 0;
+    }
+    uint64_t glob_cost = NowMicros() - start;
+
+    if (matched != expect) {
+      std::cout << "pattern " << pattern << ": GlobMatcher matched " << matched << " keys, stringmatchlen " << expect
+                << std::endl;
+      return -1;
+    }
+    std::cout << "pattern " << pattern << ": " << matched << " matched, stringmatchlen " << stringmatch_cost
+              << " us, GlobMatcher " << glob_cost << " us" << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,117 @@
+//  Copyright (c) 2023-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+/*
+ * Locks and unlocks records of a LockMgr from several threads, by the key
+ * the way most callers do, and by a hash computed once the way
+ * Cmd::InternalProcessCommand does, over a few hot keys and many cold ones.
+ */
+
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pstd/include/lock_mgr.h"
+
+int64_t ops_per_thread = 200000;
+
+static uint64_t NowMicros() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  return static_cast<uint64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+void Usage() {
+  std::cout << "Usage: " << std::endl;
+  std::cout << "\tLock_mgr_bench measures the lock/unlock pairs per second of a LockMgr under contention" << std::endl;
+  std::cout << "\t-h    -- displays this help information and exits" << std::endl;
+  std::cout << "\t-n    -- lock/unlock pairs per thread, default = 200000" << std::endl;
+  std::cout << "\texample: ./lock_mgr_bench -n 200000" << std::endl;
+}
+
+// Every key counts the times it was locked, which adds up only if no two
+// threads held it at the same time
+void Run(size_t thread_num, size_t key_num, bool precomputed) {
+  pstd::lock::LockMgr mgr(1000, 0);
+  std::vector<std::string> keys;
+  std::vector<uint64_t> hashes;
+  for (size_t i = 0; i < key_num; i++) {
+    keys.push_back("key_" + std::to_string(i));
+    hashes.push_back(pstd::lock::LockMgr::Hash(keys.back()));
+  }
+  std::vector<int64_t> counts(key_num, 0);
+
+  std::vector<std::thread> threads;
+  uint64_t start_us = NowMicros();
+  for (size_t i = 0; i < thread_num; i++) {
+    threads.emplace_back([&, i]() {
+      for (int64_t j = 0; j < ops_per_thread; j++) {
+        size_t k = (i * 104729 + j * 7919) % key_num;
+        if (precomputed) {
+          mgr.TryLock(hashes[k]);
+          counts[k]++;
+          mgr.UnLock(hashes[k]);
+        } else {
+          mgr.TryLock(keys[k]);
+          counts[k]++;
+          mgr.UnLock(keys[k]);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  uint64_t cost_us = std::max<uint64_t>(NowMicros() - start_us, 1);
+
+  int64_t total = 0;
+  for (int64_t count : counts) {
+    total += count;
+  }
+  int64_t expected = static_cast<int64_t>(thread_num) * ops_per_thread;
+  std::cout << thread_num << " threads, " << key_num << " keys, " << (precomputed ? "hashes" : "keys") << ": "
+            << expected * 1000000 / static_cast<int64_t>(cost_us) << " locks/s";
+  if (total != expected) {
+    std::cout << ", lost " << expected - total << " updates";
+  }
+  std::cout << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  int opt;
+  while ((opt = getopt(argc, argv, "hn:")) != -1) {
+    switch (opt) {
+      case 'h':
+        Usage();
+        exit(0);
+      case 'n':
+        ops_per_thread = std::atoll(optarg);
+        break;
+      default:
+        Usage();
+        exit(-1);
+    }
+  }
+  if (ops_per_thread <= 0) {
+    Usage();
+    exit(-1);
+  }
+
+  for (size_t key_num : {4, 100000}) {
+    for (size_t thread_num : {1, 4, 16}) {
+      for (bool precomputed : {false, true}) {
+        Run(thread_num, key_num, precomputed);
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,106 @@
+//  Copyright (c) 2023-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+/*
+ * Runs the read-modify-write of Redis::UpdateSpecificKeyStatistics from
+ * several threads at once on an LRUCache behind a single lock and on a
+ * ShardedLRUCache, and prints the operations per second of both.
+ */
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/lru_cache.h"
+
+size_t ops_per_thread = 200000;
+size_t capacity = 5000;
+size_t key_num = 10000;
+
+void Usage() {
+  std::cout << "Usage: " << std::endl;
+  std::cout << "\tLru_cache_bench compares LRUCache with ShardedLRUCache under concurrent updates" << std::endl;
+  std::cout << "\t-h    -- displays this help information and exits" << std::endl;
+  std::cout << "\t-n    -- operations of every thread, default = 200000" << std::endl;
+  std::cout << "\t-c    -- capacity of the caches, default = 5000" << std::endl;
+  std::cout << "\t-k    -- keys updated, default = 10000" << std::endl;
+  std::cout << "\texample: ./lru_cache_bench -n 200000 -c 5000 -k 10000" << std::endl;
+}
+
+// Returns the operations per second
+template <typename Cache>
+double RunConcurrentUpdates(Cache* cache, const std::vector<std::string>& keys, size_t thread_num) {
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < thread_num; t++) {
+    threads.emplace_back([&, t]() {
+      size_t total = 0;
+      for (size_t i = 0; i < ops_per_thread; i++) {
+        const std::string& key = keys[(i * 7919 + t * 104729) % keys.size()];
+        total = 0;
+        cache->Lookup(key, &total);
+        cache->Insert(key, total + 1);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto cost = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+  return static_cast<double>(thread_num * ops_per_thread) * 1000000 / std::max<int64_t>(cost.count(), 1);
+}
+
+int main(int argc, char* argv[]) {
+  int opt;
+  while ((opt = getopt(argc, argv, "hn:c:k:")) != -1) {
+    switch (opt) {
+      case 'h':
+        Usage();
+        exit(0);
+      case 'n':
+        ops_per_thread = std::strtoull(optarg, nullptr, 10);
+        break;
+      case 'c':
+        capacity = std::strtoull(optarg, nullptr, 10);
+        break;
+      case 'k':
+        key_num = std::strtoull(optarg, nullptr, 10);
+        break;
+      default:
+        Usage();
+        exit(-1);
+    }
+  }
+  if (key_num == 0) {
+    Usage();
+    exit(-1);
+  }
+
+  std::vector<std::string> keys;
+  keys.reserve(key_num);
+  for (size_t i = 0; i < key_num; i++) {
+    keys.push_back("statistics_key_" + std::to_string(i));
+  }
+  for (size_t thread_num : {1, 4, 8}) {
+    storage::LRUCache<std::string, size_t> lru_cache;
+    lru_cache.SetCapacity(capacity);
+    double single_lock_ops = RunConcurrentUpdates(&lru_cache, keys, thread_num);
+
+    storage::ShardedLRUCache<std::string, size_t> sharded_lru_cache;
+    sharded_lru_cache.SetCapacity(capacity);
+    double sharded_ops = RunConcurrentUpdates(&sharded_lru_cache, keys, thread_num);
+
+    std::cout << thread_num << " threads: LRUCache " << static_cast<uint64_t>(single_lock_ops)
+              << " ops/s, ShardedLRUCache " << static_cast<uint64_t>(sharded_ops) << " ops/s" << std::endl;
+  }
+  return 0;
+}
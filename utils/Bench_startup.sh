@@ -0,0 +1,114 @@
+#!/bin/bash
+# Measures how long pika takes to open its dbs on startup.
+#
+# Fills a synthetic data directory, kills pika so the next start has to
+# replay the WALs, then restarts it once for every db-open-threads value
+# and prints the time until it answers PING and the db_open_time_ms it
+# reports in INFO.
+#
+# Usage: Bench_startup.sh [databases] [keys per db] [db-open-threads values]
+#   e.g. Bench_startup.sh 8 200000 "1 4 8"
+
+utils_dir=$(
+    cd $(dirname $0)
+    pwd
+)
+root_dir=$utils_dir/..
+databases=${1:-8}
+keys=${2:-200000}
+thread_values=${3:-"1 4 8"}
+port=${PORT:-9299}
+work_dir=$(mktemp -d /tmp/pika_startup_bench.XXXXXX)
+
+function find_pika_bin() {
+    for dir in build output; do
+        if [ -f "$root_dir/$dir/pika" ]; then
+            PIKA_BIN="$root_dir/$dir/pika"
+            return
+        fi
+    done
+    echo "pika bin not found, please build the project first"
+    exit 1
+}
+
+function check_redis_cli() {
+    if [ -z "$(which redis-cli)" ]; then
+        echo "redis-cli is not installed"
+        exit 1
+    fi
+}
+
+# write_conf <db-open-threads>
+function write_conf() {
+    sed -e "s#^port :.*#port : $port#" \
+        -e "s#^log-path :.*#log-path : $work_dir/log/#" \
+        -e "s#^db-path :.*#db-path : $work_dir/db/#" \
+        -e "s#^dump-path :.*#dump-path : $work_dir/dump/#" \
+        -e "s#^db-sync-path :.*#db-sync-path : $work_dir/dbsync/#" \
+        -e "s#^pidfile :.*#pidfile : $work_dir/pika.pid#" \
+        -e "s#^databases :.*#databases : $databases#" \
+        -e "s#^db-open-threads :.*#db-open-threads : $1#" \
+        "$root_dir/conf/pika.conf" > "$work_dir/pika.conf"
+}
+
+function now_ms() {
+    echo $(($(date +%s%N) / 1000000))
+}
+
+# start_pika, sets READY_MS to the milliseconds until pika answers PING
+function start_pika() {
+    local start=$(now_ms)
+    "$PIKA_BIN" -c "$work_dir/pika.conf" > "$work_dir/pika.out" 2>&1 &
+    PIKA_PID=$!
+    until [ "$(redis-cli -p $port ping 2>/dev/null)" == "PONG" ]; do
+        if ! kill -0 $PIKA_PID 2>/dev/null; then
+            echo "pika exited, see $work_dir/pika.out"
+            exit 1
+        fi
+        sleep 0.05
+    done
+    READY_MS=$(($(now_ms) - start))
+}
+
+function cleanup() {
+    if [ -n "$PIKA_PID" ]; then
+        kill -9 $PIKA_PID 2>/dev/null
+        wait $PIKA_PID 2>/dev/null
+    fi
+    rm -rf "$work_dir"
+}
+trap cleanup EXIT
+
+find_pika_bin
+check_redis_cli
+
+echo "fill $databases dbs with $keys keys of every type in $work_dir"
+write_conf 8
+start_pika
+for ((db = 0; db < databases; db++)); do
+    {
+        echo "SELECT $db"
+        for ((i = 0; i < keys; i++)); do
+            echo "SET key_$i value_$i"
+            echo "HSET hash_$i field value_$i"
+            echo "SADD set_$i member_$i"
+            echo "RPUSH list_$i node_$i"
+            echo "ZADD zset_$i $i member_$i"
+        done
+    } | redis-cli -p $port --pipe > /dev/null
+done
+# Skip the shutdown flush, every start replays the WALs
+kill -9 $PIKA_PID
+wait $PIKA_PID 2>/dev/null
+cp -r "$work_dir/db" "$work_dir/db.synthetic"
+
+for threads in $thread_values; do
+    rm -rf "$work_dir/db"
+    cp -r "$work_dir/db.synthetic" "$work_dir/db"
+    write_conf $threads
+    start_pika
+    open_ms=$(redis-cli -p $port info server | grep db_open_time_ms | cut -d: -f2 | tr -d '\r')
+    echo "db-open-threads $threads: ready in ${READY_MS}ms, db_open_time_ms ${open_ms}"
+    kill -9 $PIKA_PID
+    wait $PIKA_PID 2>/dev/null
+done